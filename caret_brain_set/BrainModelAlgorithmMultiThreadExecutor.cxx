@@ -28,7 +28,7 @@
 
 #include "BrainModelAlgorithm.h"
 #include "BrainModelAlgorithmMultiThreadExecutor.h"
-#include "BrainModelAlgorithmRunAsThread.h"
+#include "BrainModelAlgorithmThreadPoolTask.h"
 
 /**
  * constructor.
@@ -44,6 +44,9 @@ BrainModelAlgorithmMultiThreadExecutor::BrainModelAlgorithmMultiThreadExecutor(
       numberOfThreadsToRun = 1;
    }
    stopIfAlogorithmThrowsException = stopIfAlogorithmThrowsExceptionIn;
+   taskGroup = NULL;
+   nextAlgorithmToRun = 0;
+   stopSubmittingFlag = false;
 }
 
 /**
@@ -54,7 +57,9 @@ BrainModelAlgorithmMultiThreadExecutor::BrainModelAlgorithmMultiThreadExecutor()
 }
 
 /**
- * start executing the threads.
+ * start executing the threads.  At most "numberOfThreadsToRun" algorithms
+ * are in the thread pool at one time, each completed algorithm submits
+ * the next algorithm.
  */
 void 
 BrainModelAlgorithmMultiThreadExecutor::startExecution()
@@ -66,113 +71,115 @@ BrainModelAlgorithmMultiThreadExecutor::startExecution()
    if (numAlgorithmsToRun <= 0) {
       return;
    }
-   int nextAlgorithmToRun = 0;
+   
+   algorithmTasks.resize(numAlgorithmsToRun);
+   for (int i = 0; i < numAlgorithmsToRun; i++) {
+      algorithmTasks[i] = NULL;
+   }
+   
+   CaretThreadPoolTaskGroup group;
+   taskGroup = &group;
    
    //
-   // Pointers for algorithm threads
+   // Submit the initial algorithms
    //
-   std::vector<BrainModelAlgorithmRunAsThread*> algorithmThreads(numberOfThreadsToRun);
+   submitMutex.lock();
+   nextAlgorithmToRun = 0;
+   stopSubmittingFlag = false;
    for (int i = 0; i < numberOfThreadsToRun; i++) {
-      algorithmThreads[i] = NULL;
+      submitNextAlgorithm();
    }
+   submitMutex.unlock();
    
    //
-   // Time to wait for a thread
+   // Time to wait before allowing events to process
    //
-   const unsigned long threadWaitTimeInMilliseconds = 5;
+   const unsigned long eventWaitTimeInMilliseconds = 50;
    
    //
-   // Loop for creating and executing threads
-   //
-   bool done = false;
-   while (done == false) {
-      //
-      // Loop through threads to see if any are done and create new threads
-      //
-      for (int iThread = 0; iThread < numberOfThreadsToRun; iThread++) {
-         //
-         // Is thread valid ?
-         //
-         if (algorithmThreads[iThread] != NULL) {
-            //
-            // Wait on the thread
-            //
-            algorithmThreads[iThread]->wait(threadWaitTimeInMilliseconds);
-            
-            //
-            // Is thread finished ?
-            //
-            if (algorithmThreads[iThread]->isFinished()) {
-               //
-               // Get any error message
-               //
-               if (algorithmThreads[iThread]->getAlgorithmThrewAnException()) {
-                  exceptionMessages.push_back(algorithmThreads[iThread]->getExceptionErrorMessage());
-                  
-                  //
-                  // Should execution stop ?
-                  //
-                  if (stopIfAlogorithmThrowsException) {
-                     nextAlgorithmToRun = numAlgorithmsToRun;
-                  }
-               }
-
-               //
-               // delete the thread (does not delete the algorithm)
-               //
-               delete algorithmThreads[iThread];
-               algorithmThreads[iThread] = NULL;
-            }
-         }
-         
-         //
-         // Is thread available
-         //
-         if (algorithmThreads[iThread] == NULL) {
-            //
-            // Are there algorithms that still need to run ?
-            //
-            if (nextAlgorithmToRun < numAlgorithmsToRun) {
-               //
-               // Create the new thread and start it
-               //
-               algorithmThreads[iThread] = 
-                  new BrainModelAlgorithmRunAsThread(algorithms[nextAlgorithmToRun],
-                                                     false);
-               algorithmThreads[iThread]->start(QThread::HighestPriority);
-               
-               //
-               // Inform caller of algorithm description
-               //
-               const QString s = algorithms[nextAlgorithmToRun]->getTextDescription();
-               if (s.isEmpty() == false) {
-                  emit algorithmStartedDescription(s);
-               }
-               
-               //
-               // Increment to next algorithm
-               //
-               nextAlgorithmToRun++;
-            }
-         }
-      } // for (iThread
-      
-      //
-      // Loop through the threads to see if any are still valid and if time to stop
-      //
-      done = true;
-      for (int iThread = 0; iThread < numberOfThreadsToRun; iThread++) {
-         if (algorithmThreads[iThread] != NULL) {
-            done = false;
+   // Wait for the algorithms while allowing other events to process
+   //
+   while (group.waitForAll(eventWaitTimeInMilliseconds) == false) {
+      QApplication::processEvents();
+   }
+   QApplication::processEvents();
+   taskGroup = NULL;
+   
+   //
+   // Get any error messages and delete the tasks (does not delete the algorithms)
+   //
+   for (int i = 0; i < numAlgorithmsToRun; i++) {
+      if (algorithmTasks[i] != NULL) {
+         if (algorithmTasks[i]->getAlgorithmThrewAnException()) {
+            exceptionMessages.push_back(algorithmTasks[i]->getAlgorithmExceptionErrorMessage());
          }
+         delete algorithmTasks[i];
+         algorithmTasks[i] = NULL;
       }
+   }
+   algorithmTasks.clear();
+}
 
-      //
-      // Allow other events to process
-      //
-      QApplication::processEvents();
+/**
+ * submit the next algorithm to the thread pool (mutex must be locked).
+ */
+void 
+BrainModelAlgorithmMultiThreadExecutor::submitNextAlgorithm()
+{
+   if (stopSubmittingFlag) {
+      return;
+   }
+   if (nextAlgorithmToRun >= static_cast<int>(algorithms.size())) {
+      return;
+   }
+   
+   BrainModelAlgorithmThreadPoolTask* task = 
+      new BrainModelAlgorithmThreadPoolTask(algorithms[nextAlgorithmToRun], false);
+   task->setAlgorithmIndex(nextAlgorithmToRun);
+   task->setCompletionCallback(this);
+   algorithmTasks[nextAlgorithmToRun] = task;
+   
+   //
+   // Inform caller of algorithm description
+   //
+   const QString s = algorithms[nextAlgorithmToRun]->getTextDescription();
+   if (s.isEmpty() == false) {
+      emit algorithmStartedDescription(s);
+   }
+   
+   //
+   // Increment to next algorithm
+   //
+   nextAlgorithmToRun++;
+   
+   taskGroup->submit(task);
+}
+
+/**
+ * called by thread pool when an algorithm's task completes.
+ */
+void 
+BrainModelAlgorithmMultiThreadExecutor::taskCompleted(CaretThreadPoolTask* task)
+{
+   BrainModelAlgorithmThreadPoolTask* algorithmTask = 
+      dynamic_cast<BrainModelAlgorithmThreadPoolTask*>(task);
       
-   } // while (done == false)
+   submitMutex.lock();
+   
+   //
+   // Should execution stop ?
+   //
+   if (algorithmTask != NULL) {
+      if (algorithmTask->getAlgorithmThrewAnException()) {
+         if (stopIfAlogorithmThrowsException) {
+            stopSubmittingFlag = true;
+         }
+      }
+   }
+   
+   submitNextAlgorithm();
+   
+   submitMutex.unlock();
 }
 
 /**
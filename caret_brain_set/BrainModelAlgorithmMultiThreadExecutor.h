@@ -29,13 +29,18 @@
 
 #include <vector>
 
+#include <QMutex>
 #include <QObject>
 #include <QString>
 
+#include "CaretThreadPool.h"
+
 class BrainModelAlgorithm;
+class BrainModelAlgorithmThreadPoolTask;
 
-/// class for executing brain model algorithms in parallel
-class BrainModelAlgorithmMultiThreadExecutor : public QObject {
+/// class for executing brain model algorithms in parallel using the global thread pool
+class BrainModelAlgorithmMultiThreadExecutor : public QObject,
+                                               public CaretThreadPoolTaskCompletionCallback {
    Q_OBJECT
    
    public:
@@ -53,11 +58,17 @@ class BrainModelAlgorithmMultiThreadExecutor : public QObject {
       // get any exeception messages
       void getExceptionMessages(std::vector<QString>& exceptionMessagesOut) const;
       
+      // called by thread pool when an algorithm's task completes
+      void taskCompleted(CaretThreadPoolTask* task);
+      
    signals:
       // emits algorithm description (if non-blank) when algorithm starts
       void algorithmStartedDescription(const QString&);
       
    protected:
+      // submit the next algorithm to the thread pool (mutex must be locked)
+      void submitNextAlgorithm();
+      
       // the algorithms
       std::vector<BrainModelAlgorithm*> algorithms;
       
@@ -69,6 +80,21 @@ class BrainModelAlgorithmMultiThreadExecutor : public QObject {
       
       // exeception messages
       std::vector<QString> exceptionMessages;
+      
+      // tasks running the algorithms
+      std::vector<BrainModelAlgorithmThreadPoolTask*> algorithmTasks;
+      
+      // group of tasks running the algorithms
+      CaretThreadPoolTaskGroup* taskGroup;
+      
+      // index of next algorithm to submit
+      int nextAlgorithmToRun;
+      
+      // no more algorithms are submitted when set
+      bool stopSubmittingFlag;
+      
+      // protects the submission of algorithms
+      QMutex submitMutex;
    
 };
 
@@ -39,7 +39,6 @@ BrainModelAlgorithmMultiThreaded::BrainModelAlgorithmMultiThreaded(BrainSet* bs,
    parentOfThisThread = parentOfThisThreadIn;
    threadNumber = threadNumberIn;
    threadFlag = iAmAThread;
-   threadKeepLoopingFlag = false;
    
    numberOfThreadsToRun = 1;
    
@@ -50,21 +49,6 @@ BrainModelAlgorithmMultiThreaded::BrainModelAlgorithmMultiThreaded(BrainSet* bs,
       PreferencesFile* pf = bs->getPreferencesFile();
       numberOfThreadsToRun = pf->getMaximumNumberOfThreads();
    }
-   
-   numChildThreadStarted = 0;
-   if (numberOfThreadsToRun > 1) {
-      mutexNumChildThreadStarted.unlock();
-   }
-   
-   resetNumChildThreadDone();
-   if (numberOfThreadsToRun > 1) {
-      mutexNumChildThreadDone.unlock();
-   }
-   
-   threadedIterationDoneFlag = false;
-   if (numberOfThreadsToRun > 1) {
-      mutexThreadedIterationDoneFlag.unlock();
-   }
 }
 
 /**
@@ -75,81 +59,47 @@ BrainModelAlgorithmMultiThreaded::~BrainModelAlgorithmMultiThreaded()
 }
 
 /**
- * Get the number of children thread that have started.
- */
-int
-BrainModelAlgorithmMultiThreaded::getNumChildThreadStarted()
-{
-   mutexNumChildThreadStarted.lock();
-   const int num = numChildThreadStarted;
-   mutexNumChildThreadStarted.unlock();
-   return num;
-}
-
-/**
- * Increment number of children thread that have started.
- */
-void
-BrainModelAlgorithmMultiThreaded::incrementNumChildThreadStarted()
-{
-   mutexNumChildThreadStarted.lock();
-   numChildThreadStarted++;
-   mutexNumChildThreadStarted.unlock();
-}
-
-/**
- * Reset the number of children thread done (set it to zero).
+ * Run one iteration of each child instance in the global thread pool
+ * and wait until all of them have finished the iteration.
  */
 void
-BrainModelAlgorithmMultiThreaded::resetNumChildThreadDone()
+BrainModelAlgorithmMultiThreaded::runIterationOfChildrenInThreadPool(
+                  const std::vector<BrainModelAlgorithmMultiThreaded*>& children,
+                  const int iteration)
 {
-   numChildThreadDone = 0;
+   const int numChildren = static_cast<int>(children.size());
+   std::vector<IterationTask*> tasks(numChildren);
+   
+   CaretThreadPoolTaskGroup taskGroup;
+   for (int i = 0; i < numChildren; i++) {
+      tasks[i] = new IterationTask(children[i], iteration);
+      taskGroup.submit(tasks[i]);
+   }
+   taskGroup.waitForAll();
+   
+   for (int i = 0; i < numChildren; i++) {
+      delete tasks[i];
+   }
 }
 
-/**
- * Get the number of children thread that are done with their iteration.
- */
-int
-BrainModelAlgorithmMultiThreaded::getNumChildThreadDone()
-{
-   mutexNumChildThreadDone.lock();
-   const int num = numChildThreadDone;
-   mutexNumChildThreadDone.unlock();
-   return num;
-}
+//=============================================================================
 
 /**
- * Increment number of children thread that are done with their iteration.
- */
-void
-BrainModelAlgorithmMultiThreaded::incrementNumChildThreadDone()
-{
-   mutexNumChildThreadDone.lock();
-   numChildThreadDone++;
-   mutexNumChildThreadDone.unlock();
-}
-
-/**
- * Get the threaded iteration done flag
+ * Constructor.
  */
-bool
-BrainModelAlgorithmMultiThreaded::getThreadedIterationDoneFlag()
+BrainModelAlgorithmMultiThreaded::IterationTask::IterationTask(
+                                    BrainModelAlgorithmMultiThreaded* algorithmIn,
+                                    const int iterationIn)
 {
-   mutexThreadedIterationDoneFlag.lock();
-   const bool flag = threadedIterationDoneFlag;
-   mutexThreadedIterationDoneFlag.unlock();
-   return flag;
+   algorithm = algorithmIn;
+   iteration = iterationIn;
 }
 
 /**
- * Set the threaded iteration done flag
+ * run the iteration.
  */
 void
-BrainModelAlgorithmMultiThreaded::setThreadedIterationDoneFlag(const bool flag)
+BrainModelAlgorithmMultiThreaded::IterationTask::run()
 {
-   mutexThreadedIterationDoneFlag.lock();
-   threadedIterationDoneFlag = flag;
-   mutexThreadedIterationDoneFlag.unlock();
+   algorithm->runIteration(iteration);
 }
-
-
@@ -26,14 +26,15 @@
 #ifndef __BRAIN_MODEL_ALGORITHM_MULTI_THREADED_H__
 #define __BRAIN_MODEL_ALGORITHM_MULTI_THREADED_H__
 
-#include <QMutex>
-#include <QThread>
+#include <vector>
 
 #include "BrainModelAlgorithm.h"
+#include "CaretThreadPool.h"
 
-/// Abstract class for multi-threaded algorithms that work on brain models
-class BrainModelAlgorithmMultiThreaded : public BrainModelAlgorithm,
-                                         protected QThread {
+/// Abstract class for multi-threaded algorithms that work on brain models.
+/// Child instances each process a range of nodes and their iterations are
+/// executed as tasks in the global thread pool.
+class BrainModelAlgorithmMultiThreaded : public BrainModelAlgorithm {
    public:
       /// get the number of thread to run
       int getNumberOfThreadsToRun() const { return numberOfThreadsToRun; }
@@ -44,13 +45,25 @@ class BrainModelAlgorithmMultiThreaded : public BrainModelAlgorithm,
       /// destructor
       virtual ~BrainModelAlgorithmMultiThreaded();
       
-      /// Increment the number of children threads that have started their iterations
-      void incrementNumChildThreadStarted();
-      
-      /// Increment the number of children thread that are done with their iteration.
-      void incrementNumChildThreadDone();
-
    protected:
+      /// task that runs one iteration of a child instance in the thread pool
+      class IterationTask : public CaretThreadPoolTask {
+         public:
+            /// constructor
+            IterationTask(BrainModelAlgorithmMultiThreaded* algorithmIn,
+                          const int iterationIn);
+            
+            /// run the iteration
+            void run();
+            
+         protected:
+            /// the algorithm whose iteration is run
+            BrainModelAlgorithmMultiThreaded* algorithm;
+            
+            /// the iteration number
+            int iteration;
+      };
+      
       //
       // initialize
       //
@@ -61,34 +74,21 @@ class BrainModelAlgorithmMultiThreaded : public BrainModelAlgorithm,
                               int threadNumberIn,
                               const bool iAmAThread);
       
+      /// run one iteration on the nodes assigned to this instance
+      virtual void runIteration(const int iteration) = 0;
+      
+      /// run one iteration of each child instance in the thread pool and wait for them
+      void runIterationOfChildrenInThreadPool(
+                  const std::vector<BrainModelAlgorithmMultiThreaded*>& children,
+                  const int iteration);
+      
       /// get the parent of this thread
       BrainModelAlgorithmMultiThreaded* getParentOfThisThread()
                                                      { return parentOfThisThread; }
 
-      /// get the thread keep looping flag
-      bool getThreadKeepLoopingFlag() const { return threadKeepLoopingFlag; }
-      
-      /// set the thread keep looping flag
-      void setThreadKeepLoopingFlag(const bool flag) { threadKeepLoopingFlag = flag; }
-      
       /// get the number of this thread
       int getThreadNumber() const { return threadNumber; }
       
-      /// Get the number of children threads that have started
-      int getNumChildThreadStarted();
-      
-      /// Reset the number of children thread done (set it to zero).
-      void resetNumChildThreadDone();
-      
-      /// Get the number of children thread that are done with their iteration.
-      int getNumChildThreadDone();
-
-      /// Get the threaded iteration done flag
-      bool getThreadedIterationDoneFlag();
-
-      /// Set the threaded iteration done flag
-      void setThreadedIterationDoneFlag(const bool flag);
-
       /// see if i'm a thread instance
       bool getImAThread() const { return threadFlag; }
       
@@ -99,30 +99,9 @@ private:
       /// thread flag (set if this instance is run as a thread)
       bool threadFlag;
       
-      /// mutex for accessing number of children thread started
-      QMutex mutexNumChildThreadStarted;
-      
-      /// number of children threads started
-      int numChildThreadStarted;
-
-      /// number of children thread done
-      int numChildThreadDone;
-      
-      /// mutex for accessing number of children thread done
-      QMutex mutexNumChildThreadDone;
-      
-      /// threaded iteration done flag
-      bool threadedIterationDoneFlag;
-      
-      /// mutex for accessing the threaded iteration done flag
-      QMutex mutexThreadedIterationDoneFlag;
-
       /// number of this thread
       int threadNumber;
       
-      /// used to remain in run() when running as a thread
-      bool threadKeepLoopingFlag;
-      
       /// parent of this thread
       BrainModelAlgorithmMultiThreaded* parentOfThisThread;
       
@@ -0,0 +1,73 @@
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include "BrainModelAlgorithm.h"
+#include "BrainModelAlgorithmThreadPoolTask.h"
+
+/**
+ * constructor.
+ */
+BrainModelAlgorithmThreadPoolTask::BrainModelAlgorithmThreadPoolTask(BrainModelAlgorithm* algorithmToRunIn,
+                                            const bool deleteBrainModelAlgorithmInDestructorFlagIn)
+{
+   algorithmToRun = algorithmToRunIn;
+   deleteBrainModelAlgorithmInDestructorFlag = deleteBrainModelAlgorithmInDestructorFlagIn;
+   algorithmExceptionThrownFlag = false;
+   algorithmExceptionMessage = "";
+   algorithmIndex = -1;
+}
+
+/**
+ * destructor.
+ */
+BrainModelAlgorithmThreadPoolTask::~BrainModelAlgorithmThreadPoolTask()
+{
+   if (deleteBrainModelAlgorithmInDestructorFlag) {
+      delete algorithmToRun;
+      algorithmToRun = NULL;
+   }
+}
+
+/**
+ * runs the algorithm.
+ */
+void 
+BrainModelAlgorithmThreadPoolTask::run()
+{
+   if (algorithmToRun == NULL) {
+      algorithmExceptionThrownFlag = true;
+      algorithmExceptionMessage = "PROGRAM ERROR: Algorithm passed to constructor was NULL";
+      return;
+   }
+   
+   try {
+      algorithmToRun->execute();
+   }
+   catch (BrainModelAlgorithmException& e) {
+      algorithmExceptionThrownFlag = true;
+      algorithmExceptionMessage = e.whatQString();
+   }
+}
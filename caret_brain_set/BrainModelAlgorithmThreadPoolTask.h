@@ -0,0 +1,82 @@
+#ifndef __BRAIN_MODEL_ALGORITHM_THREAD_POOL_TASK_H__
+#define __BRAIN_MODEL_ALGORITHM_THREAD_POOL_TASK_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include "CaretThreadPool.h"
+
+class BrainModelAlgorithm;
+
+/// class that runs a brain model algorithm as a task in a thread pool
+class BrainModelAlgorithmThreadPoolTask : public CaretThreadPoolTask {
+   public:
+      // constructor
+      BrainModelAlgorithmThreadPoolTask(BrainModelAlgorithm* algorithmToRunIn,
+                                        const bool deleteBrainModelAlgorithmInDestructorFlagIn);
+      
+      // destructor
+      ~BrainModelAlgorithmThreadPoolTask();
+      
+      /// call after task finishes to see if an exception occurred during algorithm execution
+      bool getAlgorithmThrewAnException() const { return algorithmExceptionThrownFlag; }
+      
+      /// get the exception error message
+      QString getAlgorithmExceptionErrorMessage() const { return algorithmExceptionMessage; }
+      
+      /// get the algorithm
+      BrainModelAlgorithm* getBrainModelAlgorithm() { return algorithmToRun; }
+      
+      /// get the algorithm (const method)
+      const BrainModelAlgorithm* getBrainModelAlgorithm() const { return algorithmToRun; }
+      
+      /// get the index of the algorithm (for use by the creator of the task)
+      int getAlgorithmIndex() const { return algorithmIndex; }
+      
+      /// set the index of the algorithm (for use by the creator of the task)
+      void setAlgorithmIndex(const int indx) { algorithmIndex = indx; }
+      
+      // runs the algorithm
+      void run();
+      
+   protected:
+      /// the algorithm that is to be run in the thread pool
+      BrainModelAlgorithm* algorithmToRun;
+      
+      /// will get set if algorithm throws an exception
+      bool algorithmExceptionThrownFlag;
+      
+      /// will get set if algorithm throws an exception
+      QString algorithmExceptionMessage;
+      
+      /// delete the brain model algorithm in the destructor
+      bool deleteBrainModelAlgorithmInDestructorFlag;
+
+      
+      /// index of the algorithm
+      int algorithmIndex;
+};
+
+#endif // __BRAIN_MODEL_ALGORITHM_THREAD_POOL_TASK_H__
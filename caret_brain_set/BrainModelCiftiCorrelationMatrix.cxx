@@ -18,6 +18,7 @@
 #include <QTime>
 
 #include "BrainModelCiftiCorrelationMatrix.h"
+#include "CorrelationMatrixEngine.h"
 #include <DebugControl.h>
 
 #ifdef _OPENMP
@@ -26,6 +27,56 @@
 
 static const bool timingFlag = false;
 
+/**
+ * Supplies the correlation engine with demeaned rows of a memory mapped
+ * matrix so that the matrix is never entirely in memory.
+ */
+class CiftiMatrixDemeanedRowSource : public CorrelationMatrixEngine::RowSource {
+   public:
+      /// constructor
+      CiftiMatrixDemeanedRowSource(const CiftiMatrix* matrixIn,
+                                   const float* rowMeansIn)
+         : matrix(matrixIn), rowMeans(rowMeansIn), readErrorFlag(false) { }
+      
+      /// copy consecutive rows with each row's mean subtracted
+      void getDemeanedRows(const long firstRow,
+                           const long numberOfRows,
+                           float* rowsOut) const {
+         const long numCols = matrix->getNumberOfColumns();
+         try {
+            matrix->getRows(rowsOut, firstRow, numberOfRows);
+         }
+         catch (CiftiFileException&) {
+            //
+            // Exceptions may not leave the thread pool task
+            //
+            std::fill(rowsOut, rowsOut + numberOfRows * numCols, 0.0f);
+            readErrorFlag = true;
+            return;
+         }
+         for (long i = 0; i < numberOfRows; i++) {
+            const double mean = rowMeans[firstRow + i];
+            float* row = rowsOut + i * numCols;
+            for (long j = 0; j < numCols; j++) {
+               row[j] = row[j] - mean;
+            }
+         }
+      }
+      
+      /// true if reading rows failed
+      bool getReadErrorFlag() const { return readErrorFlag; }
+      
+   private:
+      /// the memory mapped matrix
+      const CiftiMatrix* matrix;
+      
+      /// mean of each row
+      const float* rowMeans;
+      
+      /// reading rows failed
+      mutable bool readErrorFlag;
+};
+
 /**
  * constructor.
  */ 
@@ -33,15 +84,42 @@ BrainModelCiftiCorrelationMatrix::BrainModelCiftiCorrelationMatrix(
                                                 BrainSet* bs,
                                                 CiftiFile* inputCiftiFile,
                                                 const bool applyFisherZTransformFlag,
-                                                const bool parallelFlag)
+                                                const bool parallelFlag,
+                                                const bool floatAccumulationFlag)
    : BrainModelAlgorithm(bs),
      m_inputCiftiFile(inputCiftiFile),
      m_applyFisherZTransformFlag(applyFisherZTransformFlag),
-     m_parallelFlag(parallelFlag)
+     m_parallelFlag(parallelFlag),
+     m_floatAccumulationFlag(floatAccumulationFlag)
 {
    this->initialize();
 }
 
+/**
+ * constructor for computing blocks of rows that are written to the 
+ * output file as they are completed so that the memory used is limited
+ * to the input data and one block of rows.
+ */ 
+BrainModelCiftiCorrelationMatrix::BrainModelCiftiCorrelationMatrix(
+                                                BrainSet* bs,
+                                                CiftiFile* inputCiftiFile,
+                                                const QString& outputCiftiFileName,
+                                                const long memoryLimitMegabytes,
+                                                const bool applyFisherZTransformFlag,
+                                                const bool parallelFlag,
+                                                const bool floatAccumulationFlag)
+   : BrainModelAlgorithm(bs),
+     m_inputCiftiFile(inputCiftiFile),
+     m_applyFisherZTransformFlag(applyFisherZTransformFlag),
+     m_parallelFlag(parallelFlag),
+     m_floatAccumulationFlag(floatAccumulationFlag)
+{
+   this->initialize();
+   this->m_outputCiftiFileName = outputCiftiFileName;
+   this->m_memoryLimitMegabytes = memoryLimitMegabytes;
+   this->m_streamOutputFlag = true;
+}
+
 /**
  * destructor.
  */ 
@@ -61,6 +139,9 @@ BrainModelCiftiCorrelationMatrix::~BrainModelCiftiCorrelationMatrix()
    if (this->m_rowSumSquared != NULL) {
       delete[] this->m_rowSumSquared;
    }
+   if (this->m_onDiskMatrix != NULL) {
+      delete this->m_onDiskMatrix;
+   }
 }
 
 /**
@@ -71,10 +152,13 @@ BrainModelCiftiCorrelationMatrix::initialize()
 {
    this->m_deleteOutputCiftiFlag = true;
    this->m_outputCiftiFile = NULL;
+   this->m_outputDataArrayColumns = NULL;
+   this->m_streamOutputFlag = false;
+   this->m_memoryLimitMegabytes = 0;
    this->m_dataValues = NULL;
+   this->m_onDiskMatrix = NULL;
    this->m_rowMeans = NULL;
    this->m_rowSumSquared = NULL;
-   this->m_nextRowToProcess = -1;
 }
       
 /**
@@ -112,11 +196,16 @@ BrainModelCiftiCorrelationMatrix::execute() throw (BrainModelAlgorithmException)
    }
    
    /*
-    * Compute the means
+    * Compute the means (and sum-squared of a memory mapped matrix)
     */
    QTime meanTimer;
    meanTimer.start();
-   this->computeMeans();
+   if (this->m_onDiskMatrix != NULL) {
+      this->computeMeansAndSumSquaredOnDisk();
+   }
+   else {
+      this->computeMeans();
+   }
    if (timingFlag) {
       std::cout << "Computed means in "
                 << (meanTimer.elapsed() * 0.001)
@@ -129,7 +218,9 @@ BrainModelCiftiCorrelationMatrix::execute() throw (BrainModelAlgorithmException)
     */
    QTime ssTimer;
    ssTimer.start();
-   this->computeSumSquared();
+   if (this->m_onDiskMatrix == NULL) {
+      this->computeSumSquared();
+   }
    if (timingFlag) {
       std::cout << "Computed sum-squareds in "
                 << (ssTimer.elapsed() * 0.001)
@@ -142,6 +233,24 @@ BrainModelCiftiCorrelationMatrix::execute() throw (BrainModelAlgorithmException)
     */
    this->m_outputDimension = this->m_inputNumRows;
 
+   /*
+    * Compute the correlations and write them as they are computed
+    */
+   if (this->m_streamOutputFlag) {
+      QTime corrTimer;
+      corrTimer.start();
+      
+      this->computeCorrelationsToFile();
+      
+      if (timingFlag) {
+         std::cout << "Computed and wrote correlations in "
+                   << (corrTimer.elapsed() * 0.001)
+                   << " seconds."
+                   << std::endl;
+      }
+      return;
+   }
+   
    /*
     * Create the output metric file
     */
@@ -187,6 +296,14 @@ BrainModelCiftiCorrelationMatrix::loadDataValues()
     * Create and load the data values.
     */
    CiftiMatrix *matrix=  m_inputCiftiFile->getCiftiMatrix();
+   if (matrix->getCacheLevel() == ON_DISK) {
+      //
+      // Rows of the memory mapped matrix are demeaned and
+      // normalized one block at a time as they are needed
+      //
+      this->m_onDiskMatrix = matrix;
+      return;
+   }
    matrix->setCopyData(false);
    std::vector <int> dimensions;
    matrix->getMatrixData(this->m_dataValues,dimensions);   
@@ -199,6 +316,9 @@ BrainModelCiftiCorrelationMatrix::loadDataValues()
 CiftiFile* 
 BrainModelCiftiCorrelationMatrix::getOutputCiftiFile() 
 {
+   if (this->m_streamOutputFlag) {
+      return NULL;
+   }
    this->m_deleteOutputCiftiFlag = false;
    if(!this->m_outputCiftiFile)
    {
@@ -206,37 +326,11 @@ BrainModelCiftiCorrelationMatrix::getOutputCiftiFile()
       Nifti2Header header;
       CiftiXML xml;
       CiftiMatrix *matrix = new CiftiMatrix();
-      m_inputCiftiFile->getHeader(header);
-      m_inputCiftiFile->getCiftiXML(xml);
-      nifti_2_header head;
-      header.getHeaderStruct(head);
-      head.dim[6]=head.dim[5];//dimensions are square now
-      head.intent_code = NIFTI_INTENT_CONNECTIVITY_DENSE;
-      memset(head.intent_name,0x00,16);
-      memcpy(head.intent_name,"ConnDense",9);      
-      header.setHeaderStuct(head);
-      CiftiRootElement root;
-      xml.getXMLRoot(root);
-      int mmCount = root.m_matrices.at(0).m_matrixIndicesMap.size();
-      
-      std::vector <CiftiMatrixIndicesMapElement> mmTemp;
-      std::vector <CiftiMatrixIndicesMapElement> *mm;
-      mm = &(root.m_matrices.at(0).m_matrixIndicesMap);
-      for(int i = 0;i<mmCount;i++)
-      {
-         if(mm->at(i).m_indicesMapToDataType != CIFTI_INDEX_TYPE_TIME_POINTS)
-            mmTemp.push_back(mm->at(i));
-      }
-      *mm = mmTemp;
-      std::vector <int> appliesToDim (2,0);
-      appliesToDim[0]=0;
-      appliesToDim[1]=1;
-      mm->at(0).m_appliesToMatrixDimension = appliesToDim;
-      xml.setXMLRoot(root);
+      this->createOutputHeaderAndXML(header, xml);
       
       std::vector <int> dim (2,0);
-      dim[0]=head.dim[5];
-      dim[1]=head.dim[5];
+      dim[0]=this->m_outputDimension;
+      dim[1]=this->m_outputDimension;
       matrix->setCopyData(false);
       matrix->setMatrixData(this->m_outputDataArrayColumns[0],dim);
       this->m_outputCiftiFile->setHeader(header);
@@ -247,6 +341,42 @@ BrainModelCiftiCorrelationMatrix::getOutputCiftiFile()
    return this->m_outputCiftiFile;
 }
 
+/**
+ * create the header and XML of the output cifti file.
+ */
+void 
+BrainModelCiftiCorrelationMatrix::createOutputHeaderAndXML(Nifti2Header& header,
+                                                           CiftiXML& xml)
+{
+   m_inputCiftiFile->getHeader(header);
+   m_inputCiftiFile->getCiftiXML(xml);
+   nifti_2_header head;
+   header.getHeaderStruct(head);
+   head.dim[6]=head.dim[5];//dimensions are square now
+   head.intent_code = NIFTI_INTENT_CONNECTIVITY_DENSE;
+   memset(head.intent_name,0x00,16);
+   memcpy(head.intent_name,"ConnDense",9);      
+   header.setHeaderStuct(head);
+   CiftiRootElement root;
+   xml.getXMLRoot(root);
+   int mmCount = root.m_matrices.at(0).m_matrixIndicesMap.size();
+   
+   std::vector <CiftiMatrixIndicesMapElement> mmTemp;
+   std::vector <CiftiMatrixIndicesMapElement> *mm;
+   mm = &(root.m_matrices.at(0).m_matrixIndicesMap);
+   for(int i = 0;i<mmCount;i++)
+   {
+      if(mm->at(i).m_indicesMapToDataType != CIFTI_INDEX_TYPE_TIME_POINTS)
+         mmTemp.push_back(mm->at(i));
+   }
+   *mm = mmTemp;
+   std::vector <int> appliesToDim (2,0);
+   appliesToDim[0]=0;
+   appliesToDim[1]=1;
+   mm->at(0).m_appliesToMatrixDimension = appliesToDim;
+   xml.setXMLRoot(root);
+}
+
 /**
  * compute the means.
  */
@@ -285,6 +415,49 @@ BrainModelCiftiCorrelationMatrix::computeMeans()
    }
 }
 
+/**
+ * compute the means and sum-squared of the rows of the memory mapped
+ * matrix, reading one block of rows at a time.
+ */
+void 
+BrainModelCiftiCorrelationMatrix::computeMeansAndSumSquaredOnDisk() throw (BrainModelAlgorithmException)
+{
+   const long numRows = this->m_inputNumRows;
+   const long numCols = this->m_inputNumColumns;
+   this->m_rowMeans = new float[numRows];
+   this->m_rowSumSquared = new double[numRows];
+   
+   const long rowsPerBlock = CorrelationMatrixEngine::getTileSize();
+   std::vector<float> blockValues(rowsPerBlock * numCols);
+   for (long iBlock = 0; iBlock < numRows; iBlock += rowsPerBlock) {
+      const long numBlockRows = std::min(rowsPerBlock, numRows - iBlock);
+      try {
+         this->m_onDiskMatrix->getRows(&blockValues[0], iBlock, numBlockRows);
+      }
+      catch (CiftiFileException& e) {
+         throw BrainModelAlgorithmException(e.whatQString());
+      }
+      
+      for (long i = 0; i < numBlockRows; i++) {
+         const float* row = &blockValues[i * numCols];
+         double sum = 0.0;
+         for (long j = 0; j < numCols; j++) {
+            sum += row[j];
+         }
+         const double mean = sum / numCols;
+         
+         double ss = 0.0;
+         for (long j = 0; j < numCols; j++) {
+            const float f = row[j] - mean;
+            ss += (f * f);
+         }
+         
+         this->m_rowMeans[iBlock + i] = mean;
+         this->m_rowSumSquared[iBlock + i] = ss;
+      }
+   }
+}
+
 /**
  * compute the sum squared.  After this, the dataValues array
  * will contain the value after the mean has been subtracted. 
@@ -341,119 +514,143 @@ BrainModelCiftiCorrelationMatrix::computeSumSquared()
  * compute the correlations.
  */
 void 
-BrainModelCiftiCorrelationMatrix::computeCorrelations()
+BrainModelCiftiCorrelationMatrix::computeCorrelations() throw (BrainModelAlgorithmException)
 {
-   this->m_nextRowToProcess = -1;
-   
-#ifdef _OPENMP
-      if (this->m_parallelFlag) {
-         long numThreads = omp_get_max_threads();
-         if (numThreads > 1) {
-            #pragma omp parallel for
-            for (long i = 0; i < numThreads; i++) {
-               this->computeCorrelationsForRows();
-            }
-         }
-         else {
-            this->computeCorrelationsForRows();
-         }
-      }
-      else {
-         this->computeCorrelationsForRows();
+   if (this->m_onDiskMatrix != NULL) {
+      CiftiMatrixDemeanedRowSource rowSource(this->m_onDiskMatrix,
+                                             this->m_rowMeans);
+      CorrelationMatrixEngine engine(&rowSource,
+                                     this->m_rowSumSquared,
+                                     this->m_outputDimension,
+                                     this->m_inputNumColumns,
+                                     this->m_applyFisherZTransformFlag,
+                                     this->m_floatAccumulationFlag,
+                                     this->m_parallelFlag);
+      engine.computeCorrelationMatrix(this->m_outputDataArrayColumns);
+      if (rowSource.getReadErrorFlag()) {
+         throw BrainModelAlgorithmException("Failed to read rows of the input Cifti matrix.");
       }
-#else
-      this->computeCorrelationsForRows();
-#endif
-
+      return;
+   }
+   
+   CorrelationMatrixEngine engine(this->m_dataValues,
+                                  this->m_rowSumSquared,
+                                  this->m_outputDimension,
+                                  this->m_inputNumColumns,
+                                  this->m_applyFisherZTransformFlag,
+                                  this->m_floatAccumulationFlag,
+                                  this->m_parallelFlag);
+   engine.computeCorrelationMatrix(this->m_outputDataArrayColumns);
 }
 
 /**
- * Sompute correlations for rows until there are no more rows to process.
- * Since the correlation matrix is symmetric, we only need to calculate
- * the lower half and can then copy the result to the upper half.
+ * compute the correlations in blocks of rows, each block is appended 
+ * to the output file after it is computed.
  */
 void 
-BrainModelCiftiCorrelationMatrix::computeCorrelationsForRows()
+BrainModelCiftiCorrelationMatrix::computeCorrelationsToFile() throw (BrainModelAlgorithmException)
 {
-   const double tinyValue = 1.0e-20;
-
-   const long numJ = this->m_outputDimension;
-   const long numCols = this->m_inputNumColumns;
-
-   while (true) {
-      long iRow = -1;
+   const long numRows = this->m_outputDimension;
+   const long tileSize = CorrelationMatrixEngine::getTileSize();
+   
+   //
+   // Use the memory not occupied by the input data for the block of rows
+   // (a memory mapped input matrix is not in memory)
+   //
+   double inputMegabytes = 0.0;
+   if (this->m_onDiskMatrix == NULL) {
+      inputMegabytes = (static_cast<double>(this->m_inputNumRows)
+                        * this->m_inputNumColumns * sizeof(float))
+                       / (1024.0 * 1024.0);
+   }
+   const double blockMegabytes = this->m_memoryLimitMegabytes - inputMegabytes;
+   const double rowMegabytes = (numRows * sizeof(float)) / (1024.0 * 1024.0);
+   long rowsPerBlock = static_cast<long>(blockMegabytes / rowMegabytes);
+   const long minimumRowsPerBlock = std::min(tileSize, numRows);
+   if (rowsPerBlock < minimumRowsPerBlock) {
+      const double minimumMegabytes = inputMegabytes + minimumRowsPerBlock * rowMegabytes;
+      throw BrainModelAlgorithmException("The memory limit of "
+                                         + QString::number(this->m_memoryLimitMegabytes)
+                                         + " megabytes is less than the "
+                                         + QString::number(static_cast<long>(std::ceil(minimumMegabytes)))
+                                         + " megabytes needed for the input data and a block of "
+                                         + QString::number(minimumRowsPerBlock)
+                                         + " rows.");
+   }
+   if (rowsPerBlock >= tileSize) {
+      rowsPerBlock = (rowsPerBlock / tileSize) * tileSize;
+   }
+   if (rowsPerBlock > numRows) {
+      rowsPerBlock = numRows;
+   }
+   if(DebugControl::getDebugOn()) std::cout << "Computing correlations in blocks of " << rowsPerBlock << " rows" << std::endl;
+   
+   CiftiFile outputHeaderFile;
+   QFile outputFile(this->m_outputCiftiFileName);
+   try {
+      Nifti2Header header;
+      CiftiXML xml;
+      this->createOutputHeaderAndXML(header, xml);
+      outputHeaderFile.setHeader(header);
+      outputHeaderFile.setCiftiXML(xml);
       
-      //
-      // Only one thread may execute this block at any time
-      //
-      #pragma omp critical
-      {
-         this->m_nextRowToProcess++;
-         iRow = this->m_nextRowToProcess;
-
-         if (timingFlag) {
-            if ((iRow % 1000) == 0) {
-               std::cout << "Processing row " << iRow << std::endl;
-            }
-         }
-      }  
-       
-      if (iRow >= this->m_outputDimension) {
-         break;
+      if (outputFile.open(QIODevice::WriteOnly) == false) {
+         throw BrainModelAlgorithmException("Unable to open "
+                                            + this->m_outputCiftiFileName
+                                            + " for writing.");
       }
-
-      //
-      // Compare with remaining rows
-      //
-      for (long jRow = iRow; jRow < numJ; jRow++) {
-         //
-         //
-         // diff of mean from col I multiplied by diff of mean from column J
-         //
-         double sumSquaredBothColumns = 0.0;
-         for (long jCol = 0; jCol < numCols; jCol++) {
-            const long indxI = iRow * numCols + jCol;
-            const long indxJ = jRow * numCols + jCol;
-            sumSquaredBothColumns 
-               += (this->m_dataValues[indxI] * this->m_dataValues[indxJ]);
-         }
-         
-         //
-         // Compute correlation coefficient
-         //
-         const double denominator = this->m_rowSumSquared[iRow]
-                                  * this->m_rowSumSquared[jRow];
-         float r = 0.0;
-         if (denominator != 0.0) {
-            double sd = std::sqrt(denominator);
-            r = sumSquaredBothColumns / sd;
-         }
-         else {
-            r = sumSquaredBothColumns / tinyValue;
-         }
-         
-         /*
-          * Apply the Fisher Z-Transform?
-          */
-         if (this->m_applyFisherZTransformFlag) {
-            float denom = (1.0 - r);
-            if (denom != 0.0) {
-               r = 0.5 * std::log((1.0 + r) / denom);
-            }
-            else {
-               r = 0.5 * std::log((1.0 + r) / tinyValue);
-            }
+      outputHeaderFile.writeHeaderAndExtension(outputFile);
+   }
+   catch (CiftiFileException& e) {
+      throw BrainModelAlgorithmException(e.whatQString());
+   }
+   
+   CiftiMatrixDemeanedRowSource rowSource(this->m_onDiskMatrix,
+                                          this->m_rowMeans);
+   CorrelationMatrixEngine* engine = NULL;
+   if (this->m_onDiskMatrix != NULL) {
+      engine = new CorrelationMatrixEngine(&rowSource,
+                                           this->m_rowSumSquared,
+                                           numRows,
+                                           this->m_inputNumColumns,
+                                           this->m_applyFisherZTransformFlag,
+                                           this->m_floatAccumulationFlag,
+                                           this->m_parallelFlag);
+   }
+   else {
+      engine = new CorrelationMatrixEngine(this->m_dataValues,
+                                           this->m_rowSumSquared,
+                                           numRows,
+                                           this->m_inputNumColumns,
+                                           this->m_applyFisherZTransformFlag,
+                                           this->m_floatAccumulationFlag,
+                                           this->m_parallelFlag);
+   }
+   
+   std::vector<float> blockValues(rowsPerBlock * numRows);
+   for (long iRow = 0; iRow < numRows; iRow += rowsPerBlock) {
+      const long numBlockRows = std::min(rowsPerBlock, numRows - iRow);
+      engine->computeCorrelationsForRows(iRow, numBlockRows, &blockValues[0]);
+      
+      QString errorMessage;
+      if (rowSource.getReadErrorFlag()) {
+         errorMessage = "Failed to read rows of the input Cifti matrix.";
+      }
+      else {
+         const qint64 numBytes = static_cast<qint64>(numBlockRows) * numRows * sizeof(float);
+         if (outputFile.write((const char*)&blockValues[0], numBytes) != numBytes) {
+            errorMessage = "Failed to write correlations to "
+                           + this->m_outputCiftiFileName;
          }
-
-         //
-         // Matrix is symmetric !!!!
-         //
-         //this->outputCiftiFile->setValue(iRow, jRow, r);
-         //this->outputCiftiFile->setValue(jRow, iRow, r);
-         *(this->m_outputDataArrayColumns[iRow] + jRow) = r;
-         *(this->m_outputDataArrayColumns[jRow] + iRow) = r;
+      }
+      if (errorMessage.isEmpty() == false) {
+         delete engine;
+         throw BrainModelAlgorithmException(errorMessage);
       }
    }
+   
+   delete engine;
+   outputFile.close();
 }
 
 /**
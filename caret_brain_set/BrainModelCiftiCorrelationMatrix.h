@@ -17,7 +17,19 @@ class BrainModelCiftiCorrelationMatrix : public BrainModelAlgorithm {
            BrainSet* bs,
            CiftiFile * inputCiftiFile,
            const bool applyFisherZTransformFlag,
-           const bool parallelFlag);
+           const bool parallelFlag,
+           const bool floatAccumulationFlag = false);
+      
+      // constructor for writing blocks of rows to the output file as they
+      // are computed (memory limit includes the input data)
+      BrainModelCiftiCorrelationMatrix(
+           BrainSet* bs,
+           CiftiFile * inputCiftiFile,
+           const QString& outputCiftiFileName,
+           const long memoryLimitMegabytes,
+           const bool applyFisherZTransformFlag,
+           const bool parallelFlag,
+           const bool floatAccumulationFlag = false);
       
       // destructor
       ~BrainModelCiftiCorrelationMatrix();
@@ -26,7 +38,7 @@ class BrainModelCiftiCorrelationMatrix : public BrainModelAlgorithm {
       void execute() throw (BrainModelAlgorithmException);                                                
          
       // get the output metric file (if called caller is reponsible for DELETING
-      // returned metric file.
+      // returned metric file.  NULL if output was written as it was computed.
       CiftiFile* getOutputCiftiFile();
 
    private:
@@ -46,10 +58,16 @@ class BrainModelCiftiCorrelationMatrix : public BrainModelAlgorithm {
       void computeSumSquared();
       
       // compute the correlations
-      void computeCorrelations();
+      void computeCorrelations() throw (BrainModelAlgorithmException);
+      
+      // compute the correlations in blocks of rows that are written to the output file
+      void computeCorrelationsToFile() throw (BrainModelAlgorithmException);
       
-      // compute correlations for rows until there are no more rows to process
-      void computeCorrelationsForRows();
+      // compute the means and sum-squared of the rows of the memory mapped matrix
+      void computeMeansAndSumSquaredOnDisk() throw (BrainModelAlgorithmException);
+      
+      // create the header and XML of the output cifti file
+      void createOutputHeaderAndXML(Nifti2Header& header, CiftiXML& xml);
 
       QString m_inputCiftiFileName;
 
@@ -70,6 +88,9 @@ class BrainModelCiftiCorrelationMatrix : public BrainModelAlgorithm {
       // All values in one-dim array
       float* m_dataValues;
       
+      // memory mapped input matrix, rows are read as they are needed (NULL if in memory)
+      CiftiMatrix* m_onDiskMatrix;
+      
       // mean of all column values for each row
       float* m_rowMeans;
       
@@ -80,10 +101,16 @@ class BrainModelCiftiCorrelationMatrix : public BrainModelAlgorithm {
       
       bool m_deleteOutputCiftiFlag;
       
-      long m_nextRowToProcess;
-      
       const bool m_parallelFlag;
       
+      const bool m_floatAccumulationFlag;
+      
+      // output is written as it is computed
+      bool m_streamOutputFlag;
+      
+      // memory limit when output is written as it is computed
+      long m_memoryLimitMegabytes;
+      
 };
 
 #endif //  __BRAIN_MODEL_SURFACE_METRIC_CORRELATION_MATRIX_H__
@@ -57,6 +57,7 @@
 #include "BorderProjectionFile.h"
 #include "BrainModelSurface.h"
 #include "BrainModelSurfaceCurvature.h"
+#include "BrainModelSurfaceMultiresolutionSmoothing.h"
 #include "BrainModelSurfaceROINodeSelection.h"
 #include "BrainModelSurfacePointLocator.h"
 #include "BrainModelSurfacePointProjector.h"
@@ -78,6 +79,7 @@
 #include "TopologyFile.h"
 #include "TopologyHelper.h"
 #include "TransformationMatrixFile.h"
+#include "TriangleKernels.h"
 #include "VectorFile.h"
 
 /**
@@ -1651,30 +1653,18 @@ BrainModelSurface::computeNormals(const float* coordsIn, bool averageNormals)
          // node normals are average of the node's tiles' normals
          //
          const int numTiles = topology->getNumberOfTiles();
-         for (int i = 0; i < numTiles; i++) {
-            int va, vb, vc; 
-            topology->getTile(i, va, vb, vc);            
-            
-            const int va3 = va * 3;
-            const int vb3 = vb * 3;
-            const int vc3 = vc * 3;
-            
-            float tileNormal[3];
-            MathUtilities::computeNormal((float*)&coords[va3],
-                                       (float*)&coords[vb3],
-                                       (float*)&coords[vc3],
-                                       tileNormal);
-            normals[va3]   += tileNormal[0];
-            normals[va3+1] += tileNormal[1];
-            normals[va3+2] += tileNormal[2];
-            normals[vb3]   += tileNormal[0];
-            normals[vb3+1] += tileNormal[1];
-            normals[vb3+2] += tileNormal[2];
-            normals[vc3]   += tileNormal[0];
-            normals[vc3+1] += tileNormal[1];
-            normals[vc3+2] += tileNormal[2];
+         if (numTiles > 0) {
+            const int* tiles = topology->getTile(0);
+            std::vector<float> tileNormals(numTiles * 3);
+            TriangleKernels::computeTriangleNormals(coords, tiles, numTiles, &tileNormals[0]);
+            TriangleKernels::accumulateTriangleVectorsToPoints(tiles, numTiles, 
+                                                               &tileNormals[0], 
+                                                               &normals[0]);
          }
          
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 4096)
+#endif
          for (int k = 0; k < numCoords; k++) {
             const int k3 = k * 3;
                MathUtilities::normalize(&normals[k3]);//checks for length 0 vectors, so we don't need to track number that contribute
@@ -1684,15 +1674,17 @@ BrainModelSurface::computeNormals(const float* coordsIn, bool averageNormals)
          {
             float* normalSum = new float[3 * numCoords];
          	const TopologyHelper* myhelper = topology->getTopologyHelper(false, true, false);
-         	std::vector<int> neighbors;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 4096)
+#endif
             for (int i = 0; i < numCoords; ++i)
             {
                const int i3 = i * 3;
                normalSum[i3] = normals[i3];
                normalSum[i3 + 1] = normals[i3 + 1];
                normalSum[i3 + 2] = normals[i3 + 2];
-               myhelper->getNodeNeighbors(i, neighbors);
-               const int numNeigh = (int)neighbors.size();
+               int numNeigh = 0;
+               const int* neighbors = myhelper->getNodeNeighbors(i, numNeigh);
                for (int j = 0; j < numNeigh; ++j)
                {
                   const int node3 = neighbors[j] * 3;
@@ -1955,91 +1947,24 @@ BrainModelSurface::smoothSurfaceUsingCurvature(const float strength,
                                                const int numSteps,
                                                const float curvatureMaximum)
 {
-   QTime timer;
-   timer.start();
-
-   const int numNodes = coordinates.getNumberOfCoordinates();
-   int curvatureCounter = 1;
-   const int updateCurvatureEveryX = 1;
-   SurfaceShapeFile ssf;
-   ssf.setNumberOfNodesAndColumns(numNodes, 1);
-   const int curvatureColumn = 0;
-   
-   float* coords = coordinates.getCoordinate(0);
-   
-   const TopologyHelper* th = topology->getTopologyHelper(false, true, false);
-
-   for (int steps = 1; steps <= numSteps; steps++) {
-      //
-      // Determine if curvature should be generated
-      //
-      bool doCurvature = false;
-      if (steps == 1) {
-         doCurvature = true;
-      }
-      if (updateCurvatureEveryX > 0) {
-         if (curvatureCounter == updateCurvatureEveryX) {
-            doCurvature = true;
-            curvatureCounter = 1;
-         }
-         else {
-            curvatureCounter++;
-         }
-      }
-      
-      if (doCurvature) {
-         //
-         // Update the surface curvature (does normals too)
-         //
-         BrainModelSurfaceCurvature bmsc(brainSet,
-                                this,
-                                &ssf,
-                                curvatureColumn,
-                                BrainModelSurfaceCurvature::CURVATURE_COLUMN_DO_NOT_GENERATE,
-                                "meanCurv",
-                                "");
-         try {
-            bmsc.execute();
-         }
-         catch (BrainModelAlgorithmException&) {
-         }
-      }
-      else {
-         computeNormals();
-      }
-      
-      //
-      // Adjust each nodes position
-      //
-      for (int i = 0; i < numNodes; i++) {
-         if (th->getNodeHasNeighbors(i)) {
-            float curv = ssf.getValue(i, curvatureColumn);
-            curv = std::max(curv, -curvatureMaximum);
-            curv = std::min(curv,  curvatureMaximum);
-            float* norm = &normals[i*3];
-            const float delta[3] = {
-               norm[0] * curv * strength,
-               norm[1] * curv * strength,
-               norm[2] * curv * strength,
-            };
-         
-            coords[i*3]   += delta[0];
-            coords[i*3+1] += delta[1];
-            coords[i*3+2] += delta[2];
-         }
-      }
-      coordinates.setModified();
-      
-      //
-      // Possibly redraw this brain model
-      //
-      brainSet->drawBrainModel(this, steps);
-      
-      std::cout << "Iter: " << steps << std::endl;
+   BrainModelSurfaceSmoothing smoothObject(brainSet,
+                                           this,
+                                           BrainModelSurfaceSmoothing::SMOOTHING_TYPE_CURVATURE,
+                                           strength,
+                                           numSteps,
+                                           0,
+                                           0,
+                                           NULL,
+                                           NULL,
+                                           0,
+                                           0);
+   smoothObject.setCurvatureMaximum(curvatureMaximum);
+   try {
+      smoothObject.execute();
    }
-   
-   std::cout << "time: " << (static_cast<float>(timer.elapsed()) / 1000.0) 
-             << std::endl;
+   catch (BrainModelAlgorithmException&) {
+   }
+   computeNormals();
 }
 
 /**
@@ -3365,14 +3290,13 @@ BrainModelSurface::getSurfaceArea(const TopologyFile* tfin) const
    const TopologyFile* tf = ((tfin != NULL) ? tfin : topology);
    
    const int numTiles = tf->getNumberOfTiles();
-   for (int i = 0; i < numTiles; i++) {
-      const int* nodes = tf->getTile(i);
-      const float* p1 = coordinates.getCoordinate(nodes[0]);
-      const float* p2 = coordinates.getCoordinate(nodes[1]);
-      const float* p3 = coordinates.getCoordinate(nodes[2]);
-      area += MathUtilities::triangleArea((float*)p1,
-                                        (float*)p2,
-                                        (float*)p3);
+   if ((numTiles > 0) && (coordinates.getNumberOfCoordinates() > 0)) {
+      std::vector<float> tileAreas(numTiles);
+      TriangleKernels::computeTriangleAreas(coordinates.getCoordinate(0),
+                                            tf->getTile(0),
+                                            numTiles,
+                                            &tileAreas[0]);
+      area = TriangleKernels::sumValues(&tileAreas[0], numTiles);
    }
       
    return area;
@@ -3419,8 +3343,11 @@ BrainModelSurface::getAreaOfAllTiles(std::vector<float>& tileAreas) const
    if (topology != NULL) {
       const int numTiles = topology->getNumberOfTiles();
       tileAreas.resize(numTiles);
-      for (int i = 0; i < numTiles; i++) {
-         tileAreas[i] = getTileArea(i);
+      if ((numTiles > 0) && (coordinates.getNumberOfCoordinates() > 0)) {
+         TriangleKernels::computeTriangleAreas(coordinates.getCoordinate(0),
+                                               topology->getTile(0),
+                                               numTiles,
+                                               &tileAreas[0]);
       }
    }
 }
@@ -3445,13 +3372,11 @@ BrainModelSurface::getAreaOfAllNodes(std::vector<float>& nodeAreas) const
 
       const int numTiles = static_cast<int>(tileAreas.size());
       if (numTiles > 0) {
-         for (int i = 0; i < numTiles; i++) {
-            const int* nodes = topology->getTile(i);
-            const float oneThirdTileArea = tileAreas[i] * 0.33333;
-            nodeAreas[nodes[0]] += oneThirdTileArea;
-            nodeAreas[nodes[1]] += oneThirdTileArea;
-            nodeAreas[nodes[2]] += oneThirdTileArea;
-         }
+         TriangleKernels::accumulateTriangleValuesToPoints(topology->getTile(0),
+                                                           numTiles,
+                                                           &tileAreas[0],
+                                                           0.33333,
+                                                           &nodeAreas[0]);
       }
    }
 }
@@ -4003,9 +3928,8 @@ BrainModelSurface::getMeanDistanceBetweenNodes(BrainModelSurfaceROINodeSelection
          doNode = surfaceROI->getNodeSelected(i);
       }
       if (doNode) {
-         std::vector<int> neighbors;
-         helper->getNodeNeighbors(i, neighbors);
-         const int numNeighbors = static_cast<int>(neighbors.size());
+         int numNeighbors = 0;
+         const int* neighbors = helper->getNodeNeighbors(i, numNeighbors);
          
          float dist = 0.0;
          int neighCount = 0;
@@ -4043,186 +3967,21 @@ BrainModelSurface::linearSmoothing(const float strength, const int iterations,
                                    const std::vector<bool>* smoothOnlyTheseNodes,
                                    const int projectToSphereEveryXIterations)
 {
-   PreferencesFile* pf = brainSet->getPreferencesFile();
-   const int numThreads = pf->getMaximumNumberOfThreads();
-   
-   if (numThreads > 0) {
-      BrainModelSurfaceSmoothing smoothObject(brainSet,
-                                              this,
-                                              BrainModelSurfaceSmoothing::SMOOTHING_TYPE_LINEAR,
-                                              strength,
-                                              iterations,
-                                              smoothEdgesEveryXIterations,
-                                              0,
-                                              smoothOnlyTheseNodes,
-                                              NULL,
-                                              projectToSphereEveryXIterations,
-                                              numThreads);
-      try {
-         smoothObject.execute();
-      }
-      catch (BrainModelAlgorithmException&) {
-      }
-      
-      return;
-   }
-   
-/*
-   appendToCoordinateFileComment("Linear Smoothing: ");
-   appendToCoordinateFileComment(StringUtilities::fromNumber(strength));
-   appendToCoordinateFileComment(" ");
-   appendToCoordinateFileComment(StringUtilities::fromNumber(iterations));
-   appendToCoordinateFileComment(" ");
-   appendToCoordinateFileComment(StringUtilities::fromNumber(smoothEdgesEveryXIterations));
-   appendToCoordinateFileComment("\n");
-*/
-   
-   //
-   // Update node classification
-   //
-   brainSet->classifyNodes(getTopologyFile(), true);
-   
-   const float invStrength = 1.0 - strength;
-   
-   const int numNodes = getNumberOfNodes();
-   if (numNodes <= 0) {
-      return;
-   }
-   
-   QTime timer;
-   timer.start();
-   const TopologyHelper* helper = topology->getTopologyHelper(false, true, false);
-   if (DebugControl::getDebugOn()) {
-      std::cout << "Topology Helper time: " << (static_cast<float>(timer.elapsed()) / 1000.0) << std::endl;
-   }
-   
-   std::vector<bool> interiorNode(numNodes);
-   for (int i = 0; i < numNodes; i++) {
-      const BrainSetNodeAttribute* bna = brainSet->getNodeAttributes(i);
-      interiorNode[i] = (bna->getClassification() == 
-                         BrainSetNodeAttribute::CLASSIFICATION_TYPE_INTERIOR);
-   }
-   
-   //
-   // See smoothing is limited to a subset of nodes
-   //
-   bool smoothSubsetOfNodes = false;
-   if (smoothOnlyTheseNodes != NULL) {
-      if (static_cast<int>(smoothOnlyTheseNodes->size()) == numNodes) {
-         smoothSubsetOfNodes = true;
-      }
-   }
-   
-   //
-   // Get the radius in the event that this is a sphere
-   //
-   const float sphereRadius = getSphericalSurfaceRadius();
-   
-   //
-   // Reduce calls to coord file
-   //
-   float* nodeCoords = new float[numNodes * 3];
-   float* nodes      = new float[numNodes * 3];
-   for (int i = 0; i < numNodes; i++) {
-      coordinates.getCoordinate(i, &nodeCoords[i*3]);
-   }
-   
-   //
-   // Do 1 to iterations so that modulus check for edge smoothing works
-   //
-   for (int k = 1; k <= iterations; k++) {
-      //std::vector<float> nodes(numNodes * 3);
-      
-      //
-      // See if edges should be smoothed
-      //
-      bool smoothEdges = false;
-      if (smoothEdgesEveryXIterations > 0) {
-         if ((k % smoothEdgesEveryXIterations) == 0) {
-            smoothEdges = true;
-         }
-      }
-      
-      for (int i = 0; i < numNodes; i++) {
-         //coordinates.getCoordinate(i, &nodes[i*3]);
-         nodes[i*3]   = nodeCoords[i*3];
-         nodes[i*3+1] = nodeCoords[i*3+1];
-         nodes[i*3+2] = nodeCoords[i*3+2];
-         
-         bool smoothIt = true;
-         if (interiorNode[i] == false) {
-            smoothIt = smoothEdges;
-         }
-         
-         if (smoothIt && smoothSubsetOfNodes) {
-            smoothIt = (*smoothOnlyTheseNodes)[i];
-         }
-         
-         if (smoothIt) {   
-            //std::vector<int> neighbors;
-            //helper->getNodeNeighbors(i, neighbors);
-            //const int numNeighbors = static_cast<int>(neighbors.size());
-            
-            int numNeighbors;
-            const int* neighbors = helper->getNodeNeighbors(i, numNeighbors);
-            
-            if (numNeighbors > 0) {
-               float neighXYZ[3] = { 0.0, 0.0, 0.0 };
-               for (int j = 0; j < numNeighbors; j++) {
-                  //float np[3];
-                  //coordinates.getCoordinate(neighbors[j], np);
-                  const int n = neighbors[j];
-                  neighXYZ[0] += nodeCoords[n*3]; //np[0];
-                  neighXYZ[1] += nodeCoords[n*3+1]; //np[1];
-                  neighXYZ[2] += nodeCoords[n*3+2]; //np[2];
-               }
-               
-               const float floatNumNeigh = numNeighbors;
-               neighXYZ[0] /= floatNumNeigh;
-               neighXYZ[1] /= floatNumNeigh;
-               neighXYZ[2] /= floatNumNeigh;
-               
-               
-               nodes[i*3]   = nodeCoords[i*3]   * invStrength + neighXYZ[0] * strength;
-               nodes[i*3+1] = nodeCoords[i*3+1] * invStrength + neighXYZ[1] * strength;
-               nodes[i*3+2] = nodeCoords[i*3+2] * invStrength + neighXYZ[2] * strength;
-            }
-         }
-      }
-         
-      //
-      // If the surface should be projected to a sphere
-      //
-      if (projectToSphereEveryXIterations > 0) {
-         if ((k % projectToSphereEveryXIterations) == 0) {
-            for (int j = 0; j < numNodes; j++) {
-               MathUtilities::setVectorLength(&nodes[j*3], sphereRadius);
-            }
-         }
-      }
-      
-      for (int i = 0; i < numNodes; i++) {
-         nodeCoords[i*3]   = nodes[i*3];
-         nodeCoords[i*3+1] = nodes[i*3+1];
-         nodeCoords[i*3+2] = nodes[i*3+2];
-         coordinates.setCoordinate(i, &nodes[i*3]);
-      }    
-      
-      //
-      // Update the displayed brain model
-      //
-      brainSet->drawBrainModel(this, k);
+   BrainModelSurfaceSmoothing smoothObject(brainSet,
+                                           this,
+                                           BrainModelSurfaceSmoothing::SMOOTHING_TYPE_LINEAR,
+                                           strength,
+                                           iterations,
+                                           smoothEdgesEveryXIterations,
+                                           0,
+                                           smoothOnlyTheseNodes,
+                                           NULL,
+                                           projectToSphereEveryXIterations,
+                                           0);
+   try {
+      smoothObject.execute();
    }
-   
-   //for (int i = 0; i < numNodes; i++) {
-   //   coordinates.setCoordinate(i, &nodeCoords[i*3]);
-   //}
-   
-   delete[] nodes;
-   delete[] nodeCoords;
-
-   if (DebugControl::getDebugOn()) {
-      std::cout << "Total time: " << (static_cast<float>(timer.elapsed()) / 1000.0) << std::endl;
+   catch (BrainModelAlgorithmException&) {
    }
 }
 
@@ -4238,225 +3997,22 @@ BrainModelSurface::arealSmoothing(const float strength, const int iterations,
                                   const std::vector<bool>* smoothOnlyTheseNodes,
                                   const int projectToSphereEveryXIterations)
 {
-   PreferencesFile* pf = brainSet->getPreferencesFile();
-   const int numThreads = pf->getMaximumNumberOfThreads();
-   
-   if (numThreads > 0) {
-      BrainModelSurfaceSmoothing smoothObject(brainSet,
-                                              this,
-                                              BrainModelSurfaceSmoothing::SMOOTHING_TYPE_AREAL,
-                                              strength,
-                                              iterations,
-                                              smoothEdgesEveryXIterations,
-                                              0,
-                                              smoothOnlyTheseNodes,
-                                              NULL,
-                                              projectToSphereEveryXIterations,
-                                              numThreads);
-      try {
-         smoothObject.execute();
-      }
-      catch (BrainModelAlgorithmException&) {
-      }
-      
-      return;
-   }
-   
-/*
-   appendToCoordinateFileComment("Areal Smoothing: ");
-   appendToCoordinateFileComment(StringUtilities::fromNumber(strength));
-   appendToCoordinateFileComment(" ");
-   appendToCoordinateFileComment(StringUtilities::fromNumber(iterations));
-   appendToCoordinateFileComment(" ");
-   appendToCoordinateFileComment(StringUtilities::fromNumber(smoothEdgesEveryXIterations));
-   appendToCoordinateFileComment("\n");
-*/
-
-   //
-   // Update node classification
-   //
-   brainSet->classifyNodes(getTopologyFile(), true);
-   
-   const float invStrength = 1.0 - strength;
-   
-   const int numNodes = getNumberOfNodes();
-   
-   if ((numNodes <= 0) || (topology->getNumberOfTiles() <= 0)) {
-      return;
-   }
-   
-   QTime timer;
-   timer.start();
-   const TopologyHelper* helper = topology->getTopologyHelper(false, true, true);
-   if (DebugControl::getDebugOn()) {
-      std::cout << "Topology Helper time: " << (static_cast<float>(timer.elapsed()) / 1000.0) << std::endl;
-   }
-   
-   int* interiorNode = new int[numNodes];
-   for (int i = 0; i < numNodes; i++) {
-      const BrainSetNodeAttribute* bna = brainSet->getNodeAttributes(i);
-      interiorNode[i] = (bna->getClassification() == 
-                         BrainSetNodeAttribute::CLASSIFICATION_TYPE_INTERIOR);
-   }
-   
-   //
-   // See smoothing is limited to a subset of nodes
-   //
-   bool smoothSubsetOfNodes = false;
-   if (smoothOnlyTheseNodes != NULL) {
-      if (static_cast<int>(smoothOnlyTheseNodes->size()) == numNodes) {
-         smoothSubsetOfNodes = true;
-      }
-   }
-   
-   //
-   // Get the radius in the event that this is a sphere
-   //
-   const float sphereRadius = getSphericalSurfaceRadius();
-   
-   //
-   // Reduce calls to coord file
-   //
-   float* nodeCoords = new float[numNodes * 3];
-   float* nodes      = new float[numNodes * 3];
-   for (int i = 0; i < numNodes; i++) {
-      coordinates.getCoordinate(i, &nodeCoords[i*3]);
+   BrainModelSurfaceSmoothing smoothObject(brainSet,
+                                           this,
+                                           BrainModelSurfaceSmoothing::SMOOTHING_TYPE_AREAL,
+                                           strength,
+                                           iterations,
+                                           smoothEdgesEveryXIterations,
+                                           0,
+                                           smoothOnlyTheseNodes,
+                                           NULL,
+                                           projectToSphereEveryXIterations,
+                                           0);
+   try {
+      smoothObject.execute();
    }
-   
-   // Do 1 to iterations so that modulus check for edge smoothing works
-   //
-   for (int k = 1; k <= iterations; k++) {
-      //std::vector<float> nodes(numNodes * 3);
-      
-      //
-      // See if edges should be smoothed
-      //
-      bool smoothEdges = false;
-      if (smoothEdgesEveryXIterations > 0) {
-         if ((k % smoothEdgesEveryXIterations) == 0) {
-            smoothEdges = true;
-         }
-      }
-      
-      for (int i = 0; i < numNodes; i++) {
-         nodes[i*3]   = nodeCoords[i*3];
-         nodes[i*3+1] = nodeCoords[i*3+1];
-         nodes[i*3+2] = nodeCoords[i*3+2];
-        // coordinates.getCoordinate(i, &nodes[i*3]);
-      }
-      
-      for (int i = 0; i < numNodes; i++) {
-         bool smoothIt = true;
-         if (interiorNode[i] == false) {
-            smoothIt = smoothEdges;
-         }
-         
-         if (smoothIt && smoothSubsetOfNodes) {
-            smoothIt = (*smoothOnlyTheseNodes)[i];
-         }
-         
-         if (smoothIt) {   
-            //std::vector<int> neighbors;
-            //helper->getNodeNeighbors(i, neighbors);
-            //const int numNeighbors = static_cast<int>(neighbors.size());
-            
-            int numNeighbors;
-            const int* neighbors = helper->getNodeNeighbors(i, numNeighbors);
-            
-            if (numNeighbors > 1) {
-               
-               std::vector<float> tileAreas(numNeighbors);
-               std::vector<float> tileCenters(numNeighbors*3);
-               float totalArea = 0.0;
-               for (int j = 0; j < numNeighbors; j++) {
-               
-                  //
-                  // get 2 consecutive neighbors of this node
-                  const int n1 = neighbors[j];
-                  int next = j + 1;
-                  if (next >= numNeighbors) {
-                     next = 0;
-                  }
-                  const int n2 = neighbors[next];
-               
-                  //
-                  // Area of the triangle
-                  //
-                  const float area = MathUtilities::triangleArea(&nodeCoords[i*3],
-                                                               &nodeCoords[n1*3], &nodeCoords[n2*3]);
-                  tileAreas[j] = area;
-                  totalArea += area;
-                  
-                  //
-                  // Save center of this tile
-                  //
-                  for (int k = 0; k < 3; k++) {
-                     float p = (nodeCoords[i*3+k] + nodeCoords[n1*3+k] + nodeCoords[n2*3+k]) / 3.0;
-                     tileCenters[j*3+k] = p;
-                  }
-               }
-                  
-               //
-               // Compute the influence of the neighboring nodes
-               //
-               float xa = 0.0;
-               float ya = 0.0;
-               float za = 0.0;
-               
-               for (int j = 0; j < numNeighbors; j++) {
-                  if (tileAreas[j] > 0.0) {
-                     const float weight = tileAreas[j] / totalArea;
-                     xa += weight * tileCenters[j*3];
-                     ya += weight * tileCenters[j*3+1];
-                     za += weight * tileCenters[j*3+2];
-                  }
-               }
-
-               //
-               // Update the nodes position
-               //
-               nodes[i*3]   = nodeCoords[i*3]   * invStrength + xa * strength;
-               nodes[i*3+1] = nodeCoords[i*3+1] * invStrength + ya * strength;
-               nodes[i*3+2] = nodeCoords[i*3+2] * invStrength + za * strength;
-            }
-         }
-      }
-         
-      //
-      // If the surface should be projected to a sphere
-      //
-      if (projectToSphereEveryXIterations > 0) {
-         if ((k % projectToSphereEveryXIterations) == 0) {
-            for (int j = 0; j < numNodes; j++) {
-               MathUtilities::setVectorLength(&nodes[j*3], sphereRadius);
-            }
-         }
-      }
-      
-      for (int i = 0; i < numNodes; i++) {
-         nodeCoords[i*3]   = nodes[i*3];
-         nodeCoords[i*3+1] = nodes[i*3+1];
-         nodeCoords[i*3+2] = nodes[i*3+2];
-         coordinates.setCoordinate(i, &nodes[i*3]);
-      } 
-      
-      //
-      // Update the displayed brain model
-      //
-      brainSet->drawBrainModel(this, k);
+   catch (BrainModelAlgorithmException&) {
    }
-   
-   //for (int i = 0; i < numNodes; i++) {
-   //   coordinates.setCoordinate(i, &nodeCoords[i*3]);
-   //}
-   
-   delete[] nodes;
-   delete[] nodeCoords;
-   delete[] interiorNode;
-   
-   //if (DebugControl::getDebugOn()) {
-      std::cout << "Total time: " << (static_cast<float>(timer.elapsed()) / 1000.0) << std::endl;
-   //}
 }
 
 /**
@@ -4691,9 +4247,11 @@ BrainModelSurface::smoothOutFlatSurfaceOverlap(const float strength,
             for (int j = 0 ; j < numNearbyNodes; j++) {
                const int node = nearbyNodes[j];
                if (node != i) {
-                  std::vector<int> tiles;
-                  topologyHelper->getNodeTiles(node, tiles);
-                  tilesToCheck.insert(tiles.begin(), tiles.end());
+                  int numTiles = 0;
+                  const int* tiles = topologyHelper->getNodeTiles(node, numTiles);
+                  if (numTiles > 0) {
+                     tilesToCheck.insert(tiles, tiles + numTiles);
+                  }
                }
             }
             
@@ -4786,32 +4344,6 @@ BrainModelSurface::smoothOutFlatSurfaceOverlap(const float strength,
    return surfaceWasSmoothed;
 }
 
-/// Keeps track of info for nodes for landmark neighbors
-class NodeInfo {
-   public:
-      //
-      // Three types of nodes
-      //
-      enum NODE_TYPE {
-         NODE_NORMAL,
-         NODE_LANDMARK,
-         NODE_LANDMARK_NEIGHBOR 
-      };
-
-      float xyz[3];
-      float offset[3];
-      NODE_TYPE nodeType;
-      int   numLandmarkNeighbors;
-      
-      NodeInfo() {
-         xyz[0] = xyz[1] = xyz[2] = 0.0;
-         offset[0] = offset[1] = offset[2] = 0;
-         nodeType = NODE_NORMAL;
-         numLandmarkNeighbors = 0;
-      }
-      
-};
-
 /**
  * Performed landmark constrained smoothing.  
  */
@@ -4821,212 +4353,28 @@ BrainModelSurface::landmarkConstrainedSmoothing(const float strength,
                                                 const std::vector<bool>& landmarkNodeFlag,
                                                 const int projectToSphereEveryXIterations)
 {  
-   PreferencesFile* pf = brainSet->getPreferencesFile();
-   const int numThreads = pf->getMaximumNumberOfThreads();
-   if (numThreads > 0) {
-      BrainModelSurfaceSmoothing smoothObject(brainSet,
-                                              this,
-                                              BrainModelSurfaceSmoothing::SMOOTHING_TYPE_LANDMARK_CONSTRAINED,
-                                              strength,
-                                              iterations,
-                                              0,
-                                              0,
-                                              NULL,
-                                              &landmarkNodeFlag,
-                                              projectToSphereEveryXIterations,
-                                              numThreads);
-      try {
-         smoothObject.execute();
-      }
-      catch (BrainModelAlgorithmException&) {
-      }
-      
-      return;
-   }
-   
-   const float inverseStrength = 1.0 - strength;
-   
-   const int numNodes = getNumberOfNodes();
-   const TopologyHelper* helper = topology->getTopologyHelper(false, true, true);
-
-   std::vector<NodeInfo> nodeInfo(numNodes);
-   
-   float scale = 0.0;
-   bool  haveScale = false;
-      
    appendToCoordinateFileComment("Landmark Constrained Smoothing: ");
    appendToCoordinateFileComment(StringUtilities::fromNumber(strength));
    appendToCoordinateFileComment(" ");
    appendToCoordinateFileComment(StringUtilities::fromNumber(iterations));
    appendToCoordinateFileComment("\n");
 
-   //
-   // Set node info for all nodes
-   //
-   for (int i = 0; i < numNodes; i++) {
-      //
-      // Is this node a landmarkd
-      //
-      if (landmarkNodeFlag[i]) {
-         nodeInfo[i].nodeType = NodeInfo::NODE_LANDMARK;
-      }
-      else {
-         //
-         // See if any of nodes neighbors are landmarks
-         //
-         std::vector<int> neighbors;
-         helper->getNodeNeighbors(i, neighbors);
-         for (int j = 0; j < static_cast<int>(neighbors.size()); j++) {
-            const int n = neighbors[j];
-            if (landmarkNodeFlag[n]) {
-               nodeInfo[i].numLandmarkNeighbors++;
-            }
-            else {
-               if (haveScale == false) {
-                  haveScale = true;
-                  scale = MathUtilities::distance3D(coordinates.getCoordinate(i),
-                                                    coordinates.getCoordinate(n))  /  std::sqrt(3.0);
-               }
-            }
-         }
-         if (nodeInfo[i].numLandmarkNeighbors > 0) {
-            nodeInfo[i].nodeType = NodeInfo::NODE_LANDMARK_NEIGHBOR;
-         }
-      }
+   BrainModelSurfaceSmoothing smoothObject(brainSet,
+                                           this,
+                                           BrainModelSurfaceSmoothing::SMOOTHING_TYPE_LANDMARK_CONSTRAINED,
+                                           strength,
+                                           iterations,
+                                           0,
+                                           0,
+                                           NULL,
+                                           &landmarkNodeFlag,
+                                           projectToSphereEveryXIterations,
+                                           0);
+   try {
+      smoothObject.execute();
+   }
+   catch (BrainModelAlgorithmException&) {
    }
-   
-   //
-   // smooth for specified number of iterations
-   //
-   for (int iter = 0; iter < iterations; iter++) {
-      
-      for (int i = 0; i < numNodes; i++) {
-         //
-         // Get the coordinate
-         //
-         coordinates.getCoordinate(i, nodeInfo[i].xyz);
-         
-         //
-         // Get the neighbors for this node
-         //
-         //std::vector<int> neighbors;
-         //helper->getNodeNeighbors(i, neighbors);
-         //const int numNeighbors = static_cast<int>(neighbors.size());
-         int numNeighbors;
-         const int* neighbors = helper->getNodeNeighbors(i, numNeighbors);
-         const float floatNumNeighbors = numNeighbors;
-         
-         //
-         // Ignore nodes without neighbors and ignore landmark nodes
-         //
-         if ((numNeighbors > 1) && (nodeInfo[i].nodeType != NodeInfo::NODE_LANDMARK)) {
-               
-            //
-            // Get average of neighbor coordinates
-            //
-            float sumx = 0.0, sumy = 0.0, sumz = 0.0;
-            for (int k = 0; k < numNeighbors; k++) {
-               const float* neighXYZ = coordinates.getCoordinate(neighbors[k]);
-               sumx += neighXYZ[0];
-               sumy += neighXYZ[1];
-               sumz += neighXYZ[2];
-            }
-            float meanX = sumx / floatNumNeighbors;
-            float meanY = sumy / floatNumNeighbors;
-            float meanZ = sumz / floatNumNeighbors;
-            
-            //
-            // Is this a node neither landmark nor landmark neighbor
-            //
-            if (nodeInfo[i].nodeType == NodeInfo::NODE_NORMAL) {
-               //
-               // Normal smoothing
-               //
-               nodeInfo[i].xyz[0] = nodeInfo[i].xyz[0] * inverseStrength
-                                 + strength * meanX;
-               nodeInfo[i].xyz[1] = nodeInfo[i].xyz[1] * inverseStrength
-                                 + strength * meanY;
-               nodeInfo[i].xyz[2] = nodeInfo[i].xyz[2] * inverseStrength
-                                 + strength * meanZ;
-            }
-            else {
-               //
-               // To get here node must be a neighbor of a landmark node
-               //
-               for (int k = 0; k < numNeighbors; k++) {
-                  //
-                  // Is neighbor a landmark node ?
-                  //
-                  const int neigh = neighbors[k];
-                  if (nodeInfo[neigh].nodeType == NodeInfo::NODE_LANDMARK) {
-                     //
-                     // Get the next and previous neigbors of this landmark node
-                     //
-                     int prevNeighIndex = k - 1;
-                     if (prevNeighIndex < 0) {
-                        prevNeighIndex = numNeighbors - 1;
-                     }
-                     const int neighA = neighbors[prevNeighIndex];
-                     int nextNeighIndex = k + 1;
-                     if (nextNeighIndex >= numNeighbors) {
-                        nextNeighIndex = 0;
-                     }
-                     const int neighB = neighbors[nextNeighIndex];
-                     
-                     //
-                     // Get coordinates of this landmark neighbor and next and previous neighbors
-                     //
-                     float ai[3];
-                     coordinates.getCoordinate(neighA, ai);
-                     float bi[3];
-                     coordinates.getCoordinate(neighB, bi);
-                     float li[3];
-                     coordinates.getCoordinate(neigh, li);
-
-                     //
-                     // Adjust the position of neighbor average
-                     //
-                     float p[3];
-                     p[0] = 2*li[0] - ai[0] - bi[0];
-                     p[1] = 2*li[1] - ai[1] - bi[1];
-                     p[2] = 2*li[2] - ai[2] - bi[2];
-                     
-                     float len = std::sqrt(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
-                     p[0] /= len;
-                     p[1] /= len;
-                     p[2] /= len;
-                     
-                     meanX += li[0] + scale * p[0];
-                     meanY += li[1] + scale * p[1];
-                     meanZ += li[2] + scale * p[2];
-                  }
-               }
-               
-               meanX /= (nodeInfo[i].numLandmarkNeighbors + 1);
-               meanY /= (nodeInfo[i].numLandmarkNeighbors + 1);
-               meanZ /= (nodeInfo[i].numLandmarkNeighbors + 1);
-               nodeInfo[i].xyz[0] = inverseStrength * nodeInfo[i].xyz[0]
-                                  + strength * meanX;
-               nodeInfo[i].xyz[1] = inverseStrength * nodeInfo[i].xyz[1]
-                                  + strength * meanY;
-               nodeInfo[i].xyz[2] = inverseStrength * nodeInfo[i].xyz[2]
-                                  + strength * meanZ;
-            }
-         }
-      }
-      
-      //
-      // Set the coordinates
-      //
-      for (int i = 0; i < numNodes; i++) {
-         coordinates.setCoordinate(i, nodeInfo[i].xyz);
-      }
-      
-      //
-      // Update the displayed brain model
-      //
-      brainSet->drawBrainModel(this, iter);
-   }                 
    coordinates.clearDisplayList();
 }
 
@@ -5040,39 +4388,6 @@ BrainModelSurface::landmarkNeighborConstrainedSmoothing(const float strength,
                                                         const int smoothNeighborsEveryX,
                                                         const int projectToSphereEveryXIterations)
 {  
-   PreferencesFile* pf = brainSet->getPreferencesFile();
-   int numThreads = pf->getMaximumNumberOfThreads();
-//   numThreads = 0;
-//   if (numThreads > 0) {
-//      BrainModelSurfaceSmoothing smoothObject(brainSet,
-//                                              this,
-//                                              BrainModelSurfaceSmoothing::SMOOTHING_TYPE_LANDMARK_NEIGHBOR_CONSTRAINED,
-//                                              strength,
-//                                              iterations,
-//                                              0,
-//                                              smoothNeighborsEveryX,
-//                                              NULL,
-//                                              &landmarkNodeFlag,
-//                                              projectToSphereEveryXIterations,
-//                                              numThreads);
-//      try {
-//         smoothObject.execute();
-//      }
-//      catch (BrainModelAlgorithmException&) {
-//      }
-//
-//      return;
-//   }
-
-   const float sphereRadius = getSphericalSurfaceRadius();
-   
-   const float inverseStrength = 1.0 - strength;
-   
-   const int numNodes = getNumberOfNodes();
-   const TopologyHelper* helper = topology->getTopologyHelper(false, true, true);
-
-   std::vector<NodeInfo> nodeInfo(numNodes);
-   
    appendToCoordinateFileComment("Landmark Neighbor Constrained Smoothing: ");
    appendToCoordinateFileComment(StringUtilities::fromNumber(strength));
    appendToCoordinateFileComment(" ");
@@ -5081,201 +4396,22 @@ BrainModelSurface::landmarkNeighborConstrainedSmoothing(const float strength,
    appendToCoordinateFileComment(StringUtilities::fromNumber(smoothNeighborsEveryX));
    appendToCoordinateFileComment("\n");
    
-   //
-   // Set node info for all nodes
-   //
-   for (int i = 0; i < numNodes; i++) {
-      //
-      // Get neighbors for this node
-      //
-      //std::vector<int> neighbors;
-      //helper->getNodeNeighbors(i, neighbors);
-      //const int numNeighbors = static_cast<int>(neighbors.size());
-      int numNeighbors;
-      const int* neighbors = helper->getNodeNeighbors(i, numNeighbors);
-      const float floatNumNeighbors = numNeighbors;
-
-      //
-      // Is this node a landmarkd
-      //
-      if (landmarkNodeFlag[i]) {
-         nodeInfo[i].nodeType = NodeInfo::NODE_LANDMARK;
-         
-         //
-         // Calculate offset of this landmark node from the average of neighbors
-         //
-         float neighborSum[3] = { 0.0, 0.0, 0.0 };
-         for (int j = 0; j < numNeighbors; j++) {
-            const float* xyz = coordinates.getCoordinate(neighbors[j]);
-            neighborSum[0] += xyz[0];
-            neighborSum[1] += xyz[1];
-            neighborSum[2] += xyz[2];
-         }
-         const float* xyz = coordinates.getCoordinate(i);
-         nodeInfo[i].offset[0] = xyz[0] - (neighborSum[0] / floatNumNeighbors);
-         nodeInfo[i].offset[1] = xyz[1] - (neighborSum[1] / floatNumNeighbors);
-         nodeInfo[i].offset[2] = xyz[2] - (neighborSum[2] / floatNumNeighbors);
-      }
-      else {
-         //
-         // See if any of nodes neighbors are landmarks
-         //
-         for (int j = 0; j < numNeighbors; j++) {
-            const int n = neighbors[j];
-            if (landmarkNodeFlag[n]) {
-               nodeInfo[i].numLandmarkNeighbors++;
-            }
-         }
-         if (nodeInfo[i].numLandmarkNeighbors > 0) {
-            nodeInfo[i].nodeType = NodeInfo::NODE_LANDMARK_NEIGHBOR;
-         }
-      }
+   BrainModelSurfaceSmoothing smoothObject(brainSet,
+                                           this,
+                                           BrainModelSurfaceSmoothing::SMOOTHING_TYPE_LANDMARK_NEIGHBOR_CONSTRAINED,
+                                           strength,
+                                           iterations,
+                                           0,
+                                           smoothNeighborsEveryX,
+                                           NULL,
+                                           &landmarkNodeFlag,
+                                           projectToSphereEveryXIterations,
+                                           0);
+   try {
+      smoothObject.execute();
    }
-   
-   //
-   // Apply offsets to landmark neighbors
-   //
-   for (int i = 0; i < numNodes; i++) {
-      if (nodeInfo[i].nodeType == NodeInfo::NODE_LANDMARK_NEIGHBOR) {
-         //
-         // Get neighbors for this node
-         //
-         //std::vector<int> neighbors;
-         //helper->getNodeNeighbors(i, neighbors);
-         //const int numNeighbors = static_cast<int>(neighbors.size());
-         int numNeighbors;
-         const int* neighbors = helper->getNodeNeighbors(i, numNeighbors);
-         
-         //
-         // Get average of landmark neighbor offsets
-         //
-         float avg[3] = { 0.0, 0.0, 0.0 };
-         for (int j = 0; j < numNeighbors; j++) {
-            const int n = neighbors[j];
-            if (nodeInfo[n].nodeType == NodeInfo::NODE_LANDMARK) {
-               avg[0] += nodeInfo[n].offset[0];
-               avg[1] += nodeInfo[n].offset[1];
-               avg[2] += nodeInfo[n].offset[2];
-            }
-         }
-         
-         //
-         // Offset this landmark neighbor
-         //
-         const float floatNumLandmarkNeighbors = nodeInfo[i].numLandmarkNeighbors;
-         float xyz[3];
-         coordinates.getCoordinate(i, xyz);
-         xyz[0] += (avg[0] / floatNumLandmarkNeighbors);
-         xyz[1] += (avg[1] / floatNumLandmarkNeighbors);
-         xyz[2] += (avg[2] / floatNumLandmarkNeighbors);
-         coordinates.setCoordinate(i, xyz);
-      }
+   catch (BrainModelAlgorithmException&) {
    }
-   
-   //
-   // smooth for specified number of iterations
-   //
-   int smoothNeighborCounter = 1;
-   for (int iter = 1; iter <= iterations; iter++) {
-      
-      for (int i = 0; i < numNodes; i++) {
-         //
-         // Get the coordinate
-         //
-         coordinates.getCoordinate(i, nodeInfo[i].xyz);
-         
-         //
-         // Get the neighbors for this node
-         //
-         //std::vector<int> neighbors;
-         //helper->getNodeNeighbors(i, neighbors);
-         //const int numNeighbors = static_cast<int>(neighbors.size());
-         int numNeighbors;
-         const int* neighbors = helper->getNodeNeighbors(i, numNeighbors);
-         const float floatNumNeighbors = numNeighbors;
-         
-         //
-         // Only smooth nodes with neighbors
-         //
-         if (numNeighbors > 0) {
-            //
-            // Do not smooth landmark nodes
-            // smooth landmark neighbors every "smoothNeighborsEveryX" iterations
-            // smooth normal nodes every iteration
-            //
-            if ((nodeInfo[i].nodeType == NodeInfo::NODE_NORMAL) ||
-                ((nodeInfo[i].nodeType == NodeInfo::NODE_LANDMARK_NEIGHBOR) &&
-                 (smoothNeighborCounter == smoothNeighborsEveryX))) {
-               //
-               // Get average of neighbors coordinates
-               //
-               float neighborAverage[3] = { 0.0, 0.0, 0.0 };
-               for (int j = 0; j < numNeighbors; j++) {
-                  const int n = neighbors[j];
-                  const float* xyz = coordinates.getCoordinate(n);
-                  neighborAverage[0] += xyz[0];
-                  neighborAverage[1] += xyz[1];
-                  neighborAverage[2] += xyz[2];
-               }
-               neighborAverage[0] /= floatNumNeighbors;
-               neighborAverage[1] /= floatNumNeighbors;
-               neighborAverage[2] /= floatNumNeighbors;
-               
-               //
-               // Smooth the node
-               //
-               nodeInfo[i].xyz[0] = nodeInfo[i].xyz[0] * inverseStrength
-                                  + strength * neighborAverage[0];
-               nodeInfo[i].xyz[1] = nodeInfo[i].xyz[1] * inverseStrength
-                                  + strength * neighborAverage[1];
-               nodeInfo[i].xyz[2] = nodeInfo[i].xyz[2] * inverseStrength
-                                  + strength * neighborAverage[2];
-            }
-         }
-      }
-         
-      //
-      // Update the neighbor smoothing counter
-      //
-      if (smoothNeighborCounter >= smoothNeighborsEveryX) {
-         smoothNeighborCounter = 1;
-      }
-      else {
-         smoothNeighborCounter++;
-      }
-      
-      //
-      // If the surface should be projected to a sphere
-      //
-      if (projectToSphereEveryXIterations > 0) {
-         if ((iter % projectToSphereEveryXIterations) == 0) {
-            for (int j = 0; j < numNodes; j++) {
-               MathUtilities::setVectorLength(nodeInfo[j].xyz, sphereRadius);
-            }
-         }
-      }
-
-      //
-      // Set the coordinates
-      //
-      for (int i = 0; i < numNodes; i++) {
-         coordinates.setCoordinate(i, nodeInfo[i].xyz);
-      }
-      
-      //
-      // If the surface should be projected to a sphere
-      //
-      //if (projectToSphereEveryXIterations > 0) {
-      //   if ((iter % projectToSphereEveryXIterations) == 0) {
-      //      convertToSphereWithRadius(sphereRadius);
-      //   }
-      //}
-      
-      //
-      // Update the displayed brain model
-      //
-      brainSet->drawBrainModel(this, iter);
-   }                 
    coordinates.clearDisplayList();
 }
 
@@ -5991,17 +5127,20 @@ BrainModelSurface::inflate(const int smoothingIterations,
       //
       // Inflate the surface
       //
+      float* coords = coordinates.getCoordinate(0);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 4096)
+#endif
       for (int i = 0; i < numNodes; i++) {
-         float p[3];
-         coordinates.getCoordinate(i, p);
+         float* p = &coords[i*3];
          const double radiusPoint = std::sqrt(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
          double factor = 1.0 + ( (inflationFactor - 1.0)
                                  * (1.0 - (radiusPoint / radius)) );       
          p[0] *= factor;
          p[1] *= factor;
          p[2] *= factor;
-         coordinates.setCoordinate(i, p);
       }
+      coordinates.setModified();
    }
    
    //       
@@ -6030,7 +5169,8 @@ BrainModelSurface::createInflatedAndEllipsoidFromFiducial(const bool createInfla
                                                           const bool scaleToMatchFiducialArea,
                                                           const float iterationsScaleIn,
                                                           MetricFile* metricMeasurementsFileOut,
-                                                          const float compressionFactorIn) const
+                                                          const float compressionFactorIn,
+                                                          const bool multiresolutionSmoothingFlag) const
 {
    if ((createInflated == false) &&
        (createVeryInflated == false) &&
@@ -6074,7 +5214,8 @@ BrainModelSurface::createInflatedAndEllipsoidFromFiducial(const bool createInfla
                                                    3.0,   // finger compress/stretch threshold
                                                    1.0,   // finger smoothing strength
                                                    0,     // finger smoothing iterations
-                                                   &metricMeasureFile1);
+                                                   &metricMeasureFile1,
+                                                   multiresolutionSmoothingFlag);
    
    if (DebugControl::getDebugOn()) {
       if (metricMeasurementsFileOut != NULL) {
@@ -6135,7 +5276,8 @@ BrainModelSurface::createInflatedAndEllipsoidFromFiducial(const bool createInfla
                                                    3.0,   // finger compress/stretch threshold
                                                    1.0,   // finger smoothing strength
                                                    fingerSmoothingIterations,
-                                                   &metricMeasureFile2);   
+                                                   &metricMeasureFile2,
+                                                   multiresolutionSmoothingFlag);   
    if (scaleToMatchFiducialArea) {
       inflatedSurface->scaleSurfaceToArea(fiducialSurfaceArea, false);
    }
@@ -6165,7 +5307,8 @@ BrainModelSurface::createInflatedAndEllipsoidFromFiducial(const bool createInfla
                                                       3.0,   // finger compress/stretch threshold
                                                       1.0,   // finger smoothing strength
                                                       0,     // finger smoothing iterations
-                                                      &metricMeasureFile3);
+                                                      &metricMeasureFile3,
+                                                      multiresolutionSmoothingFlag);
       if (scaleToMatchFiducialArea) {
          veryInflatedSurface->scaleSurfaceToArea(fiducialSurfaceArea, false);
       }
@@ -6198,7 +5341,8 @@ BrainModelSurface::createInflatedAndEllipsoidFromFiducial(const bool createInfla
                                                       3.0,   // finger compress/stretch threshold
                                                       1.0,   // finger smoothing strength
                                                       fingerSmoothingIterations,    // finger smoothing iterations
-                                                      &metricMeasureFile4);
+                                                      &metricMeasureFile4,
+                                                      multiresolutionSmoothingFlag);
       //
       // Find the "compressed" column
       //
@@ -6240,7 +5384,8 @@ BrainModelSurface::createInflatedAndEllipsoidFromFiducial(const bool createInfla
                                                       4.0,   // finger compress/stretch threshold
                                                       1.0,   // finger smoothing strength
                                                       fingerSmoothingIterations,     // finger smoothing iterations
-                                                      &metricMeasureFile5);
+                                                      &metricMeasureFile5,
+                                                      multiresolutionSmoothingFlag);
       if (scaleToMatchFiducialArea) {
          ellipsoidSurface->scaleSurfaceToArea(fiducialSurfaceArea, false);
       }
@@ -6345,7 +5490,8 @@ BrainModelSurface::inflateSurfaceAndSmoothFingers(const BrainModelSurface* fiduc
                                                   const float compressStretchThreshold,
                                                   const float fingerSmoothingStrength,
                                                   const int fingerSmoothingIterations,
-                                                  MetricFile* metricMeasurementsFile)
+                                                  MetricFile* metricMeasurementsFile,
+                                                  const bool multiresolutionSmoothingFlag)
 {
    if (fiducialSurfaceIn == NULL) {
       std::cout << "ERROR: BrainModelSurface::inflateSurfaceAndSmoothFingers - No fiducial surface as input." << std::endl;
@@ -6423,6 +5569,18 @@ BrainModelSurface::inflateSurfaceAndSmoothFingers(const BrainModelSurface* fiduc
    const CoordinateFile* fiducialCoords = fiducialSurface->getCoordinateFile();
    const float* fiducialPos = fiducialCoords->getCoordinate(0);
    
+   //
+   // Multiresolution smoothing does most of the regular smoothing on coarse levels
+   //
+   BrainModelSurfaceMultiresolutionSmoothing* multiresolutionSmoothing = NULL;
+   if (multiresolutionSmoothingFlag) {
+      multiresolutionSmoothing = new BrainModelSurfaceMultiresolutionSmoothing(brainSet,
+                                                                 this,
+                                                                 regularSmoothingStrength,
+                                                                 regularSmoothingIterations,
+                                                                 1);
+   }
+   
    //
    // Step 6: Main Smoothing Cycle
    // Note: No smoothing takes place in the "+1" cycle, just metric calculation
@@ -6434,16 +5592,28 @@ BrainModelSurface::inflateSurfaceAndSmoothFingers(const BrainModelSurface* fiduc
          // Step 6a: Apply Smoothing to AUX coord
          //  Caret Menu: Operate->Smoothing->Smoothing...
          //
-         arealSmoothing(regularSmoothingStrength, 
-                        regularSmoothingIterations,
-                        1);
+         if (multiresolutionSmoothing != NULL) {
+            try {
+               multiresolutionSmoothing->execute();
+            }
+            catch (BrainModelAlgorithmException&) {
+            }
+         }
+         else {
+            arealSmoothing(regularSmoothingStrength, 
+                           regularSmoothingIterations,
+                           1);
+         }
 
          //
          // Step 6b: Incrementally Inflate AUX Surface by Ellipsoidal Projection
          //
+         float* surfaceXYZ = surfaceCoords->getCoordinate(0);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 4096)
+#endif
          for (int i = 0; i < numNodes; i++) {
-            float xyz[3];
-            surfaceCoords->getCoordinate(i, xyz);
+            float* xyz = &surfaceXYZ[i*3];
             const float x = xyz[0] / xdiff;
             const float y = xyz[1] / ydiff;
             const float z = xyz[2] / zdiff;
@@ -6455,8 +5625,8 @@ BrainModelSurface::inflateSurfaceAndSmoothFingers(const BrainModelSurface* fiduc
             xyz[0] *= k;
             xyz[1] *= k;
             xyz[2] *= k;
-            surfaceCoords->setCoordinate(i, xyz);
          }
+         surfaceCoords->setModified();
       }
       
       // Step 6c: Calculate surface area of this surface
@@ -6475,6 +5645,9 @@ BrainModelSurface::inflateSurfaceAndSmoothFingers(const BrainModelSurface* fiduc
       //
       // Step 6d: Calculate compress/stretched value for each node
       //
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1024)
+#endif
       for (int i = 0; i < numNodes; i++) {
       
          //
@@ -6599,16 +5772,20 @@ BrainModelSurface::inflateSurfaceAndSmoothFingers(const BrainModelSurface* fiduc
                                        * surfaceAreaRatio);
       }
       
+      if (DebugControl::getDebugOn()) {
+         for (int i = 0; i < numNodes; i += 1000) {
+            std::cout << "comp-stretch " << i << " " << compressedStretched[i] << std::endl;
+         }
+      }
+      
       //
       // average compressed/stretched for all nodes by averaging with neighbors
       //
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1024)
+#endif
       for (int i = 0; i < numNodes; i++) {
          averageCompressedStretched[i] = compressedStretched[i];
-         if (DebugControl::getDebugOn()) {
-            if ((i % 1000) == 0) {
-               std::cout << "comp-stretch " << i << " " << compressedStretched[i] << std::endl;
-            }
-         }
          int numNeighbors;
          const int* neighbors = th->getNodeNeighbors(i, numNeighbors);
          if (numNeighbors > 0) {
@@ -6816,6 +5993,9 @@ BrainModelSurface::inflateSurfaceAndSmoothFingers(const BrainModelSurface* fiduc
    }
    
    delete fiducialSurface;
+   if (multiresolutionSmoothing != NULL) {
+      delete multiresolutionSmoothing;
+   }
    
    //delete[] arealCompression;
    delete[] averageCompressedStretched;
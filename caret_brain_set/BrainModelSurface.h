@@ -235,7 +235,8 @@ class BrainModelSurface : public BrainModel {
                                                   const bool scaleToMatchFiducialArea,
                                                   const float iterationsScale,
                                                   MetricFile* metricMeasurementsFile,
-                                                  const float compressionFactorIn = 0.95) const;
+                                                  const float compressionFactorIn = 0.95,
+                                                  const bool multiresolutionSmoothingFlag = false) const;
       
       /// convert "this" surface to VTK PolyData
       vtkPolyData* convertToVtkPolyData() const;
@@ -475,7 +476,8 @@ class BrainModelSurface : public BrainModel {
                                           const float compressStretchThreshold,
                                           const float fingerSmoothingStrength,
                                           const int fingerSmoothingIterations,
-                                          MetricFile* metricMeasurementsFile);
+                                          MetricFile* metricMeasurementsFile,
+                                          const bool multiresolutionSmoothingFlag = false);
       
       /// translate a surface to its center of mass
       void translateToCenterOfMass();
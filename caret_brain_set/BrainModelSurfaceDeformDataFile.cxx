@@ -1421,33 +1421,33 @@ BrainModelSurfaceDeformDataFile::deformCellOrFociFile(BrainSet* sourceBrainSet,
    BrainModelSurfacePointProjector tdspp(targetProjectSurface,
                            BrainModelSurfacePointProjector::SURFACE_TYPE_HINT_OTHER,
                            false);
-   for (int i = 0; i < sourceCellFile->getNumberOfCells(); i++) {
+   const int numCells = sourceCellFile->getNumberOfCells();
+   std::vector<float> cellXYZ(numCells * 3);
+   for (int i = 0; i < numCells; i++) {
+      sourceCellFile->getCell(i)->getXYZ(&cellXYZ[i * 3]);
+   }
+   std::vector<int> cellTiles(numCells), cellTileNodes(numCells * 3);
+   std::vector<float> cellTileAreas(numCells * 3);
+   if (numCells > 0) {
+      tdspp.projectToClosestTiles(&cellXYZ[0],
+                                  numCells,
+                                  &cellTiles[0],
+                                  &cellTileNodes[0],
+                                  &cellTileAreas[0]);
+   }
+   for (int i = 0; i < numCells; i++) {
       CellData* cd = sourceCellFile->getCell(i);
-      float xyz[3];
-      cd->getXYZ(xyz);
-      int nearestNode, tileNodes[3];
-      float tileAreas[3];
-      const int tile = tdspp.projectBarycentric(xyz,
-                                                 nearestNode,
-                                                 tileNodes,
-                                                 tileAreas);
+      float xyz[3] = { 0.0, 0.0, 0.0 };
+      
       //
       // Unproject onto target fiducial surface
       //
-      if (tile >= 0) {
-         BrainModelSurfacePointProjector::unprojectPoint(tileNodes,
-                                                         tileAreas,
+      if (cellTiles[i] >= 0) {
+         BrainModelSurfacePointProjector::unprojectPoint(&cellTileNodes[i * 3],
+                                                         &cellTileAreas[i * 3],
                                                          targetFiducialCoordinateFile,
                                                          xyz);
       }
-      else if (nearestNode >= 0) {
-         targetFiducialCoordinateFile->getCoordinate(nearestNode, xyz);
-      }
-      else {
-         xyz[0] = 0.0;
-         xyz[1] = 0.0;
-         xyz[2] = 0.0;
-      }
       cd->setXYZ(xyz);
    }
    
@@ -1734,33 +1734,33 @@ BrainModelSurfaceDeformDataFile::deformCellOrFociProjectionFile(BrainSet* source
    BrainModelSurfacePointProjector tdspp(targetProjectSurface,
                            BrainModelSurfacePointProjector::SURFACE_TYPE_HINT_OTHER,
                            false);
-   for (int i = 0; i < sourceCellFile->getNumberOfCells(); i++) {
+   const int numCells = sourceCellFile->getNumberOfCells();
+   std::vector<float> cellXYZ(numCells * 3);
+   for (int i = 0; i < numCells; i++) {
+      sourceCellFile->getCell(i)->getXYZ(&cellXYZ[i * 3]);
+   }
+   std::vector<int> cellTiles(numCells), cellTileNodes(numCells * 3);
+   std::vector<float> cellTileAreas(numCells * 3);
+   if (numCells > 0) {
+      tdspp.projectToClosestTiles(&cellXYZ[0],
+                                  numCells,
+                                  &cellTiles[0],
+                                  &cellTileNodes[0],
+                                  &cellTileAreas[0]);
+   }
+   for (int i = 0; i < numCells; i++) {
       CellData* cd = sourceCellFile->getCell(i);
-      float xyz[3];
-      cd->getXYZ(xyz);
-      int nearestNode, tileNodes[3];
-      float tileAreas[3];
-      const int tile = tdspp.projectBarycentric(xyz,
-                                                 nearestNode,
-                                                 tileNodes,
-                                                 tileAreas);
+      float xyz[3] = { 0.0, 0.0, 0.0 };
+      
       //
       // Unproject onto target fiducial surface
       //
-      if (tile >= 0) {
-         BrainModelSurfacePointProjector::unprojectPoint(tileNodes,
-                                                         tileAreas,
+      if (cellTiles[i] >= 0) {
+         BrainModelSurfacePointProjector::unprojectPoint(&cellTileNodes[i * 3],
+                                                         &cellTileAreas[i * 3],
                                                          targetFiducialCoordinateFile,
                                                          xyz);
       }
-      else if (nearestNode >= 0) {
-         targetFiducialCoordinateFile->getCoordinate(nearestNode, xyz);
-      }
-      else {
-         xyz[0] = 0.0;
-         xyz[1] = 0.0;
-         xyz[2] = 0.0;
-      }
       cd->setXYZ(xyz);
    }
    
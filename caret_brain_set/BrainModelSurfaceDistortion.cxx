@@ -172,10 +172,10 @@ BrainModelSurfaceDistortion::execute() throw (BrainModelAlgorithmException)
          
          if (numberOfNeighbors >= 1.0) {
             distortion = 0.0;
-            std::vector<int> tiles;
-            th.getNodeTiles(i, tiles);
+            int numTiles = 0;
+            const int* tiles = th.getNodeTiles(i, numTiles);
             
-            for (int j = 0; j < static_cast<int>(tiles.size()); j++) {
+            for (int j = 0; j < numTiles; j++) {
                distortion += tileDistortion[tiles[j]];
             }
             distortion /= numberOfNeighbors;
@@ -199,9 +199,8 @@ BrainModelSurfaceDistortion::execute() throw (BrainModelAlgorithmException)
       //
       for (int i = 0; i < numNodes; i++) {
          float distortion = 0.0;
-         std::vector<int> neighbors;
-         th.getNodeNeighbors(i, neighbors);
-         const int numberOfNeighbors = neighbors.size();
+         int numberOfNeighbors = 0;
+         const int* neighbors = th.getNodeNeighbors(i, numberOfNeighbors);
          
          if (numberOfNeighbors >= 1) {
             const float* me = coords->getCoordinate(i); 
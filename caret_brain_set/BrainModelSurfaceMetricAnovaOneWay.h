@@ -68,6 +68,11 @@ class BrainModelSurfaceMetricAnovaOneWay : public BrainModelSurfaceMetricFindClu
                          const int fStatisticColumn,
                          const int dofColumn,
                          const int pValueColumn) throw (BrainModelAlgorithmException);
+      
+      /// compute the shuffled F-Map for one permutation
+      void computePermutedStatisticalMap(const int iterationIndex,
+                                         std::vector<float>& valuesOut,
+                                         QString& columnNameOut) throw (BrainModelAlgorithmException);
                 
       /// the input metric file names
       std::vector<QString> inputMetricFileNames;
@@ -75,9 +80,6 @@ class BrainModelSurfaceMetricAnovaOneWay : public BrainModelSurfaceMetricFindClu
       /// the input metric files
       std::vector<MetricFile*> inputMetricFiles;
       
-      /// metric files that are output of shuffling
-      std::vector<MetricFile*> shuffledMetricFiles;
-      
       /// interations for generating shuffled F-Map file
       int iterations;
 };
@@ -96,12 +96,6 @@ BrainModelSurfaceMetricAnovaTwoWay::~BrainModelSurfaceMetricAnovaTwoWay()
       inputMetricFiles[i] = NULL;
    }
    inputMetricFiles.clear();
-   
-   for (unsigned int i = 0; i < shuffledMetricFiles.size(); i++) {
-      delete shuffledMetricFiles[i];
-      shuffledMetricFiles[i] = NULL;
-   }
-   shuffledMetricFiles.clear();
 }
 
 /**
@@ -151,7 +145,6 @@ BrainModelSurfaceMetricAnovaTwoWay::executeClusterSearch() throw (BrainModelAlgo
    enum { 
       ALG_STEP_CHECKING_INPUT,
       ALG_STEP_F_MAP,
-      ALG_STEP_SHUFFLED_F_MAP,
       ALG_STEP_FINDING_CLUSTERS_F_MAP,
       ALG_STEP_FINDING_CLUSTERS_SHUFFLED_F_MAP,
       ALG_NUM_STEPS
@@ -280,60 +273,6 @@ BrainModelSurfaceMetricAnovaTwoWay::executeClusterSearch() throw (BrainModelAlgo
    // Should a shuffled Statistical Map be created
    //
    if (iterations > 0) {
-      //
-      // Update progress
-      //
-      updateProgressDialog("Doing Shuffled F-Map",
-                           ALG_STEP_SHUFFLED_F_MAP,
-                           ALG_NUM_STEPS);
-      //
-      // Create shuffled statistical map metric file
-      //
-      shuffleStatisticalMapShapeFile = new MetricFile;
-      shuffleStatisticalMapShapeFile->setNumberOfNodesAndColumns(numberOfNodes,
-                                                                 iterations);
-              
-      //
-      // Create metric files that will be the output of the shuffle process
-      //
-      for (int i = 0; i < numInputFiles; i++) {
-         shuffledMetricFiles.push_back(new MetricFile(*inputMetricFiles[i]));
-      }
-      
-      //
-      // Perform for specified number of iterations
-      //
-      for (int i = 0; i < iterations; i++) {
-         //
-         // Shuffle the input files
-         //
-         try {
-            MetricFile::shuffle(inputMetricFiles, shuffledMetricFiles);
-         }
-         catch (FileException& e) {
-            throw BrainModelAlgorithmException(e);
-         }
-         
-         //
-         // Create the F-Statistic
-         //
-         performFTest(shuffledMetricFiles,
-                      shuffleStatisticalMapShapeFile,
-                      i,
-                      -1,
-                      -1);
-      }
-
-      //
-      // Write the shuffled F-Statistic metric file
-      //
-      try {
-         shuffleStatisticalMapShapeFile->writeFile(shuffledStatisticalMapFileName);
-      }
-      catch (FileException& e) {
-         throw BrainModelAlgorithmException(e);
-      }   
-      
       //
       // Update progress
       //
@@ -357,18 +296,22 @@ BrainModelSurfaceMetricAnovaTwoWay::executeClusterSearch() throw (BrainModelAlgo
 
                            
       //
-      // find the clusters in Shuffled F-Map
-      // Note: Only use largest cluster from each column
+      // find the clusters in Shuffled F-Map.  Each shuffled F-Map is
+      // computed, and its largest cluster found, by the permutation engine
+      // so that all of the shuffled F-Maps are never in memory.
       //
       std::vector<Cluster> shuffleFMapClusters;
-      findClusters(shuffleStatisticalMapShapeFile, shuffleFMapClusters, "Finding Clusters in Shuffled F-Map", 
-                   -1, true);
+      std::vector<float> shuffleFMapMaximumStatistics;
+      findPermutationNullDistribution(iterations,
+                                      "Finding Clusters in Shuffled F-Map",
+                                      shuffleFMapClusters,
+                                      shuffleFMapMaximumStatistics);
       
       //
       // Set pValue for shuffled T-Map
       // 
-      setRandomizedClusterPValues(*shuffleStatisticalMapShapeFile,
-                               shuffleFMapClusters);
+      setRandomizedClusterPValues(iterations,
+                                  shuffleFMapClusters);
                                
       //
       // Find area of the "P-Value" cluster in the shuffled F-Map
@@ -544,6 +487,7 @@ BrainModelSurfaceMetricAnovaTwoWay::performFTest(const std::vector<MetricFile*>&
    //
    for (int i = 0; i < numberOfNodes; i++) {
       StatisticAnovaTwoWay anova;
+      anova.setComputePValue(pValueColumn >= 0);
       anova.setNumberOfFactorLevels(numberOfRows, numberOfColumns);
       anova.setAnovaModelType(statisticAnovaModel);
       
@@ -586,3 +530,47 @@ BrainModelSurfaceMetricAnovaTwoWay::performFTest(const std::vector<MetricFile*>&
    }
    
 }
+
+/**
+ * Compute the shuffled F-Map for one permutation (called from multiple threads).
+ * P-Values are not computed for the shuffled F-Map since they are computed
+ * with DCDFLIB which is not thread safe.
+ */
+void 
+BrainModelSurfaceMetricAnovaTwoWay::computePermutedStatisticalMap(const int iterationIndex,
+                                                  std::vector<float>& valuesOut,
+                                                  QString& columnNameOut) throw (BrainModelAlgorithmException)
+{
+   //
+   // Shuffle into copies of the input files so that threads do not share them
+   //
+   const int numInputFiles = static_cast<int>(inputMetricFiles.size());
+   std::vector<MetricFile> shuffledFiles;
+   shuffledFiles.reserve(numInputFiles);
+   for (int i = 0; i < numInputFiles; i++) {
+      shuffledFiles.push_back(*inputMetricFiles[i]);
+   }
+   std::vector<MetricFile*> shuffledMetricFiles;
+   for (int i = 0; i < numInputFiles; i++) {
+      shuffledMetricFiles.push_back(&shuffledFiles[i]);
+   }
+   try {
+      MetricFile::shuffle(inputMetricFiles, shuffledMetricFiles, iterationIndex);
+   }
+   catch (FileException& e) {
+      throw BrainModelAlgorithmException(e);
+   }
+   
+   //
+   // Create the F-Statistic
+   //
+   MetricFile fMapFile;
+   fMapFile.setNumberOfNodesAndColumns(inputMetricFiles[0]->getNumberOfNodes(), 1);
+   performFTest(shuffledMetricFiles,
+                &fMapFile,
+                0,
+                -1,
+                -1);
+   fMapFile.getColumnForAllNodes(0, valuesOut);
+   columnNameOut = fMapFile.getColumnName(0);
+}
@@ -87,6 +87,11 @@ class BrainModelSurfaceMetricAnovaTwoWay : public BrainModelSurfaceMetricFindClu
                          const int dofColumn,
                          const int pValueColumn) throw (BrainModelAlgorithmException);
       
+      // compute the shuffled F-Map for one permutation
+      void computePermutedStatisticalMap(const int iterationIndex,
+                                         std::vector<float>& valuesOut,
+                                         QString& columnNameOut) throw (BrainModelAlgorithmException);
+      
       // get the index into one dimensional array of files or names
       int getFileIndex(const int rowNumber,
                        const int columnNumber) const;
@@ -100,9 +105,6 @@ class BrainModelSurfaceMetricAnovaTwoWay : public BrainModelSurfaceMetricFindClu
       /// the input metric files
       std::vector<MetricFile*> inputMetricFiles;
       
-      /// metric files that are output of shuffling
-      std::vector<MetricFile*> shuffledMetricFiles;
-      
       /// interations for generating shuffled F-Map file
       int iterations;
       
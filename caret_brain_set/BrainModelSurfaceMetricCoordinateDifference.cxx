@@ -88,6 +88,8 @@ BrainModelSurfaceMetricCoordinateDifference::BrainModelSurfaceMetricCoordinateDi
    coordFileNameGroupA = coordFileNameGroupAIn;
    coordFileNameGroupB = coordFileNameGroupBIn;
    iterations = iterationsIn;
+   permutationDeviationGroupA = NULL;
+   permutationDeviationGroupB = NULL;
 }
       
 /**
@@ -121,7 +123,6 @@ BrainModelSurfaceMetricCoordinateDifference::executeClusterSearch() throw (Brain
       enum {
          ALG_STEP_CHECKING_INPUT,
          ALG_STEP_TMAP,
-         ALG_STEP_SHUFFLED_TMAP,
          ALG_STEP_FINDING_CLUSTERS_T_MAP,
          ALG_STEP_FINDING_CLUSTERS_SHUFFLE_T_MAP,
          ALG_NUM_STEPS
@@ -280,81 +281,6 @@ BrainModelSurfaceMetricCoordinateDifference::executeClusterSearch() throw (Brain
       }
       
       
-      //
-      // Update progress
-      //
-      updateProgressDialog("Doing Shuffled Distance File",
-                           ALG_STEP_SHUFFLED_TMAP,
-                           ALG_NUM_STEPS);
-                           
-      //
-      // Get all coords in one group
-      //
-      std::vector<CoordinateFile*> allCoords;
-      allCoords.insert(allCoords.end(),
-                       coordGroupA.begin(),
-                       coordGroupA.end());
-      allCoords.insert(allCoords.end(),
-                       coordGroupB.begin(),
-                       coordGroupB.end());
-      const int totalNumCoords = static_cast<int>(allCoords.size());
-      if (totalNumCoords < 2) {
-         throw BrainModelAlgorithmException("There must be at least two coord files.");
-      }                 
-      
-      //
-      // Do shuffled Distance File
-      //
-      shuffleStatisticalMapShapeFile = new MetricFile;
-      shuffleStatisticalMapShapeFile->setNumberOfNodesAndColumns(numberOfNodes,
-                                                       iterations);
-      for (int i = 0; i < iterations; i++) {
-         CoordinateFile c1, c2;
-         CoordinateFile::createShuffledAverageCoordinatesFiles(allCoords,
-                                                               -1,
-                                                               c1,
-                                                               c2);
-         switch (mode) {
-            case MODE_COORDINATE_DIFFERENCE:
-               shuffleStatisticalMapShapeFile->addColumnOfCoordinateDifference(
-                               MetricFile::COORDINATE_DIFFERENCE_MODE_ABSOLUTE,
-                                                              &c1,
-                                                              &c2,
-                                                              bms->getTopologyFile(),
-                                                              i,
-                                                              "Coord Difference",
-                                                              "Difference of two average coord files");
-               break;
-            case MODE_TMAP_DIFFERENCE:
-               shuffleStatisticalMapShapeFile->addColumnOfCoordinateDifferenceTMap(&c1,
-                                                              &c2,
-                                                              bms->getTopologyFile(),
-                                                              i,
-                                                              "T-Map Coord Difference",
-                                                              "T-Map of Difference of two average coord files",
-                                                              &deviationGroupA,
-                                                              0,
-                                                              &deviationGroupB,
-                                                              0,
-                                                              false);
-               break;
-         }
-      }
-
-      //
-      // Write Shuffled  Distance file
-      //
-      try {
-         shuffleStatisticalMapShapeFile->writeFile(shuffledStatisticalMapFileName);
-      }
-      catch (FileException& e) {
-         std::ostringstream str;
-         str << "Unable to write Shuffled Distance File: "
-             << FileUtilities::basename(shuffledStatisticalMapFileName).toAscii().constData();
-         cleanUp();
-         throw BrainModelAlgorithmException(str.str().c_str());
-      }
-
       //
       // Update progress
       //
@@ -377,17 +303,48 @@ BrainModelSurfaceMetricCoordinateDifference::executeClusterSearch() throw (Brain
                            ALG_NUM_STEPS);
                            
       //
-      // find the clusters in Shuffled Distance File
-      // Note: Only use largest cluster from each column
+      // Get all coords in one group
+      //
+      permutationCoordFiles.clear();
+      permutationCoordFiles.insert(permutationCoordFiles.end(),
+                                   coordGroupA.begin(),
+                                   coordGroupA.end());
+      permutationCoordFiles.insert(permutationCoordFiles.end(),
+                                   coordGroupB.begin(),
+                                   coordGroupB.end());
+      const int totalNumCoords = static_cast<int>(permutationCoordFiles.size());
+      if (totalNumCoords < 2) {
+         throw BrainModelAlgorithmException("There must be at least two coord files.");
+      }                 
+      permutationDeviationGroupA = &deviationGroupA;
+      permutationDeviationGroupB = &deviationGroupB;
+      
+      //
+      // find the clusters in Shuffled Distance File.  Each shuffled distance
+      // file is computed, and its largest cluster found, by the permutation 
+      // engine so that all of the shuffled distance files are never in memory.
       //
       std::vector<Cluster> shuffleTMapClusters;
-      findClusters(shuffleStatisticalMapShapeFile, shuffleTMapClusters, "Finding Clusters in Shuffled Distance File", -1, true);
+      std::vector<float> shuffleTMapMaximumStatistics;
+      try {
+         findPermutationNullDistribution(iterations,
+                                         "Finding Clusters in Shuffled Distance File",
+                                         shuffleTMapClusters,
+                                         shuffleTMapMaximumStatistics);
+      }
+      catch (BrainModelAlgorithmException& e) {
+         cleanUp();
+         throw e;
+      }
+      permutationCoordFiles.clear();
+      permutationDeviationGroupA = NULL;
+      permutationDeviationGroupB = NULL;
       
       //
       // Set pValue for shuffled T-Map
       // 
-      setRandomizedClusterPValues(*shuffleStatisticalMapShapeFile,
-                               shuffleTMapClusters);
+      setRandomizedClusterPValues(iterations,
+                                  shuffleTMapClusters);
                                
       //
       // Find area of the "P-Value" cluster in the shuffled Distance File
@@ -558,5 +515,65 @@ BrainModelSurfaceMetricCoordinateDifference::computeCoordinateDeviation(const st
 void
 BrainModelSurfaceMetricCoordinateDifference::cleanUp()
 {
+   permutationCoordFiles.clear();
+   permutationDeviationGroupA = NULL;
+   permutationDeviationGroupB = NULL;
    BrainModelSurfaceMetricFindClustersBase::cleanUp();
 }
+
+/**
+ * Compute the shuffled distance map for one permutation (called from multiple threads).
+ */
+void 
+BrainModelSurfaceMetricCoordinateDifference::computePermutedStatisticalMap(const int iterationIndex,
+                                                  std::vector<float>& valuesOut,
+                                                  QString& columnNameOut) throw (BrainModelAlgorithmException)
+{
+   if ((permutationCoordFiles.empty()) ||
+       (permutationDeviationGroupA == NULL) ||
+       (permutationDeviationGroupB == NULL)) {
+      throw BrainModelAlgorithmException("Program Error: Shuffled Distance File input is invalid.");
+   }
+   
+   MetricFile distanceFile;
+   distanceFile.setNumberOfNodesAndColumns(permutationCoordFiles[0]->getNumberOfCoordinates(), 1);
+   try {
+      CoordinateFile c1, c2;
+      CoordinateFile::createShuffledAverageCoordinatesFiles(permutationCoordFiles,
+                                                            -1,
+                                                            c1,
+                                                            c2,
+                                                            iterationIndex);
+      switch (mode) {
+         case MODE_COORDINATE_DIFFERENCE:
+            distanceFile.addColumnOfCoordinateDifference(
+                            MetricFile::COORDINATE_DIFFERENCE_MODE_ABSOLUTE,
+                                                           &c1,
+                                                           &c2,
+                                                           bms->getTopologyFile(),
+                                                           0,
+                                                           "Coord Difference",
+                                                           "Difference of two average coord files");
+            break;
+         case MODE_TMAP_DIFFERENCE:
+            distanceFile.addColumnOfCoordinateDifferenceTMap(&c1,
+                                                           &c2,
+                                                           bms->getTopologyFile(),
+                                                           0,
+                                                           "T-Map Coord Difference",
+                                                           "T-Map of Difference of two average coord files",
+                                                           permutationDeviationGroupA,
+                                                           0,
+                                                           permutationDeviationGroupB,
+                                                           0,
+                                                           false);
+            break;
+      }
+   }
+   catch (FileException& e) {
+      throw BrainModelAlgorithmException(e.whatQString());
+   }
+   
+   distanceFile.getColumnForAllNodes(0, valuesOut);
+   columnNameOut = distanceFile.getColumnName(0);
+}
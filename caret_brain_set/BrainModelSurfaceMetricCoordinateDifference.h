@@ -82,6 +82,11 @@ class BrainModelSurfaceMetricCoordinateDifference : public BrainModelSurfaceMetr
                                       const CoordinateFile& averageCoordFile,
                                       MetricFile& deviationFile);
                                       
+      // compute the shuffled distance map for one permutation
+      void computePermutedStatisticalMap(const int iterationIndex,
+                                         std::vector<float>& valuesOut,
+                                         QString& columnNameOut) throw (BrainModelAlgorithmException);
+      
       /// mode of the algorithm
       MODE mode;
       
@@ -100,6 +105,15 @@ class BrainModelSurfaceMetricCoordinateDifference : public BrainModelSurfaceMetr
       /// iterations for shuffling average coord files
       int iterations;
       
+      /// coordinate files of both groups for permutations
+      std::vector<CoordinateFile*> permutationCoordFiles;
+      
+      /// group A deviation for permutations
+      const MetricFile* permutationDeviationGroupA;
+      
+      /// group B deviation for permutations
+      const MetricFile* permutationDeviationGroupB;
+      
       /// name of distance metric file
       //QString& distanceMetricFileName;
       
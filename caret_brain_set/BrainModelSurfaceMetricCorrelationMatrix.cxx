@@ -18,6 +18,7 @@
 #include <QTime>
 
 #include "BrainModelSurfaceMetricCorrelationMatrix.h"
+#include "CorrelationMatrixEngine.h"
 #include "GiftiDataArray.h"
 #include "GiftiDataArrayFile.h"
 #include "GiftiDataArrayFileStreamReader.h"
@@ -37,14 +38,16 @@ BrainModelSurfaceMetricCorrelationMatrix::BrainModelSurfaceMetricCorrelationMatr
                                                 MetricFile* inputMetricFileIn,
                                                 const bool applyFisherZTransformFlagIn,
                                                 const bool outputGiftiFlagIn,
-                                                const bool parallelFlagIn)
+                                                const bool parallelFlagIn,
+                                                const bool floatAccumulationFlagIn)
    : BrainModelAlgorithm(bs),
      GiftiDataArrayReadListener(),
      mode(MODE_FILES_IN_MEMORY),
      inputMetricFile(inputMetricFileIn),
      applyFisherZTransformFlag(applyFisherZTransformFlagIn),
      outputGiftiFlag(outputGiftiFlagIn),
-     parallelFlag(parallelFlagIn)
+     parallelFlag(parallelFlagIn),
+     floatAccumulationFlag(floatAccumulationFlagIn)
 {
    this->initialize();
 }
@@ -56,14 +59,16 @@ BrainModelSurfaceMetricCorrelationMatrix::BrainModelSurfaceMetricCorrelationMatr
             const QString& outputMetricFileName,
             const bool applyFisherZTransformFlagIn,
             const bool outputGiftiFlagIn,
-            const bool parallelFlagIn)
+            const bool parallelFlagIn,
+            const bool floatAccumulationFlagIn)
     : BrainModelAlgorithm(NULL),
       GiftiDataArrayReadListener(),
       mode(MODE_METRIC_INCREMENTAL),
       inputMetricFile(NULL),
       applyFisherZTransformFlag(applyFisherZTransformFlagIn),
       outputGiftiFlag(outputGiftiFlagIn),
-      parallelFlag(parallelFlagIn)
+      parallelFlag(parallelFlagIn),
+      floatAccumulationFlag(floatAccumulationFlagIn)
 {
    this->initialize();
    this->inputMetricFileName = inputMetricFileName;
@@ -109,7 +114,6 @@ BrainModelSurfaceMetricCorrelationMatrix::initialize()
    this->dataValues = NULL;
    this->rowMeans = NULL;
    this->rowSumSquared = NULL;
-   this->nextRowToProcess = -1;
 }
       
 /**
@@ -478,29 +482,18 @@ BrainModelSurfaceMetricCorrelationMatrix::computeSumSquared()
 void 
 BrainModelSurfaceMetricCorrelationMatrix::computeCorrelations(const Mode currentMode)
 {
-   this->nextRowToProcess = -1;
-
    switch (currentMode) {
    case MODE_FILES_IN_MEMORY:
-#ifdef _OPENMP
-      if (this->parallelFlag) {
-         long numThreads = omp_get_max_threads();
-         if (numThreads > 1) {
-            #pragma omp parallel for
-            for (long i = 0; i < numThreads; i++) {
-               this->computeCorrelationsForRows();
-            }
-         }
-         else {
-            this->computeCorrelationsForRows();
-         }
-      }
-      else {
-         this->computeCorrelationsForRows();
+      {
+         CorrelationMatrixEngine engine(this->dataValues,
+                                        this->rowSumSquared,
+                                        this->outputDimension,
+                                        this->inputNumColumns,
+                                        this->applyFisherZTransformFlag,
+                                        this->floatAccumulationFlag,
+                                        this->parallelFlag);
+         engine.computeCorrelationMatrix(this->outputDataArrayColumns);
       }
-#else
-      this->computeCorrelationsForRows();
-#endif
       break;
    case MODE_METRIC_INCREMENTAL:
       {
@@ -508,25 +501,13 @@ BrainModelSurfaceMetricCorrelationMatrix::computeCorrelations(const Mode current
          if (file == NULL) {
             throw BrainModelAlgorithmException("Failed to open output file for writing.");
          }
-#ifdef _OPENMP
-         if (this->parallelFlag) {
-            long numThreads = omp_get_max_threads();
-            if (numThreads > 1) {
-               #pragma omp parallel for
-               for (long i = 0; i < numThreads; i++) {
-                  this->computeCorrelationsForRowsMetricIncremental(file);
-               }
-            }
-            else {
-               this->computeCorrelationsForRowsMetricIncremental(file);
-            }
-         }
-         else {
+         try {
             this->computeCorrelationsForRowsMetricIncremental(file);
          }
-#else
-         this->computeCorrelationsForRowsMetricIncremental(file);
-#endif
+         catch (BrainModelAlgorithmException&) {
+            fclose(file);
+            throw;
+         }
          fclose(file);
       }
       break;
@@ -534,206 +515,35 @@ BrainModelSurfaceMetricCorrelationMatrix::computeCorrelations(const Mode current
 }
 
 /**
- * Sompute correlations for rows until there are no more rows to process.
- * Since the correlation matrix is symmetric, we only need to calculate
- * the lower half and can then copy the result to the upper half.
- */
-void 
-BrainModelSurfaceMetricCorrelationMatrix::computeCorrelationsForRows()
-{
-   const double tinyValue = 1.0e-20;
-
-   const long numJ = this->outputDimension;
-   const long numCols = this->inputNumColumns;
-
-   while (true) {
-      long iRow = -1;
-      
-      //
-      // Only one thread may execute this block at any time
-      //
-      #pragma omp critical
-      {
-         this->nextRowToProcess++;
-         iRow = this->nextRowToProcess;
-
-         if (timingFlag) {
-            if ((iRow % 1000) == 0) {
-               std::cout << "Processing row " << iRow << std::endl;
-            }
-         }
-      }  
-       
-      if (iRow >= this->outputDimension) {
-         break;
-      }
-
-      //
-      // Compare with remaining rows
-      //
-      for (long jRow = iRow; jRow < numJ; jRow++) {
-         //
-         //
-         // diff of mean from col I multiplied by diff of mean from column J
-         //
-         double sumSquaredBothColumns = 0.0;
-         for (long jCol = 0; jCol < numCols; jCol++) {
-            const long indxI = iRow * numCols + jCol;
-            const long indxJ = jRow * numCols + jCol;
-            sumSquaredBothColumns 
-               += (this->dataValues[indxI] * this->dataValues[indxJ]);
-         }
-         
-         //
-         // Compute correlation coefficient
-         //
-         const double denominator = this->rowSumSquared[iRow]
-                                  * this->rowSumSquared[jRow];
-         float r = 0.0;
-         if (denominator != 0.0) {
-            double sd = std::sqrt(denominator);
-            r = sumSquaredBothColumns / sd;
-         }
-         else {
-            r = sumSquaredBothColumns / tinyValue;
-         }
-         
-         /*
-          * Apply the Fisher Z-Transform?
-          */
-         if (this->applyFisherZTransformFlag) {
-            float denom = (1.0 - r);
-            if (denom != 0.0) {
-               r = 0.5 * std::log((1.0 + r) / denom);
-            }
-            else {
-               r = 0.5 * std::log((1.0 + r) / tinyValue);
-            }
-         }
-
-         //
-         // Matrix is symmetric !!!!
-         //
-         //this->outputMetricFile->setValue(iRow, jRow, r);
-         //this->outputMetricFile->setValue(jRow, iRow, r);
-         *(this->outputDataArrayColumns[iRow] + jRow) = r;
-         *(this->outputDataArrayColumns[jRow] + iRow) = r;
-      }
-   }
-}
-
-/**
- * Sompute correlations for rows until there are no more rows to process.
- * Since the correlation matrix is symmetric, we only need to calculate
- * the lower half and can then copy the result to the upper half.
- *
- * THIS is NOT functioning correctly.  Except for first part of output file,
- * the remainder appears to be zeros.
+ * Compute correlations for blocks of rows with all rows and write
+ * each block of rows to the file as it is completed.
  */
 void
 BrainModelSurfaceMetricCorrelationMatrix::computeCorrelationsForRowsMetricIncremental(FILE* file)
 {
-   const double tinyValue = 1.0e-20;
-   const long numJ = this->outputDimension;
-   const long numCols = this->inputNumColumns;
-
-   float* dataRow = new float[this->outputDimension];
-
-   while (true) {
-      long iRow = -1;
-
-      //
-      // Only one thread may execute this block at any time
-      //
-      #pragma omp critical
-      {
-         this->nextRowToProcess++;
-         iRow = this->nextRowToProcess;
-      }
-
-      if (iRow >= this->outputDimension) {
-         break;
-      }
-
-      //
-      // Compare with ALL rows
-      //
-      for (long jRow = 0; jRow < numJ; jRow++) {
-         //
-         //
-         // diff of mean from col I multiplied by diff of mean from column J
-         //
-         double sumSquaredBothColumns = 0.0;
-         for (long jCol = 0; jCol < numCols; jCol++) {
-            const long indxI = iRow * numCols + jCol;
-            const long indxJ = jRow * numCols + jCol;
-            sumSquaredBothColumns
-               += (this->dataValues[indxI] * this->dataValues[indxJ]);
-         }
-
-         //
-         // Compute correlation coefficient
-         //
-         const double denominator = this->rowSumSquared[iRow]
-                                  * this->rowSumSquared[jRow];
-         float r = 0.0;
-         if (denominator != 0.0) {
-            double sd = std::sqrt(denominator);
-            r = sumSquaredBothColumns / sd;
-         }
-         else {
-            r = sumSquaredBothColumns / tinyValue;
-         }
-
-         /*
-          * Apply the Fisher Z-Transform?
-          */
-         if (this->applyFisherZTransformFlag) {
-            float denom = (1.0 - r);
-            if (denom != 0.0) {
-               r = 0.5 * std::log((1.0 + r) / denom);
-            }
-            else {
-               r = 0.5 * std::log((1.0 + r) / tinyValue);
-            }
-         }
-
-         dataRow[jRow] = r;
-//         //
-//         // Matrix is symmetric !!!!
-//         //
-//         //this->outputMetricFile->setValue(iRow, jRow, r);
-//         //this->outputMetricFile->setValue(jRow, iRow, r);
-//         if (this->outputGiftiFlag) {
-//            const long indx1 = iRow * numJ + jRow;
-//            this->outputGiftiArrayData[indx1] = r;
-//            const long indx2 = jRow * numJ + iRow;
-//            this->outputGiftiArrayData[indx2] = r;
-//         }
-//         else {
-//            *(this->outputMetricArrayColumns[iRow] + jRow) = r;
-//            *(this->outputMetricArrayColumns[jRow] + iRow) = r;
-//         }
-      }
-
-      //
-      // Only one thread may execute this block at any time
-      //
-      #pragma omp critical
-      {
-         long offset = iRow * this->outputDimension * 4;
-         unsigned long numToWrite = this->outputDimension * 4;
-
-         if (fseek(file, offset, SEEK_SET) != 0) {
-            throw BrainModelAlgorithmException("Seek into output file failed.");
-         }
-         if (fwrite((void*)dataRow, 1, numToWrite, file) != numToWrite) {
-            throw BrainModelAlgorithmException("Failed to write bytes to output file.");
-         }
+   CorrelationMatrixEngine engine(this->dataValues,
+                                  this->rowSumSquared,
+                                  this->outputDimension,
+                                  this->inputNumColumns,
+                                  this->applyFisherZTransformFlag,
+                                  this->floatAccumulationFlag,
+                                  this->parallelFlag);
+
+   const long rowsPerBlock = CorrelationMatrixEngine::getTileSize() * 4;
+   float* dataRows = new float[rowsPerBlock * this->outputDimension];
+
+   for (long iRow = 0; iRow < this->outputDimension; iRow += rowsPerBlock) {
+      const long numRows = std::min(rowsPerBlock, this->outputDimension - iRow);
+      engine.computeCorrelationsForRows(iRow, numRows, dataRows);
+
+      const unsigned long numToWrite = numRows * this->outputDimension * 4;
+      if (fwrite((void*)dataRows, 1, numToWrite, file) != numToWrite) {
+         delete[] dataRows;
+         throw BrainModelAlgorithmException("Failed to write bytes to output file.");
       }
    }
 
-   delete[] dataRow;
+   delete[] dataRows;
 }
 
 
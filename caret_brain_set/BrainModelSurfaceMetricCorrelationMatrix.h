@@ -23,7 +23,8 @@ class BrainModelSurfaceMetricCorrelationMatrix : public BrainModelAlgorithm,
            MetricFile* inputMetricFileIn,
            const bool applyFisherZTransformFlagIn,
            const bool outputGiftiFlagIn,
-           const bool parallelFlagIn);
+           const bool parallelFlagIn,
+           const bool floatAccumulationFlagIn = false);
       
       // create instance for processing that reads and writes files incrementally
       // in order to minimize memory usage
@@ -32,7 +33,8 @@ class BrainModelSurfaceMetricCorrelationMatrix : public BrainModelAlgorithm,
                   const QString& outputMetricFileName,
                   const bool applyFisherZTransformFlagIn,
                   const bool outputGiftiFlagIn,
-                  const bool parallelFlagIn);
+                  const bool parallelFlagIn,
+                  const bool floatAccumulationFlagIn = false);
 
       // destructor
       ~BrainModelSurfaceMetricCorrelationMatrix();
@@ -84,10 +86,7 @@ class BrainModelSurfaceMetricCorrelationMatrix : public BrainModelAlgorithm,
       // compute the correlations
       void computeCorrelations(const Mode currentMode);
       
-      // compute correlations for rows until there are no more rows to process
-      void computeCorrelationsForRows();
-      
-      // compute correlations for rows until there are no more rows to process
+      // compute correlations for blocks of rows and write them to the file
       void computeCorrelationsForRowsMetricIncremental(FILE* file);
 
       const Mode mode;
@@ -125,12 +124,12 @@ class BrainModelSurfaceMetricCorrelationMatrix : public BrainModelAlgorithm,
       
       bool deleteOutputGiftiFlag;
       
-      long nextRowToProcess;
-      
       const bool outputGiftiFlag;
 
       const bool parallelFlag;
       
+      const bool floatAccumulationFlag;
+
 };
 
 #endif //  __BRAIN_MODEL_SURFACE_METRIC_CORRELATION_MATRIX_H__
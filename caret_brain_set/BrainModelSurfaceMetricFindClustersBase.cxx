@@ -25,6 +25,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <deque>
 #include <limits>
 #include <sstream>
 
@@ -32,7 +33,7 @@
 #include <QFile>
 #include <QTextStream>
 
-#include "BrainModelAlgorithmRunAsThread.h"
+#include "BrainModelAlgorithmThreadPoolTask.h"
 #include "BrainModelSurface.h"
 #include "BrainModelSurfaceMetricClustering.h"
 #include "BrainModelSurfaceMetricFindClustersBase.h"
@@ -142,11 +143,9 @@ BrainModelSurfaceMetricFindClustersBase::execute() throw (BrainModelAlgorithmExc
    }
    
    //
-   // check Shuffled TMap file name
-   // 
-   if (shuffledStatisticalMapFileName.isEmpty()) {
-      throw BrainModelAlgorithmException("Shuffled T-Map file name is empty.");
-   }
+   // Note: Shuffled Statistical Map file name is optional and the
+   // shuffled statistical map is only written when it is not empty.
+   //
    
    //
    // check Report file name
@@ -419,6 +418,7 @@ BrainModelSurfaceMetricFindClustersBase::findClustersSingleThread(MetricFile* mf
  */
 void
 BrainModelSurfaceMetricFindClustersBase::saveClusters(BrainModelSurfaceMetricClustering* bmsmc,
+                                                      const std::vector<float>& nodeAreas,
                                                       std::vector<Cluster>& clustersOut,
                                                       const int columnNumber,
                                                       const bool useLargestClusterPerColumnFlag)
@@ -428,12 +428,6 @@ BrainModelSurfaceMetricFindClustersBase::saveClusters(BrainModelSurfaceMetricClu
    //
    std::vector<Cluster> clusters;
    
-   //
-   // Node areas
-   //
-   std::vector<float> nodeAreas;
-   bms->getAreaOfAllNodes(nodeAreas);
-
    //
    // Process the clusters
    //
@@ -529,33 +523,23 @@ BrainModelSurfaceMetricFindClustersBase::findClustersMultiThread(MetricFile* mf,
    }
    
    //
-   // Next column that is to be processed
-   //
-   int nextColumnToProcess = startColumn;
-   
-   //
-   // Time to wait for threads in milliseconds
-   //
-   const unsigned long totalWaitTime = 1000;  // 1000 milliseconds == 1 second
-   const unsigned long threadWaitTime = totalWaitTime / numberOfThreads;
-   
-   //
-   // Pointers for algorithm threads
+   // Node areas
    //
-   std::vector<BrainModelAlgorithmRunAsThread*> algorithmThreads(numberOfThreads);
-   for (int i = 0; i < numberOfThreads; i++) {
-      algorithmThreads[i] = NULL;
-   }
+   std::vector<float> nodeAreas;
+   bms->getAreaOfAllNodes(nodeAreas);
    
    //
-   // Column number on which thread is operating
+   // Next column that is to be processed
    //
-   std::vector<int> threadColumnNumber(numberOfThreads, -1);
+   int nextColumnToProcess = startColumn;
    
    //
-   // One metric column per thread
+   // Tasks in the thread pool, their metric files and column numbers,
+   // in the order in which they were submitted
    //
-   std::vector<MetricFile> metricFilesForThreads(numberOfThreads);
+   std::deque<BrainModelAlgorithmThreadPoolTask*> columnTasks;
+   std::deque<MetricFile*> columnMetricFiles;
+   std::deque<int> columnNumbers;
    
    //
    // Progress data
@@ -569,124 +553,104 @@ BrainModelSurfaceMetricFindClustersBase::findClustersMultiThread(MetricFile* mf,
    bool done = false;
    while (done == false) {
       //
-      // Loop through the threads to see if any are done and create new threads
+      // Keep the number of columns in the thread pool at the number of threads
       //
-      for (int iThread = 0; iThread < numberOfThreads; iThread++) {
+      while ((nextColumnToProcess <= endColumn) &&
+             (static_cast<int>(columnTasks.size()) < numberOfThreads)) {
          //
-         // Is thread valid
+         // Update progress
          //
-         if (algorithmThreads[iThread] != NULL) {
-            //
-            // Wait on the thread
-            //
-            algorithmThreads[iThread]->wait(threadWaitTime);
-            
-            //
-            // Is the thread finished
-            //
-            if (algorithmThreads[iThread]->isFinished()) {
-               //
-               // Get the algorithm
-               //
-               BrainModelSurfaceMetricClustering* bmsmc = 
-                  dynamic_cast<BrainModelSurfaceMetricClustering*>(algorithmThreads[iThread]->getBrainModelAlgorithm());
-                  
-               //
-               // Save the clusters
-               //
-               saveClusters(bmsmc,
-                            clustersOut,
-                            threadColumnNumber[iThread],
-                            useLargestClusterPerColumnFlag);
-               
-               //
-               // delete the thread (which also deletes the algorithm)
-               //
-               delete algorithmThreads[iThread];
-               algorithmThreads[iThread] = NULL;
-            }
+         progressCounter++;
+         if (progressMessage.isEmpty() == false) {
+            std::ostringstream str;
+            str << progressMessage.toAscii().constData()
+                << ": "
+                << progressCounter
+                << " of "
+                << numProgress;
+            updateProgressDialog(str.str().c_str(), -1, -1);
          }
+
+         //
+         // Copy data to the task's metric file
+         //
+         MetricFile* columnMetricFile = new MetricFile;
+         columnMetricFile->setNumberOfNodesAndColumns(mf->getNumberOfNodes(), 1);
+         std::vector<float> nodeValues;
+         mf->getColumnForAllNodes(nextColumnToProcess, nodeValues);
+         columnMetricFile->setColumnForAllNodes(0, nodeValues);
          
          //
-         // Is the thread available ?
+         // Create a new cluster finding algorithm
          //
-         if (algorithmThreads[iThread] == NULL) {
-            //
-            // Are there still columns of data to process
-            //
-            if (nextColumnToProcess <= endColumn) {
-               //
-               // Update progress
-               //
-               progressCounter++;
-               if (progressMessage.isEmpty() == false) {
-                  std::ostringstream str;
-                  str << progressMessage.toAscii().constData()
-                      << ": "
-                      << progressCounter
-                      << " of "
-                      << numProgress;
-                  updateProgressDialog(str.str().c_str(), -1, -1);
-               }
-
-               //
-               // Set column being processed by thread (columns in report start at one)
-               //
-               threadColumnNumber[iThread] = nextColumnToProcess + 1;
-               
-               //
-               // Copy data to the thread's metric file
-               //
-               metricFilesForThreads[iThread].setNumberOfNodesAndColumns(mf->getNumberOfNodes(), 1);
-               std::vector<float> nodeValues;
-               mf->getColumnForAllNodes(nextColumnToProcess, nodeValues);
-               metricFilesForThreads[iThread].setColumnForAllNodes(0, nodeValues);
-               
-               //
-               // Create a new cluster finding algorithm
-               //
-               BrainModelSurfaceMetricClustering* clusterAlgorithm =
-                  new BrainModelSurfaceMetricClustering (brain,
-                                                    bms,
-                                                    &metricFilesForThreads[iThread],
-                                                    BrainModelSurfaceMetricClustering::CLUSTER_ALGORITHM_MINIMUM_SURFACE_AREA,
-                                                    0,
-                                                    0,
-                                                    "cluster",
-                                                    1,
-                                                    0.1,
-                                                    negMin,
-                                                    negMax,
-                                                    posMin,
-                                                    posMax,
-                                                    true);
-               
-               //
-               // Create a new thread to run the algorithm and take ownership of cluster algorithm
-               //
-               algorithmThreads[iThread] = 
-                  new BrainModelAlgorithmRunAsThread(clusterAlgorithm, true);
-               algorithmThreads[iThread]->start(QThread::HighestPriority);
-               //if (DebugControl::getDebugOn()) {
-                  std::cout << "Started thread " << iThread << " for column " << nextColumnToProcess << std::endl;
-               //}
-               
-               //
-               // Move on to next metric column
-               //
-               nextColumnToProcess++;
-            } // if (nextColumnToProcess <= endColumn)
-         } // if (algorithmThreads[iThread] == NULL) 
-      } // for (int iThread
-      
-      //
-      // Loop through the threads to see if any are still valid and if time to stop
-      //
-      done = true;
-      for (int iThread = 0; iThread < numberOfThreads; iThread++) {
-         if (algorithmThreads[iThread] != NULL) {
-            done = false;
+         BrainModelSurfaceMetricClustering* clusterAlgorithm =
+            new BrainModelSurfaceMetricClustering (brain,
+                                              bms,
+                                              columnMetricFile,
+                                              BrainModelSurfaceMetricClustering::CLUSTER_ALGORITHM_MINIMUM_SURFACE_AREA,
+                                              0,
+                                              0,
+                                              "cluster",
+                                              1,
+                                              0.1,
+                                              negMin,
+                                              negMax,
+                                              posMin,
+                                              posMax,
+                                              true);
+         
+         //
+         // Create a task to run the algorithm that takes ownership of cluster algorithm
+         //
+         BrainModelAlgorithmThreadPoolTask* task =
+            new BrainModelAlgorithmThreadPoolTask(clusterAlgorithm, true);
+         CaretThreadPool::getGlobalThreadPool()->submit(task);
+         if (DebugControl::getDebugOn()) {
+            std::cout << "Submitted cluster search for column " << nextColumnToProcess << std::endl;
          }
+         
+         //
+         // Column numbers in report start at one
+         //
+         columnTasks.push_back(task);
+         columnMetricFiles.push_back(columnMetricFile);
+         columnNumbers.push_back(nextColumnToProcess + 1);
+         
+         //
+         // Move on to next metric column
+         //
+         nextColumnToProcess++;
+      }
+      
+      if (columnTasks.empty()) {
+         done = true;
+      }
+      else {
+         //
+         // Wait for the oldest column so clusters are saved in column order
+         //
+         BrainModelAlgorithmThreadPoolTask* task = columnTasks.front();
+         task->waitForFinished();
+         
+         //
+         // Save the clusters
+         //
+         BrainModelSurfaceMetricClustering* bmsmc = 
+            dynamic_cast<BrainModelSurfaceMetricClustering*>(task->getBrainModelAlgorithm());
+         saveClusters(bmsmc,
+                      nodeAreas,
+                      clustersOut,
+                      columnNumbers.front(),
+                      useLargestClusterPerColumnFlag);
+         
+         //
+         // delete the task (which also deletes the algorithm) and the metric file
+         //
+         delete task;
+         delete columnMetricFiles.front();
+         columnTasks.pop_front();
+         columnMetricFiles.pop_front();
+         columnNumbers.pop_front();
       }
 
       //
@@ -702,258 +666,314 @@ BrainModelSurfaceMetricFindClustersBase::findClustersMultiThread(MetricFile* mf,
    std::sort(clustersOut.begin(), clustersOut.end());
    std::reverse(clustersOut.begin(), clustersOut.end());
 }
-/*
+
+/**
+ * Set randomized cluster p-values.
+ */
 void 
-BrainModelSurfaceMetricFindClustersBase::findClustersMultiThread(MetricFile* mf,
-                                                        std::vector<Cluster>& clustersOut,
-                                                        const QString& progressMessage,
-                                                        const int limitToColumn,
-                                                        const bool useLargestClusterPerColumnFlag,
-                                                        const int numberOfThreads)
-                                                           throw (BrainModelAlgorithmException)
+BrainModelSurfaceMetricFindClustersBase::setRandomizedClusterPValues(
+                                                 const MetricFile& randomFile, 
+                                                 std::vector<Cluster>& randomClusters)
 {
-   float posMin = positiveThresh;
-   float posMax = std::numeric_limits<float>::max();
-   float negMin = negativeThresh;
-   float negMax =  -std::numeric_limits<float>::max();
+   setRandomizedClusterPValues(randomFile.getNumberOfColumns(),
+                               randomClusters);
+}
+                                
+/**
+ * Set randomized cluster p-values using the number of iterations that
+ * produced the randomized clusters.
+ */
+void 
+BrainModelSurfaceMetricFindClustersBase::setRandomizedClusterPValues(
+                                                 const int numberOfIterationsIn, 
+                                                 std::vector<Cluster>& randomClusters)
+{
+   const float numberOfIterations = numberOfIterationsIn;
+   if (numberOfIterations <= 0.0) {
+       return;
+   }
+   
+   int numClusters = static_cast<int>(randomClusters.size());
+   for (int i = 0; i < numClusters; i++) {
+       const float pValue = (i + 1) / numberOfIterations;
+       Cluster& cluster = randomClusters[i];
+       cluster.pValue = pValue;
+   }
+}
+
+/**
+ * Compute the statistical map for one permutation.  The permutation must be
+ * determined only by the iteration index (see StatisticPermutation::setPermutationIndex())
+ * since permutations are computed in any order and by multiple threads.
+ */
+void 
+BrainModelSurfaceMetricFindClustersBase::computePermutedStatisticalMap(const int /*iterationIndex*/,
+                                                 std::vector<float>& /*valuesOut*/,
+                                                 QString& /*columnNameOut*/) throw (BrainModelAlgorithmException)
+{
+   throw BrainModelAlgorithmException("Program Error: Permuted statistical map is not "
+                                      "supported by this algorithm.");
+}
+
+/**
+ * Find the null distribution of the largest cluster and the maximum statistic.
+ *
+ * Each permutation's statistical map is computed, its clusters are found, and
+ * only the largest cluster and the maximum absolute statistic are kept so the
+ * permuted statistical maps never need to be held in memory at the same time.
+ * Permutations are processed in the thread pool when more than one thread is
+ * used.  If the shuffled statistical map file name is not empty, the permuted
+ * maps are also stored and written to the shuffled statistical map file.
+ *
+ * Largest clusters are sorted so biggest elements are first.  Maximum statistics
+ * are in iteration order.
+ */
+void 
+BrainModelSurfaceMetricFindClustersBase::findPermutationNullDistribution(
+                                           const int numberOfIterations,
+                                           const QString& progressMessage,
+                                           std::vector<Cluster>& largestClustersOut,
+                                           std::vector<float>& maximumStatisticsOut) 
+                                                    throw (BrainModelAlgorithmException)
+{
+   QTime timer;
+   timer.start();
+   
+   largestClustersOut.clear();
+   maximumStatisticsOut.clear();
+   if (numberOfIterations <= 0) {
+      return;
+   }
+   const int numberOfNodes = bms->getNumberOfNodes();
    
    //
-   // Determine columns for finding clusters
+   // Make sure the topology helper is created before any tasks run
+   // so that the tasks do not need to create it
    //
-   int startColumn = 0;
-   int endColumn = mf->getNumberOfColumns() - 1;
-   if (limitToColumn >= 0) {
-      if (limitToColumn >= mf->getNumberOfColumns()) {
-         std::ostringstream str;
-         str << "Invalid column: "
-             << limitToColumn
-             << " for file " 
-             << FileUtilities::basename(mf->getFileName()).toAscii().constData();
-         throw BrainModelAlgorithmException(str.str().c_str());
-      }
-      startColumn = limitToColumn;
-      endColumn   = limitToColumn;
+   bms->getTopologyFile()->getTopologyHelper(false, true, false);
+   
+   //
+   // Node areas are computed once since computing them in each task
+   // would nest their parallel loop in every thread of the pool
+   //
+   bms->getAreaOfAllNodes(permutationNodeAreas);
+   
+   //
+   // Permuted maps are only kept if they are to be written
+   //
+   if (shuffleStatisticalMapShapeFile != NULL) {
+      delete shuffleStatisticalMapShapeFile;
+      shuffleStatisticalMapShapeFile = NULL;
    }
+   if (shuffledStatisticalMapFileName.isEmpty() == false) {
+      shuffleStatisticalMapShapeFile = new MetricFile;
+      shuffleStatisticalMapShapeFile->setNumberOfNodesAndColumns(numberOfNodes,
+                                                                 numberOfIterations);
+   }
+   maximumStatisticsOut.reserve(numberOfIterations);
    
    //
-   // Process each column group with the size being the number of threads
+   // Limit the number of permutations in progress to limit memory usage
    //
-   int progressCounter = 0;
-   const int numProgress = endColumn - startColumn + 1;
-   for (int i = startColumn; i <= endColumn; i += numberOfThreads) {
-      if (DebugControl::getDebugOn()) {
-         std::cout << "Cluster analysis for column: " << i << std::endl;
-      }
-      
-      progressCounter++;
-      if (progressMessage.isEmpty() == false) {
-         std::ostringstream str;
-         str << progressMessage.toAscii().constData()
-             << ": "
-             << progressCounter
-             << " of "
-             << numProgress;
-         updateProgressDialog(str.str().c_str(), -1, -1);
-      }
-
-      //
-      // Create shape files for each of the threads
-      //
-      std::vector<MetricFile> tempShapeFile(numberOfThreads);
-
-      //
-      // Create storage for the algorithms and the threads
+   const bool useThreadPoolFlag = (numberOfThreads > 1);
+   const int maximumNumberOfTasks = std::max(numberOfThreads, 1) * 2;
+   
+   //
+   // Tasks in the order in which they were created
+   //
+   std::deque<BrainModelSurfaceMetricFindClustersPermutationTask*> permutationTasks;
+   int nextIterationToProcess = 0;
+   
+   bool done = false;
+   while (done == false) {
       //
-      std::vector<BrainModelSurfaceMetricClustering*> clusterAlgorithms(numberOfThreads);
-      std::vector<BrainModelAlgorithmRunAsThread*> algorithmThreads(numberOfThreads);
-      
+      // Keep the thread pool busy
       //
-      // Allow other events to process
-      //
-      allowEventsToProcess();
+      while ((nextIterationToProcess < numberOfIterations) &&
+             (static_cast<int>(permutationTasks.size()) < maximumNumberOfTasks)) {
+         BrainModelSurfaceMetricFindClustersPermutationTask* task =
+            new BrainModelSurfaceMetricFindClustersPermutationTask(this,
+                                                                   nextIterationToProcess);
+         permutationTasks.push_back(task);
+         nextIterationToProcess++;
+         if (useThreadPoolFlag) {
+            CaretThreadPool::getGlobalThreadPool()->submit(task);
+         }
+         else {
+            task->run();
+         }
+      }
       
-      //
-      // Create and start each of the threads
-      //
-      for (int iThread = 0; iThread < numberOfThreads; iThread++) {
+      if (permutationTasks.empty()) {
+         done = true;
+      }
+      else {
          //
-         // Column number being processed
+         // Wait for the oldest task so results are saved in iteration order
          //
-         const int columnNumber = i + iThread;
-         algorithmThreads[iThread] = NULL;
-         clusterAlgorithms[iThread] = NULL;
-         
-         if (columnNumber <= endColumn) {
-            //
-            // Create a shape file containing just the single column
-            //
-            tempShapeFile[iThread].setNumberOfNodesAndColumns(mf->getNumberOfNodes(), 1);
-            std::vector<float> nodeValues;
-            mf->getColumnForAllNodes(columnNumber, nodeValues);
-            tempShapeFile[iThread].setColumnForAllNodes(0, nodeValues);
-            
-            //
-            // Create the cluster algorithm
-            //
-            clusterAlgorithms[iThread] = new BrainModelSurfaceMetricClustering (brain,
-                                                    bms,
-                                                    &tempShapeFile[iThread],
-                                                    BrainModelSurfaceMetricClustering::CLUSTER_ALGORITHM_MINIMUM_SURFACE_AREA,
-                                                    0,
-                                                    0,
-                                                    "cluster",
-                                                    1,
-                                                    0.1,
-                                                    negMin,
-                                                    negMax,
-                                                    posMin,
-                                                    posMax);
-            
-            //
-            // Create the thread to run the algorithm and start it
-            //
-            algorithmThreads[iThread] = 
-               new BrainModelAlgorithmRunAsThread(clusterAlgorithms[iThread]);
-            algorithmThreads[iThread]->start();
-            algorithmThreads[iThread]->setPriority(QThread::HighestPriority);
-            if (DebugControl::getDebugOn()) {
-               std::cout << "Started thread " << iThread << " for column " << columnNumber << std::endl;
-            }
-         } // if (columnNumber <= endColumn)
-      } // for (int iThread
+         BrainModelSurfaceMetricFindClustersPermutationTask* task = permutationTasks.front();
+         permutationTasks.pop_front();
+         task->waitForFinished();
          
-      //
-      // Allow other events to process
-      //
-      allowEventsToProcess();
-      
-      //
-      // Wait for all of the threads to finish
-      //
-      for (int iThread = 0; iThread < numberOfThreads; iThread++) {
-         if (algorithmThreads[iThread] != NULL) {
-            algorithmThreads[iThread]->wait();
-            if (DebugControl::getDebugOn()) {
-               std::cout << "Thread finished " << iThread << std::endl;
-            }
+         QString errorMessage = task->getErrorMessage();
+         if (task->getTaskThrewAnException()) {
+            errorMessage = task->getExceptionErrorMessage();
          }
-      } // for (int iThread
-      
-      //
-      // Process the outputs of the cluster algorithms
-      //
-      for (int iThread = 0; iThread < numberOfThreads; iThread++) {
-         if (algorithmThreads[iThread] != NULL) {
-            //
-            // Pointer to the cluster algorithm
-            //
-            BrainModelSurfaceMetricClustering* bmsmc = clusterAlgorithms[iThread];
-            
-            //
-            // Storage for the clusters
-            //
-            std::vector<Cluster> clusters;
-            
-            //
-            // Process the clusters
-            //
-            const int numClusters = bmsmc->getNumberOfClusters();
-            for (int j = 0; j < numClusters; j++) {
-               const BrainModelSurfaceMetricClustering::Cluster* cluster = bmsmc->getCluster(j);
-               const int numNodesInCluster = cluster->getNumberOfNodesInCluster();
-
-               //
-               // Corrected area is sum of each node's area multiplied by
-               // 2 to the power of the selected metric column for the node
-               //
-               float correctedArea = 0.0;
-               if ((areaCorrectionShapeFile != NULL) ||
-                   (areaCorrectionShapeFileColumn >= 0)) {
-                  for (int k = 0; k < numNodesInCluster; k++) {
-                     const int nodeNum = cluster->getNodeInCluster(k);
-                     float nodeArea = bmsmc->getNodeArea(nodeNum);
-                     const double metric = areaCorrectionShapeFile->getValue(nodeNum, areaCorrectionShapeFileColumn);
-                     correctedArea += (nodeArea * std::pow(2.0, metric));
-                  }
-               }
-               
-               //
-               // Save the cluster information
-               //
-               float cog[3];
-               cluster->getCenterOfGravity(cog);
-               Cluster c;
-               c.column = i + iThread + 1;
-               c.numberOfNodes = cluster->getNumberOfNodesInCluster();
-               c.nodes = cluster->getNodesInCluster();
-               c.area = cluster->getArea();
-               c.areaCorrected = correctedArea;
-               c.cogX = cog[0];
-               c.cogY = cog[1];
-               c.cogZ = cog[2];
-               float threshMin, threshMax;
-               cluster->getThresholds(threshMin, threshMax);
-               c.threshMin = threshMin;
-               c.threshMax = threshMax;
-               clusters.push_back(c);
-            } // for (int j = 0; j < numClusters
-            
-            //
-            // Should only largest cluster be used
-            //
-            if (useLargestClusterPerColumnFlag) {
-               if (clusters.empty() == false) {
-                  std::sort(clusters.begin(), clusters.end());
-                  const int largestClusterIndex = static_cast<int>(clusters.size() - 1);
-                  clustersOut.push_back(clusters[largestClusterIndex]);
-               }
+         if (errorMessage.isEmpty() == false) {
+            delete task;
+            while (permutationTasks.empty() == false) {
+               permutationTasks.front()->waitForFinished();
+               delete permutationTasks.front();
+               permutationTasks.pop_front();
             }
-            else {
-               clustersOut.insert(clustersOut.end(), clusters.begin(), clusters.end());
-            }
-         } // if (algorithmThreads[iThread]
+            throw BrainModelAlgorithmException(errorMessage);
+         }
          
          //
-         // Free up memory
+         // Save the results of the permutation
          //
-         if (algorithmThreads[iThread] != NULL) {
-            delete algorithmThreads[iThread];
-            algorithmThreads[iThread] = NULL;
+         const int iterationIndex = task->getIterationIndex();
+         const std::vector<Cluster>& largestCluster = task->getLargestCluster();
+         largestClustersOut.insert(largestClustersOut.end(),
+                                   largestCluster.begin(), largestCluster.end());
+         maximumStatisticsOut.push_back(task->getMaximumStatistic());
+         if (shuffleStatisticalMapShapeFile != NULL) {
+            shuffleStatisticalMapShapeFile->setColumnForAllNodes(iterationIndex,
+                                                                 task->getValues());
+            shuffleStatisticalMapShapeFile->setColumnName(iterationIndex,
+                                                          task->getColumnName());
          }
-         if (clusterAlgorithms[iThread] != NULL) {
-            delete clusterAlgorithms[iThread];
-            clusterAlgorithms[iThread] = NULL;
+         delete task;
+         
+         //
+         // Update progress
+         //
+         if (progressMessage.isEmpty() == false) {
+            std::ostringstream str;
+            str << progressMessage.toAscii().constData()
+                << ": "
+                << (iterationIndex + 1)
+                << " of "
+                << numberOfIterations;
+            updateProgressDialog(str.str().c_str(), -1, -1);
          }
-      } // for (int iThread
-   }  // for (int i = startColumn
+      }
+      
+      //
+      // Allow other events to process
+      //
+      allowEventsToProcess();
+      
+   } // while (done == false)
    
    //
    // Sort clusters so biggest elements first
    //
-   std::sort(clustersOut.begin(), clustersOut.end());
-   std::reverse(clustersOut.begin(), clustersOut.end());
+   setNamesForClusters(largestClustersOut);
+   std::sort(largestClustersOut.begin(), largestClustersOut.end());
+   std::reverse(largestClustersOut.begin(), largestClustersOut.end());
+   
+   //
+   // Write the permuted maps
+   //
+   if (shuffleStatisticalMapShapeFile != NULL) {
+      try {
+         shuffleStatisticalMapShapeFile->writeFile(shuffledStatisticalMapFileName);
+      }
+      catch (FileException& e) {
+         std::ostringstream str;
+         str << "Unable to write Shuffled Statistical Map: "
+             << FileUtilities::basename(shuffledStatisticalMapFileName).toAscii().constData();
+         throw BrainModelAlgorithmException(str.str().c_str());
+      }
+   }
+   
+   if (DebugControl::getDebugOn()) {
+      std::cout << "Permutation null distribution with " << numberOfThreads << " threads: "
+                << (static_cast<float>(timer.elapsed()) / 1000.0) << " seconds." << std::endl;
+   }
 }
-*/
 
 /**
- * Set randomized cluster p-values.
+ * Compute one permutation's statistical map, its largest cluster (if there are
+ * any clusters), and the maximum absolute value of the statistic.
+ * Called from multiple threads.
  */
 void 
-BrainModelSurfaceMetricFindClustersBase::setRandomizedClusterPValues(
-                                                 const MetricFile& randomFile, 
-                                                 std::vector<Cluster>& randomClusters)
+BrainModelSurfaceMetricFindClustersBase::processPermutation(const int iterationIndex,
+                                                          std::vector<float>& valuesOut,
+                                                          QString& columnNameOut,
+                                                          std::vector<Cluster>& largestClusterOut,
+                                                          float& maximumStatisticOut) 
+                                                             throw (BrainModelAlgorithmException)
 {
-   const float numberOfIterations = randomFile.getNumberOfColumns();
-   if (numberOfIterations <= 0.0) {
-       return;
+   largestClusterOut.clear();
+   maximumStatisticOut = 0.0;
+   
+   //
+   // Compute the permuted statistical map
+   //
+   computePermutedStatisticalMap(iterationIndex, valuesOut, columnNameOut);
+   const int numberOfNodes = bms->getNumberOfNodes();
+   if (static_cast<int>(valuesOut.size()) != numberOfNodes) {
+      throw BrainModelAlgorithmException("Program Error: Permuted statistical map has "
+                                         "wrong number of nodes.");
+   }
+   for (int i = 0; i < numberOfNodes; i++) {
+      maximumStatisticOut = std::max(maximumStatisticOut, 
+                                     static_cast<float>(std::fabs(valuesOut[i])));
    }
    
-   int numClusters = static_cast<int>(randomClusters.size());
-   for (int i = 0; i < numClusters; i++) {
-       const float pValue = (i + 1) / numberOfIterations;
-       Cluster& cluster = randomClusters[i];
-       cluster.pValue = pValue;
+   //
+   // Find the clusters
+   //
+   MetricFile permutationMetricFile;
+   permutationMetricFile.setNumberOfNodesAndColumns(numberOfNodes, 1);
+   permutationMetricFile.setColumnForAllNodes(0, valuesOut);
+   BrainModelSurfaceMetricClustering bmsmc(brain,
+                                           bms,
+                                           &permutationMetricFile,
+                                           BrainModelSurfaceMetricClustering::CLUSTER_ALGORITHM_MINIMUM_SURFACE_AREA,
+                                           0,
+                                           0,
+                                           "cluster",
+                                           1,
+                                           0.1,
+                                           negativeThresh,
+                                           -std::numeric_limits<float>::max(),
+                                           positiveThresh,
+                                           std::numeric_limits<float>::max(),
+                                           true);
+   bmsmc.execute();
+   
+   //
+   // Keep only the largest cluster (column numbers start at one)
+   //
+   saveClusters(&bmsmc, permutationNodeAreas, largestClusterOut, iterationIndex + 1, true);
+}
+
+/**
+ * Get the statistic value at the p-value from the null distribution of the
+ * maximum statistic.  The value of a statistic must exceed this value to be 
+ * significant at the p-value (family wise).
+ */
+float 
+BrainModelSurfaceMetricFindClustersBase::getSignificantStatistic(
+                                   const std::vector<float>& maximumStatistics) const
+{
+   if (maximumStatistics.empty()) {
+      return std::numeric_limits<float>::max();
    }
+   
+   std::vector<float> sortedStatistics(maximumStatistics);
+   std::sort(sortedStatistics.begin(), sortedStatistics.end());
+   std::reverse(sortedStatistics.begin(), sortedStatistics.end());
+   
+   const int numberOfIterations = static_cast<int>(sortedStatistics.size());
+   int index = std::min(static_cast<int>(pValue * numberOfIterations) - 1,
+                        numberOfIterations - 1);
+   index = std::max(index, 0);
+   return sortedStatistics[index];
 }
                                 
 /**
@@ -1228,3 +1248,50 @@ BrainModelSurfaceMetricFindClustersBase::cleanUp()
    //
    // bms - it is owned by "brain"
 }
+
+//=============================================================================
+//
+// Task that computes a permutation in the thread pool
+//
+//=============================================================================
+
+/**
+ * constructor.
+ */
+BrainModelSurfaceMetricFindClustersPermutationTask::BrainModelSurfaceMetricFindClustersPermutationTask(
+                            BrainModelSurfaceMetricFindClustersBase* algorithmIn,
+                            const int iterationIndexIn)
+{
+   algorithm = algorithmIn;
+   iterationIndex = iterationIndexIn;
+   maximumStatistic = 0.0;
+   errorMessage = "";
+}
+
+/**
+ * destructor.
+ */
+BrainModelSurfaceMetricFindClustersPermutationTask::~BrainModelSurfaceMetricFindClustersPermutationTask()
+{
+}
+
+/**
+ * compute the permutation.
+ */
+void 
+BrainModelSurfaceMetricFindClustersPermutationTask::run()
+{
+   try {
+      algorithm->processPermutation(iterationIndex,
+                                    values,
+                                    columnName,
+                                    largestCluster,
+                                    maximumStatistic);
+   }
+   catch (BrainModelAlgorithmException& e) {
+      errorMessage = e.whatQString();
+      if (errorMessage.isEmpty()) {
+         errorMessage = "Permutation " + QString::number(iterationIndex) + " failed.";
+      }
+   }
+}
@@ -30,9 +30,11 @@
 #include <vector>
 
 #include "BrainModelAlgorithm.h"
+#include "CaretThreadPool.h"
 
 class BrainModelSurface;
 class BrainModelSurfaceMetricClustering;
+class BrainModelSurfaceMetricFindClustersPermutationTask;
 class MetricFile;
 class QTextStream;
 
@@ -149,6 +151,7 @@ class BrainModelSurfaceMetricFindClustersBase : public BrainModelAlgorithm {
       
       /// Get the clusters after the cluster finding algorithm has finished
       void saveClusters(BrainModelSurfaceMetricClustering* bmsmc,
+                        const std::vector<float>& nodeAreas,
                         std::vector<Cluster>& clustersOut,
                         const int columnNumber,
                         const bool useLargestClusterPerColumnFlag);
@@ -156,6 +159,32 @@ class BrainModelSurfaceMetricFindClustersBase : public BrainModelAlgorithm {
       // set randomized cluster p-values
       void setRandomizedClusterPValues(const MetricFile& randomFile, 
                                 std::vector<Cluster>& randomClusters);
+      
+      // set randomized cluster p-values
+      void setRandomizedClusterPValues(const int numberOfIterations, 
+                                std::vector<Cluster>& randomClusters);
+      
+      // compute the statistical map for one permutation (subclasses using
+      // findPermutationNullDistribution() must override; called from multiple threads)
+      virtual void computePermutedStatisticalMap(const int iterationIndex,
+                                         std::vector<float>& valuesOut,
+                                         QString& columnNameOut) throw (BrainModelAlgorithmException);
+      
+      // find the null distribution of largest cluster and maximum statistic by permutation
+      void findPermutationNullDistribution(const int numberOfIterations,
+                                           const QString& progressMessage,
+                                           std::vector<Cluster>& largestClustersOut,
+                                           std::vector<float>& maximumStatisticsOut) throw (BrainModelAlgorithmException);
+      
+      // compute one permutation's statistical map, largest cluster, and maximum statistic
+      void processPermutation(const int iterationIndex,
+                              std::vector<float>& valuesOut,
+                              QString& columnNameOut,
+                              std::vector<Cluster>& largestClusterOut,
+                              float& maximumStatisticOut) throw (BrainModelAlgorithmException);
+      
+      // get the statistic value at the p-value from the maximum statistic null distribution
+      float getSignificantStatistic(const std::vector<float>& maximumStatistics) const;
                                 
       // print the clusters
       void printClusters(QTextStream& stream, const std::vector<Cluster>& clusters,
@@ -243,6 +272,67 @@ class BrainModelSurfaceMetricFindClustersBase : public BrainModelAlgorithm {
       
       /// number of threads for cluster search
       int numberOfThreads;
+      
+      /// node areas computed once for all permutations
+      std::vector<float> permutationNodeAreas;
+      
+   friend class BrainModelSurfaceMetricFindClustersPermutationTask;
+};
+
+/// task that computes one permutation of the statistical map in the thread pool
+class BrainModelSurfaceMetricFindClustersPermutationTask : public CaretThreadPoolTask {
+   public:
+      // constructor
+      BrainModelSurfaceMetricFindClustersPermutationTask(
+                            BrainModelSurfaceMetricFindClustersBase* algorithmIn,
+                            const int iterationIndexIn);
+      
+      // destructor
+      ~BrainModelSurfaceMetricFindClustersPermutationTask();
+      
+      // compute the permutation
+      void run();
+      
+      /// get the iteration index
+      int getIterationIndex() const { return iterationIndex; }
+      
+      /// get the permuted statistical map values
+      const std::vector<float>& getValues() const { return values; }
+      
+      /// get the name of the permuted statistical map
+      QString getColumnName() const { return columnName; }
+      
+      /// get the largest cluster (empty if there are no clusters)
+      const std::vector<BrainModelSurfaceMetricFindClustersBase::Cluster>& getLargestCluster() const
+                                                              { return largestCluster; }
+      
+      /// get the maximum absolute value of the statistic
+      float getMaximumStatistic() const { return maximumStatistic; }
+      
+      /// get the error message (empty if no error)
+      QString getErrorMessage() const { return errorMessage; }
+      
+   protected:
+      /// the algorithm
+      BrainModelSurfaceMetricFindClustersBase* algorithm;
+      
+      /// the iteration index
+      int iterationIndex;
+      
+      /// the permuted statistical map values
+      std::vector<float> values;
+      
+      /// name of the permuted statistical map
+      QString columnName;
+      
+      /// the largest cluster
+      std::vector<BrainModelSurfaceMetricFindClustersBase::Cluster> largestCluster;
+      
+      /// maximum absolute value of the statistic
+      float maximumStatistic;
+      
+      /// error message
+      QString errorMessage;
 };
 
 #endif // __BRAIN_MODEL_SURFACE_SHAPE_FIND_CLUSTERS_BASE_H__
@@ -131,7 +131,6 @@ BrainModelSurfaceMetricInterHemClusters::executeClusterSearch() throw (BrainMode
       ALG_STEP_TMAP_PRODUCT,
       ALG_STEP_SHUFFLED_TMAP_LEFT,
       ALG_STEP_SHUFFLED_TMAP_RIGHT,
-      ALG_STEP_SHUFFLED_TMAP_PRODUCT,
       ALG_STEP_FINDING_CLUSTERS_T_MAP,
       ALG_STEP_FINDING_CLUSTERS_SHUFFLE_T_MAP,
       ALG_NUM_STEPS
@@ -389,7 +388,8 @@ BrainModelSurfaceMetricInterHemClusters::executeClusterSearch() throw (BrainMode
                                                                 brain->getTopologyFile(0),
                                                                 tVarianceSmoothingIterations,
                                                                 tVarianceSmoothingStrength,
-                                                                false);
+                                                                false,
+                                                                RANDOM_STREAM_SHUFFLE_LEFT);
    }
    catch (FileException& e) {
       std::ostringstream str;
@@ -435,7 +435,8 @@ BrainModelSurfaceMetricInterHemClusters::executeClusterSearch() throw (BrainMode
                                                                 brain->getTopologyFile(0),
                                                                 tVarianceSmoothingIterations,
                                                                 tVarianceSmoothingStrength,
-                                                                false);
+                                                                false,
+                                                                RANDOM_STREAM_SHUFFLE_RIGHT);
    }
    catch (FileException& e) {
       std::ostringstream str;
@@ -459,52 +460,6 @@ BrainModelSurfaceMetricInterHemClusters::executeClusterSearch() throw (BrainMode
       throw BrainModelAlgorithmException(str.str().c_str());
    }
 
-   //
-   // Update progress
-   //
-   updateProgressDialog("Creating Shuffled T-Map Product",
-                        ALG_STEP_SHUFFLED_TMAP_PRODUCT,
-                        ALG_NUM_STEPS);
-     
-   //
-   // Create shuffled T-Map product file
-   //
-   shuffleStatisticalMapShapeFile = new MetricFile;
-   shuffleStatisticalMapShapeFile->setNumberOfNodesAndColumns(numberOfNodes, iterationsShuffledTMap);
-   QString stMapCom("Shuffled T-Map Product of ");
-   stMapCom.append(FileUtilities::basename(leftShuffledTMapFileName));
-   stMapCom.append(" and ");
-   stMapCom.append(FileUtilities::basename(rightShuffledTMapFileName));
-   statisticalMapShapeFile->setFileComment(stMapCom);
-   for (int j = 0; j < iterationsShuffledTMap; j++) {
-      const int leftCol = StatisticRandomNumber::randomInteger(0, leftShuffledTMapShapeFile->getNumberOfColumns() - 1);
-      const int rightCol = StatisticRandomNumber::randomInteger(0, rightShuffledTMapShapeFile->getNumberOfColumns() - 1);
-      std::ostringstream str;
-      str << "Left=" << leftCol
-          << "   "
-          << "Right=" << rightCol;
-      shuffleStatisticalMapShapeFile->setColumnComment(j, str.str().c_str());
-      for (int i = 0; i < numberOfNodes; i++) {
-         shuffleStatisticalMapShapeFile->setValue(i, j,
-                                 leftShuffledTMapShapeFile->getValue(i, leftCol) *
-                                 rightShuffledTMapShapeFile->getValue(i, rightCol));
-      }
-   }
-
-   //
-   // Write Right Shuffled  T-Map product file
-   //
-   try {
-      shuffleStatisticalMapShapeFile->writeFile(shuffledStatisticalMapFileName);
-   }
-   catch (FileException& e) {
-      std::ostringstream str;
-      str << "Unable to write right Shuffled T-Map: "
-          << FileUtilities::basename(shuffledStatisticalMapFileName).toAscii().constData();
-      cleanUp();
-      throw BrainModelAlgorithmException(str.str().c_str());
-   }
-   
    //
    // Update progress
    //
@@ -528,16 +483,27 @@ BrainModelSurfaceMetricInterHemClusters::executeClusterSearch() throw (BrainMode
                         ALG_NUM_STEPS);
                         
    //
-   // find the clusters in Shuffled T-Map
-   // Note: Only use largest cluster from each column
+   // find the clusters in Shuffled T-Map product.  Each shuffled T-Map
+   // product is computed, and its largest cluster found, by the permutation
+   // engine so that all of the shuffled T-Map products are never in memory.
    //
    std::vector<Cluster> shuffleTMapClusters;
-   findClusters(shuffleStatisticalMapShapeFile, shuffleTMapClusters, "Finding clusters in Shuffled T-Map", -1, true);
+   std::vector<float> shuffleTMapMaximumStatistics;
+   try {
+      findPermutationNullDistribution(iterationsShuffledTMap,
+                                      "Finding clusters in Shuffled T-Map",
+                                      shuffleTMapClusters,
+                                      shuffleTMapMaximumStatistics);
+   }
+   catch (BrainModelAlgorithmException& e) {
+      cleanUp();
+      throw e;
+   }
    
    //
    // Set pValue for shuffled T-Map
    // 
-   setRandomizedClusterPValues(*shuffleStatisticalMapShapeFile,
+   setRandomizedClusterPValues(iterationsShuffledTMap,
                                shuffleTMapClusters);
                                
    //
@@ -705,3 +671,35 @@ BrainModelSurfaceMetricInterHemClusters::cleanUp()
       rightShuffledTMapShapeFile = NULL;
    }
 }
+
+/**
+ * Compute the shuffled T-Map product for one permutation (called from multiple 
+ * threads).  A randomly selected column of the left shuffled T-Map is multiplied
+ * by a randomly selected column of the right shuffled T-Map.
+ */
+void 
+BrainModelSurfaceMetricInterHemClusters::computePermutedStatisticalMap(const int iterationIndex,
+                                                  std::vector<float>& valuesOut,
+                                                  QString& columnNameOut) throw (BrainModelAlgorithmException)
+{
+   if ((leftShuffledTMapShapeFile == NULL) ||
+       (rightShuffledTMapShapeFile == NULL)) {
+      throw BrainModelAlgorithmException("Program Error: Shuffled T-Map product input is invalid.");
+   }
+   
+   StatisticRandomNumber randomNumber(iterationIndex, RANDOM_STREAM_SHUFFLE_PRODUCT);
+   const int leftCol = randomNumber.nextInteger(0, leftShuffledTMapShapeFile->getNumberOfColumns() - 1);
+   const int rightCol = randomNumber.nextInteger(0, rightShuffledTMapShapeFile->getNumberOfColumns() - 1);
+   std::ostringstream str;
+   str << "Left=" << leftCol
+       << "   "
+       << "Right=" << rightCol;
+   columnNameOut = str.str().c_str();
+   
+   const int numberOfNodes = leftShuffledTMapShapeFile->getNumberOfNodes();
+   valuesOut.resize(numberOfNodes);
+   for (int i = 0; i < numberOfNodes; i++) {
+      valuesOut[i] = leftShuffledTMapShapeFile->getValue(i, leftCol) *
+                     rightShuffledTMapShapeFile->getValue(i, rightCol);
+   }
+}
@@ -73,12 +73,28 @@ class BrainModelSurfaceMetricInterHemClusters : public BrainModelSurfaceMetricFi
       ~BrainModelSurfaceMetricInterHemClusters();
       
    protected:
+      /// random number streams so that the left and right shuffles and the
+      /// selection of the product columns are independent of each other
+      enum RANDOM_STREAM {
+         /// left hemisphere shuffled T-Map
+         RANDOM_STREAM_SHUFFLE_LEFT = 1,
+         /// right hemisphere shuffled T-Map
+         RANDOM_STREAM_SHUFFLE_RIGHT = 2,
+         /// columns of shuffled T-Map product
+         RANDOM_STREAM_SHUFFLE_PRODUCT = 3
+      };
+      
       /// must be implemented by subclasses
       void executeClusterSearch() throw (BrainModelAlgorithmException);
       
       // free memory
       void cleanUp();
       
+      // compute the shuffled T-Map product for one permutation
+      void computePermutedStatisticalMap(const int iterationIndex,
+                                         std::vector<float>& valuesOut,
+                                         QString& columnNameOut) throw (BrainModelAlgorithmException);
+      
       /// name of shape file Right A
       QString shapeFileRightAName;
    
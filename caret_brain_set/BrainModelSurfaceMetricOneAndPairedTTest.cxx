@@ -88,6 +88,7 @@ BrainModelSurfaceMetricOneAndPairedTTest::BrainModelSurfaceMetricOneAndPairedTTe
    metricFileNames = metricFileNamesIn;
    tTestConstant  = tTestConstantIn;
    permutationIterations = permutationIterationsIn;
+   permutationMetricFile = NULL;
 }
 
 /**
@@ -109,7 +110,6 @@ BrainModelSurfaceMetricOneAndPairedTTest::executeClusterSearch() throw (BrainMod
    enum {
       ALG_STEP_CHECKING_INPUT,
       ALG_STEP_TMAP,
-      ALG_STEP_PERMUTED_TMAP,
       ALG_STEP_FINDING_CLUSTERS_T_MAP,
       ALG_STEP_FINDING_CLUSTERS_PERMUTED_T_MAP,
       ALG_NUM_STEPS
@@ -128,7 +128,7 @@ BrainModelSurfaceMetricOneAndPairedTTest::executeClusterSearch() throw (BrainMod
    //
    // check iterations
    //
-   if (permutationIterations < 0) {
+   if (permutationIterations <= 0) {
       throw BrainModelAlgorithmException("Permutation iterations must be positive.");
    }
 
@@ -213,46 +213,6 @@ BrainModelSurfaceMetricOneAndPairedTTest::executeClusterSearch() throw (BrainMod
       cleanUp();
       throw BrainModelAlgorithmException(str.str().c_str());
    }
-   
-   
-   //
-   // Update progress
-   //
-   updateProgressDialog("Doing Permuted T-Map",
-                        ALG_STEP_PERMUTED_TMAP,
-                        ALG_NUM_STEPS);
-                        
-   //
-   // Do shuffled T-Map
-   //
-   try {
-      shuffleStatisticalMapShapeFile = metricFile.computePermutedTValues(tTestConstant,
-                                                               permutationIterations,
-                                                               brain->getTopologyFile(0),
-                                                               tVarianceSmoothingIterations,
-                                                               tVarianceSmoothingStrength);
-   }
-   catch (FileException& e) {
-      std::ostringstream str;
-      str << "Permuted T-Map failure: "
-          << e.whatQString().toAscii().constData();
-      cleanUp();
-      throw BrainModelAlgorithmException(str.str().c_str());
-   }
-
-   //
-   // Write Shuffled  T-Map file
-   //
-   try {
-      shuffleStatisticalMapShapeFile->writeFile(shuffledStatisticalMapFileName);
-   }
-   catch (FileException& e) {
-      std::ostringstream str;
-      str << "Unable to write Permuted T-Map: "
-          << FileUtilities::basename(shuffledStatisticalMapFileName).toAscii().constData();
-      cleanUp();
-      throw BrainModelAlgorithmException(str.str().c_str());
-   }
 
    //
    // Update progress
@@ -276,16 +236,29 @@ BrainModelSurfaceMetricOneAndPairedTTest::executeClusterSearch() throw (BrainMod
                         ALG_NUM_STEPS);
                         
    //
-   // find the clusters in Shuffled T-Map
-   // Note: Only use largest cluster from each column
+   // find the clusters in Permuted T-Map.  Each permuted T-Map is
+   // computed, and its largest cluster found, by the permutation engine
+   // so that all of the permuted T-Maps are never in memory.
    //
    std::vector<Cluster> shuffleTMapClusters;
-   findClusters(shuffleStatisticalMapShapeFile, shuffleTMapClusters, "Finding Clusters in Permuted T-Map", -1, true);
+   std::vector<float> shuffleTMapMaximumStatistics;
+   permutationMetricFile = &metricFile;
+   try {
+      findPermutationNullDistribution(permutationIterations,
+                                      "Finding Clusters in Permuted T-Map",
+                                      shuffleTMapClusters,
+                                      shuffleTMapMaximumStatistics);
+   }
+   catch (BrainModelAlgorithmException& e) {
+      cleanUp();
+      throw e;
+   }
+   permutationMetricFile = NULL;
    
    //
    // Set pValue for shuffled T-Map
    // 
-   setRandomizedClusterPValues(*shuffleStatisticalMapShapeFile,
+   setRandomizedClusterPValues(permutationIterations,
                                shuffleTMapClusters);
                                
    //
@@ -513,5 +486,35 @@ BrainModelSurfaceMetricOneAndPairedTTest::pairedTTestProcessing(MetricFile& metr
 void 
 BrainModelSurfaceMetricOneAndPairedTTest::cleanUp()
 {
+   permutationMetricFile = NULL;
    BrainModelSurfaceMetricFindClustersBase::cleanUp();
 }
+
+/**
+ * Compute the permuted T-Map for one permutation (called from multiple threads).
+ */
+void 
+BrainModelSurfaceMetricOneAndPairedTTest::computePermutedStatisticalMap(const int iterationIndex,
+                                                  std::vector<float>& valuesOut,
+                                                  QString& columnNameOut) throw (BrainModelAlgorithmException)
+{
+   if (permutationMetricFile == NULL) {
+      throw BrainModelAlgorithmException("Program Error: Permuted T-Map input is invalid.");
+   }
+   
+   try {
+      permutationMetricFile->computePermutedTValuesRepetition(iterationIndex,
+                                                              tTestConstant,
+                                                              brain->getTopologyFile(0),
+                                                              tVarianceSmoothingIterations,
+                                                              tVarianceSmoothingStrength,
+                                                              valuesOut);
+   }
+   catch (FileException& e) {
+      std::ostringstream str;
+      str << "Permuted T-Map failure: "
+          << e.whatQString().toAscii().constData();
+      throw BrainModelAlgorithmException(str.str().c_str());
+   }
+   columnNameOut = "Permuted T-Values";
+}
@@ -72,6 +72,11 @@ class BrainModelSurfaceMetricOneAndPairedTTest : public BrainModelSurfaceMetricF
       // free memory
       virtual void cleanUp();
       
+      // compute the permuted T-Map for one permutation
+      void computePermutedStatisticalMap(const int iterationIndex,
+                                         std::vector<float>& valuesOut,
+                                         QString& columnNameOut) throw (BrainModelAlgorithmException);
+      
       // create the metric file for one-sample T-Test processing
       void oneSampleTTestProcessing(MetricFile& metricFileOut) throw (BrainModelAlgorithmException);
       
@@ -89,6 +94,9 @@ class BrainModelSurfaceMetricOneAndPairedTTest : public BrainModelSurfaceMetricF
       
       /// t-test mode
       T_TEST_MODE tTestMode;    
+      
+      /// metric file whose columns are sign flipped for permutations
+      const MetricFile* permutationMetricFile;
 };
 
 #endif // __BRAIN_MODEL_SURFACE_ONE_SAMPLE_T_TEST_H
@@ -32,6 +32,7 @@
 #include "BrainModelSurface.h"
 #include "BrainModelSurfaceMetricFullWidthHalfMaximum.h"
 #include "BrainModelSurfaceMetricSmoothing.h"
+#include "BrainModelSurfaceMetricSmoothingOperator.h"
 #include "DebugControl.h"
 #include "GaussianComputation.h"
 #include "GeodesicHelper.h"
@@ -163,21 +164,37 @@ BrainModelSurfaceMetricSmoothing::execute() throw (BrainModelAlgorithmException)
                              gaussSigmaTang,
                              gaussTangentCutoff);
    
-   //
-   // Determine the neighbors for each node
-   //
-   determineNeighbors();
-   
    //
    // Full width half maximum measurements
    //
    float fullWidthHalfMaximum = 0.0;
    int fullWidthHalfMaximumNumberOfIterations = 0;
    
+   //
+   // Linear algorithms are applied as a sparse matrix of weights that is
+   // assembled once or mapped from a cache file (the loop below is then skipped)
+   //
+   int iterationsRemaining = iterations;
+   BrainModelSurfaceMetricSmoothingOperator smoothingOperator(numberOfNodes);
+   if (createSmoothingOperator(smoothingOperator)) {
+      smoothingOperator.smoothColumns(metricFile,
+                                      std::vector<int>(1, smoothColumn),
+                                      std::vector<int>(1, smoothColumn),
+                                      iterations,
+                                      true);
+      iterationsRemaining = 0;
+   }
+   else {
+      //
+      // Determine the neighbors for each node
+      //
+      determineNeighbors();
+   }
+   
    //
    // Prepate for smoothing
    //
-   for (int iter = 0; iter < iterations; iter++) {
+   for (int iter = 0; iter < iterationsRemaining; iter++) {
    
       bool stopSmoothingFlag = false;
       switch (algorithm) {
@@ -413,10 +430,11 @@ BrainModelSurfaceMetricSmoothing::execute() throw (BrainModelAlgorithmException)
                case SMOOTH_ALGORITHM_GEODESIC_GAUSSIAN:
                   {//distance to neighbor is geodesic, not euclidean, check determineNeighbors
                      int j, end = neighInfo.numNeighbors;
-                     float totalWeight = 0.0f, weight;
+                     float totalWeight = 0.0f, weight, tempf;
                      for (j = 0; j < end; ++j)
                      {//weighted average, using gaussian of geodesic distance as weight
-                        weight = neighInfo.geoGaussWeight[j];//the gaussian function, this could be precomputed in determineNeighbors
+                        tempf = neighInfo.distanceToNeighbor[j] / geodesicGaussSigma;
+                        weight = std::exp(-tempf * tempf * 0.5f);//the gaussian function
                         totalWeight += weight;
                         neighborSum += weight * inputValues[neighInfo.neighbors[j]];
                      }
@@ -528,6 +546,75 @@ BrainModelSurfaceMetricSmoothing::execute() throw (BrainModelAlgorithmException)
    delete[] outputValues;
 }
 
+/**
+ * Create the sparse smoothing operator containing the weights of one iteration.
+ * Returns false if the algorithm is not linear (dilation and full width half 
+ * maximum, which must measure the data during smoothing).
+ */
+bool 
+BrainModelSurfaceMetricSmoothing::createSmoothingOperator(BrainModelSurfaceMetricSmoothingOperator& smoothingOperator)
+{
+   BrainModelSurfaceMetricSmoothingOperator::Kernel::TYPE kernelType =
+      BrainModelSurfaceMetricSmoothingOperator::Kernel::TYPE_AVERAGE_NEIGHBORS;
+   switch (algorithm) {
+      case SMOOTH_ALGORITHM_AVERAGE_NEIGHBORS:
+         kernelType = BrainModelSurfaceMetricSmoothingOperator::Kernel::TYPE_AVERAGE_NEIGHBORS;
+         break;
+      case SMOOTH_ALGORITHM_SURFACE_NORMAL_GAUSSIAN:
+         kernelType = BrainModelSurfaceMetricSmoothingOperator::Kernel::TYPE_SURFACE_NORMAL_GAUSSIAN;
+         break;
+      case SMOOTH_ALGORITHM_WEIGHTED_AVERAGE_NEIGHBORS:
+         kernelType = BrainModelSurfaceMetricSmoothingOperator::Kernel::TYPE_WEIGHTED_AVERAGE_NEIGHBORS;
+         break;
+      case SMOOTH_ALGORITHM_GEODESIC_GAUSSIAN:
+         kernelType = BrainModelSurfaceMetricSmoothingOperator::Kernel::TYPE_GEODESIC_GAUSSIAN;
+         break;
+      case SMOOTH_ALGORITHM_DILATE:
+      case SMOOTH_ALGORITHM_FULL_WIDTH_HALF_MAXIMUM:
+      case SMOOTH_ALGORITHM_NONE:
+         return false;
+         break;
+   }
+   
+   const BrainModelSurfaceMetricSmoothingOperator::Kernel kernel(kernelType,
+                                                                 strength,
+                                                                 gaussNormBelowCutoff,
+                                                                 gaussNormAboveCutoff,
+                                                                 gaussSigmaNorm,
+                                                                 gaussSigmaTang,
+                                                                 gaussTangentCutoff,
+                                                                 geodesicGaussSigma);
+   smoothingOperator.create(kernel,
+                            "BrainModelSurfaceMetricSmoothing",
+                            fiducialSurface,
+                            gaussianSphericalSurface,
+                            operatorCacheDirectoryName,
+                            this);
+   
+   return smoothingOperator.isComplete();
+}
+
+/**
+ * get the neighbors of a node and the distances to them.
+ */
+void 
+BrainModelSurfaceMetricSmoothing::getNeighborsOfNode(const int nodeNumber,
+                                                     const std::vector<int>*& neighborsOut,
+                                                     const std::vector<float>*& distancesOut) const
+{
+   neighborsOut = &nodeNeighbors[nodeNumber].neighbors;
+   distancesOut = &nodeNeighbors[nodeNumber].distanceToNeighbor;
+}
+
+/**
+ * free the neighbors of the nodes.
+ */
+void 
+BrainModelSurfaceMetricSmoothing::clearNeighbors()
+{
+   nodeNeighbors.clear();
+}
+
 /**
  * determine neighbors for each node.
  */
@@ -540,6 +627,15 @@ BrainModelSurfaceMetricSmoothing::determineNeighbors()
     nodeNeighbors.clear();
     nodeNeighbors.resize(numberOfNodes);
 
+    //
+    // Surface graph for geodesic distances is shared by all threads
+    //
+    GeodesicHelperBase* geodesicBase = NULL;
+    if (algorithm == SMOOTH_ALGORITHM_GEODESIC_GAUSSIAN) {
+        geodesicBase = new GeodesicHelperBase(fiducialSurface->getCoordinateFile(),
+                                              fiducialSurface->getTopologyFile());
+    }
+
     QTime timer;
     timer.start();
 #ifdef _OPENMP
@@ -559,7 +655,7 @@ BrainModelSurfaceMetricSmoothing::determineNeighbors()
         GeodesicHelper* gh = NULL;
         float maxDistanceCutoff = std::numeric_limits<float>::max();
         float geoCutoff = 4.0f * geodesicGaussSigma;
-        std::vector<float>* geoGaussWeight = NULL, distance;
+        std::vector<float> distance;
         switch (algorithm) {
         case SMOOTH_ALGORITHM_AVERAGE_NEIGHBORS:
             break;
@@ -577,8 +673,7 @@ BrainModelSurfaceMetricSmoothing::determineNeighbors()
             break;
         case SMOOTH_ALGORITHM_GEODESIC_GAUSSIAN:
             cf = fiducialSurface->getCoordinateFile();
-            gh = new GeodesicHelper(cf, topologyFile);//each thread gets its own
-            geoGaussWeight = new std::vector<float>;
+            gh = new GeodesicHelper(geodesicBase);//each thread gets its own scratch arrays
             break;
         case SMOOTH_ALGORITHM_NONE:
             break;
@@ -592,8 +687,6 @@ BrainModelSurfaceMetricSmoothing::determineNeighbors()
 #endif
         for (int i = 0; i < numberOfNodes; i++) {
             std::vector<int> neighbors;
-            int numNeigh;
-            float tempf;
 
             switch (algorithm) {
             case SMOOTH_ALGORITHM_AVERAGE_NEIGHBORS:
@@ -623,13 +716,6 @@ BrainModelSurfaceMetricSmoothing::determineNeighbors()
                     neighbors.push_back(i);//for geogauss, we want the center node in the list
                     gh->getGeoToTheseNodes(i, neighbors, distance, true);
                 }
-                numNeigh = (int)neighbors.size();
-                geoGaussWeight->resize(numNeigh);
-                for (int j = 0; j < numNeigh; ++j)
-                {
-                   tempf = distance[j] / geodesicGaussSigma;
-                   (*geoGaussWeight)[j] = std::exp(-tempf * tempf * 0.5f);//the gaussian function
-                }
                 break;
             case SMOOTH_ALGORITHM_NONE:
                 break;
@@ -638,11 +724,11 @@ BrainModelSurfaceMetricSmoothing::determineNeighbors()
             //
             // add to all neighbors
             //
-            nodeNeighbors[i] = NeighborInfo(cf, i, neighbors, maxDistanceCutoff, geoGaussWeight);
+            nodeNeighbors[i] = NeighborInfo(cf, i, neighbors, maxDistanceCutoff, (gh ? &distance : NULL));
         }
         if (gh) delete gh;
-        if (geoGaussWeight) delete geoGaussWeight;
     }//omp parallel
+    if (geodesicBase) delete geodesicBase;
     const float elapsedTime = timer.elapsed() * 0.001;
     if (DebugControl::getDebugOn()) {
         std::cout << "Time to determine neighbors: " << elapsedTime << " seconds." << std::endl;
@@ -658,12 +744,12 @@ BrainModelSurfaceMetricSmoothing::NeighborInfo::NeighborInfo(const CoordinateFil
                                                     const int myNodeNumber,
                                                     const std::vector<int>& neighborsIn,
                                                     const float maxDistanceCutoff,
-                                                    const std::vector<float>* distanceWeights)
+                                                    const std::vector<float>* distances)
 {
    const int numNeighborsIn = static_cast<int>(neighborsIn.size());
-   if (distanceWeights)
+   if (distances)
    {//use STL vector copy operator, don't need to exclude anything
-      geoGaussWeight = *distanceWeights;
+      distanceToNeighbor = *distances;
       neighbors = neighborsIn;
    } else {
       for (int i = 0; i < numNeighborsIn; i++) {
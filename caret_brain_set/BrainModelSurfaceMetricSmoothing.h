@@ -30,13 +30,15 @@
 #include <vector>
 
 #include "BrainModelAlgorithm.h"
+#include "BrainModelSurfaceMetricSmoothingOperator.h"
 
 class BrainModelSurface;
 class CoordinateFile;
 class MetricFile;
 
 /// Class for smoothing metric data
-class BrainModelSurfaceMetricSmoothing : public BrainModelAlgorithm {
+class BrainModelSurfaceMetricSmoothing : public BrainModelAlgorithm,
+                                         public BrainModelSurfaceMetricSmoothingOperator::NeighborProvider {
    public:
       /// smoothing algorithms
       enum SMOOTH_ALGORITHM {
@@ -78,10 +80,25 @@ class BrainModelSurfaceMetricSmoothing : public BrainModelAlgorithm {
       QString getFullWidthHalfMaximumSmoothingResultsDescription() const 
                          { return fullWidthHalfMaximumSmoothingResultsDescription; }
       
+      /// set directory for smoothing operator cache files (empty disables caching)
+      void setOperatorCacheDirectoryName(const QString& name) 
+                         { operatorCacheDirectoryName = name; }
+      
    protected:
       /// determine neighbors for each node
       void determineNeighbors();
       
+      // get the neighbors of a node and the distances to them
+      void getNeighborsOfNode(const int nodeNumber,
+                              const std::vector<int>*& neighborsOut,
+                              const std::vector<float>*& distancesOut) const;
+      
+      // free the neighbors of the nodes
+      void clearNeighbors();
+      
+      // create the sparse smoothing operator containing the weights of one iteration
+      bool createSmoothingOperator(BrainModelSurfaceMetricSmoothingOperator& smoothingOperator);
+      
       /// class for neighbor information
       class NeighborInfo {
          public:
@@ -90,7 +107,7 @@ class BrainModelSurfaceMetricSmoothing : public BrainModelAlgorithm {
                          const int myNodeNumber,
                          const std::vector<int>& neighborsIn,
                          const float maxDistanceCutoff,
-                         const std::vector<float>* distanceWeights = NULL);
+                         const std::vector<float>* distances = NULL);
             
             /// Destructor
             ~NeighborInfo();
@@ -101,9 +118,6 @@ class BrainModelSurfaceMetricSmoothing : public BrainModelAlgorithm {
             /// the neighbors
             std::vector<int> neighbors;
             
-            /// precomputed geodesic gaussian weights
-            std::vector<float> geoGaussWeight;
-            
             /// neighbor distances
             std::vector<float> distanceToNeighbor;
             
@@ -167,6 +181,9 @@ class BrainModelSurfaceMetricSmoothing : public BrainModelAlgorithm {
       
       /// full width half maximum smoothing results description
       QString fullWidthHalfMaximumSmoothingResultsDescription;
+      
+      /// directory for smoothing operator cache files
+      QString operatorCacheDirectoryName;
 };
 
 #endif // __BRAIN_MODEL_SURFACE_METRIC_SMOOTHING_H__
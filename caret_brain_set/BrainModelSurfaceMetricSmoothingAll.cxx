@@ -33,6 +33,7 @@
 #include "BrainModelSurface.h"
 #include "BrainModelSurfaceMetricFullWidthHalfMaximum.h"
 #include "BrainModelSurfaceMetricSmoothingAll.h"
+#include "BrainModelSurfaceMetricSmoothingOperator.h"
 #include "DebugControl.h"
 #include "GaussianComputation.h"
 #include "GeodesicHelper.h"
@@ -195,9 +196,18 @@ BrainModelSurfaceMetricSmoothingAll::execute() throw (BrainModelAlgorithmExcepti
                              gaussTangentCutoff);
    
    //
-   // Determine the neighbors for each node
+   // Linear algorithms are applied as a sparse matrix of weights that is
+   // assembled once (or mapped from a cache file) and multiplied with blocks 
+   // of columns
    //
-   determineNeighbors();
+   BrainModelSurfaceMetricSmoothingOperator smoothingOperator(numberOfNodes);
+   const bool useOperatorFlag = createSmoothingOperator(smoothingOperator);
+   if (useOperatorFlag == false) {
+      //
+      // Determine the neighbors for each node
+      //
+      determineNeighbors();
+   }
    
    //
    // Add comments describing smoothing
@@ -263,6 +273,36 @@ BrainModelSurfaceMetricSmoothingAll::execute() throw (BrainModelAlgorithmExcepti
    this->runParallelFlag = false;
 #endif 
 
+   if (useOperatorFlag) {
+      std::vector<int> inputColumns, outputColumns;
+      if (this->smoothAllColumnsFlag) {
+         for (int i = 0; i < this->metricFile->getNumberOfColumns(); i++) {
+            inputColumns.push_back(i);
+            outputColumns.push_back(i);
+         }
+      }
+      else {
+         inputColumns.push_back(column);
+         outputColumns.push_back(outputColumn);
+      }
+      
+      smoothingOperator.smoothColumns(metricFile,
+                                      inputColumns,
+                                      outputColumns,
+                                      iterations,
+                                      this->runParallelFlag);
+      
+      for (unsigned int i = 0; i < outputColumns.size(); i++) {
+         QString comment(metricFile->getColumnComment(outputColumns[i]));
+         if (comment.isEmpty() == false) {
+            comment.append("\n");
+         }
+         comment.append(smoothComment);
+         metricFile->setColumnComment(outputColumns[i], comment);
+      }
+      return;
+   }
+   
    if (this->smoothAllColumnsFlag) {
       int numColumns = this->metricFile->getNumberOfColumns();
       
@@ -647,6 +687,75 @@ BrainModelSurfaceMetricSmoothingAll::smoothSingleColumn(const QString& columnDes
    metricFile->setColumnComment(smoothColumn, smoothComment);
 }
 
+/**
+ * Create the sparse smoothing operator containing the weights of one iteration.
+ * Returns false if the algorithm is not linear (dilation and full width half 
+ * maximum, which must measure the data during smoothing).
+ */
+bool 
+BrainModelSurfaceMetricSmoothingAll::createSmoothingOperator(BrainModelSurfaceMetricSmoothingOperator& smoothingOperator)
+{
+   BrainModelSurfaceMetricSmoothingOperator::Kernel::TYPE kernelType =
+      BrainModelSurfaceMetricSmoothingOperator::Kernel::TYPE_AVERAGE_NEIGHBORS;
+   switch (algorithm) {
+      case SMOOTH_ALGORITHM_AVERAGE_NEIGHBORS:
+         kernelType = BrainModelSurfaceMetricSmoothingOperator::Kernel::TYPE_AVERAGE_NEIGHBORS;
+         break;
+      case SMOOTH_ALGORITHM_SURFACE_NORMAL_GAUSSIAN:
+         kernelType = BrainModelSurfaceMetricSmoothingOperator::Kernel::TYPE_SURFACE_NORMAL_GAUSSIAN;
+         break;
+      case SMOOTH_ALGORITHM_WEIGHTED_AVERAGE_NEIGHBORS:
+         kernelType = BrainModelSurfaceMetricSmoothingOperator::Kernel::TYPE_WEIGHTED_AVERAGE_NEIGHBORS;
+         break;
+      case SMOOTH_ALGORITHM_GEODESIC_GAUSSIAN:
+         kernelType = BrainModelSurfaceMetricSmoothingOperator::Kernel::TYPE_GEODESIC_GAUSSIAN;
+         break;
+      case SMOOTH_ALGORITHM_DILATE:
+      case SMOOTH_ALGORITHM_FULL_WIDTH_HALF_MAXIMUM:
+      case SMOOTH_ALGORITHM_NONE:
+         return false;
+         break;
+   }
+   
+   const BrainModelSurfaceMetricSmoothingOperator::Kernel kernel(kernelType,
+                                                                 strength,
+                                                                 gaussNormBelowCutoff,
+                                                                 gaussNormAboveCutoff,
+                                                                 gaussSigmaNorm,
+                                                                 gaussSigmaTang,
+                                                                 gaussTangentCutoff,
+                                                                 geodesicGaussSigma);
+   smoothingOperator.create(kernel,
+                            "BrainModelSurfaceMetricSmoothingAll",
+                            fiducialSurface,
+                            gaussianSphericalSurface,
+                            operatorCacheDirectoryName,
+                            this);
+   
+   return smoothingOperator.isComplete();
+}
+
+/**
+ * get the neighbors of a node and the distances to them.
+ */
+void 
+BrainModelSurfaceMetricSmoothingAll::getNeighborsOfNode(const int nodeNumber,
+                                                        const std::vector<int>*& neighborsOut,
+                                                        const std::vector<float>*& distancesOut) const
+{
+   neighborsOut = &nodeNeighbors[nodeNumber].neighbors;
+   distancesOut = &nodeNeighbors[nodeNumber].distanceToNeighbor;
+}
+
+/**
+ * free the neighbors of the nodes.
+ */
+void 
+BrainModelSurfaceMetricSmoothingAll::clearNeighbors()
+{
+   nodeNeighbors.clear();
+}
+
 /**
  * determine neighbors for each node.
  */
@@ -30,6 +30,7 @@
 #include <vector>
 
 #include "BrainModelAlgorithm.h"
+#include "BrainModelSurfaceMetricSmoothingOperator.h"
 
 class BrainModelSurface;
 class CoordinateFile;
@@ -37,7 +38,8 @@ class GaussianComputation;
 class MetricFile;
 
 /// Class for smoothing metric data
-class BrainModelSurfaceMetricSmoothingAll : public BrainModelAlgorithm {
+class BrainModelSurfaceMetricSmoothingAll : public BrainModelAlgorithm,
+                                            public BrainModelSurfaceMetricSmoothingOperator::NeighborProvider {
    public:
       /// smoothing algorithms
       enum SMOOTH_ALGORITHM {
@@ -96,6 +98,10 @@ class BrainModelSurfaceMetricSmoothingAll : public BrainModelAlgorithm {
       QString getFullWidthHalfMaximumSmoothingResultsDescription() const 
                          { return fullWidthHalfMaximumSmoothingResultsDescription; }
       
+      /// set directory for smoothing operator cache files (empty disables caching)
+      void setOperatorCacheDirectoryName(const QString& name) 
+                         { operatorCacheDirectoryName = name; }
+      
    protected:
       // smooth a column in the metric file
       void smoothSingleColumn(const QString& columnDescription,
@@ -106,6 +112,17 @@ class BrainModelSurfaceMetricSmoothingAll : public BrainModelAlgorithm {
       /// determine neighbors for each node
       void determineNeighbors();
       
+      // get the neighbors of a node and the distances to them
+      void getNeighborsOfNode(const int nodeNumber,
+                              const std::vector<int>*& neighborsOut,
+                              const std::vector<float>*& distancesOut) const;
+      
+      // free the neighbors of the nodes
+      void clearNeighbors();
+      
+      // create the sparse smoothing operator containing the weights of one iteration
+      bool createSmoothingOperator(BrainModelSurfaceMetricSmoothingOperator& smoothingOperator);
+      
       /// class for neighbor information
       class NeighborInfo {
          public:
@@ -189,6 +206,9 @@ class BrainModelSurfaceMetricSmoothingAll : public BrainModelAlgorithm {
       bool smoothAllColumnsFlag;
       
       bool runParallelFlag;
+      
+      /// directory for smoothing operator cache files
+      QString operatorCacheDirectoryName;
 };
 
 #endif // __BRAIN_MODEL_SURFACE_METRIC_SMOOTHING_ALL_H__
@@ -0,0 +1,598 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+
+#include "BrainModelSurface.h"
+#include "BrainModelSurfaceMetricSmoothingOperator.h"
+#include "CoordinateFile.h"
+#include "GaussianComputation.h"
+#include "MetricFile.h"
+#include "TopologyFile.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * constructor.
+ */
+BrainModelSurfaceMetricSmoothingOperator::BrainModelSurfaceMetricSmoothingOperator(
+                                                         const int numberOfNodesIn)
+{
+   numberOfNodes = numberOfNodesIn;
+   numberOfWeights = 0;
+   rowStart.reserve(numberOfNodes + 1);
+   rowStart.push_back(0);
+   rowStartData = NULL;
+   weightNodeData = NULL;
+   weightsData = NULL;
+   cacheFile = NULL;
+   cacheFileData = NULL;
+}
+
+/**
+ * destructor.
+ */
+BrainModelSurfaceMetricSmoothingOperator::~BrainModelSurfaceMetricSmoothingOperator()
+{
+   releaseCacheFile();
+}
+
+/**
+ * release a mapped cache file.
+ */
+void 
+BrainModelSurfaceMetricSmoothingOperator::releaseCacheFile()
+{
+   if (cacheFile != NULL) {
+      if (cacheFileData != NULL) {
+         cacheFile->unmap(cacheFileData);
+      }
+      cacheFile->close();
+      delete cacheFile;
+   }
+   cacheFile = NULL;
+   cacheFileData = NULL;
+}
+
+/**
+ * add the weights for the next node (nodes must be added in order).
+ * The smoothed value of the node is its weight times its value plus the sum of 
+ * its neighbors' weights times the neighbors' values.  Zero weights are not stored.
+ */
+void 
+BrainModelSurfaceMetricSmoothingOperator::addNode(const int nodeNumber,
+                                                  const float nodeWeight,
+                                                  const std::vector<int>& neighbors,
+                                                  const std::vector<float>& neighborWeights)
+{
+   if ((nodeNumber != (static_cast<int>(rowStart.size()) - 1)) ||
+       (nodeNumber >= numberOfNodes)) {
+      return;
+   }
+   
+   if (nodeWeight != 0.0) {
+      weightNode.push_back(nodeNumber);
+      weights.push_back(nodeWeight);
+   }
+   const int numNeighbors = std::min(neighbors.size(), neighborWeights.size());
+   for (int j = 0; j < numNeighbors; j++) {
+      if (neighborWeights[j] != 0.0) {
+         weightNode.push_back(neighbors[j]);
+         weights.push_back(neighborWeights[j]);
+      }
+   }
+   rowStart.push_back(static_cast<int>(weights.size()));
+   
+   //
+   // Weights are in place once the last node is added
+   //
+   if (static_cast<int>(rowStart.size()) == (numberOfNodes + 1)) {
+      numberOfWeights = static_cast<int>(weights.size());
+      rowStartData = &rowStart[0];
+      if (numberOfWeights > 0) {
+         weightNodeData = &weightNode[0];
+         weightsData = &weights[0];
+      }
+   }
+}
+
+/**
+ * create the operator for a kernel.  If a cache directory is given and it contains
+ * a valid cache file for the surfaces and kernel, the operator is mapped from it.
+ * Otherwise the neighbors are determined, the operator is assembled, and the
+ * cache file is written.  The algorithm name is part of the cache file name
+ * since algorithms may determine neighbors differently.
+ */
+void 
+BrainModelSurfaceMetricSmoothingOperator::create(const Kernel& kernel,
+                                                 const QString& algorithmName,
+                                                 const BrainModelSurface* fiducialSurface,
+                                                 const BrainModelSurface* gaussianSphericalSurface,
+                                                 const QString& cacheDirectoryName,
+                                                 NeighborProvider* neighborProvider)
+{
+   QString cacheFileName;
+   if (cacheDirectoryName.isEmpty() == false) {
+      std::vector<const CoordinateFile*> coordinateFiles;
+      coordinateFiles.push_back(fiducialSurface->getCoordinateFile());
+      coordinateFiles.push_back(gaussianSphericalSurface->getCoordinateFile());
+      cacheFileName = createCacheFileName(cacheDirectoryName,
+                                          coordinateFiles,
+                                          fiducialSurface->getTopologyFile(),
+                                          algorithmName + " " + kernel.getDescription());
+      if (readCacheFile(cacheFileName)) {
+         return;
+      }
+   }
+   
+   neighborProvider->determineNeighbors();
+   assemble(kernel, fiducialSurface, neighborProvider);
+   neighborProvider->clearNeighbors();
+   
+   if (cacheFileName.isEmpty() == false) {
+      try {
+         writeCacheFile(cacheFileName);
+      }
+      catch (FileException& e) {
+         std::cout << "WARNING: " << e.whatQString().toAscii().constData() << std::endl;
+      }
+   }
+}
+
+/**
+ * assemble the operator for a kernel from the neighbors of the nodes.
+ */
+void 
+BrainModelSurfaceMetricSmoothingOperator::assemble(const Kernel& kernel,
+                                                   const BrainModelSurface* fiducialSurface,
+                                                   const NeighborProvider* neighborProvider)
+{
+   const GaussianComputation gauss(kernel.gaussNormBelowCutoff,
+                                   kernel.gaussNormAboveCutoff,
+                                   kernel.gaussSigmaNorm,
+                                   kernel.gaussSigmaTang,
+                                   kernel.gaussTangentCutoff);
+   const CoordinateFile* coordinateFile = fiducialSurface->getCoordinateFile();
+   const float strength = kernel.strength;
+   const float oneMinusStrength = 1.0 - strength;
+   const std::vector<int> noNeighbors;
+   const std::vector<float> noWeights;
+   
+   for (int i = 0; i < numberOfNodes; i++) {
+      const std::vector<int>* neighbors = NULL;
+      const std::vector<float>* distances = NULL;
+      neighborProvider->getNeighborsOfNode(i, neighbors, distances);
+      const int numNeighbors = static_cast<int>(neighbors->size());
+      
+      //
+      // Nodes without neighbors are not smoothed
+      //
+      if (numNeighbors <= 0) {
+         addNode(i, 1.0, noNeighbors, noWeights);
+         continue;
+      }
+      
+      float nodeWeight = oneMinusStrength;
+      std::vector<float> neighborWeights(numNeighbors, 0.0);
+      switch (kernel.type) {
+         case Kernel::TYPE_AVERAGE_NEIGHBORS:
+            for (int j = 0; j < numNeighbors; j++) {
+               neighborWeights[j] = strength / static_cast<float>(numNeighbors);
+            }
+            break;
+         case Kernel::TYPE_SURFACE_NORMAL_GAUSSIAN:
+            {
+               float totalWeight = 0.0;
+               for (int j = 0; j < numNeighbors; j++) {
+                  neighborWeights[j] = gauss.evaluate(coordinateFile->getCoordinate(i),
+                                                      fiducialSurface->getNormal(i),
+                                                      coordinateFile->getCoordinate((*neighbors)[j]));
+                  totalWeight += neighborWeights[j];
+               }
+               for (int j = 0; j < numNeighbors; j++) {
+                  if (totalWeight > 0.0) {
+                     neighborWeights[j] = strength * (neighborWeights[j] / totalWeight);
+                  }
+                  else {
+                     neighborWeights[j] = 0.0;
+                  }
+               }
+            }
+            break;
+         case Kernel::TYPE_WEIGHTED_AVERAGE_NEIGHBORS:
+            {
+               float totalDistance = 0.0;
+               for (int j = 0; j < numNeighbors; j++) {
+                  totalDistance += (*distances)[j];
+               }
+               if (totalDistance == 0.0) {
+                  totalDistance = 1.0;
+               }
+               float totalWeight = 0.0;
+               for (int j = 0; j < numNeighbors; j++) {
+                  neighborWeights[j] = 1.0 - ((*distances)[j] / totalDistance);
+                  totalWeight += neighborWeights[j];
+               }
+               if (totalWeight == 0.0) {
+                  totalWeight = 1.0;
+               }
+               for (int j = 0; j < numNeighbors; j++) {
+                  neighborWeights[j] = strength * (neighborWeights[j] / totalWeight);
+               }
+            }
+            break;
+         case Kernel::TYPE_GEODESIC_GAUSSIAN:
+            {
+               //
+               // Geodesic gaussian ignores strength (center node is in neighbors)
+               //
+               nodeWeight = 0.0;
+               float totalWeight = 0.0;
+               for (int j = 0; j < numNeighbors; j++) {
+                  const float tempf = (*distances)[j] / kernel.geodesicGaussSigma;
+                  const double d = -tempf * tempf * 0.5f;
+                  neighborWeights[j] = std::exp(d);
+                  totalWeight += neighborWeights[j];
+               }
+               for (int j = 0; j < numNeighbors; j++) {
+                  neighborWeights[j] /= totalWeight;
+               }
+            }
+            break;
+      }
+      
+      addNode(i, nodeWeight, *neighbors, neighborWeights);
+   }
+}
+
+/**
+ * create the name of a cache file from the content of the surface(s) and kernel.
+ * The name is a hash of the coordinates, the topology, and the description of
+ * the kernel (algorithm and its parameters) so any change to the surface or 
+ * parameters results in a different cache file.
+ */
+QString 
+BrainModelSurfaceMetricSmoothingOperator::createCacheFileName(const QString& cacheDirectoryName,
+                                  const std::vector<const CoordinateFile*>& coordinateFiles,
+                                  const TopologyFile* topologyFile,
+                                  const QString& kernelDescription)
+{
+   QCryptographicHash hash(QCryptographicHash::Md5);
+   
+   for (unsigned int i = 0; i < coordinateFiles.size(); i++) {
+      const CoordinateFile* cf = coordinateFiles[i];
+      const int numCoords = cf->getNumberOfCoordinates();
+      hash.addData(reinterpret_cast<const char*>(&numCoords), sizeof(numCoords));
+      if (numCoords > 0) {
+         hash.addData(reinterpret_cast<const char*>(cf->getCoordinate(0)),
+                      numCoords * 3 * sizeof(float));
+      }
+   }
+   
+   const int numTiles = topologyFile->getNumberOfTiles();
+   hash.addData(reinterpret_cast<const char*>(&numTiles), sizeof(numTiles));
+   if (numTiles > 0) {
+      hash.addData(reinterpret_cast<const char*>(topologyFile->getTile(0)),
+                   numTiles * 3 * sizeof(int));
+   }
+   
+   hash.addData(kernelDescription.toAscii());
+   
+   return (QDir(cacheDirectoryName).filePath("caret_smoothing_"
+                                             + QString(hash.result().toHex())
+                                             + ".bin"));
+}
+
+/**
+ * read (memory map) the operator from a cache file.  Returns false if the 
+ * file does not exist or is not valid for this operator's number of nodes.
+ */
+bool 
+BrainModelSurfaceMetricSmoothingOperator::readCacheFile(const QString& fileName)
+{
+   releaseCacheFile();
+   
+   cacheFile = new QFile(fileName);
+   if (cacheFile->open(QFile::ReadOnly) == false) {
+      releaseCacheFile();
+      return false;
+   }
+   
+   const qint64 fileSize = cacheFile->size();
+   const qint64 headerSize = CACHE_HEADER_INTS * sizeof(int);
+   if (fileSize < headerSize) {
+      releaseCacheFile();
+      return false;
+   }
+   cacheFileData = cacheFile->map(0, fileSize);
+   if (cacheFileData == NULL) {
+      releaseCacheFile();
+      return false;
+   }
+   
+   //
+   // Verify header (magic number also detects different byte order)
+   //
+   const int* header = reinterpret_cast<const int*>(cacheFileData);
+   const int numWeights = header[3];
+   if ((header[0] != CACHE_FILE_MAGIC) ||
+       (header[1] != CACHE_FILE_VERSION) ||
+       (header[2] != numberOfNodes) ||
+       (numWeights < 0) ||
+       (fileSize != (headerSize 
+                     + static_cast<qint64>(numberOfNodes + 1) * sizeof(int)
+                     + static_cast<qint64>(numWeights) * (sizeof(int) + sizeof(float))))) {
+      releaseCacheFile();
+      return false;
+   }
+   
+   const int* rowStartPtr = &header[CACHE_HEADER_INTS];
+   const int* weightNodePtr = &rowStartPtr[numberOfNodes + 1];
+   const float* weightsPtr = reinterpret_cast<const float*>(&weightNodePtr[numWeights]);
+   
+   //
+   // Verify indices so a damaged file cannot cause out of range access
+   //
+   if ((rowStartPtr[0] != 0) || (rowStartPtr[numberOfNodes] != numWeights)) {
+      releaseCacheFile();
+      return false;
+   }
+   for (int i = 0; i < numberOfNodes; i++) {
+      if (rowStartPtr[i] > rowStartPtr[i + 1]) {
+         releaseCacheFile();
+         return false;
+      }
+   }
+   for (int i = 0; i < numWeights; i++) {
+      if ((weightNodePtr[i] < 0) || (weightNodePtr[i] >= numberOfNodes)) {
+         releaseCacheFile();
+         return false;
+      }
+   }
+   
+   //
+   // Use the mapped data in place of any assembled weights
+   //
+   rowStart.clear();
+   weightNode.clear();
+   weights.clear();
+   numberOfWeights = numWeights;
+   rowStartData = rowStartPtr;
+   weightNodeData = weightNodePtr;
+   weightsData = weightsPtr;
+   
+   return true;
+}
+
+/**
+ * write the operator to a cache file.  The file is written with a temporary 
+ * name and then renamed so that other processes never map a partial file.
+ */
+void 
+BrainModelSurfaceMetricSmoothingOperator::writeCacheFile(const QString& fileName) const 
+                                                          throw (FileException)
+{
+   if (isComplete() == false) {
+      throw FileException(fileName, "Smoothing operator is incomplete.");
+   }
+   
+   QTemporaryFile tempFile(fileName + ".XXXXXX");
+   if (tempFile.open() == false) {
+      throw FileException(fileName, tempFile.errorString());
+   }
+   
+   const int header[CACHE_HEADER_INTS] = {
+      CACHE_FILE_MAGIC,
+      CACHE_FILE_VERSION,
+      numberOfNodes,
+      numberOfWeights
+   };
+   
+   bool errorFlag = false;
+   errorFlag |= (tempFile.write(reinterpret_cast<const char*>(header),
+                                sizeof(header)) != static_cast<qint64>(sizeof(header)));
+   const qint64 rowBytes = static_cast<qint64>(numberOfNodes + 1) * sizeof(int);
+   errorFlag |= (tempFile.write(reinterpret_cast<const char*>(rowStartData),
+                                rowBytes) != rowBytes);
+   if (numberOfWeights > 0) {
+      const qint64 nodeBytes = static_cast<qint64>(numberOfWeights) * sizeof(int);
+      errorFlag |= (tempFile.write(reinterpret_cast<const char*>(weightNodeData),
+                                   nodeBytes) != nodeBytes);
+      const qint64 weightBytes = static_cast<qint64>(numberOfWeights) * sizeof(float);
+      errorFlag |= (tempFile.write(reinterpret_cast<const char*>(weightsData),
+                                   weightBytes) != weightBytes);
+   }
+   tempFile.close();
+   if (errorFlag) {
+      throw FileException(fileName, "Error writing smoothing operator cache file: "
+                                    + tempFile.errorString());
+   }
+   
+   //
+   // Another process may have created the file, in which case it is kept
+   //
+   if (QFile::exists(fileName) == false) {
+      if (tempFile.rename(fileName)) {
+         tempFile.setAutoRemove(false);
+      }
+   }
+}
+
+/**
+ * multiply a node's row with a node-major block of columns.
+ */
+inline void 
+BrainModelSurfaceMetricSmoothingOperator::multiplyRow(const int nodeNumber,
+                                                      const float* blockIn,
+                                                      float* blockOut,
+                                                      const int numberOfColumns) const
+{
+   float* out = &blockOut[nodeNumber * numberOfColumns];
+   for (int c = 0; c < numberOfColumns; c++) {
+      out[c] = 0.0;
+   }
+   
+   const int iEnd = rowStartData[nodeNumber + 1];
+   for (int i = rowStartData[nodeNumber]; i < iEnd; i++) {
+      const float w = weightsData[i];
+      const float* in = &blockIn[weightNodeData[i] * numberOfColumns];
+      for (int c = 0; c < numberOfColumns; c++) {
+         out[c] += w * in[c];
+      }
+   }
+}
+
+/**
+ * multiply a node-major block of columns (numberOfColumns values for each node,
+ * so the value for node "n" and column "c" is at [n * numberOfColumns + c]).
+ */
+void 
+BrainModelSurfaceMetricSmoothingOperator::multiply(const float* blockIn,
+                                                   float* blockOut,
+                                                   const int numberOfColumns,
+                                                   const bool runParallelFlag) const
+{
+   if (runParallelFlag) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 256)
+#endif
+      for (int i = 0; i < numberOfNodes; i++) {
+         multiplyRow(i, blockIn, blockOut, numberOfColumns);
+      }
+   }
+   else {
+      for (int i = 0; i < numberOfNodes; i++) {
+         multiplyRow(i, blockIn, blockOut, numberOfColumns);
+      }
+   }
+}
+
+/**
+ * smooth columns of a metric file for the number of iterations.
+ * The columns are smoothed in blocks so that the weights are read once per 
+ * iteration for all of the columns in a block.
+ */
+void 
+BrainModelSurfaceMetricSmoothingOperator::smoothColumns(MetricFile* metricFile,
+                                                        const std::vector<int>& inputColumns,
+                                                        const std::vector<int>& outputColumns,
+                                                        const int iterations,
+                                                        const bool runParallelFlag) const
+{
+   if (isComplete() == false) {
+      return;
+   }
+   const int numColumns = std::min(inputColumns.size(), outputColumns.size());
+   
+   std::vector<float> blockOne(numberOfNodes * std::min(numColumns, 
+                                                        static_cast<int>(COLUMN_BLOCK_SIZE)));
+   std::vector<float> blockTwo(blockOne.size());
+   std::vector<float> columnValues(numberOfNodes);
+   
+   for (int startColumn = 0; startColumn < numColumns; startColumn += COLUMN_BLOCK_SIZE) {
+      const int blockColumns = std::min(static_cast<int>(COLUMN_BLOCK_SIZE),
+                                        numColumns - startColumn);
+      float* blockIn  = &blockOne[0];
+      float* blockOut = &blockTwo[0];
+      
+      //
+      // Copy the columns into the node-major block
+      //
+      for (int c = 0; c < blockColumns; c++) {
+         const float* columnData = metricFile->getColumnForAllNodesSpan(inputColumns[startColumn + c]);
+         for (int i = 0; i < numberOfNodes; i++) {
+            blockIn[i * blockColumns + c] = columnData[i];
+         }
+      }
+      
+      //
+      // Smooth
+      //
+      for (int iter = 0; iter < iterations; iter++) {
+         multiply(blockIn, blockOut, blockColumns, runParallelFlag);
+         std::swap(blockIn, blockOut);
+      }
+      
+      //
+      // Copy the block into the output columns
+      //
+      for (int c = 0; c < blockColumns; c++) {
+         for (int i = 0; i < numberOfNodes; i++) {
+            columnValues[i] = blockIn[i * blockColumns + c];
+         }
+         metricFile->setColumnForAllNodes(outputColumns[startColumn + c], columnValues);
+      }
+   }
+}
+
+//=============================================================================
+
+/**
+ * constructor.
+ */
+BrainModelSurfaceMetricSmoothingOperator::Kernel::Kernel(const TYPE typeIn,
+                                                         const float strengthIn,
+                                                         const float gaussNormBelowCutoffIn,
+                                                         const float gaussNormAboveCutoffIn,
+                                                         const float gaussSigmaNormIn,
+                                                         const float gaussSigmaTangIn,
+                                                         const float gaussTangentCutoffIn,
+                                                         const float geodesicGaussSigmaIn)
+{
+   type = typeIn;
+   strength = strengthIn;
+   gaussNormBelowCutoff = gaussNormBelowCutoffIn;
+   gaussNormAboveCutoff = gaussNormAboveCutoffIn;
+   gaussSigmaNorm = gaussSigmaNormIn;
+   gaussSigmaTang = gaussSigmaTangIn;
+   gaussTangentCutoff = gaussTangentCutoffIn;
+   geodesicGaussSigma = geodesicGaussSigmaIn;
+}
+
+/**
+ * get a description of the kernel and its parameters (used in cache file names).
+ */
+QString 
+BrainModelSurfaceMetricSmoothingOperator::Kernel::getDescription() const
+{
+   const QString description = 
+        QString::number(static_cast<int>(type))
+      + QString(" ") + QString::number(strength, 'g', 9)
+      + QString(" ") + QString::number(gaussNormBelowCutoff, 'g', 9)
+      + QString(" ") + QString::number(gaussNormAboveCutoff, 'g', 9)
+      + QString(" ") + QString::number(gaussSigmaNorm, 'g', 9)
+      + QString(" ") + QString::number(gaussSigmaTang, 'g', 9)
+      + QString(" ") + QString::number(gaussTangentCutoff, 'g', 9)
+      + QString(" ") + QString::number(geodesicGaussSigma, 'g', 9);
+   return description;
+}
@@ -0,0 +1,234 @@
+#ifndef __BRAIN_MODEL_SURFACE_METRIC_SMOOTHING_OPERATOR_H__
+#define __BRAIN_MODEL_SURFACE_METRIC_SMOOTHING_OPERATOR_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#include <vector>
+
+#include <QString>
+
+#include "FileException.h"
+
+class BrainModelSurface;
+class CoordinateFile;
+class MetricFile;
+class QFile;
+class TopologyFile;
+
+/// Sparse (compressed sparse row) matrix containing the weights of one iteration 
+/// of a linear smoothing algorithm.  The matrix is assembled once and each 
+/// smoothing iteration is a multiplication of the matrix with a block of 
+/// metric columns.  An operator may be saved to a cache file and later 
+/// memory mapped so that expensive neighborhoods (geodesic gaussian) are 
+/// computed only once for a surface.
+class BrainModelSurfaceMetricSmoothingOperator {
+   public:
+      /// a linear smoothing kernel and its parameters
+      class Kernel {
+         public:
+            /// type of kernel
+            enum TYPE {
+               TYPE_AVERAGE_NEIGHBORS,
+               TYPE_WEIGHTED_AVERAGE_NEIGHBORS,
+               TYPE_SURFACE_NORMAL_GAUSSIAN,
+               TYPE_GEODESIC_GAUSSIAN
+            };
+            
+            // constructor
+            Kernel(const TYPE typeIn,
+                   const float strengthIn,
+                   const float gaussNormBelowCutoffIn,
+                   const float gaussNormAboveCutoffIn,
+                   const float gaussSigmaNormIn,
+                   const float gaussSigmaTangIn,
+                   const float gaussTangentCutoffIn,
+                   const float geodesicGaussSigmaIn);
+            
+            // get a description of the kernel and its parameters
+            QString getDescription() const;
+            
+            /// type of kernel
+            TYPE type;
+            
+            /// smoothing strength
+            float strength;
+            
+            /// gaussian norm below cutoff
+            float gaussNormBelowCutoff;
+            
+            /// gaussian norm above cutoff
+            float gaussNormAboveCutoff;
+            
+            /// gaussian sigma norm
+            float gaussSigmaNorm;
+            
+            /// gaussian sigma tang
+            float gaussSigmaTang;
+            
+            /// gaussian tangent cutoff
+            float gaussTangentCutoff;
+            
+            /// geodesic gaussian sigma
+            float geodesicGaussSigma;
+      };
+      
+      /// Provides the neighbors of each node for assembling an operator.  The 
+      /// neighbors are only determined if the operator is not read from a cache file.
+      class NeighborProvider {
+         public:
+            /// destructor
+            virtual ~NeighborProvider() { }
+            
+            /// determine the neighbors of each node
+            virtual void determineNeighbors() = 0;
+            
+            /// get the neighbors of a node and the distances to them
+            /// (geodesic distances for the geodesic gaussian kernel)
+            virtual void getNeighborsOfNode(const int nodeNumber,
+                                            const std::vector<int>*& neighborsOut,
+                                            const std::vector<float>*& distancesOut) const = 0;
+            
+            /// free the neighbors of the nodes
+            virtual void clearNeighbors() = 0;
+      };
+      
+      // constructor
+      BrainModelSurfaceMetricSmoothingOperator(const int numberOfNodesIn);
+      
+      // destructor
+      ~BrainModelSurfaceMetricSmoothingOperator();
+      
+      // add the weights for the next node (nodes must be added in order)
+      void addNode(const int nodeNumber,
+                   const float nodeWeight,
+                   const std::vector<int>& neighbors,
+                   const std::vector<float>& neighborWeights);
+      
+      /// get the number of nodes
+      int getNumberOfNodes() const { return numberOfNodes; }
+      
+      /// get the number of non-zero weights
+      int getNumberOfWeights() const { return numberOfWeights; }
+      
+      /// is the operator complete (weights added for all nodes)
+      bool isComplete() const { return (rowStartData != NULL); }
+      
+      // create the operator for a kernel by reading its cache file or by 
+      // assembling it from the neighbors of the nodes (and writing the cache file)
+      void create(const Kernel& kernel,
+                  const QString& algorithmName,
+                  const BrainModelSurface* fiducialSurface,
+                  const BrainModelSurface* gaussianSphericalSurface,
+                  const QString& cacheDirectoryName,
+                  NeighborProvider* neighborProvider);
+      
+      // assemble the operator for a kernel from the neighbors of the nodes
+      void assemble(const Kernel& kernel,
+                    const BrainModelSurface* fiducialSurface,
+                    const NeighborProvider* neighborProvider);
+      
+      // create the name of a cache file from the content of the surface(s) and kernel
+      static QString createCacheFileName(const QString& cacheDirectoryName,
+                                         const std::vector<const CoordinateFile*>& coordinateFiles,
+                                         const TopologyFile* topologyFile,
+                                         const QString& kernelDescription);
+      
+      // read (memory map) the operator from a cache file (false if invalid or missing)
+      bool readCacheFile(const QString& fileName);
+      
+      // write the operator to a cache file
+      void writeCacheFile(const QString& fileName) const throw (FileException);
+      
+      // multiply a node-major block of columns (numberOfColumns values for each node)
+      void multiply(const float* blockIn,
+                    float* blockOut,
+                    const int numberOfColumns,
+                    const bool runParallelFlag) const;
+      
+      // smooth columns of a metric file for the number of iterations
+      void smoothColumns(MetricFile* metricFile,
+                         const std::vector<int>& inputColumns,
+                         const std::vector<int>& outputColumns,
+                         const int iterations,
+                         const bool runParallelFlag) const;
+      
+      /// number of columns smoothed together
+      enum { COLUMN_BLOCK_SIZE = 32 };
+      
+   protected:
+      /// header at start of a cache file
+      enum { 
+         CACHE_FILE_MAGIC   = 0x43534f50,
+         CACHE_FILE_VERSION = 1,
+         CACHE_HEADER_INTS  = 4
+      };
+      
+      // copy constructor (not allowed, may contain a mapped file)
+      BrainModelSurfaceMetricSmoothingOperator(const BrainModelSurfaceMetricSmoothingOperator&);
+      
+      // assignment operator (not allowed, may contain a mapped file)
+      BrainModelSurfaceMetricSmoothingOperator& operator=(const BrainModelSurfaceMetricSmoothingOperator&);
+      
+      // release a mapped cache file
+      void releaseCacheFile();
+      
+      // multiplya node's row with a node-major block of columns
+      inline void multiplyRow(const int nodeNumber,
+                              const float* blockIn,
+                              float* blockOut,
+                              const int numberOfColumns) const;
+      
+      /// number of nodes
+      int numberOfNodes;
+      
+      /// number of non-zero weights
+      int numberOfWeights;
+      
+      /// index of first weight for each node (number of nodes plus one)
+      std::vector<int> rowStart;
+      
+      /// node number of each weight
+      std::vector<int> weightNode;
+      
+      /// the weights
+      std::vector<float> weights;
+      
+      /// row starts in use (vector or mapped cache file, NULL until complete)
+      const int* rowStartData;
+      
+      /// weight node numbers in use (vector or mapped cache file)
+      const int* weightNodeData;
+      
+      /// weights in use (vector or mapped cache file)
+      const float* weightsData;
+      
+      /// mapped cache file (NULL if operator was assembled)
+      QFile* cacheFile;
+      
+      /// start of mapped cache file
+      uchar* cacheFileData;
+};
+
+#endif // __BRAIN_MODEL_SURFACE_METRIC_SMOOTHING_OPERATOR_H__
@@ -24,6 +24,7 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <sstream>
@@ -96,6 +97,9 @@ BrainModelSurfaceMetricTwoSampleTTest::BrainModelSurfaceMetricTwoSampleTTest(
    shapeFileAName = shapeFileANameIn;
    shapeFileBName = shapeFileBNameIn;
    iterations = iterationsIn;
+   permutationShapeFile = NULL;
+   permutationNumberInGroup1 = 0;
+   permutationPooledVarianceFlag = false;
 }
       
 /**
@@ -315,50 +319,35 @@ BrainModelSurfaceMetricTwoSampleTTest::executeClusterSearch() throw (BrainModelA
             cleanUp();
             throw BrainModelAlgorithmException(str.str().c_str());
          }
-         break;
-      case VARIANCE_MODE_POOLED:  // NOTE: same processing for pooled and unpooled
-      case VARIANCE_MODE_UNPOOLED:
-         {
-            //
-            // Combine input shape for shuffled T-Map
-            //
-            MetricFile allShape = ssfA;
-            allShape.append(ssfB);
-            
-            //
-            // Do shuffled T-Map
-            //
+
+         //
+         // Write Shuffled  T-Map file
+         //
+         if (shuffledStatisticalMapFileName.isEmpty() == false) {
             try {
-               shuffleStatisticalMapShapeFile = allShape.computeStatisticalShuffledTMap(iterations,
-                                                                         ssfA.getNumberOfColumns(),
-                                                                         brain->getTopologyFile(0),
-                                                                         tVarianceSmoothingIterations,
-                                                                         tVarianceSmoothingStrength,
-                                                                         pooledVarianceFlag);
+               shuffleStatisticalMapShapeFile->writeFile(shuffledStatisticalMapFileName);
             }
             catch (FileException& e) {
                std::ostringstream str;
-               str << "Shuffled T-Map failure: "
-                   << e.whatQString().toAscii().constData();
+               str << "Unable to write Shuffled T-Map: "
+                   << FileUtilities::basename(shuffledStatisticalMapFileName).toAscii().constData();
                cleanUp();
                throw BrainModelAlgorithmException(str.str().c_str());
             }
-         };
+         }
+         break;
+      case VARIANCE_MODE_POOLED:  // NOTE: same processing for pooled and unpooled
+      case VARIANCE_MODE_UNPOOLED:
+         //
+         // Combine input shape for shuffled T-Map.  Each shuffled T-Map
+         // is computed, and its clusters found, by the permutation engine
+         // so that all of the shuffled T-Maps are never in memory.
+         //
+         permutationShapeFile = new MetricFile(ssfA);
+         permutationShapeFile->append(ssfB);
+         permutationNumberInGroup1 = ssfA.getNumberOfColumns();
+         permutationPooledVarianceFlag = pooledVarianceFlag;
          break;
-   }
-
-   //
-   // Write Shuffled  T-Map file
-   //
-   try {
-      shuffleStatisticalMapShapeFile->writeFile(shuffledStatisticalMapFileName);
-   }
-   catch (FileException& e) {
-      std::ostringstream str;
-      str << "Unable to write Shuffled T-Map: "
-          << FileUtilities::basename(shuffledStatisticalMapFileName).toAscii().constData();
-      cleanUp();
-      throw BrainModelAlgorithmException(str.str().c_str());
    }
 
    //
@@ -386,13 +375,48 @@ BrainModelSurfaceMetricTwoSampleTTest::executeClusterSearch() throw (BrainModelA
    // Note: Only use largest cluster from each column
    //
    std::vector<Cluster> shuffleTMapClusters;
-   findClusters(shuffleStatisticalMapShapeFile, shuffleTMapClusters, "Finding Clusters in Shuffled T-Map", -1, true);
+   std::vector<float> shuffleTMapMaximumStatistics;
+   switch (varianceMode) {
+      case VARIANCE_MODE_SIGMA:
+         {
+            findClusters(shuffleStatisticalMapShapeFile, shuffleTMapClusters, "Finding Clusters in Shuffled T-Map", -1, true);
+            
+            std::vector<float> values;
+            for (int j = 0; j < shuffleStatisticalMapShapeFile->getNumberOfColumns(); j++) {
+               shuffleStatisticalMapShapeFile->getColumnForAllNodes(j, values);
+               float maxValue = 0.0;
+               for (int i = 0; i < numberOfNodes; i++) {
+                  maxValue = std::max(maxValue, static_cast<float>(std::fabs(values[i])));
+               }
+               shuffleTMapMaximumStatistics.push_back(maxValue);
+            }
+         }
+         break;
+      case VARIANCE_MODE_POOLED:  // NOTE: same processing for pooled and unpooled
+      case VARIANCE_MODE_UNPOOLED:
+         try {
+            findPermutationNullDistribution(iterations,
+                                            "Finding Clusters in Shuffled T-Map",
+                                            shuffleTMapClusters,
+                                            shuffleTMapMaximumStatistics);
+         }
+         catch (BrainModelAlgorithmException& e) {
+            cleanUp();
+            throw e;
+         }
+         break;
+   }
    
    //
    // Set pValue for shuffled T-Map
    // 
-   setRandomizedClusterPValues(*shuffleStatisticalMapShapeFile,
+   setRandomizedClusterPValues(iterations,
                                shuffleTMapClusters);
+   
+   //
+   // T-Map value that is significant (family wise) at the P-Value
+   //
+   const float significantTValue = getSignificantStatistic(shuffleTMapMaximumStatistics);
                                
    //
    // Find area of the "P-Value" cluster in the shuffled T-Map
@@ -478,6 +502,7 @@ BrainModelSurfaceMetricTwoSampleTTest::executeClusterSearch() throw (BrainModelA
    reportStream << "Iterations:          " << iterations << "\n";
    reportStream << "P-Value:             " << pValue << "\n";
    reportStream << "Significant Area:    " << significantCorrectedArea << "\n";
+   reportStream << "Significant |T|:     " << significantTValue << "\n";
    reportStream << "\n";
    
    //
@@ -731,6 +756,19 @@ BrainModelSurfaceMetricTwoSampleTTest::transformToRankSum(MetricFile& fileA,
       dataB = new float[numColB];
    }
 
+   //
+   // Node-major copies of the data make each node's values contiguous
+   // (the values are gathered from the columns if a copy cannot be made)
+   //
+   try {
+      fileA.createNodeMajorDataStore();
+      fileB.createNodeMajorDataStore();
+   }
+   catch (FileException&) {
+      fileA.removeNodeMajorDataStore();
+      fileB.removeNodeMajorDataStore();
+   }
+   
    //
    // Convert data to rank-sum indices
    //
@@ -738,17 +776,25 @@ BrainModelSurfaceMetricTwoSampleTTest::transformToRankSum(MetricFile& fileA,
       //
       // Get the data for each node
       //
-      fileA.getAllColumnValuesForNode(i, dataA);
-      fileB.getAllColumnValuesForNode(i, dataB);
+      const float* nodeDataA = fileA.getAllColumnValuesForNodeSpan(i);
+      if (nodeDataA == NULL) {
+         fileA.getAllColumnValuesForNode(i, dataA);
+         nodeDataA = dataA;
+      }
+      const float* nodeDataB = fileB.getAllColumnValuesForNodeSpan(i);
+      if (nodeDataB == NULL) {
+         fileB.getAllColumnValuesForNode(i, dataB);
+         nodeDataB = dataB;
+      }
       
       //
       // Transform the data
       //
       StatisticRankTransformation rt;
-      StatisticDataGroup dga(dataA,
+      StatisticDataGroup dga(nodeDataA,
                              numColA,
                              StatisticDataGroup::DATA_STORAGE_MODE_POINT);
-      StatisticDataGroup dgb(dataB,
+      StatisticDataGroup dgb(nodeDataB,
                              numColB,
                              StatisticDataGroup::DATA_STORAGE_MODE_POINT);
       rt.addDataGroup(&dga);
@@ -774,6 +820,9 @@ BrainModelSurfaceMetricTwoSampleTTest::transformToRankSum(MetricFile& fileA,
       fileB.setAllColumnValuesForNode(i, sdgRankB->getPointerToData());
    }
    
+   fileA.removeNodeMajorDataStore();
+   fileB.removeNodeMajorDataStore();
+   
    //
    // Free memory
    //
@@ -805,5 +854,41 @@ BrainModelSurfaceMetricTwoSampleTTest::transformToRankSum(MetricFile& fileA,
 void
 BrainModelSurfaceMetricTwoSampleTTest::cleanUp()
 {
+   if (permutationShapeFile != NULL) {
+      delete permutationShapeFile;
+      permutationShapeFile = NULL;
+   }
    BrainModelSurfaceMetricFindClustersBase::cleanUp();
 }
+
+/**
+ * Compute the shuffled T-Map for one permutation (called from multiple threads).
+ */
+void 
+BrainModelSurfaceMetricTwoSampleTTest::computePermutedStatisticalMap(const int iterationIndex,
+                                                  std::vector<float>& valuesOut,
+                                                  QString& columnNameOut) throw (BrainModelAlgorithmException)
+{
+   if (permutationShapeFile == NULL) {
+      throw BrainModelAlgorithmException("Program Error: Shuffled T-Map input is invalid.");
+   }
+   
+   QString columnComment;
+   try {
+      permutationShapeFile->computeStatisticalShuffledTMapRepetition(iterationIndex,
+                                                                     permutationNumberInGroup1,
+                                                                     brain->getTopologyFile(0),
+                                                                     tVarianceSmoothingIterations,
+                                                                     tVarianceSmoothingStrength,
+                                                                     permutationPooledVarianceFlag,
+                                                                     valuesOut,
+                                                                     columnNameOut,
+                                                                     columnComment);
+   }
+   catch (FileException& e) {
+      std::ostringstream str;
+      str << "Shuffled T-Map failure: "
+          << e.whatQString().toAscii().constData();
+      throw BrainModelAlgorithmException(str.str().c_str());
+   }
+}
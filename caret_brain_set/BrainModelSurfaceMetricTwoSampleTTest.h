@@ -92,6 +92,11 @@ class BrainModelSurfaceMetricTwoSampleTTest : public BrainModelSurfaceMetricFind
       // free memory
       void cleanUp();
       
+      // compute the shuffled T-Map for one permutation
+      void computePermutedStatisticalMap(const int iterationIndex,
+                                         std::vector<float>& valuesOut,
+                                         QString& columnNameOut) throw (BrainModelAlgorithmException);
+      
       // create donna's sigma t-map
       MetricFile* createDonnasSigmaTMap(const MetricFile& mfA,
                                         const MetricFile& mfB,
@@ -123,6 +128,15 @@ class BrainModelSurfaceMetricTwoSampleTTest : public BrainModelSurfaceMetricFind
       
       /// the variance mode
       VARIANCE_MODE varianceMode;
+      
+      /// both groups' shape files combined for permutations
+      MetricFile* permutationShapeFile;
+      
+      /// number of columns in first group of permutations
+      int permutationNumberInGroup1;
+      
+      /// pool the variance for permutations
+      bool permutationPooledVarianceFlag;
 };
 
 #endif // __BRAIN_MODEL_SURFACE_SHAPE_TWO_SAMPLE_H__
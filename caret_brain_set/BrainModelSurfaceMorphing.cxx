@@ -328,12 +328,13 @@ BrainModelSurfaceMorphing::execute() throw (BrainModelAlgorithmException)
          endNode   += numNodesPerThread;
       }
    }
+   const std::vector<BrainModelAlgorithmMultiThreaded*> poolThreads(threads.begin(),
+                                                                   threads.end());
    
    //
    // morph for the surface
    //
    for (int i = 1; i <= iterations; i++) {
-      const bool firstIterationFlag = (i == 1);
       const bool lastIterationFlag = (i == iterations);
       
       //
@@ -357,56 +358,15 @@ BrainModelSurfaceMorphing::execute() throw (BrainModelAlgorithmException)
       if (numberOfThreads > 1) {
          for (int j = 0; j < numberOfThreads; j++) {
             //
-            // Run each thread for an iteration of smoothing
+            // Set up each thread instance for an iteration of morphing
             //
             threads[j]->setInputAndOutputCoords(inputCoords, outputCoords);
-            
-            //
-            // Clear the number of child threads done
-            //
-            resetNumChildThreadDone();
-            
-            //
-            // Start the threads if this is the first iteration
-            //
-            if (firstIterationFlag) {
-               threads[j]->setThreadKeepLoopingFlag(true);
-               threads[j]->setThreadedIterationDoneFlag(true);
-               threads[j]->start(QThread::TimeCriticalPriority);
-            }
-         }
-         
-         //
-         // Wait until all threads have started and in their loop.
-         // This is need for the case that there is only one iteration.
-         //
-         while (getNumChildThreadStarted() < numberOfThreads) {
-            msleep(1);
-         }
-         
-         for (int j = 0; j < numberOfThreads; j++) {
-            //
-            // if the last iteration, clear the keep looping flag for the thread
-            //
-            if (lastIterationFlag ) {
-               threads[j]->setThreadKeepLoopingFlag(false);
-            }
-            
-            //
-            // wake the thread so that it executes an iteration
-            //
-            if (DebugControl::getDebugOn()) {
-               std::cout << "Allowing morphing thread " << j << " to run." << std::endl;
-            }
-            threads[j]->setThreadedIterationDoneFlag(false);
          }
          
          //
-         // Wait until all of the threads finish
+         // Run the iteration of each thread instance in the thread pool
          //
-         while (getNumChildThreadDone() < numberOfThreads) {
-            msleep(1);
-         }
+         runIterationOfChildrenInThreadPool(poolThreads, i);
          if (DebugControl::getDebugOn()) {
             std::cout << "All morphing threads completed iteration." << std::endl;
          }
@@ -416,7 +376,7 @@ BrainModelSurfaceMorphing::execute() throw (BrainModelAlgorithmException)
          // Smooth for one iteration
          //
          setIndicesOfNodesToMorph(0, numberOfNodes - 1);
-         run(i);
+         runIteration(i);
       }
       
       //
@@ -737,86 +697,106 @@ BrainModelSurfaceMorphing::setForcesOnNoMorphNodes()
  * Morph the surface
  */
 void
-BrainModelSurfaceMorphing::run(int iteration)
+BrainModelSurfaceMorphing::runIteration(const int iteration)
 {
    QTime timer;
    timer.start();
 
    //
-   // set looping flag for non-threaded execution so that we do an iteration
+   // morph each node that should be morphed
    //
-   if (getImAThread() == false) {
-      setThreadKeepLoopingFlag(true);
-   }
-   
-   //
-   // The threaded execution will stay in the loop since run only gets called once
-   //
-   while (getThreadKeepLoopingFlag()) {
-   
+   for (int j = startNodeIndex; j <= endNodeIndex; j++) {
       //
-      // Is this a threaded instance
+      // Save node position
       //
-      if (getImAThread()) {
-         //
-         // let parent know that this thread has started
-         //
-         getParentOfThisThread()->incrementNumChildThreadStarted();
-         
-         //
-         // Wait until parent says it is okay to go
-         //
-         while (getThreadedIterationDoneFlag()) {
-            msleep(1);
-         }
-         if (DebugControl::getDebugOn()) {
-            std::cout << "Morphing Thread " << getThreadNumber() << " now executing." << std::endl;
-         }
-      }
+      float nodePos[3] = { inputCoords[j*3], inputCoords[j*3+1], inputCoords[j*3+2] };
+      outputCoords[j*3]   = nodePos[0];
+      outputCoords[j*3+1] = nodePos[1];
+      outputCoords[j*3+2] = nodePos[2];
       
       //
-      // morph each node that should be morphed
+      // Info for this node
       //
-      for (int j = startNodeIndex; j <= endNodeIndex; j++) {
+      NeighborInformation& nodeInfo = morphNodeInfo[j];
+      
+      //
+      // If this node has neighbors and should be morphed
+      //
+      if ((nodeInfo.numNeighbors > 1) && nodeShouldBeMorphed[j]) {
          //
-         // Save node position
+         // Initialize forces to zero
          //
-         float nodePos[3] = { inputCoords[j*3], inputCoords[j*3+1], inputCoords[j*3+2] };
-         outputCoords[j*3]   = nodePos[0];
-         outputCoords[j*3+1] = nodePos[1];
-         outputCoords[j*3+2] = nodePos[2];
+         nodeInfo.resetForces();
          
+         float linearForceComponents[3];
+         float angularForceComponents[3];
+      
+         const float floatNumNeighbors = static_cast<float>(nodeInfo.numNeighbors);
          //
-         // Info for this node
+         // Apply linear forces to node
          //
-         NeighborInformation& nodeInfo = morphNodeInfo[j];
-         
+         if (linearForce > 0.0) {
+            for (int k = 0; k < nodeInfo.numNeighbors; k++) {
+               const int n = nodeInfo.neighbors[k];
+               computeLinearForce(inputCoords, nodeInfo, j, n, k, linearForceComponents);
+               for (int i = 0; i < 3; i++) {
+                  nodeInfo.totalForce[i] +=
+                     linearForceComponents[i] / floatNumNeighbors;
+                  nodeInfo.linearForce[i] +=
+                     linearForceComponents[i] / floatNumNeighbors;
+               
+                  //
+                  // If this neighbor is not a morphable node
+                  //
+                  if (nodeShouldBeMorphed[n] == false) {
+                     //
+                     //  Add the inverse of the neighbor's linear force
+                     //
+                     nodeInfo.totalForce[i]  -= (noMorphNeighborStepSize * 
+                                                morphNodeInfo[n].linearForce[i])
+                                                / floatNumNeighbors;
+                     nodeInfo.linearForce[i] -= (noMorphNeighborStepSize * 
+                                                morphNodeInfo[n].linearForce[i])
+                                                / floatNumNeighbors;
+                  }
+               }
+            }
+
+            if (DebugControl::getDebugOn()) {
+               if (DebugControl::getDebugNodeNumber() == j) {
+                  std::cout << std::endl;
+                  std::cout << "Total Linear Force for node: " << j
+                           << "(" << nodeInfo.linearForce[0]
+                           << ", " << nodeInfo.linearForce[1]
+                           << ", " << nodeInfo.linearForce[2] << ")" << std::endl;
+                  std::cout << std::endl;
+               }
+            }
+         }
+            
          //
-         // If this node has neighbors and should be morphed
+         // Apply angular forces to node
          //
-         if ((nodeInfo.numNeighbors > 1) && nodeShouldBeMorphed[j]) {
-            //
-            // Initialize forces to zero
-            //
-            nodeInfo.resetForces();
-            
-            float linearForceComponents[3];
-            float angularForceComponents[3];
-         
-            const float floatNumNeighbors = static_cast<float>(nodeInfo.numNeighbors);
-            //
-            // Apply linear forces to node
-            //
-            if (linearForce > 0.0) {
-               for (int k = 0; k < nodeInfo.numNeighbors; k++) {
+         if (angularForce > 0.0) {
+            if (nodeInfo.classification == BrainSetNodeAttribute::CLASSIFICATION_TYPE_CORNER) {
+               computeAngularForce(inputCoords, nodeInfo, 0, angularForceComponents);
+               for (int i = 0; i < 3; i++){
+                  nodeInfo.totalForce[i] +=
+                           angularForceComponents[i] / (floatNumNeighbors - 1.0);
+                  nodeInfo.angularForce[i] +=
+                           angularForceComponents[i] / (floatNumNeighbors - 1.0);
+               }
+            }
+            else {
+               for (int k = 0; k < nodeInfo.numNeighbors; k++){
                   const int n = nodeInfo.neighbors[k];
-                  computeLinearForce(inputCoords, nodeInfo, j, n, k, linearForceComponents);
-                  for (int i = 0; i < 3; i++) {
+                  computeAngularForce(inputCoords, nodeInfo, k, angularForceComponents);
+                  for (int i = 0; i < 3; i++){
                      nodeInfo.totalForce[i] +=
-                        linearForceComponents[i] / floatNumNeighbors;
-                     nodeInfo.linearForce[i] +=
-                        linearForceComponents[i] / floatNumNeighbors;
-                  
+                              angularForceComponents[i] / floatNumNeighbors;
+                     nodeInfo.angularForce[i] +=
+                              angularForceComponents[i] / floatNumNeighbors;
+               
                      //
                      // If this neighbor is not a morphable node
                      //
@@ -824,129 +804,59 @@ BrainModelSurfaceMorphing::run(int iteration)
                         //
                         //  Add the inverse of the neighbor's linear force
                         //
-                        nodeInfo.totalForce[i]  -= (noMorphNeighborStepSize * 
-                                                   morphNodeInfo[n].linearForce[i])
+                        nodeInfo.totalForce[i]   -= (noMorphNeighborStepSize * 
+                                                   morphNodeInfo[n].angularForce[i])
                                                    / floatNumNeighbors;
-                        nodeInfo.linearForce[i] -= (noMorphNeighborStepSize * 
-                                                   morphNodeInfo[n].linearForce[i])
+                        nodeInfo.angularForce[i] -= (noMorphNeighborStepSize * 
+                                                   morphNodeInfo[n].angularForce[i])
                                                    / floatNumNeighbors;
                      }
                   }
                }
-   
-               if (DebugControl::getDebugOn()) {
-                  if (DebugControl::getDebugNodeNumber() == j) {
-                     std::cout << std::endl;
-                     std::cout << "Total Linear Force for node: " << j
-                              << "(" << nodeInfo.linearForce[0]
-                              << ", " << nodeInfo.linearForce[1]
-                              << ", " << nodeInfo.linearForce[2] << ")" << std::endl;
-                     std::cout << std::endl;
-                  }
-               }
-            }
-               
-            //
-            // Apply angular forces to node
-            //
-            if (angularForce > 0.0) {
-               if (nodeInfo.classification == BrainSetNodeAttribute::CLASSIFICATION_TYPE_CORNER) {
-                  computeAngularForce(inputCoords, nodeInfo, 0, angularForceComponents);
-                  for (int i = 0; i < 3; i++){
-                     nodeInfo.totalForce[i] +=
-                              angularForceComponents[i] / (floatNumNeighbors - 1.0);
-                     nodeInfo.angularForce[i] +=
-                              angularForceComponents[i] / (floatNumNeighbors - 1.0);
-                  }
-               }
-               else {
-                  for (int k = 0; k < nodeInfo.numNeighbors; k++){
-                     const int n = nodeInfo.neighbors[k];
-                     computeAngularForce(inputCoords, nodeInfo, k, angularForceComponents);
-                     for (int i = 0; i < 3; i++){
-                        nodeInfo.totalForce[i] +=
-                                 angularForceComponents[i] / floatNumNeighbors;
-                        nodeInfo.angularForce[i] +=
-                                 angularForceComponents[i] / floatNumNeighbors;
-                  
-                        //
-                        // If this neighbor is not a morphable node
-                        //
-                        if (nodeShouldBeMorphed[n] == false) {
-                           //
-                           //  Add the inverse of the neighbor's linear force
-                           //
-                           nodeInfo.totalForce[i]   -= (noMorphNeighborStepSize * 
-                                                      morphNodeInfo[n].angularForce[i])
-                                                      / floatNumNeighbors;
-                           nodeInfo.angularForce[i] -= (noMorphNeighborStepSize * 
-                                                      morphNodeInfo[n].angularForce[i])
-                                                      / floatNumNeighbors;
-                        }
-                     }
-                  }
-               }
-            } // if (angularForce > 0.0)
-            
-            //
-            // Adjust forces during spherical morphing
-            //
-            if (morphingSurfaceType == MORPHING_SURFACE_SPHERICAL) {
-               mapForcesToPlane(nodePos, nodeInfo.totalForce);
-               mapForcesToPlane(nodePos, nodeInfo.angularForce);
-               mapForcesToPlane(nodePos, nodeInfo.linearForce);
             }
-            
-            //
-            // Add forces and store in temporary node positions
-            //
-            outputCoords[j*3]   = nodePos[0] + stepSize * nodeInfo.totalForce[0];
-            outputCoords[j*3+1] = nodePos[1] + stepSize * nodeInfo.totalForce[1];
-            outputCoords[j*3+2] = nodePos[2] + stepSize * nodeInfo.totalForce[2];
-            
-            if (DebugControl::getDebugOn()) {
-               if (checkNaN(&outputCoords[j*3], 3)) {
-                  QString s = "PROGRAM ERROR: NaN detected for coordinate "
-                            + QString::number(j)
-                            + " iteration "
-                            + QString::number(iteration)
-                            + " in "
-                            + FileUtilities::basename(morphingSurface->getCoordinateFile()->getFileName());
-                  throw BrainModelAlgorithmException(s);
-               }
-            }            
-         }  // if (nodeInfo.numNeighbors > 1)
+         } // if (angularForce > 0.0)
          
          //
-         // Project back to sphere if morphing a sphere
+         // Adjust forces during spherical morphing
          //
-         switch (morphingSurfaceType) {
-            case MORPHING_SURFACE_FLAT:
-               break;
-            case MORPHING_SURFACE_SPHERICAL:
-               projectNodeBackToSphere(j);
-               break;
+         if (morphingSurfaceType == MORPHING_SURFACE_SPHERICAL) {
+            mapForcesToPlane(nodePos, nodeInfo.totalForce);
+            mapForcesToPlane(nodePos, nodeInfo.angularForce);
+            mapForcesToPlane(nodePos, nodeInfo.linearForce);
          }
          
-      } // for (j = 0...
-      
-      if (getImAThread()) {
-         if (DebugControl::getDebugOn()) {
-            std::cout << "Morphing Thread " << getThreadNumber() << " finished iteration." << std::endl;
-         }
-         //
-         // A threaded instance needs to tell that it has completed an iteration
-         //
-         setThreadedIterationDoneFlag(true);
-         getParentOfThisThread()->incrementNumChildThreadDone();
-      }
-      else {
          //
-         // A non-threaded instance needs to return
+         // Add forces and store in temporary node positions
          //
-         setThreadKeepLoopingFlag(false);
+         outputCoords[j*3]   = nodePos[0] + stepSize * nodeInfo.totalForce[0];
+         outputCoords[j*3+1] = nodePos[1] + stepSize * nodeInfo.totalForce[1];
+         outputCoords[j*3+2] = nodePos[2] + stepSize * nodeInfo.totalForce[2];
+         
+         if (DebugControl::getDebugOn()) {
+            if (checkNaN(&outputCoords[j*3], 3)) {
+               QString s = "PROGRAM ERROR: NaN detected for coordinate "
+                         + QString::number(j)
+                         + " iteration "
+                         + QString::number(iteration)
+                         + " in "
+                         + FileUtilities::basename(morphingSurface->getCoordinateFile()->getFileName());
+               throw BrainModelAlgorithmException(s);
+            }
+         }            
+      }  // if (nodeInfo.numNeighbors > 1)
+      
+      //
+      // Project back to sphere if morphing a sphere
+      //
+      switch (morphingSurfaceType) {
+         case MORPHING_SURFACE_FLAT:
+            break;
+         case MORPHING_SURFACE_SPHERICAL:
+            projectNodeBackToSphere(j);
+            break;
       }
-   } // while (keepLooping)
+      
+   } // for (j = 0...
 
    if (DebugControl::getDebugOn()) {
       std::cout << "   iteration"
@@ -175,8 +175,8 @@ class BrainModelSurfaceMorphing : public BrainModelAlgorithmMultiThreaded {
                                 BrainModelSurfaceMorphing* parentOfThisThreadIn,
                                 const int threadNumberIn);      
                                            
-      /// morph for one iteration
-      void run(int iteration);
+      /// morph for one iteration (run in the thread pool for thread instances)
+      void runIteration(const int iteration);
       
       /// Compute the angular force on a node by its neighbor.
       void computeAngularForce(const float* coords,
@@ -0,0 +1,392 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#include <algorithm>
+#include <iostream>
+
+#define __BRAIN_MODEL_SURFACE_MULTIRESOLUTION_SMOOTHING_MAIN__
+#include "BrainModelSurfaceMultiresolutionSmoothing.h"
+#undef __BRAIN_MODEL_SURFACE_MULTIRESOLUTION_SMOOTHING_MAIN__
+
+#include "BrainModelSurface.h"
+#include "BrainModelSurfaceSmoothing.h"
+#include "CoordinateFile.h"
+#include "DebugControl.h"
+#include "TopologyFile.h"
+#include "TopologyHelper.h"
+
+/**
+ * Constructor.
+ */
+BrainModelSurfaceMultiresolutionSmoothing::BrainModelSurfaceMultiresolutionSmoothing(
+                                                BrainSet* bs,
+                                                BrainModelSurface* surfaceIn,
+                                                const float strengthIn,
+                                                const int iterationsIn,
+                                                const int edgeIterationsIn)
+   : BrainModelAlgorithm(bs)
+{
+   surface        = surfaceIn;
+   strength       = strengthIn;
+   iterations     = iterationsIn;
+   edgeIterations = edgeIterationsIn;
+}
+
+/**
+ * Destructor.
+ */
+BrainModelSurfaceMultiresolutionSmoothing::~BrainModelSurfaceMultiresolutionSmoothing()
+{
+}
+
+/**
+ * Execute the algorithm.
+ */
+void 
+BrainModelSurfaceMultiresolutionSmoothing::execute() throw (BrainModelAlgorithmException)
+{
+   if (surface == NULL) {
+      throw BrainModelAlgorithmException("Surface is invalid (NULL).");
+   }
+   const int numNodes = surface->getNumberOfNodes();
+   if (numNodes <= 0) {
+      throw BrainModelAlgorithmException("Surface has no nodes to smooth.");
+   }
+   if (iterations <= 0) {
+      return;
+   }
+   
+   if (levels.empty()) {
+      createLevels();
+   }
+   
+   //
+   // A few iterations are always done on the surface and the rest
+   // are done on a coarse level
+   //
+   int fineIterations = std::min(iterations, std::max(2, iterations / 10));
+   const int coarseWork = iterations - fineIterations;
+   
+   //
+   // An iteration on a coarse level smooths as much as a number of
+   // iterations on the surface equal to the ratio of the node counts
+   // (the squared edge length grows with the ratio).  Use the coarsest
+   // level that still gets enough iterations to resolve the smoothing.
+   //
+   int coarseLevel = 0;
+   int coarseIterations = 0;
+   for (int i = 1; i < getNumberOfLevels(); i++) {
+      const float levelRatio = static_cast<float>(levels[i].numberOfNodes)
+                             / static_cast<float>(numNodes);
+      const int levelIterations = static_cast<int>(coarseWork * levelRatio + 0.5);
+      if (levelIterations >= MINIMUM_COARSE_ITERATIONS) {
+         coarseLevel = i;
+         coarseIterations = levelIterations;
+      }
+   }
+   
+   CoordinateFile* cf = surface->getCoordinateFile();
+   
+   if (coarseLevel > 0) {
+      //
+      // Areal smoothing with strength "s" moves a node toward the tile centers
+      // which is linear smoothing with a strength of two-thirds "s"
+      //
+      const float linearStrength = strength * (2.0 / 3.0);
+      
+      //
+      // Coordinates of each level before smoothing
+      //
+      std::vector<std::vector<float> > originalXYZ(coarseLevel + 1);
+      const float* surfaceXYZ = cf->getCoordinate(0);
+      originalXYZ[0].assign(surfaceXYZ, surfaceXYZ + numNodes * 3);
+      for (int i = 1; i <= coarseLevel; i++) {
+         const Level& level = levels[i];
+         const std::vector<float>& fineXYZ = originalXYZ[i - 1];
+         std::vector<float>& xyz = originalXYZ[i];
+         xyz.resize(level.numberOfNodes * 3);
+         for (int j = 0; j < level.numberOfNodes; j++) {
+            const int p = level.parentNodes[j];
+            xyz[j*3]   = fineXYZ[p*3];
+            xyz[j*3+1] = fineXYZ[p*3+1];
+            xyz[j*3+2] = fineXYZ[p*3+2];
+         }
+      }
+      
+      //
+      // Smooth the coarse level
+      //
+      std::vector<float> smoothedXYZ(originalXYZ[coarseLevel]);
+      smoothLevel(levels[coarseLevel], smoothedXYZ, linearStrength, coarseIterations);
+      
+      //
+      // Interpolate displacements up to the surface
+      //
+      for (int i = coarseLevel - 1; i >= 0; i--) {
+         const Level& level = levels[i];
+         const std::vector<float>& coarseOriginalXYZ = originalXYZ[i + 1];
+         const std::vector<float>& levelOriginalXYZ = originalXYZ[i];
+         std::vector<float> xyz(levelOriginalXYZ);
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1024)
+#endif
+         for (int j = 0; j < level.numberOfNodes; j++) {
+            const int first = level.prolongOffsets[j];
+            const int last  = level.prolongOffsets[j + 1];
+            if (last > first) {
+               float delta[3] = { 0.0, 0.0, 0.0 };
+               for (int k = first; k < last; k++) {
+                  const int c = level.prolongNodes[k];
+                  delta[0] += smoothedXYZ[c*3]   - coarseOriginalXYZ[c*3];
+                  delta[1] += smoothedXYZ[c*3+1] - coarseOriginalXYZ[c*3+1];
+                  delta[2] += smoothedXYZ[c*3+2] - coarseOriginalXYZ[c*3+2];
+               }
+               const float num = last - first;
+               xyz[j*3]   += delta[0] / num;
+               xyz[j*3+1] += delta[1] / num;
+               xyz[j*3+2] += delta[2] / num;
+            }
+         }
+         
+         //
+         // Remove artifacts of the interpolation on intermediate levels
+         //
+         if (i > 0) {
+            smoothLevel(level, xyz, linearStrength, INTERMEDIATE_LEVEL_ITERATIONS);
+         }
+         smoothedXYZ.swap(xyz);
+      }
+      
+      cf->setAllCoordinates(&smoothedXYZ[0]);
+      
+      if (DebugControl::getDebugOn()) {
+         std::cout << "Multiresolution smoothing: " << coarseIterations
+                   << " iterations on level " << coarseLevel << " with "
+                   << levels[coarseLevel].numberOfNodes << " nodes, "
+                   << fineIterations << " iterations on surface." << std::endl;
+      }
+   }
+   else {
+      fineIterations = iterations;
+   }
+   
+   //
+   // Finish with areal smoothing of the surface
+   //
+   BrainModelSurfaceSmoothing smoothing(brainSet,
+                                        surface,
+                                        BrainModelSurfaceSmoothing::SMOOTHING_TYPE_AREAL,
+                                        strength,
+                                        fineIterations,
+                                        edgeIterations,
+                                        0,
+                                        NULL,
+                                        NULL,
+                                        0,
+                                        0);
+   smoothing.execute();
+}
+
+/**
+ * Build the levels of the hierarchy.
+ */
+void 
+BrainModelSurfaceMultiresolutionSmoothing::createLevels()
+{
+   levels.clear();
+   
+   //
+   // The surface is the first level
+   //
+   const TopologyHelper* th = surface->getTopologyFile()->getTopologyHelper(false, true, false);
+   Level surfaceLevel;
+   surfaceLevel.numberOfNodes = surface->getNumberOfNodes();
+   surfaceLevel.neighborOffsets.resize(surfaceLevel.numberOfNodes + 1, 0);
+   for (int i = 0; i < surfaceLevel.numberOfNodes; i++) {
+      int numNeighbors = 0;
+      const int* neighbors = th->getNodeNeighbors(i, numNeighbors);
+      surfaceLevel.neighborNodes.insert(surfaceLevel.neighborNodes.end(),
+                                        neighbors, neighbors + numNeighbors);
+      surfaceLevel.neighborOffsets[i + 1] = static_cast<int>(surfaceLevel.neighborNodes.size());
+   }
+   levels.push_back(surfaceLevel);
+   
+   //
+   // Coarsen until the levels become too small
+   //
+   while (getNumberOfLevels() < MAXIMUM_NUMBER_OF_LEVELS) {
+      Level coarse;
+      if (createCoarseLevel(levels[levels.size() - 1], coarse) == false) {
+         break;
+      }
+      levels.push_back(coarse);
+   }
+   
+   if (DebugControl::getDebugOn()) {
+      for (int i = 0; i < getNumberOfLevels(); i++) {
+         std::cout << "Multiresolution smoothing level " << i << ": "
+                   << levels[i].numberOfNodes << " nodes" << std::endl;
+      }
+   }
+}
+
+/**
+ * Create a coarse level from a level.  The coarse nodes are a maximal 
+ * independent set of the level's nodes and every other node belongs to the
+ * first coarse node that is its neighbor.  Coarse nodes are neighbors when 
+ * any of their nodes are neighbors.  Returns false (and leaves "fine" unchanged)
+ * if the coarse level would have too few nodes.
+ */
+bool 
+BrainModelSurfaceMultiresolutionSmoothing::createCoarseLevel(Level& fine, 
+                                                             Level& coarse) const
+{
+   const int numFineNodes = fine.numberOfNodes;
+   
+   //
+   // Select the coarse nodes
+   //
+   std::vector<int> coarseIndex(numFineNodes, -1);
+   std::vector<int> aggregate(numFineNodes, -1);
+   int numCoarseNodes = 0;
+   for (int i = 0; i < numFineNodes; i++) {
+      const int first = fine.neighborOffsets[i];
+      const int last  = fine.neighborOffsets[i + 1];
+      if ((last > first) && (aggregate[i] < 0)) {
+         coarseIndex[i] = numCoarseNodes;
+         aggregate[i]   = numCoarseNodes;
+         for (int j = first; j < last; j++) {
+            const int n = fine.neighborNodes[j];
+            if (aggregate[n] < 0) {
+               aggregate[n] = numCoarseNodes;
+            }
+         }
+         numCoarseNodes++;
+      }
+   }
+   
+   if (numCoarseNodes < MINIMUM_NUMBER_OF_LEVEL_NODES) {
+      return false;
+   }
+   
+   //
+   // Coarse nodes used to prolong each fine node are the coarse node itself
+   // or the coarse nodes that are its neighbors
+   //
+   fine.prolongOffsets.resize(numFineNodes + 1, 0);
+   fine.prolongNodes.clear();
+   for (int i = 0; i < numFineNodes; i++) {
+      if (coarseIndex[i] >= 0) {
+         fine.prolongNodes.push_back(coarseIndex[i]);
+      }
+      else {
+         for (int j = fine.neighborOffsets[i]; j < fine.neighborOffsets[i + 1]; j++) {
+            const int c = coarseIndex[fine.neighborNodes[j]];
+            if (c >= 0) {
+               fine.prolongNodes.push_back(c);
+            }
+         }
+      }
+      fine.prolongOffsets[i + 1] = static_cast<int>(fine.prolongNodes.size());
+   }
+   
+   //
+   // Neighbors of the coarse nodes
+   //
+   std::vector<std::vector<int> > coarseNeighbors(numCoarseNodes);
+   for (int i = 0; i < numFineNodes; i++) {
+      const int a = aggregate[i];
+      if (a < 0) {
+         continue;
+      }
+      for (int j = fine.neighborOffsets[i]; j < fine.neighborOffsets[i + 1]; j++) {
+         const int b = aggregate[fine.neighborNodes[j]];
+         if ((b >= 0) && (b != a)) {
+            coarseNeighbors[a].push_back(b);
+         }
+      }
+   }
+   
+   coarse.numberOfNodes = numCoarseNodes;
+   coarse.parentNodes.resize(numCoarseNodes);
+   for (int i = 0; i < numFineNodes; i++) {
+      if (coarseIndex[i] >= 0) {
+         coarse.parentNodes[coarseIndex[i]] = i;
+      }
+   }
+   coarse.neighborOffsets.resize(numCoarseNodes + 1, 0);
+   coarse.neighborNodes.clear();
+   for (int i = 0; i < numCoarseNodes; i++) {
+      std::vector<int>& neighbors = coarseNeighbors[i];
+      std::sort(neighbors.begin(), neighbors.end());
+      neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+      coarse.neighborNodes.insert(coarse.neighborNodes.end(), 
+                                  neighbors.begin(), neighbors.end());
+      coarse.neighborOffsets[i + 1] = static_cast<int>(coarse.neighborNodes.size());
+   }
+   
+   return true;
+}
+
+/**
+ * Linear smoothing of a level's coordinates.
+ */
+void 
+BrainModelSurfaceMultiresolutionSmoothing::smoothLevel(const Level& level,
+                                                       std::vector<float>& xyz,
+                                                       const float levelStrength,
+                                                       const int levelIterations) const
+{
+   const float inverseStrength = 1.0 - levelStrength;
+   std::vector<float> outputXYZ(xyz.size());
+   
+   for (int iter = 0; iter < levelIterations; iter++) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1024)
+#endif
+      for (int i = 0; i < level.numberOfNodes; i++) {
+         const int first = level.neighborOffsets[i];
+         const int last  = level.neighborOffsets[i + 1];
+         if (last > first) {
+            float neighXYZ[3] = { 0.0, 0.0, 0.0 };
+            for (int j = first; j < last; j++) {
+               const int n = level.neighborNodes[j];
+               neighXYZ[0] += xyz[n*3];
+               neighXYZ[1] += xyz[n*3+1];
+               neighXYZ[2] += xyz[n*3+2];
+            }
+            const float floatNumNeigh = last - first;
+            outputXYZ[i*3]   = xyz[i*3]   * inverseStrength + (neighXYZ[0] / floatNumNeigh) * levelStrength;
+            outputXYZ[i*3+1] = xyz[i*3+1] * inverseStrength + (neighXYZ[1] / floatNumNeigh) * levelStrength;
+            outputXYZ[i*3+2] = xyz[i*3+2] * inverseStrength + (neighXYZ[2] / floatNumNeigh) * levelStrength;
+         }
+         else {
+            outputXYZ[i*3]   = xyz[i*3];
+            outputXYZ[i*3+1] = xyz[i*3+1];
+            outputXYZ[i*3+2] = xyz[i*3+2];
+         }
+      }
+      xyz.swap(outputXYZ);
+   }
+}
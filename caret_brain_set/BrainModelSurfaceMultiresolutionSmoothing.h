@@ -0,0 +1,130 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#ifndef __BRAIN_MODEL_SURFACE_MULTIRESOLUTION_SMOOTHING_H__
+#define __BRAIN_MODEL_SURFACE_MULTIRESOLUTION_SMOOTHING_H__
+
+#include <vector>
+
+#include "BrainModelAlgorithm.h"
+
+class BrainModelSurface;
+
+/// Smooths a surface using a hierarchy of coarser node graphs.  Each coarse
+/// level keeps a maximal independent set of the nodes of the level above and
+/// connects nodes whose groups of nodes are adjacent.  Most of the smoothing
+/// is done as linear smoothing on a coarse level, the displacements are
+/// interpolated back up to the surface and a few areal smoothing iterations
+/// on the surface finish the job.  An instance may be executed repeatedly
+/// and only builds the hierarchy the first time.
+class BrainModelSurfaceMultiresolutionSmoothing : public BrainModelAlgorithm {
+   public:
+      /// constructor
+      BrainModelSurfaceMultiresolutionSmoothing(BrainSet* bs,
+                                                BrainModelSurface* surfaceIn,
+                                                const float strengthIn,
+                                                const int iterationsIn,
+                                                const int edgeIterationsIn);
+      
+      /// destructor
+      ~BrainModelSurfaceMultiresolutionSmoothing();
+      
+      /// execute the algorithm
+      void execute() throw (BrainModelAlgorithmException);
+      
+      /// get the number of levels in the hierarchy (valid after execution)
+      int getNumberOfLevels() const { return static_cast<int>(levels.size()); }
+      
+   protected:
+      /// a level of the hierarchy
+      class Level {
+         public:
+            /// number of nodes in this level
+            int numberOfNodes;
+            
+            /// offset of each node's neighbors in "neighborNodes" (numberOfNodes + 1)
+            std::vector<int> neighborOffsets;
+            
+            /// neighbors of all nodes
+            std::vector<int> neighborNodes;
+            
+            /// node in the level above of each node (empty for the surface level)
+            std::vector<int> parentNodes;
+            
+            /// offset of each node's coarse nodes in "prolongNodes" (numberOfNodes + 1)
+            std::vector<int> prolongOffsets;
+            
+            /// nodes in the next coarser level whose displacements are averaged
+            /// to get the displacement of a node in this level
+            std::vector<int> prolongNodes;
+      };
+      
+      /// build the levels of the hierarchy
+      void createLevels();
+      
+      /// create a coarse level from a level
+      bool createCoarseLevel(Level& fine, Level& coarse) const;
+      
+      /// linear smoothing of a level's coordinates
+      void smoothLevel(const Level& level,
+                       std::vector<float>& xyz,
+                       const float levelStrength,
+                       const int levelIterations) const;
+                       
+      /// the surface
+      BrainModelSurface* surface;
+      
+      /// smoothing strength
+      float strength;
+      
+      /// smoothing iterations (on the surface)
+      int iterations;
+      
+      /// smooth edges every X iterations on the surface
+      int edgeIterations;
+      
+      /// the levels (the surface is level zero)
+      std::vector<Level> levels;
+      
+      /// maximum number of levels
+      static const int MAXIMUM_NUMBER_OF_LEVELS;
+      
+      /// stop coarsening when a level has fewer nodes
+      static const int MINIMUM_NUMBER_OF_LEVEL_NODES;
+      
+      /// fewest smoothing iterations worth running on a coarse level
+      static const int MINIMUM_COARSE_ITERATIONS;
+      
+      /// smoothing iterations on intermediate levels after prolongation
+      static const int INTERMEDIATE_LEVEL_ITERATIONS;
+};
+
+#ifdef __BRAIN_MODEL_SURFACE_MULTIRESOLUTION_SMOOTHING_MAIN__
+   const int BrainModelSurfaceMultiresolutionSmoothing::MAXIMUM_NUMBER_OF_LEVELS = 8;
+   const int BrainModelSurfaceMultiresolutionSmoothing::MINIMUM_NUMBER_OF_LEVEL_NODES = 100;
+   const int BrainModelSurfaceMultiresolutionSmoothing::MINIMUM_COARSE_ITERATIONS = 5;
+   const int BrainModelSurfaceMultiresolutionSmoothing::INTERMEDIATE_LEVEL_ITERATIONS = 2;
+#endif // __BRAIN_MODEL_SURFACE_MULTIRESOLUTION_SMOOTHING_MAIN__
+
+#endif // __BRAIN_MODEL_SURFACE_MULTIRESOLUTION_SMOOTHING_H__
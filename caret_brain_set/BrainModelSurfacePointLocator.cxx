@@ -28,9 +28,18 @@
 #include "BrainModelSurface.h"
 #include "BrainModelSurfacePointLocator.h"
 #include "TopologyFile.h"
-#include "vtkIdList.h"
-#include "vtkMath.h"
-#include "vtkPointLocator.h"
+
+/**
+ * squared distance between two points.
+ */
+static inline float
+distanceSquared3D(const float p1[3], const float p2[3])
+{
+   const float dx = p1[0] - p2[0];
+   const float dy = p1[1] - p2[1];
+   const float dz = p1[2] - p2[2];
+   return (dx*dx + dy*dy + dz*dz);
+}
 
 /**
  * Constructor.
@@ -51,21 +60,17 @@ BrainModelSurfacePointLocator::BrainModelSurfacePointLocator(const BrainModelSur
                                                        const std::vector<bool>* limitToTheseNodes)
    : coordFile(bms->getCoordinateFile())
 {
-   locator  = NULL;
-   points   = NULL;
-   polyData = NULL;
-   
    //const CoordinateFile* coordFile = bms->getCoordinateFile();
    const int numPoints = coordFile->getNumberOfCoordinates();
-   if (numPoints <= 0) {
-      return;
-   }
    
    //
    // Find out if surface will have nodes added to it after this object is constructed
    //
    nodesMayBeAddedToSurface = nodesMayBeAddedToSurfaceIn;
    originalNumberOfNodes   = numPoints;
+   if (numPoints <= 0) {
+      return;
+   }
    
    //
    // If necessary, keep track of which nodes are connected
@@ -102,25 +107,22 @@ BrainModelSurfacePointLocator::BrainModelSurfacePointLocator(const BrainModelSur
    //
    // Add the nodes to the point locator
    //   
-   int counter = 0;
-   points = vtkPoints::New();
+   std::vector<float> pointXYZ;
+   std::vector<int> pointNodeIndex;
    for (int i = 0; i < numPoints; i++) {
       if (useThisNode[i]) {
-         float xyz[3];
-         coordFile->getCoordinate(i, xyz);
-         points->InsertPoint(counter, xyz);
-         counter++;
-         pointIndexToNodeIndex.push_back(i);
+         const float* xyz = coordFile->getCoordinate(i);
+         pointXYZ.push_back(xyz[0]);
+         pointXYZ.push_back(xyz[1]);
+         pointXYZ.push_back(xyz[2]);
+         pointNodeIndex.push_back(i);
       }
    }
    
-   polyData = vtkPolyData::New();
-   polyData->SetPoints(points);
-   
-   locator = vtkPointLocator::New();
-   locator->Initialize();
-   locator->SetDataSet(polyData);
-   locator->BuildLocator();
+   if (pointNodeIndex.empty() == false) {
+      locator.setPoints(&pointXYZ[0], &pointNodeIndex[0], 
+                        static_cast<int>(pointNodeIndex.size()));
+   }
 }
 
 /*
@@ -128,38 +130,15 @@ BrainModelSurfacePointLocator::BrainModelSurfacePointLocator(const BrainModelSur
  */
 BrainModelSurfacePointLocator::~BrainModelSurfacePointLocator()
 {
-   if (locator != NULL)  {
-      locator->Delete();
-      locator = NULL;
-   }
-   if (polyData != NULL) {
-      polyData->Delete();
-      polyData = NULL;
-   }
-   if (points != NULL) {
-      points->Delete();
-      points = NULL;
-   }
 }
 
 /**      
  * find point nearest to location (returns negative BrainModelSurface is empty)
  */
 int 
-BrainModelSurfacePointLocator::getNearestPoint(const float xyz[3])
+BrainModelSurfacePointLocator::getNearestPoint(const float xyz[3]) const
 {
-   int closestNodeIndex = -1;
-   if (locator != NULL) {
-#ifdef HAVE_VTK5
-      double d[3] = { xyz[0], xyz[1], xyz[2] };
-      const int num = locator->FindClosestPoint(d);
-#else // HAVE_VTK5
-      const int num = locator->FindClosestPoint((float*)xyz);
-#endif // HAVE_VTK5
-      if (num >= 0) {
-         closestNodeIndex = pointIndexToNodeIndex[num];
-      }
-   }
+   int closestNodeIndex = locator.getNearestPoint(xyz);
    
    //
    // Is is possible that nodes have been added to the surface
@@ -183,9 +162,9 @@ BrainModelSurfacePointLocator::getNearestPoint(const float xyz[3])
                closestNodeIndex = closestNewNodeIndex;
             }
             else {
-               const float newCoordDist = vtkMath::Distance2BetweenPoints(xyz, 
+               const float newCoordDist = distanceSquared3D(xyz, 
                                                        coordFile->getCoordinate(closestNewNodeIndex));
-               const float oldCoordDist = vtkMath::Distance2BetweenPoints(xyz, 
+               const float oldCoordDist = distanceSquared3D(xyz, 
                                                        coordFile->getCoordinate(closestNodeIndex));
                if (newCoordDist < oldCoordDist) {
                   closestNodeIndex = closestNewNodeIndex;
@@ -198,33 +177,55 @@ BrainModelSurfacePointLocator::getNearestPoint(const float xyz[3])
    return closestNodeIndex;
 }
 
+/**
+ * find points nearest to many locations (three coordinates per location).
+ * If "runParallelFlag" is set, the queries are divided among threads.
+ */
+void 
+BrainModelSurfacePointLocator::getNearestPoints(const float* xyzs,
+                                                const int numberOfLocations,
+                                                int* nearestPointsOut,
+                                                const bool runParallelFlag) const
+{
+   if (nodesMayBeAddedToSurface &&
+       (originalNumberOfNodes < coordFile->getNumberOfCoordinates())) {
+      //
+      // Added nodes are only in the coordinate file so search one at a time
+      //
+      for (int i = 0; i < numberOfLocations; i++) {
+         nearestPointsOut[i] = getNearestPoint(&xyzs[i * 3]);
+      }
+      return;
+   }
+   
+   locator.getNearestPoints(xyzs, numberOfLocations, nearestPointsOut, runParallelFlag);
+}
+
+/**
+ * find the "k" points nearest to location, nearest first.  Nodes added to
+ * the surface after this object was constructed are not searched.
+ */
+void 
+BrainModelSurfacePointLocator::getNearestPoints(const float xyz[3],
+                                                const int k,
+                                                std::vector<int>& nearestPointsOut,
+                                                std::vector<float>& distancesSquaredOut) const
+{
+   locator.getNearestPoints(xyz, k, nearestPointsOut, distancesSquaredOut);
+}
+
 /**
  * Find points within a specified radius of the location.
  */
 void
 BrainModelSurfacePointLocator::getPointsWithinRadius(const float xyz[3],
                                                      const float radius,
-                                                     std::vector<int>& nearbyPointsOut)
+                                                     std::vector<int>& nearbyPointsOut) const
 {
-   nearbyPointsOut.clear();
-   
-   vtkIdList* idList = vtkIdList::New();
-   
    //
-   // Find nearby points with the vtk locator
+   // Find nearby points with the locator
    //
-#ifdef HAVE_VTK5
-   double xyzD[3] = { xyz[0], xyz[1], xyz[2] };
-   locator->FindPointsWithinRadius(radius, xyzD, idList);   
-#else // HAVE_VTK5
-   locator->FindPointsWithinRadius(radius, xyz, idList);   
-#endif // HAVE_VTK5
-   const int numIDs = idList->GetNumberOfIds();
-   if (numIDs > 0) {
-      for (int i = 0; i < numIDs; i++) {
-         nearbyPointsOut.push_back(pointIndexToNodeIndex[idList->GetId(i)]);
-      }
-   }
+   locator.getPointsWithinRadius(xyz, radius, nearbyPointsOut);
    
    // Is is possible that nodes have been added to the surface
    //
@@ -241,15 +242,13 @@ BrainModelSurfacePointLocator::getPointsWithinRadius(const float xyz[3],
          //
          for (int i = originalNumberOfNodes; i < newNumberOfNodes; i++) {
             const float* coordXYZ = coordFile->getCoordinate(i);
-            const float distSquared = vtkMath::Distance2BetweenPoints(xyz, coordXYZ);
+            const float distSquared = distanceSquared3D(xyz, coordXYZ);
             if (distSquared < radiusSquared) {
                nearbyPointsOut.push_back(i);
             }
          }
       }
    }
-   
-   if (idList != NULL) idList->Delete();
 }
 
 
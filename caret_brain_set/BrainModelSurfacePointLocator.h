@@ -22,22 +22,19 @@
  *
  */
 /*LICENSE_END*/
-
-
-
 #ifndef __VE_BRAIN_MODEL_SURFACE_POINT_LOCATOR_H__
 #define __VE_BRAIN_MODEL_SURFACE_POINT_LOCATOR_H__
 
 #include <vector>
 
+#include "PointKDTree.h"
+
 class BrainModelSurface;
 class CoordinateFile;
-class vtkPointLocator;
-class vtkPoints;
-class vtkPolyData;
 
 /// This class is used to quickly find the nearest point (node) in a BrainModelSurface.  It
-/// should be used when multiple queries will be made.
+/// should be used when multiple queries will be made.  Queries do not modify the
+/// locator so they may be made from multiple threads at the same time.
 class BrainModelSurfacePointLocator {
    public:
       /// Constructor
@@ -50,27 +47,29 @@ class BrainModelSurfacePointLocator {
       ~BrainModelSurfacePointLocator();
       
       /// find point nearest to location (returns negative BrainModelSurface is empty)
-      int getNearestPoint(const float xyz[3]);
+      int getNearestPoint(const float xyz[3]) const;
+      
+      /// find points nearest to many locations (three coordinates per location)
+      void getNearestPoints(const float* xyzs,
+                            const int numberOfLocations,
+                            int* nearestPointsOut,
+                            const bool runParallelFlag = true) const;
+      
+      /// find the "k" points nearest to location, nearest first
+      void getNearestPoints(const float xyz[3],
+                            const int k,
+                            std::vector<int>& nearestPointsOut,
+                            std::vector<float>& distancesSquaredOut) const;
       
       /// find points within the specified radius of the location
       void getPointsWithinRadius(const float xyz[3],
                                  const float radius,
-                                 std::vector<int>& nearbyPointsOut); 
+                                 std::vector<int>& nearbyPointsOut) const; 
                                  
    private:
-      /// the point locator
-      vtkPointLocator* locator;
-      
-      /// the points
-      vtkPoints* points;
+      /// the point locator (ids of points are node indices)
+      PointKDTree locator;
       
-      /// data set for the points
-      vtkPolyData* polyData;
-      
-      /// If we are limited to connected nodes, only connected nodes will be placed into the
-      /// point locator.  "pointIndexToNodeIndex" keeps track of this relationship.
-      std::vector<int> pointIndexToNodeIndex;
-
       /// nodes may be added to the surface after this object is constructed
       bool nodesMayBeAddedToSurface;
       
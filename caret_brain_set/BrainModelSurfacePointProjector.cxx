@@ -31,6 +31,7 @@
 #include <cmath>
 #include <iostream>
 #include <limits>
+#include <vector>
 
 #include "BrainModelSurface.h"
 #include "BrainModelSurfacePointLocator.h"
@@ -38,6 +39,7 @@
 #include "MathUtilities.h"
 #include "TopologyFile.h"
 #include "TopologyHelper.h"
+#include "TriangleBVH.h"
 
 #include "vtkMath.h"
 #include "vtkPlane.h"
@@ -61,6 +63,7 @@ BrainModelSurfacePointProjector::BrainModelSurfacePointProjector(
    // Create a point locator for connected nodes
    //
    pointLocator = new BrainModelSurfacePointLocator(bmsIn, true, surfaceMayHaveNodesAddedToIt);
+   triangleBVH = NULL;
    
    nearestNodeToleranceSquared = 0.01 * 0.01;
    tileAreaTolerance    = -0.01;
@@ -97,6 +100,80 @@ BrainModelSurfacePointProjector::~BrainModelSurfacePointProjector()
 {
    if (pointLocator != NULL) delete pointLocator;
    pointLocator = NULL;
+   if (triangleBVH != NULL) delete triangleBVH;
+   triangleBVH = NULL;
+}
+
+/**
+ * Get the bounding volume hierarchy of the tiles.  It is created on first 
+ * use from the surface's coordinates at that time.
+ */
+const TriangleBVH*
+BrainModelSurfacePointProjector::getTriangleBVH()
+{
+   if (triangleBVH == NULL) {
+      triangleBVH = new TriangleBVH;
+      const int numCoords = coordinateFile->getNumberOfCoordinates();
+      const int numTiles  = topologyFile->getNumberOfTiles();
+      if ((numCoords > 0) && (numTiles > 0)) {
+         triangleBVH->setTriangles(coordinateFile->getCoordinate(0),
+                                   numCoords,
+                                   topologyFile->getTile(0),
+                                   numTiles);
+      }
+   }
+   return triangleBVH;
+}
+
+/**
+ * Project many points (three coordinates per point) to the tiles closest to
+ * them.  For each point, the tile (negative if there are no tiles), its three
+ * nodes, and the barycentric areas (in the order used by "unprojectPoint()")
+ * are output.  Unlike the other projection methods this does not change the
+ * state of the projector once the tiles' hierarchy has been created, so the 
+ * points are projected in parallel if "runParallelFlag" is set.
+ */
+void
+BrainModelSurfacePointProjector::projectToClosestTiles(const float* xyzs,
+                                                       const int numberOfPoints,
+                                                       int* tilesOut,
+                                                       int* tileNodesOut,
+                                                       float* barycentricOut,
+                                                       const bool runParallelFlag)
+{
+   const TriangleBVH* bvh = getTriangleBVH();
+   std::vector<float> weights(numberOfPoints * 3);
+   bvh->getClosestTriangles(xyzs, numberOfPoints, tilesOut, &weights[0], NULL, 
+                            runParallelFlag);
+   
+   for (int i = 0; i < numberOfPoints; i++) {
+      int* nodes = &tileNodesOut[i * 3];
+      float* areas = &barycentricOut[i * 3];
+      if (tilesOut[i] < 0) {
+         nodes[0] = -1;
+         nodes[1] = -1;
+         nodes[2] = -1;
+         areas[0] = 0.0;
+         areas[1] = 0.0;
+         areas[2] = 0.0;
+         continue;
+      }
+      
+      topologyFile->getTile(tilesOut[i], nodes);
+      
+      //
+      // Scale weights by the tile's area, area "i" is opposite the tile's node "i + 1"
+      //
+      float tileArea = MathUtilities::triangleArea(coordinateFile->getCoordinate(nodes[0]),
+                                                   coordinateFile->getCoordinate(nodes[1]),
+                                                   coordinateFile->getCoordinate(nodes[2]));
+      if (tileArea <= 0.0) {
+         tileArea = 1.0;
+      }
+      areas[0] = weights[i * 3 + 2] * tileArea;
+      areas[1] = weights[i * 3]     * tileArea;
+      areas[2] = weights[i * 3 + 1] * tileArea;
+   }
 }
 
 /**
@@ -414,9 +491,8 @@ BrainModelSurfacePointProjector::projectBarycentric(const float xyz[3], int& nea
       //
       // Check neighboring nodes of node nearest to query point
       //
-      std::vector<int> neighbors;
-      topologyHelper->getNodeNeighbors(nearestNodeNumberOut, neighbors);
-      const int numNeighbors = static_cast<int>(neighbors.size());
+      int numNeighbors = 0;
+      const int* neighbors = topologyHelper->getNodeNeighbors(nearestNodeNumberOut, numNeighbors);
       for (int i = 0; i < numNeighbors; i++) {
          checkPointInNodesTiles(topologyHelper, neighbors[i]);
          if (barycentricSearchStatus == TILE_FOUND) {
@@ -425,6 +501,28 @@ BrainModelSurfacePointProjector::projectBarycentric(const float xyz[3], int& nea
       }
    }
    
+   //
+   // Points near folds or on sparse meshes may not be in the tiles around the
+   // nearest node, so search the tiles around the tile closest to the point
+   //
+   if ((barycentricSearchStatus == TILE_NOT_FOUND) && (checkNeighbors)) {
+      float weights[3], closestXYZ[3], distanceSquared;
+      const int closestTile = getTriangleBVH()->getClosestTriangle(xyz, weights, 
+                                                                   closestXYZ, 
+                                                                   distanceSquared);
+      if (closestTile >= 0) {
+         checkPointInTile(closestTile);
+         int closestTileNodes[3];
+         topologyFile->getTile(closestTile, closestTileNodes);
+         for (int i = 0; i < 3; i++) {
+            if (barycentricSearchStatus == TILE_FOUND) {
+               break;
+            }
+            checkPointInNodesTiles(topologyHelper, closestTileNodes[i]);
+         }
+      }
+   }
+   
    //
    // Might be "on" the nearest node
    //
@@ -478,9 +576,8 @@ BrainModelSurfacePointProjector::checkPointInNodesTiles(const TopologyHelper* to
    //
    // Get the tiles used by the closest node
    //
-   std::vector<int> tiles;
-   topologyHelper->getNodeTiles(nodeNumber, tiles);
-   const int numTiles = static_cast<int>(tiles.size());
+   int numTiles = 0;
+   const int* tiles = topologyHelper->getNodeTiles(nodeNumber, numTiles);
    
    for (int i = 0; i < numTiles; i++) {
       checkPointInTile(tiles[i]);
@@ -35,6 +35,7 @@ class BrainModelSurfacePointLocator;
 class CoordinateFile;
 class TopologyFile;
 class TopologyHelper;
+class TriangleBVH;
 
 /// This class is used to project points onto a BrainModelSurface.  It can project to
 /// the nearest node or to a barycentric position in a tile.
@@ -76,6 +77,14 @@ class BrainModelSurfacePointProjector {
                                        int tileNodesOut[3], 
                                        float barycentricOut[3]);
                                      
+      /// project many points to the closest tiles (thread-safe once called)
+      void projectToClosestTiles(const float* xyzs,
+                                 const int numberOfPoints,
+                                 int* tilesOut,
+                                 int* tileNodesOut,
+                                 float* barycentricOut,
+                                 const bool runParallelFlag = true);
+      
       /// unproject using the specified coordinate file
       static void unprojectPoint(const int tileNodes[3], const float tileAreas[3],
                                  const CoordinateFile* cf, float xyzOut[3]);
@@ -89,6 +98,9 @@ class BrainModelSurfacePointProjector {
          TILE_FOUND_DEGENERATE
       };
       
+      /// get the bounding volume hierarchy of the tiles (created on first use)
+      const TriangleBVH* getTriangleBVH();
+      
       /// see if a point is in any of the files used by a node.
       void checkPointInNodesTiles(const TopologyHelper* topologyHelper, const int nodeNumber);
                                   
@@ -103,6 +115,9 @@ class BrainModelSurfacePointProjector {
       /// point locator for BrainModelSurface
       BrainModelSurfacePointLocator* pointLocator;
       
+      /// bounding volume hierarchy of the tiles
+      TriangleBVH* triangleBVH;
+      
       /// coordinate file
       const CoordinateFile* coordinateFile;
       
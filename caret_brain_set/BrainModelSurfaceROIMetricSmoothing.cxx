@@ -381,6 +381,7 @@ BrainModelSurfaceROIMetricSmoothing::determineNeighbors()
    CoordinateFile* cf = fiducialSurface->getCoordinateFile();
    float geoCutoff = 4.0f * geodesicGaussSigma;
    cf = fiducialSurface->getCoordinateFile();
+   GeodesicHelperBase geodesicBase(cf, topologyFile);//surface graph shared by all threads
    QTime timer;
    timer.start();
 #ifdef _OPENMP
@@ -388,7 +389,7 @@ BrainModelSurfaceROIMetricSmoothing::determineNeighbors()
 #endif
    {
       TopologyHelper topologyHelper(topologyFile, false, true, false);
-      GeodesicHelper gh(cf, topologyFile);//need private copies of this due to mutex locking
+      GeodesicHelper gh(&geodesicBase);//need private scratch arrays due to mutex locking
       std::vector<float> distance;
 
       //
@@ -35,12 +35,11 @@
 #include "BrainModelBorderSet.h"
 #include "BrainModelSurface.h"
 #include "BrainModelSurfaceConnectedSearchMetric.h"
-#include "BrainModelSurfaceGeodesic.h"
 #include "BrainModelSurfaceROINodeSelection.h"
 #include "BrainSet.h"
 #include "BrainSetNodeAttribute.h"
 #include "DebugControl.h"
-#include "GeodesicDistanceFile.h"
+#include "GeodesicHelper.h"
 #include "LatLonFile.h"
 #include "MathUtilities.h"
 #include "MetricFile.h"
@@ -332,51 +331,47 @@ BrainModelSurfaceROINodeSelection::selectNodesWithinGeodesicDistance(
        (nodeNumber >= numNodes)) {
       return "Invalid node number for selecting nodes with geodesic.";
    }
-   
-   GeodesicDistanceFile geodesicDistanceFile;
-   BrainModelSurfaceGeodesic geodesic(brainSet,
-                                      (BrainModelSurface*)selectionSurface,
-                                      NULL,
-                                      -1,
-                                      "",
-                                      &geodesicDistanceFile,
-                                      -1,
-                                      "GeoDist",
-                                      nodeNumber,
-                                      NULL);
-   try {
-      geodesic.execute();
+   if (selectionSurface->getTopologyFile() == NULL) {
+      return "ERROR: Selection Surface has no topology.";
    }
-   catch (BrainModelAlgorithmException&) {
+   
+   //
+   // Only the nodes within the distance are visited (edge distances, as 
+   // computed by BrainModelSurfaceGeodesic)
+   //
+   GeodesicHelper geodesicHelper(selectionSurface->getCoordinateFile(),
+                                 selectionSurface->getTopologyFile());
+   if (geodesicHelper.getNumberOfNodes() != numNodes) {
       return ("Selecting nodes with geodesic failed for node number "
               + QString::number(nodeNumber));
    }
-        
-   if ((geodesicDistanceFile.getNumberOfNodes() == numNodes) &&
-       (geodesicDistanceFile.getNumberOfColumns() >= 1)) {
-      std::vector<int> newNodeSelections(numNodes, 0);
-      
-      for (int i = 0; i < numNodes; i++) {
-         if (geodesicDistanceFile.getNodeParentDistance(i, 0)
-             < geodesicDistance) {
-            newNodeSelections[i] = 1;
-         }
+   std::vector<int> nodes;
+   std::vector<float> distances;
+   geodesicHelper.getNodesToGeoDist(nodeNumber,
+                                    geodesicDistance,
+                                    nodes,
+                                    distances,
+                                    false);
+   
+   std::vector<int> newNodeSelections(numNodes, 0);
+   const int numNodesFound = static_cast<int>(nodes.size());
+   for (int i = 0; i < numNodesFound; i++) {
+      if (distances[i] < geodesicDistance) {
+         newNodeSelections[nodes[i]] = 1;
       }
-      newNodeSelections[nodeNumber] = 1;
-      
-      const QString& description = 
-         ("Nodes within  "
-          + QString::number(geodesicDistance, 'f', 3)
-          + " geodesic distance of node number "
-          + QString::number(nodeNumber));
-         
-      return processNewNodeSelections(selectionLogic,
-                                      selectionSurface,
-                                      newNodeSelections,
-                                      description);
    }
-   return ("Selecting nodes with geodesic failed for node number "
-           + QString::number(nodeNumber));
+   newNodeSelections[nodeNumber] = 1;
+   
+   const QString& description = 
+      ("Nodes within  "
+       + QString::number(geodesicDistance, 'f', 3)
+       + " geodesic distance of node number "
+       + QString::number(nodeNumber));
+      
+   return processNewNodeSelections(selectionLogic,
+                                   selectionSurface,
+                                   newNodeSelections,
+                                   description);
 }                                                
       
 /**
@@ -803,6 +798,51 @@ BrainModelSurfaceROINodeSelection::dilate(const BrainModelSurface* selectionSurf
                               + " iterations"));
 }
 
+/**
+ * dilate the selected nodes by a geodesic distance (adds all nodes within the
+ * distance of any selected node).  Distances from all selected nodes are 
+ * computed together so each node is visited once.
+ */
+void 
+BrainModelSurfaceROINodeSelection::dilateByGeodesicDistance(const BrainModelSurface* selectionSurface,
+                                                            const float geodesicDistance)
+{
+   update();
+   const int numNodes = static_cast<int>(nodeSelectedFlags.size());
+   
+   std::vector<int> selectedNodes;
+   for (int i = 0; i < numNodes; i++) {
+      if (nodeSelectedFlags[i]) {
+         selectedNodes.push_back(i);
+      }
+   }
+   if (selectedNodes.empty() ||
+       (selectionSurface->getTopologyFile() == NULL)) {
+      return;
+   }
+   
+   GeodesicHelper geodesicHelper(selectionSurface->getCoordinateFile(),
+                                 selectionSurface->getTopologyFile());
+   if (geodesicHelper.getNumberOfNodes() != numNodes) {
+      return;
+   }
+   std::vector<int> nodes;
+   std::vector<float> distances;
+   geodesicHelper.getNodesToGeoDist(selectedNodes,
+                                    geodesicDistance,
+                                    nodes,
+                                    distances,
+                                    true);
+   for (unsigned int i = 0; i < nodes.size(); i++) {
+      nodeSelectedFlags[nodes[i]] = 1;
+   }
+   
+   addToSelectionDescription("",
+                             ("Dilated "
+                              + QString::number(geodesicDistance, 'f', 3)
+                              + " geodesic distance"));
+}
+
 /**
  * dilate around the node (adds node's neighbors to ROI).
  */
@@ -2484,9 +2524,9 @@ BrainModelSurfaceROINodeSelection::findIslands(const BrainModelSurface* selectio
                visited[nodeNumber] = 1;
                nodeRootNeighbor[nodeNumber] = origNeighbor;
                numConnectedNeighbors[origNeighbor]++;
-               std::vector<int> neighbors;
-               topologyHelper->getNodeNeighbors(nodeNumber, neighbors);
-               for (int i = 0; i < static_cast<int>(neighbors.size()); i++) {
+               int numNeighbors = 0;
+               const int* neighbors = topologyHelper->getNodeNeighbors(nodeNumber, numNeighbors);
+               for (int i = 0; i < numNeighbors; i++) {
                   const int node = neighbors[i];
                   if (visited[node] == 0) {
                      st.push(node);
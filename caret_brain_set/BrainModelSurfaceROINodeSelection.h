@@ -173,6 +173,10 @@ class BrainModelSurfaceROINodeSelection {
       void dilate(const BrainModelSurface* selectionSurface,
                   int numberOfIterations);
       
+      // dilate the selected nodes by a geodesic distance
+      void dilateByGeodesicDistance(const BrainModelSurface* selectionSurface,
+                                    const float geodesicDistance);
+      
       // dilate around the node (adds node's neighbors to ROI)
       void dilateAroundNode(const BrainModelSurface* selectionSurface,
                             const int nodeNumber);
@@ -23,7 +23,9 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include <QDateTime>
 #include <QWaitCondition>
@@ -35,17 +37,17 @@
 #undef __BRAIN_MODEL_SURFACE_SMOOTHING_MAIN_H__
 
 #include "BrainModelSurface.h"
+#include "BrainModelSurfaceCurvature.h"
 #include "BrainSet.h"
 #include "BrainSetNodeAttribute.h"
+#include "CaretThreadPool.h"
 #include "DebugControl.h"
 #include "MathUtilities.h"
 #include "StringUtilities.h"
+#include "SurfaceShapeFile.h"
 #include "TopologyFile.h"
 #include "TopologyHelper.h"
 
-static const int SLEEP_TIME = 1;
-static const int SLEEP_TIME_MICROSECONDS = 250;
-
 /**
  * Constructor for the main controller of smoothing.
  */
@@ -210,6 +212,8 @@ BrainModelSurfaceSmoothing::BrainModelSurfaceSmoothing(BrainSet* bs,
                                        const SMOOTHING_TYPE smoothingTypeIn,
                                        const float strengthIn,
                                        const float landmarkScaleIn,
+                                       const float sphereRadiusIn,
+                                       const float curvatureMaximumIn,
                                        NodeInfo* nodeInfoIn,
                                        TopologyHelper* topologyHelperIn,
                                        const int startNodeIndexIn,
@@ -228,6 +232,8 @@ BrainModelSurfaceSmoothing::BrainModelSurfaceSmoothing(BrainSet* bs,
    startNodeIndex       = startNodeIndexIn;
    endNodeIndex         = endNodeIndexIn;
    landmarkScale        = landmarkScaleIn;
+   sphereRadius         = sphereRadiusIn;
+   curvatureMaximum     = curvatureMaximumIn;
 }
 
 /**
@@ -267,6 +273,11 @@ BrainModelSurfaceSmoothing::initialize()
    topologyHelper   = NULL;
    nodeInfo         = NULL;
    landmarkScale    = 1.0;
+   sphereRadius     = 1.0;
+   projectToSphereThisIteration = false;
+   curvatureMaximum = std::numeric_limits<float>::max();
+   nodeCurvature    = NULL;
+   nodeNormals      = NULL;
 }
 
 /**
@@ -298,43 +309,20 @@ BrainModelSurfaceSmoothing::execute() throw (BrainModelAlgorithmException)
    
    inverseStrength = 1.0 - strength;
    
-   if (numberOfNodes <= 0) {
-      throw BrainModelAlgorithmException("Surface has no nodes");
-   }
-   
    //
    // Timer to time entire operation
    //
    QTime timer;
    timer.start();
    
-/*
-   switch(smoothingType) {
-      case SMOOTHING_TYPE_AREAL:
-         surface->appendToCoordinateFileComment("Areal ");
-         break;
-      case SMOOTHING_TYPE_LINEAR:
-         surface->appendToCoordinateFileComment("Linear ");
-         break;
-   }
-   surface->appendToCoordinateFileComment(" Smoothing: ");
-   surface->appendToCoordinateFileComment(StringUtilities::fromNumber(strength));
-   surface->appendToCoordinateFileComment(" ");
-   surface->appendToCoordinateFileComment(StringUtilities::fromNumber(iterations));
-   surface->appendToCoordinateFileComment(" ");
-   surface->appendToCoordinateFileComment(StringUtilities::fromNumber(edgeIterations));
-   surface->appendToCoordinateFileComment("\n");
-*/
-   
    //
    // Get radius in event it is a sphere
    //
-   const float sphereRadius = surface->getSphericalSurfaceRadius();
+   sphereRadius = surface->getSphericalSurfaceRadius();
    
    //
    // Topology helper for node neighbors
    //
-   //topologyHelper = new TopologyHelper(topology, false, true, true);
    topologyHelper = (TopologyHelper*)topology->getTopologyHelper(false, true, true);
    if (DebugControl::getDebugOn()) {
       std::cout << "Topology Helper time: " << (static_cast<float>(timer.elapsed()) / 1000.0) << std::endl;
@@ -352,12 +340,11 @@ BrainModelSurfaceSmoothing::execute() throw (BrainModelAlgorithmException)
    //
    // Get the coordinates and load them into arrays
    //
-   float* coordsArray1 = new float[numberOfNodes * 3];
-   float* coordsArray2 = new float[numberOfNodes * 3];
+   coordsArray1 = new float[numberOfNodes * 3];
+   coordsArray2 = new float[numberOfNodes * 3];
    CoordinateFile* coordFile = surface->getCoordinateFile();
-   for (int i = 0; i < numberOfNodes; i++) {
-      coordFile->getCoordinate(i, &coordsArray1[i*3]);
-   }
+   const float* surfaceCoords = coordFile->getCoordinate(0);
+   std::copy(surfaceCoords, surfaceCoords + numberOfNodes * 3, coordsArray1);
    
    //
    // Set the input and output coord pointers
@@ -367,23 +354,46 @@ BrainModelSurfaceSmoothing::execute() throw (BrainModelAlgorithmException)
    
    int smoothNeighborCounter = 1;
    
+   //
+   // A number of threads less than one uses all threads in the pool
+   //
+   int numberOfThreads = getNumberOfThreadsToRun();
+   if (numberOfThreads <= 0) {
+      numberOfThreads = CaretThreadPool::getGlobalThreadPool()->getNumberOfThreads();
+   }
+   numberOfThreads = std::min(numberOfThreads, numberOfNodes);
+   
    //
    // See if threads are being used, and if so, create them.
    //
-   const int numberOfThreads = getNumberOfThreadsToRun();
    if (numberOfThreads > 1) {
       //
-      // Number of nodes each thread should smooth
+      // The work for a node is proportional to its number of neighbors
+      // so give each thread a range of nodes with about the same
+      // number of neighbors.
       //
-      const int numNodesPerThread = numberOfNodes / numberOfThreads;
+      long totalWork = 0;
+      for (int i = 0; i < numberOfNodes; i++) {
+         int numNeighbors = 0;
+         topologyHelper->getNodeNeighbors(i, numNeighbors);
+         totalWork += numNeighbors + 1;
+      }
+      
       int startNode = 0;
-      int endNode   = numNodesPerThread;
+      long workSum = 0;
       for (int i = 0; i < numberOfThreads; i++) {
-         //
-         // Limit ending node for last thread
-         //
-         if (i == (numberOfThreads - 1)) {
-            endNode = numberOfNodes - 1;
+         const bool lastThreadFlag = (i == (numberOfThreads - 1));
+         const long workLimit = (totalWork * (i + 1)) / numberOfThreads;
+         int endNode = startNode - 1;
+         while ((endNode < (numberOfNodes - 1)) &&
+                ((workSum < workLimit) || lastThreadFlag)) {
+            endNode++;
+            int numNeighbors = 0;
+            topologyHelper->getNodeNeighbors(endNode, numNeighbors);
+            workSum += numNeighbors + 1;
+         }
+         if (endNode < startNode) {
+            continue;
          }
          if (DebugControl::getDebugOn()) {
             std::cout << "Smoothing thread " << i << " nodes " 
@@ -398,27 +408,34 @@ BrainModelSurfaceSmoothing::execute() throw (BrainModelAlgorithmException)
                                                             smoothingType,
                                                             strength,
                                                             landmarkScale,
+                                                            sphereRadius,
+                                                            curvatureMaximum,
                                                             nodeInfo,
                                                             topologyHelper,
                                                             startNode,
                                                             endNode,
                                                             this,
-                                                            i);
+                                                            static_cast<int>(threads.size()));
          threads.push_back(bmss);  
          
-         //
-         // Determine node indices which each thread should smooth
-         //
          startNode = endNode + 1;
-         endNode   += numNodesPerThread;
       }
    }
+   const std::vector<BrainModelAlgorithmMultiThreaded*> poolThreads(threads.begin(),
+                                                                   threads.end());
+   
+   //
+   // Curvature smoothing needs the curvature of the surface each iteration
+   //
+   SurfaceShapeFile curvatureShapeFile;
+   if (smoothingType == SMOOTHING_TYPE_CURVATURE) {
+      curvatureShapeFile.setNumberOfNodesAndColumns(numberOfNodes, 1);
+   }
    
    //
    // Smooth the specified number of iterations
    //
    for (int i = 1; i <= iterations; i++) {
-      const bool firstIterationFlag = (i == 1);
       const bool lastIterationFlag  = (i == iterations);
       //
       // See if edges should be smoothed this iteration
@@ -442,73 +459,56 @@ BrainModelSurfaceSmoothing::execute() throw (BrainModelAlgorithmException)
          smoothNeighborCounter++;
       }
       
+      //
+      // See if the surface should be projected to a sphere
+      //
+      projectToSphereThisIteration = false;
+      if (projectToSphereEveryXIterations > 0) {
+         if ((i % projectToSphereEveryXIterations) == 0) {
+            projectToSphereThisIteration = true;
+         }
+      }
+      
+      //
+      // Update the curvature and normals of the surface (input coordinates)
+      //
+      if (smoothingType == SMOOTHING_TYPE_CURVATURE) {
+         coordFile->setAllCoordinates(inputCoords);
+         BrainModelSurfaceCurvature bmsc(brainSet,
+                                surface,
+                                &curvatureShapeFile,
+                                0,
+                                BrainModelSurfaceCurvature::CURVATURE_COLUMN_DO_NOT_GENERATE,
+                                "meanCurv",
+                                "");
+         try {
+            bmsc.execute();
+         }
+         catch (BrainModelAlgorithmException&) {
+         }
+         setCurvatureAndNormals(curvatureShapeFile.getColumnForAllNodesSpan(0),
+                                surface->getNormal(0));
+      }
+      
       //
       // If running threads
       //
-      if (numberOfThreads > 1) {
-         for (int j = 0; j < numberOfThreads; j++) {
+      if (threads.empty() == false) {
+         for (unsigned int j = 0; j < threads.size(); j++) {
             //
-            // Run each thread for an iteration of smoothing
+            // Set up each thread instance for an iteration of smoothing
             //
             threads[j]->setInputAndOutputCoords(inputCoords, outputCoords);
             threads[j]->setSmoothEdgesThisIteration(smoothEdgesThisIteration);
             threads[j]->setSmoothLandmarkNeighborsThisIteration(smoothLandmarkNeighborsThisIteration);
-            //
-            // Clear the number of child threads done
-            //
-            resetNumChildThreadDone();
-            
-            //
-            // Start the threads if this is the first iteration
-            //
-            if (firstIterationFlag) {
-               threads[j]->setThreadKeepLoopingFlag(true);
-               threads[j]->setThreadedIterationDoneFlag(true);
-               threads[j]->start(QThread::TimeCriticalPriority);
-            }
-/*            
-            //
-            // if the last iteration clear the keep looping flag
-            //
-            if (lastIterationFlag ) {
-               threads[j]->setThreadKeepLoopingFlag(false);
-            }
-*/
+            threads[j]->setProjectToSphereThisIteration(projectToSphereThisIteration);
+            threads[j]->setCurvatureAndNormals(nodeCurvature, nodeNormals);
          }
          
          //
-         // Wait until all threads have started and in their loop.
-         // This is need for the case that there is only one iteration.
+         // Run the iteration of each thread instance in the thread pool
          //
-         while (getNumChildThreadStarted() < numberOfThreads) {
-            //msleep(SLEEP_TIME);
-            usleep(SLEEP_TIME_MICROSECONDS);
-         }
-         
-         for (int j = 0; j < numberOfThreads; j++) {
-            //
-            // if the last iteration, clear the keep looping flag for the thread
-            //
-            if (lastIterationFlag ) {
-               threads[j]->setThreadKeepLoopingFlag(false);
-            }
-            
-            //
-            // wake the thread so that it executes an iteration
-            //
-            if (DebugControl::getDebugOn()) {
-               std::cout << "Allowing smoothing thread " << j << " to run." << std::endl;
-            }
-            threads[j]->setThreadedIterationDoneFlag(false);
-         }
-         
-         //
-         // Wait until all of the threads finish
-         //
-         while (getNumChildThreadDone() < numberOfThreads) {
-            //msleep(SLEEP_TIME);
-            usleep(SLEEP_TIME_MICROSECONDS);
-         }
+         runIterationOfChildrenInThreadPool(poolThreads, i);
          if (DebugControl::getDebugOn()) {
             std::cout << "All smoothing threads completed iteration." << std::endl;
          }
@@ -519,18 +519,7 @@ BrainModelSurfaceSmoothing::execute() throw (BrainModelAlgorithmException)
          // Smooth for one iteration
          //
          setIndicesOfNodesToSmooth(0, numberOfNodes - 1);
-         run();
-      }
-      
-      //
-      // If the surface should be projected to a sphere
-      //
-      if (projectToSphereEveryXIterations > 0) {
-         if ((i % projectToSphereEveryXIterations) == 0) {
-            for (int j = 0; j < numberOfNodes; j++) {
-               MathUtilities::setVectorLength(&outputCoords[j*3], sphereRadius);
-            }
-         }
+         runIteration(i);
       }
       
       //
@@ -541,9 +530,7 @@ BrainModelSurfaceSmoothing::execute() throw (BrainModelAlgorithmException)
          // Update the displayed brain model
          //
          if (brainSet->isIterationUpdate(i)) {
-            for (int j = 0; j < numberOfNodes; j++) {
-               coordFile->setCoordinate(j, &outputCoords[j*3]);
-            }
+            coordFile->setAllCoordinates(outputCoords);
             brainSet->drawBrainModel(surface, i);
          }
          
@@ -552,14 +539,19 @@ BrainModelSurfaceSmoothing::execute() throw (BrainModelAlgorithmException)
          //
          std::swap(inputCoords, outputCoords);
       }
+      else if (smoothingType == SMOOTHING_TYPE_CURVATURE) {
+         //
+         // Curvature smoothing also updates the display after the last iteration
+         //
+         coordFile->setAllCoordinates(outputCoords);
+         brainSet->drawBrainModel(surface, i);
+      }
    }
    
    //
    // copy the smoothed coordinates back to the surface
    //
-   for (int i = 0; i < numberOfNodes; i++) {
-      coordFile->setCoordinate(i, &outputCoords[i*3]);
-   }
+   coordFile->setAllCoordinates(outputCoords);
    
    if (DebugControl::getDebugOn()) {
       std::cout << "Total smoothing time: " << (static_cast<float>(timer.elapsed()) / 1000.0) << std::endl;
@@ -567,325 +559,312 @@ BrainModelSurfaceSmoothing::execute() throw (BrainModelAlgorithmException)
 }
 
 /**
- * smooths for an iteration (required by QThread).
+ * smooths for an iteration (the iteration number is not used).
  */
 void 
-BrainModelSurfaceSmoothing::run()
+BrainModelSurfaceSmoothing::runIteration(const int /*iteration*/)
 {
    const int maxNeighbors = topologyHelper->getMaximumNumberOfNeighbors();
    if (maxNeighbors <= 0) {
       return;
    }
    
-   float* tileAreas = new float[maxNeighbors];
-   float* tileCenters = new float[maxNeighbors * 3];
-   
    //
-   // set looping flag for non-threaded execution so that we do an iteration
+   // Scratch space is kept between iterations
    //
-   if (getImAThread() == false) {
-      setThreadKeepLoopingFlag(true);
+   if (static_cast<int>(tileAreas.size()) < maxNeighbors) {
+      tileAreas.resize(maxNeighbors);
+      tileCenters.resize(maxNeighbors * 3);
    }
    
+   bool arealSmoothIt = false;
+   bool linearSmoothIt = false;
+   switch (smoothingType) {
+      case SMOOTHING_TYPE_LANDMARK_NEIGHBOR_CONSTRAINED:
+         linearSmoothIt = true;
+         break;
+      case SMOOTHING_TYPE_LANDMARK_CONSTRAINED:
+         linearSmoothIt = true;
+         break;
+      case SMOOTHING_TYPE_AREAL:
+         arealSmoothIt = true;
+         break;
+      case SMOOTHING_TYPE_LINEAR:
+         linearSmoothIt = true;
+         break;
+      case SMOOTHING_TYPE_CURVATURE:
+         break;
+   }
    
-   //
-   // The threaded execution will stay in the loop since run only gets called once
-   //
-   while (getThreadKeepLoopingFlag()) {
-   
+   for (int i = startNodeIndex; i <= endNodeIndex; i++) {
+      const int ix = i * 3;
+      const int iy = ix + 1;
+      const int iz = iy + 1;
+      
+      outputCoords[ix] = inputCoords[ix];
+      outputCoords[iy] = inputCoords[iy];
+      outputCoords[iz] = inputCoords[iz];
+      
       //
-      // Is this a threaded instance
+      // Curvature smoothing moves nodes along their normal by their curvature
       //
-      if (getImAThread()) {
-         //
-         // let parent know that this thread has started
-         //
-         getParentOfThisThread()->incrementNumChildThreadStarted();
-         
-         //
-         // Wait until parent says it is okay to go
-         //
-         while (getThreadedIterationDoneFlag()) {
-            //msleep(SLEEP_TIME);
-            usleep(SLEEP_TIME_MICROSECONDS);
-         }
-         if (DebugControl::getDebugOn()) {
-            std::cout << "Smoothing Thread " << getThreadNumber() << " now executing." << std::endl;
+      if (smoothingType == SMOOTHING_TYPE_CURVATURE) {
+         if (nodeInfo[i].nodeType != NodeInfo::NODE_TYPE_DO_NOT_SMOOTH) {
+            if (topologyHelper->getNodeHasNeighbors(i)) {
+               float curv = nodeCurvature[i];
+               curv = std::max(curv, -curvatureMaximum);
+               curv = std::min(curv,  curvatureMaximum);
+               const float* norm = &nodeNormals[ix];
+               outputCoords[ix] += norm[0] * curv * strength;
+               outputCoords[iy] += norm[1] * curv * strength;
+               outputCoords[iz] += norm[2] * curv * strength;
+            }
          }
+         continue;
       }
       
-      for (int i = startNodeIndex; i <= endNodeIndex; i++) {
-         const int ix = i * 3;
-         const int iy = ix + 1;
-         const int iz = iy + 1;
-         
-         outputCoords[ix] = inputCoords[ix];
-         outputCoords[iy] = inputCoords[iy];
-         outputCoords[iz] = inputCoords[iz];
-         
-         //
-         // Determine if this node should be smoothed
-         //
-         bool smoothIt = true;
-         if (nodeInfo[i].edgeNodeFlag) {
-            smoothIt = smoothEdgesThisIteration;
-         }
-         
-         //
-         // Special cases of smoothing
-         //
-         switch (nodeInfo[i].nodeType) {
-            case NodeInfo::NODE_TYPE_DO_NOT_SMOOTH:
-               smoothIt = false;
-               break;
-            case NodeInfo::NODE_TYPE_NORMAL:
-               break;
-            case NodeInfo::NODE_TYPE_LANDMARK:
+      //
+      // Determine if this node should be smoothed
+      //
+      bool smoothIt = true;
+      if (nodeInfo[i].edgeNodeFlag) {
+         smoothIt = smoothEdgesThisIteration;
+      }
+      
+      //
+      // Special cases of smoothing
+      //
+      switch (nodeInfo[i].nodeType) {
+         case NodeInfo::NODE_TYPE_DO_NOT_SMOOTH:
+            smoothIt = false;
+            break;
+         case NodeInfo::NODE_TYPE_NORMAL:
+            break;
+         case NodeInfo::NODE_TYPE_LANDMARK:
+            smoothIt = false;
+            break;
+         case NodeInfo::NODE_TYPE_LANDMARK_NEIGHBOR:
+            if (smoothingType == SMOOTHING_TYPE_LANDMARK_NEIGHBOR_CONSTRAINED) {
+               smoothIt = smoothLandmarkNeighborsThisIteration;
+            }
+            if (smoothingType == SMOOTHING_TYPE_LANDMARK_CONSTRAINED) {
                smoothIt = false;
-               break;
-            case NodeInfo::NODE_TYPE_LANDMARK_NEIGHBOR:
-               if (smoothingType == SMOOTHING_TYPE_LANDMARK_NEIGHBOR_CONSTRAINED) {
-                  smoothIt = smoothLandmarkNeighborsThisIteration;
-               }
-               if (smoothingType == SMOOTHING_TYPE_LANDMARK_CONSTRAINED) {
-                  smoothIt = false;
-                  
+               
+               //
+               // Get the neighbors for this node
+               //
+               int numNeighbors = 0;
+               const int* neighbors = topologyHelper->getNodeNeighbors(i, numNeighbors);
+               
+               if (numNeighbors > 2) {
                   //
-                  // Get the neighbors for this node
+                  // Determine average of neighbor coordinates
                   //
-                  int numNeighbors = 0;
-                  const int* neighbors = topologyHelper->getNodeNeighbors(i, numNeighbors);
+                  float neighAvg[3] = { 0.0, 0.0, 0.0 };
+                  for (int j = 0; j < numNeighbors; j++) {
+                     const int n = neighbors[j];
+                     neighAvg[0] += inputCoords[n*3];
+                     neighAvg[1] += inputCoords[n*3+1];
+                     neighAvg[2] += inputCoords[n*3+2];
+                  }
+                  const float floatNumNeigh = numNeighbors;
+                  neighAvg[0] /= floatNumNeigh;
+                  neighAvg[1] /= floatNumNeigh;
+                  neighAvg[2] /= floatNumNeigh;
                   
-                  if (numNeighbors > 2) {
-                     //
-                     // Determine average of neighbor coordinates
-                     //
-                     float neighAvg[3] = { 0.0, 0.0, 0.0 };
-                     for (int j = 0; j < numNeighbors; j++) {
-                        const int n = neighbors[j];
-                        neighAvg[0] += inputCoords[n*3];
-                        neighAvg[1] += inputCoords[n*3+1];
-                        neighAvg[2] += inputCoords[n*3+2];
-                     }
-                     const float floatNumNeigh = numNeighbors;
-                     neighAvg[0] /= floatNumNeigh;
-                     neighAvg[1] /= floatNumNeigh;
-                     neighAvg[2] /= floatNumNeigh;
-                     
+                  //
+                  // Check each neighbor
+                  //
+                  for (int k = 0; k < numNeighbors; k++) {
                      //
-                     // Check each neighbor
+                     // Is the neighbor a landmark
                      //
-                     for (int k = 0; k < numNeighbors; k++) {
+                     const int neigh = neighbors[k];
+                     if (nodeInfo[neigh].nodeType == NodeInfo::NODE_TYPE_LANDMARK) {
                         //
-                        // Is the neighbor a landmark
+                        // Get next and previous neighbors
                         //
-                        const int neigh = neighbors[k];
-                        if (nodeInfo[neigh].nodeType == NodeInfo::NODE_TYPE_LANDMARK) {
-                           //
-                           // Get next and previous neighbors
-                           //
-                           int prevNeighIndex = k - 1;
-                           if (prevNeighIndex < 0) {
-                              prevNeighIndex = numNeighbors - 1;
-                           }
-                           const int neighA = neighbors[prevNeighIndex];
-                           int nextNeighIndex = k + 1;
-                           if (nextNeighIndex >= numNeighbors) {
-                              nextNeighIndex = 0;
-                           }
-                           const int neighB = neighbors[nextNeighIndex];
-                           
-                           //
-                           // Get coordinates of the neighbors
-                           //
-                           const float* ai = &inputCoords[neighA * 3];
-                           const float* bi = &inputCoords[neighB * 3];
-                           const float* li = &inputCoords[neigh * 3];
-                           
-                           //
-                           // Adjust position of neighbor average
-                           //
-                           float p[3] = {
-                              2 * li[0] - ai[0] - bi[0],
-                              2 * li[1] - ai[1] - bi[1],
-                              2 * li[2] - ai[2] - bi[2]
-                           };
-                           const float len = std::sqrt(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
-                           p[0] /= len;
-                           p[1] /= len;
-                           p[2] /= len;
-                           
-                           neighAvg[0] += li[0] + landmarkScale * p[0];
-                           neighAvg[1] += li[1] + landmarkScale * p[1];
-                           neighAvg[2] += li[2] + landmarkScale * p[2];
-
-                           //std::cout << "Node "
-                           //          << i
-                           //          << ": p["
-                           //          << p[0]
-                           //          << ","
-                           //          << p[1]
-                           //          << ","
-                           //          << p[2]
-                           //          << "]"
-                           //          << std::endl;
+                        int prevNeighIndex = k - 1;
+                        if (prevNeighIndex < 0) {
+                           prevNeighIndex = numNeighbors - 1;
                         }
+                        const int neighA = neighbors[prevNeighIndex];
+                        int nextNeighIndex = k + 1;
+                        if (nextNeighIndex >= numNeighbors) {
+                           nextNeighIndex = 0;
+                        }
+                        const int neighB = neighbors[nextNeighIndex];
+                        
+                        //
+                        // Get coordinates of the neighbors
+                        //
+                        const float* ai = &inputCoords[neighA * 3];
+                        const float* bi = &inputCoords[neighB * 3];
+                        const float* li = &inputCoords[neigh * 3];
+                        
+                        //
+                        // Adjust position of neighbor average
+                        //
+                        float p[3] = {
+                           2 * li[0] - ai[0] - bi[0],
+                           2 * li[1] - ai[1] - bi[1],
+                           2 * li[2] - ai[2] - bi[2]
+                        };
+                        const float len = std::sqrt(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+                        p[0] /= len;
+                        p[1] /= len;
+                        p[2] /= len;
+                        
+                        neighAvg[0] += li[0] + landmarkScale * p[0];
+                        neighAvg[1] += li[1] + landmarkScale * p[1];
+                        neighAvg[2] += li[2] + landmarkScale * p[2];
                      }
-                     
-                     const float neighPlusOne = nodeInfo[i].numLandmarkNeighbors + 1;
-                     neighAvg[0] /= neighPlusOne;
-                     neighAvg[1] /= neighPlusOne;
-                     neighAvg[2] /= neighPlusOne;
-                     
-                     outputCoords[ix] = inverseStrength * inputCoords[ix]
-                                       + strength * neighAvg[0];
-                     outputCoords[iy] = inverseStrength * inputCoords[iy]
-                                       + strength * neighAvg[1];
-                     outputCoords[iz] = inverseStrength * inputCoords[iz]
-                                         + strength * neighAvg[2];
                   }
+                  
+                  const float neighPlusOne = nodeInfo[i].numLandmarkNeighbors + 1;
+                  neighAvg[0] /= neighPlusOne;
+                  neighAvg[1] /= neighPlusOne;
+                  neighAvg[2] /= neighPlusOne;
+                  
+                  outputCoords[ix] = inverseStrength * inputCoords[ix]
+                                    + strength * neighAvg[0];
+                  outputCoords[iy] = inverseStrength * inputCoords[iy]
+                                    + strength * neighAvg[1];
+                  outputCoords[iz] = inverseStrength * inputCoords[iz]
+                                      + strength * neighAvg[2];
                }
-               break;
-         }
-         
-         if (smoothIt) {
-            //
-            // Get the neighbors for this node
-            //
-            int numNeighbors = 0;
-            const int* neighbors = topologyHelper->getNodeNeighbors(i, numNeighbors);
-            
-            bool arealSmoothIt = false;
-            bool linearSmoothIt = false;
-            switch (smoothingType) {
-               case SMOOTHING_TYPE_LANDMARK_NEIGHBOR_CONSTRAINED:
-                  linearSmoothIt = true;
-                  break;
-               case SMOOTHING_TYPE_LANDMARK_CONSTRAINED:
-                  linearSmoothIt = true;
-                  break;
-               case SMOOTHING_TYPE_AREAL:
-                  arealSmoothIt = true;
-                  break;
-               case SMOOTHING_TYPE_LINEAR:
-                  linearSmoothIt = true;
-                  break;
             }
-            
-            if (arealSmoothIt) {
-               if (numNeighbors > 1) {
-                  float totalArea = 0.0;
-                  for (int j = 0; j < numNeighbors; j++) {                  
-                     //
-                     // get 2 consecutive neighbors of this node
-                     //
-                     const int n1 = neighbors[j];
-                     int next = j + 1;
-                     if (next >= numNeighbors) {
-                        next = 0;
-                     }
-                     const int n2 = neighbors[next];
-                  
-                     //
-                     // Area of the triangle
-                     //
-                     const float area = MathUtilities::triangleArea(&inputCoords[ix], 
-                                                                  &inputCoords[n1*3],
-                                                                  &inputCoords[n2*3]);
-                     tileAreas[j] = area;
-                     totalArea += area;
-                     
-                     //
-                     // Save center of this tile
-                     //
-                     for (int k = 0; k < 3; k++) {
-                        float p = (inputCoords[ix+k] + inputCoords[n1*3+k] + inputCoords[n2*3+k]) / 3.0;
-                        tileCenters[j*3+k] = p;
-                     }
+            break;
+      }
+      
+      if (smoothIt) {
+         //
+         // Get the neighbors for this node
+         //
+         int numNeighbors = 0;
+         const int* neighbors = topologyHelper->getNodeNeighbors(i, numNeighbors);
+         
+         if (arealSmoothIt) {
+            if (numNeighbors > 1) {
+               float totalArea = 0.0;
+               for (int j = 0; j < numNeighbors; j++) {                  
+                  //
+                  // get 2 consecutive neighbors of this node
+                  //
+                  const int n1 = neighbors[j];
+                  int next = j + 1;
+                  if (next >= numNeighbors) {
+                     next = 0;
                   }
-                    
+                  const int n2 = neighbors[next];
+               
                   //
-                  // Total area is zero when this node and all of its neighbors
-                  // have the exact same XYZ coordinate
+                  // Area of the triangle
                   //
-                  if (totalArea > 0.0) {
-                     //
-                     // Compute the influence of the neighboring nodes
-                     //
-                     float xa = 0.0;
-                     float ya = 0.0;
-                     float za = 0.0;
-                     
-                     for (int j = 0; j < numNeighbors; j++) {
-                        if (tileAreas[j] > 0.0) {
-                           const float weight = tileAreas[j] / totalArea;
-                           xa += weight * tileCenters[j*3];
-                           ya += weight * tileCenters[j*3+1];
-                           za += weight * tileCenters[j*3+2];
-                        }
-                     }
-      
-                     //
-                     // Update the nodes position
-                     //
-                     outputCoords[ix] = inputCoords[ix] * inverseStrength 
-                                    + xa * strength;
-                     outputCoords[iy] = inputCoords[iy] * inverseStrength 
-                                    + ya * strength;
-                     outputCoords[iz] = inputCoords[iz] * inverseStrength 
-                                    + za * strength;
+                  const float area = MathUtilities::triangleArea(&inputCoords[ix], 
+                                                               &inputCoords[n1*3],
+                                                               &inputCoords[n2*3]);
+                  tileAreas[j] = area;
+                  totalArea += area;
+                  
+                  //
+                  // Save center of this tile
+                  //
+                  for (int k = 0; k < 3; k++) {
+                     float p = (inputCoords[ix+k] + inputCoords[n1*3+k] + inputCoords[n2*3+k]) / 3.0;
+                     tileCenters[j*3+k] = p;
                   }
                }
-            }
-            
-            if (linearSmoothIt) {
-               if (numNeighbors > 1) {
-                  float neighXYZ[3] = { 0.0, 0.0, 0.0 };
+                 
+               //
+               // Total area is zero when this node and all of its neighbors
+               // have the exact same XYZ coordinate
+               //
+               if (totalArea > 0.0) {
+                  //
+                  // Compute the influence of the neighboring nodes
+                  //
+                  float xa = 0.0;
+                  float ya = 0.0;
+                  float za = 0.0;
+                  
                   for (int j = 0; j < numNeighbors; j++) {
-                     const int n = neighbors[j];
-                     neighXYZ[0] += inputCoords[n*3];
-                     neighXYZ[1] += inputCoords[n*3+1];
-                     neighXYZ[2] += inputCoords[n*3+2];
+                     if (tileAreas[j] > 0.0) {
+                        const float weight = tileAreas[j] / totalArea;
+                        xa += weight * tileCenters[j*3];
+                        ya += weight * tileCenters[j*3+1];
+                        za += weight * tileCenters[j*3+2];
+                     }
                   }
-                  
-                  const float floatNumNeigh = numNeighbors;
-                  neighXYZ[0] /= floatNumNeigh;
-                  neighXYZ[1] /= floatNumNeigh;
-                  neighXYZ[2] /= floatNumNeigh;
-                  
-                  
+   
+                  //
+                  // Update the nodes position
+                  //
                   outputCoords[ix] = inputCoords[ix] * inverseStrength 
-                                 + neighXYZ[0] * strength;
+                                 + xa * strength;
                   outputCoords[iy] = inputCoords[iy] * inverseStrength 
-                                 + neighXYZ[1] * strength;
+                                 + ya * strength;
                   outputCoords[iz] = inputCoords[iz] * inverseStrength 
-                                 + neighXYZ[2] * strength;
+                                 + za * strength;
                }
             }
          }
-      }
-      
-      if (getImAThread()) {
-         if (DebugControl::getDebugOn()) {
-            std::cout << "Smoothing Thread " << getThreadNumber() << " finished iteration." << std::endl;
+         
+         if (linearSmoothIt) {
+            //
+            // Landmark constrained smoothing needs two neighbors, the others only one
+            //
+            int minimumNumberOfNeighbors = 1;
+            if (smoothingType == SMOOTHING_TYPE_LANDMARK_CONSTRAINED) {
+               minimumNumberOfNeighbors = 2;
+            }
+            if (numNeighbors >= minimumNumberOfNeighbors) {
+               float neighXYZ[3] = { 0.0, 0.0, 0.0 };
+               for (int j = 0; j < numNeighbors; j++) {
+                  const int n = neighbors[j];
+                  neighXYZ[0] += inputCoords[n*3];
+                  neighXYZ[1] += inputCoords[n*3+1];
+                  neighXYZ[2] += inputCoords[n*3+2];
+               }
+               
+               const float floatNumNeigh = numNeighbors;
+               neighXYZ[0] /= floatNumNeigh;
+               neighXYZ[1] /= floatNumNeigh;
+               neighXYZ[2] /= floatNumNeigh;
+               
+               
+               outputCoords[ix] = inputCoords[ix] * inverseStrength 
+                              + neighXYZ[0] * strength;
+               outputCoords[iy] = inputCoords[iy] * inverseStrength 
+                              + neighXYZ[1] * strength;
+               outputCoords[iz] = inputCoords[iz] * inverseStrength 
+                              + neighXYZ[2] * strength;
+            }
          }
-         //
-         // A threaded instance needs to tell that it has completed an iteration
-         //
-         setThreadedIterationDoneFlag(true);
-         getParentOfThisThread()->incrementNumChildThreadDone();
       }
-      else {
-         //
-         // A non-threaded instance needs to return
-         //
-         setThreadKeepLoopingFlag(false);
+   }
+   
+   //
+   // Project this range of nodes to the sphere
+   //
+   if (projectToSphereThisIteration) {
+      for (int i = startNodeIndex; i <= endNodeIndex; i++) {
+         MathUtilities::setVectorLength(&outputCoords[i*3], sphereRadius);
       }
-   } // while (keepLooping)
-   delete[] tileAreas;
-   delete[] tileCenters;
+   }
 }
       
+/**
+ * Set the curvature and normals used by curvature smoothing this iteration.
+ */
+void
+BrainModelSurfaceSmoothing::setCurvatureAndNormals(const float* curvatureIn,
+                                                   const float* normalsIn)
+{
+   nodeCurvature = curvatureIn;
+   nodeNormals   = normalsIn;
+}
+
 /**
  * Set the indices of the nodes that are to be smoothed (inclusive).
  */
@@ -36,7 +36,12 @@ class BrainModelSurface;
 class QWaitCondition;
 class TopologyHelper;
 
-/// class for smoothing a brain model surface, multiple threads optional
+/// Engine for smoothing a brain model surface.  Each iteration is a Jacobi
+/// update from the input coordinates into the output coordinates (the two
+/// buffers are swapped between iterations) so the result does not depend
+/// upon the number of threads.  Nodes are partitioned into ranges of roughly
+/// equal neighbor counts and each range is smoothed by a task in the global
+/// thread pool.
 class BrainModelSurfaceSmoothing : public BrainModelAlgorithmMultiThreaded {
    public:
       /// Types of smoothing
@@ -44,10 +49,11 @@ class BrainModelSurfaceSmoothing : public BrainModelAlgorithmMultiThreaded {
          SMOOTHING_TYPE_AREAL,
          SMOOTHING_TYPE_LINEAR,
          SMOOTHING_TYPE_LANDMARK_CONSTRAINED,
-         SMOOTHING_TYPE_LANDMARK_NEIGHBOR_CONSTRAINED
+         SMOOTHING_TYPE_LANDMARK_NEIGHBOR_CONSTRAINED,
+         SMOOTHING_TYPE_CURVATURE
       };
       
-      /// constructor
+      /// constructor (numberOfThreadsIn less than one uses all threads in the thread pool)
       BrainModelSurfaceSmoothing(BrainSet* bs,
                                  BrainModelSurface* surfaceIn,
                                  const SMOOTHING_TYPE smoothingTypeIn,
@@ -66,6 +72,10 @@ class BrainModelSurfaceSmoothing : public BrainModelAlgorithmMultiThreaded {
       /// execute the algorithm
       void execute() throw (BrainModelAlgorithmException);
       
+      /// set the limit of the curvature magnitude used by curvature smoothing
+      void setCurvatureMaximum(const float curvatureMaximumIn) 
+                                    { curvatureMaximum = curvatureMaximumIn; }
+      
    protected:
       /// class stores information about each node
       class NodeInfo {
@@ -99,6 +109,8 @@ class BrainModelSurfaceSmoothing : public BrainModelAlgorithmMultiThreaded {
                                        const SMOOTHING_TYPE smoothingTypeIn,
                                        const float strengthIn,
                                        const float landmarkScaleIn,
+                                       const float sphereRadiusIn,
+                                       const float curvatureMaximumIn,
                                        NodeInfo* nodeInfoIn,
                                        TopologyHelper* topologyHelperIn,
                                        const int startNodeIndexIn,
@@ -109,8 +121,8 @@ class BrainModelSurfaceSmoothing : public BrainModelAlgorithmMultiThreaded {
       /// Initialize member variables.
       void initialize();
       
-      /// smooths for an iteration (required by QThread)
-      void run();
+      /// smooths for an iteration (run in the thread pool for thread instances)
+      void runIteration(const int iteration);
       
       /// set smooth edges this iteration
       void setSmoothEdgesThisIteration(const bool smooth) { smoothEdgesThisIteration = smooth; }
@@ -119,6 +131,13 @@ class BrainModelSurfaceSmoothing : public BrainModelAlgorithmMultiThreaded {
       void setSmoothLandmarkNeighborsThisIteration(const bool smooth)
                           { smoothLandmarkNeighborsThisIteration = smooth; }
  
+      /// set project to sphere this iteration
+      void setProjectToSphereThisIteration(const bool project) 
+                          { projectToSphereThisIteration = project; }
+      
+      /// set the curvature and normals used by curvature smoothing this iteration
+      void setCurvatureAndNormals(const float* curvatureIn, const float* normalsIn);
+      
       /// set the indices of the nodes that are to be smoothed (inclusive)
       void setIndicesOfNodesToSmooth(const int startNodeIndexIn, const int endNodeIndexIn);
       
@@ -187,6 +206,27 @@ class BrainModelSurfaceSmoothing : public BrainModelAlgorithmMultiThreaded {
       
       /// smooth landmark neighbors this iteration
       bool smoothLandmarkNeighborsThisIteration;
+      
+      /// radius used when projecting to a sphere
+      float sphereRadius;
+      
+      /// project to sphere this iteration
+      bool projectToSphereThisIteration;
+      
+      /// limit of curvature magnitude for curvature smoothing
+      float curvatureMaximum;
+      
+      /// curvature of each node for curvature smoothing (do not delete)
+      const float* nodeCurvature;
+      
+      /// normal of each node for curvature smoothing (do not delete)
+      const float* nodeNormals;
+      
+      /// area of tiles around a node (scratch for areal smoothing)
+      std::vector<float> tileAreas;
+      
+      /// center of tiles around a node (scratch for areal smoothing)
+      std::vector<float> tileCenters;
 };
 
 #ifdef __BRAIN_MODEL_SURFACE_SMOOTHING_MAIN_H__
@@ -734,7 +734,7 @@ BrainModelVolumeGradient::LPF_5(float* voxels,
                                 const int ncol, const int nrow, const int nslices,
                                 const float Wo)
 {
-   float   lpf_filter[5];
+   std::vector<float> lpf_filter(5);
    lpf_filter[0] = 1.0/16.0;
    lpf_filter[1] = 1.0/4.0;
    lpf_filter[2] = 3.0/8.0;
@@ -747,7 +747,8 @@ BrainModelVolumeGradient::LPF_5(float* voxels,
      //printf ("Filter %d %f\n", i, lpf_filter[i]);
 	}
 	//printf ("before lpf %f %f\n", volume[417], Wo);
-   VolumeFile::seperableConvolve(ncol, nrow, nslices, voxels, lpf_filter);
+   const int dim[3] = { ncol, nrow, nslices };
+   lowPassConvolution.convolve(voxels, dim, lpf_filter);
 	//printf ("after lpf %f %f\n", volume[417], Wo);
 }
 
@@ -27,6 +27,7 @@
  */
 /*LICENSE_END*/
 #include "BrainModelAlgorithm.h"
+#include "SeparableConvolution.h"
 
 class SureFitVectorFile;
 class VolumeFile;
@@ -78,6 +79,9 @@ class BrainModelVolumeGradient : public BrainModelAlgorithm {
       
       /// sine table
       float* gradientSinTable[3];
+      
+      /// convolution for low pass filtering (keeps its scratch volume between filterings)
+      SeparableConvolution lowPassConvolution;
 
       /// compute wave vectors.
       void computeWaveVectors(float N[NALPHA][3], const float kmag, const float phi);
@@ -27,6 +27,7 @@
 #include "BrainModelVolumeTFCE.h"
 #include "BrainSet.h"
 #include "VolumeFile.h"
+#include <algorithm>
 #include <cmath>
 
 /**
@@ -74,6 +75,17 @@ BrainModelVolumeTFCE::execute() throw (BrainModelAlgorithmException)
    {
       throw BrainModelAlgorithmException("Volume has multiple components.");
    }
+   
+   //
+   // Read the voxels of a paged volume here so that a read error is reported
+   //
+   try {
+      inFuncVolume->loadVoxelData();
+   }
+   catch (FileException& e) {
+      throw BrainModelAlgorithmException(e.whatQString());
+   }
+   
    bool createdOutVolume = false;
    if (outFuncVolume == NULL) {
       outFuncVolume = new VolumeFile(*inFuncVolume);
@@ -94,83 +106,262 @@ BrainModelVolumeTFCE::execute() throw (BrainModelAlgorithmException)
             "Input and Output Volumes are of different dimensions.");
       }
    }
-   int i, j, k, ti, tj, tk, maxi, maxj, maxk, mini, minj, mink, temp, growingInd, growingCur, numVoxels = aDim[0] * aDim[1] * aDim[2];
-   float fmax = 0.0f, thresh, valToAdd;
-   float* voxels = inFuncVolume->getVoxelData(), *outData = outFuncVolume->getVoxelData();
-   bool* flagUsed = new bool[numVoxels];//bitwise saves little space, due to other arrays, so make it simple
-   int* growing = new int[numVoxels * 3];//excessive array for storing clusters, just in case (and in case indices range outside 0-255)
-   for (temp = 0; temp < numVoxels; ++temp)
-   {
-      if (voxels[temp] > fmax) fmax = voxels[temp];
-      outData[temp] = 0.0f;
+   computeTFCE(inFuncVolume->getVoxelData(),
+               outFuncVolume->getVoxelData(),
+               aDim,
+               numSteps,
+               E,
+               H);
+   if (createdOutVolume) {
+      brainSet->addVolumeFile(VolumeFile::VOLUME_TYPE_SEGMENTATION,
+                              outFuncVolume,
+                              outFuncVolume->getFileName(),
+                              true,
+                              false);
    }
-   for (thresh = fmax / numSteps / 2.0f; thresh < fmax; thresh += fmax / numSteps)
-   {
-      for (temp = 0; temp < numVoxels; ++temp) flagUsed[temp] = false;
-      for (k = 0; k < aDim[2]; ++k)
-      {
-         for (j = 0; j < aDim[1]; ++j)
-         {
-            for (i = 0; i < aDim[0]; ++i)
-            {
-               temp = inFuncVolume->getVoxelDataIndex(i, j, k);
-               if (!flagUsed[temp] && voxels[temp] >= thresh)
-               {
-                  flagUsed[temp] = true;
-                  growingInd = 3;
-                  growingCur = 0;
-                  growing[0] = i;
-                  growing[1] = j;
-                  growing[2] = k;
-                  while (growingCur < growingInd)
-                  {
-                     maxi = min(aDim[0], growing[growingCur] + 2);
-                     maxj = min(aDim[1], growing[growingCur + 1] + 2);
-                     maxk = min(aDim[2], growing[growingCur + 2] + 2);
-                     mini = max(0, growing[growingCur] - 1);
-                     minj = max(0, growing[growingCur + 1] - 1);
-                     mink = max(0, growing[growingCur + 2] - 1);
-                     for (tk = mink; tk < maxk; ++tk)
-                     {
-                        for (tj = minj; tj < maxj; ++tj)
-                        {
-                           for (ti = mini; ti < maxi; ++ti)
-                           {
-                              temp = inFuncVolume->getVoxelDataIndex(ti, tj, tk);
-                              if (!flagUsed[temp] && voxels[temp] >= thresh)
-                              {
-                                 flagUsed[temp] = true;
-                                 growing[growingInd] = ti;
-                                 growing[growingInd + 1] = tj;
-                                 growing[growingInd + 2] = tk;
-                                 growingInd += 3;
-                              }
-                           }
-                        }
-                     }
-                     growingCur += 3;
+   outFuncVolume->setVoxelColoringInvalid();
+}
+
+/**
+ * Find the root of a voxel's cluster.  The path to the root is compressed
+ * while keeping the sum of potentials from each voxel to the root unchanged.
+ */
+int 
+BrainModelVolumeTFCE::findClusterRoot(std::vector<int>& parent,
+                                      std::vector<double>& potential,
+                                      const int voxel)
+{
+   const int parentVoxel = parent[voxel];
+   if (parentVoxel == voxel) {
+      return voxel;
+   }
+   const int root = findClusterRoot(parent, potential, parentVoxel);
+   if (parentVoxel != root) {
+      potential[voxel] += potential[parentVoxel];
+      parent[voxel] = root;
+   }
+   return root;
+}
+
+/**
+ * Compute TFCE for one volume (safe to call from multiple threads).
+ *
+ * The voxels are sorted (by threshold step) once and the thresholds are swept 
+ * from highest to lowest while clusters are merged in a disjoint-set structure.
+ * Each cluster's root accumulates e^E * h^H * dh for the steps in which the cluster 
+ * did not change and a voxel's TFCE value is the sum of the accumulations on 
+ * the path to its root.  This produces the same values as a flood fill at
+ * every threshold step ((step + 0.5) * dh using 26 neighbors).
+ */
+void 
+BrainModelVolumeTFCE::computeTFCE(const float* voxels,
+                                  float* outData,
+                                  const int dimensions[3],
+                                  const int numSteps,
+                                  const float E,
+                                  const float H)
+{
+   const int dimI = dimensions[0];
+   const int dimJ = dimensions[1];
+   const int dimK = dimensions[2];
+   const int dimIJ = dimI * dimJ;
+   const int numVoxels = dimIJ * dimK;
+   
+   float fmax = 0.0f;
+   for (int i = 0; i < numVoxels; i++) {
+      if (voxels[i] > fmax) fmax = voxels[i];
+      outData[i] = 0.0f;
+   }
+   if ((fmax <= 0.0f) || (numSteps <= 0)) {
+      return;
+   }
+   const float dh = fmax / numSteps;
+   
+   //
+   // Threshold step at which each voxel joins a cluster (-1 if never)
+   // and count of voxels joining at each step
+   //
+   std::vector<int> voxelStep(numVoxels, -1);
+   std::vector<int> stepStart(numSteps + 1, 0);
+   for (int i = 0; i < numVoxels; i++) {
+      const float value = voxels[i];
+      if (value >= (0.5f * dh)) {
+         int step = static_cast<int>(value / dh - 0.5f);
+         step = min(max(step, 0), numSteps - 1);
+         while ((step > 0) && (((step + 0.5f) * dh) > value)) {
+            step--;
+         }
+         while ((step < (numSteps - 1)) && (((step + 1.5f) * dh) <= value)) {
+            step++;
+         }
+         voxelStep[i] = step;
+         stepStart[step + 1]++;
+      }
+   }
+   
+   //
+   // Sort voxels by threshold step
+   //
+   for (int s = 0; s < numSteps; s++) {
+      stepStart[s + 1] += stepStart[s];
+   }
+   std::vector<int> sortedVoxels(stepStart[numSteps]);
+   std::vector<int> stepNext(stepStart.begin(), stepStart.end() - 1);
+   for (int i = 0; i < numVoxels; i++) {
+      if (voxelStep[i] >= 0) {
+         sortedVoxels[stepNext[voxelStep[i]]++] = i;
+      }
+   }
+   
+   //
+   // Sum of h^H * dh for all steps at or above a step
+   //
+   std::vector<double> stepSum(numSteps + 1, 0.0);
+   for (int s = numSteps - 1; s >= 0; s--) {
+      stepSum[s] = stepSum[s + 1] 
+                 + std::pow(static_cast<double>((s + 0.5f) * dh), static_cast<double>(H)) * dh;
+   }
+   
+   //
+   // Disjoint-set of clusters (parent is -1 until voxel joins a cluster).
+   // firstStepAdded is the lowest step already added to a root's potential.
+   //
+   std::vector<int> parent(numVoxels, -1);
+   std::vector<int> clusterSize(numVoxels, 0);
+   std::vector<double> potential(numVoxels, 0.0);
+   std::vector<int> firstStepAdded(numVoxels, numSteps);
+   
+   for (int s = numSteps - 1; s >= 0; s--) {
+      for (int n = stepStart[s]; n < stepStart[s + 1]; n++) {
+         const int voxel = sortedVoxels[n];
+         parent[voxel] = voxel;
+         clusterSize[voxel] = 1;
+         firstStepAdded[voxel] = s + 1;
+         
+         const int k = voxel / dimIJ;
+         const int j = (voxel - k * dimIJ) / dimI;
+         const int i = voxel - k * dimIJ - j * dimI;
+         const int mink = max(0, k - 1), maxk = min(dimK, k + 2);
+         const int minj = max(0, j - 1), maxj = min(dimJ, j + 2);
+         const int mini = max(0, i - 1), maxi = min(dimI, i + 2);
+         for (int tk = mink; tk < maxk; tk++) {
+            for (int tj = minj; tj < maxj; tj++) {
+               for (int ti = mini; ti < maxi; ti++) {
+                  const int neighbor = ti + tj * dimI + tk * dimIJ;
+                  if (parent[neighbor] < 0) {
+                     continue;
                   }
-                  growingCur = 0;
-                  valToAdd = std::pow(growingInd / 3.0f, E) * std::pow(thresh, H) * fmax / numSteps;// e(h)^E * h^H * dh
-                  //NOTE: integral approximation can be improved using standard weighting techniques, currently uses center of piece method
-                  while (growingCur < growingInd)
-                  {
-                     outData[outFuncVolume->getVoxelDataIndex(growing[growingCur], growing[growingCur + 1], growing[growingCur + 2])] += valToAdd;
-                     growingCur += 3;
+                  int rootA = findClusterRoot(parent, potential, voxel);
+                  int rootB = findClusterRoot(parent, potential, neighbor);
+                  if (rootA == rootB) {
+                     continue;
                   }
+                  
+                  //
+                  // Add the steps above this step to both clusters before merging
+                  //
+                  potential[rootA] += std::pow(static_cast<double>(clusterSize[rootA]), static_cast<double>(E))
+                                    * (stepSum[s + 1] - stepSum[firstStepAdded[rootA]]);
+                  potential[rootB] += std::pow(static_cast<double>(clusterSize[rootB]), static_cast<double>(E))
+                                    * (stepSum[s + 1] - stepSum[firstStepAdded[rootB]]);
+                  
+                  //
+                  // Merge smaller cluster into larger cluster
+                  //
+                  if (clusterSize[rootA] < clusterSize[rootB]) {
+                     std::swap(rootA, rootB);
+                  }
+                  parent[rootB] = rootA;
+                  potential[rootB] -= potential[rootA];
+                  clusterSize[rootA] += clusterSize[rootB];
+                  firstStepAdded[rootA] = s + 1;
                }
             }
          }
       }
    }
-   if (createdOutVolume) {
-      brainSet->addVolumeFile(VolumeFile::VOLUME_TYPE_SEGMENTATION,
-                              outFuncVolume,
-                              outFuncVolume->getFileName(),
-                              true,
-                              false);
+   
+   //
+   // Add the remaining steps to all clusters
+   //
+   for (int n = 0; n < static_cast<int>(sortedVoxels.size()); n++) {
+      const int voxel = sortedVoxels[n];
+      if (parent[voxel] == voxel) {
+         potential[voxel] += std::pow(static_cast<double>(clusterSize[voxel]), static_cast<double>(E))
+                           * (stepSum[0] - stepSum[firstStepAdded[voxel]]);
+         firstStepAdded[voxel] = 0;
+      }
    }
-   outFuncVolume->setVoxelColoringInvalid();
-   delete[] flagUsed;
-   delete[] growing;
+   
+   //
+   // TFCE value of voxel is sum of potentials to its cluster's root
+   //
+   for (int n = 0; n < static_cast<int>(sortedVoxels.size()); n++) {
+      const int voxel = sortedVoxels[n];
+      const int root = findClusterRoot(parent, potential, voxel);
+      double value = potential[voxel];
+      if (root != voxel) {
+         value += potential[root];
+      }
+      outData[voxel] = static_cast<float>(value);
+   }
+}
+
+/**
+ * Compute TFCE for many volumes (such as the permutations of a permutation test)
+ * using the thread pool.  Each volume is computed by one thread.
+ */
+void 
+BrainModelVolumeTFCE::computeTFCEMultipleVolumes(const std::vector<const float*>& voxels,
+                                                 const std::vector<float*>& outData,
+                                                 const int dimensions[3],
+                                                 const int numSteps,
+                                                 const float E,
+                                                 const float H)
+{
+   const int numVolumes = min(static_cast<int>(voxels.size()),
+                              static_cast<int>(outData.size()));
+   std::vector<ComputeTask*> tasks(numVolumes);
+   
+   CaretThreadPoolTaskGroup taskGroup;
+   for (int i = 0; i < numVolumes; i++) {
+      tasks[i] = new ComputeTask(voxels[i], outData[i], dimensions, numSteps, E, H);
+      taskGroup.submit(tasks[i]);
+   }
+   taskGroup.waitForAll();
+   
+   for (int i = 0; i < numVolumes; i++) {
+      delete tasks[i];
+   }
+}
+
+//=============================================================================
+
+/**
+ * Constructor.
+ */
+BrainModelVolumeTFCE::ComputeTask::ComputeTask(const float* voxelsIn,
+                                               float* outDataIn,
+                                               const int dimensionsIn[3],
+                                               const int numStepsIn,
+                                               const float EIn,
+                                               const float HIn)
+{
+   voxels = voxelsIn;
+   outData = outDataIn;
+   dimensions[0] = dimensionsIn[0];
+   dimensions[1] = dimensionsIn[1];
+   dimensions[2] = dimensionsIn[2];
+   numSteps = numStepsIn;
+   E = EIn;
+   H = HIn;
+}
+
+/**
+ * compute TFCE.
+ */
+void 
+BrainModelVolumeTFCE::ComputeTask::run()
+{
+   computeTFCE(voxels, outData, dimensions, numSteps, E, H);
 }
@@ -27,7 +27,10 @@
  */
 /*LICENSE_END*/
 
+#include <vector>
+
 #include "BrainModelAlgorithm.h"
+#include "CaretThreadPool.h"
 
 class VolumeFile;
 
@@ -56,7 +59,58 @@ class BrainModelVolumeTFCE : public BrainModelAlgorithm {
       static inline const float defaultH() { return 2.0f; };
       static inline int min(int a, int b) { return (a > b ? b : a); };
       static inline int max(int a, int b) { return (a > b ? a : b); };
+      
+      // compute TFCE for one volume's voxels (safe to call from multiple threads)
+      static void computeTFCE(const float* voxels,
+                              float* outData,
+                              const int dimensions[3],
+                              const int numSteps = 50,
+                              const float E = 0.5f,
+                              const float H = 2.0f);
+      
+      // compute TFCE for many volumes (such as permutations) using the thread pool
+      static void computeTFCEMultipleVolumes(const std::vector<const float*>& voxels,
+                                             const std::vector<float*>& outData,
+                                             const int dimensions[3],
+                                             const int numSteps = 50,
+                                             const float E = 0.5f,
+                                             const float H = 2.0f);
    protected:
+      /// task that computes TFCE for one volume in the thread pool
+      class ComputeTask : public CaretThreadPoolTask {
+         public:
+            /// constructor
+            ComputeTask(const float* voxelsIn,
+                        float* outDataIn,
+                        const int dimensionsIn[3],
+                        const int numStepsIn,
+                        const float EIn,
+                        const float HIn);
+            
+            /// compute TFCE
+            void run();
+            
+         protected:
+            /// the input voxels
+            const float* voxels;
+            
+            /// the output voxels
+            float* outData;
+            
+            /// dimensions of the volume
+            int dimensions[3];
+            
+            /// parameter storage
+            int numSteps;
+            float E, H;
+      };
+      
+      // find root of voxel's cluster with path compression
+      static int findClusterRoot(std::vector<int>& parent,
+                                 std::vector<double>& potential,
+                                 const int voxel);
+      
+
       /// segmentation volume, anatomy input volume
       VolumeFile* outFuncVolume;
       VolumeFile* inFuncVolume;
@@ -215,6 +215,16 @@ BrainModelVolumeToSurfaceMapper::execute() throw (BrainModelAlgorithmException)
          if (volumeFile == NULL) {
             throw BrainModelAlgorithmException("No volume provided.");
          }
+         
+         //
+         // Read the voxels of a paged volume here so that a read error is reported
+         //
+         try {
+            volumeFile->loadVoxelData();
+         }
+         catch (FileException& e) {
+            throw BrainModelAlgorithmException(e.whatQString());
+         }
    
          if (dataFileColumn < 0) {
             columnsToAdd = 1;
@@ -4490,9 +4490,19 @@ BrainSet::readVolumeFile(const QString& name,
    bool updateSpec = updateSpecIn;
    bool append = appendIn;
    
+   //
+   // Functional volumes are usually viewed one sub-volume at a time so
+   // their voxels are paged in when accessed (unless all are transformed)
+   //
+   int readSelection = VolumeFile::VOLUME_READ_SELECTION_ALL;
+   if ((vt == VolumeFile::VOLUME_TYPE_FUNCTIONAL) &&
+       specDataFileTransformationMatrix.isIdentity()) {
+      readSelection = VolumeFile::VOLUME_READ_SELECTION_ALL_PAGED;
+   }
+   
    std::vector<VolumeFile*> volumes;
    VolumeFile::readFile(name, 
-                        VolumeFile::VOLUME_READ_SELECTION_ALL,
+                        readSelection,
                         volumes,
                         false);
                         
@@ -26,6 +26,7 @@ HEADERS += BorderFileProjector.h \
       BrainModelAlgorithmMultiThreadExecutor.h \
 	   BrainModelAlgorithmMultiThreaded.h \
       BrainModelAlgorithmRunAsThread.h \
+      BrainModelAlgorithmThreadPoolTask.h \
 	   BrainModelBorderSet.h \
        BrainModelCiftiCorrelationMatrix.h \
       BrainModelCiftiDenseConnectomeGradient.h \
@@ -89,8 +90,10 @@ HEADERS += BorderFileProjector.h \
       BrainModelSurfaceMetricTwoSampleTTest.h \
       BrainModelSurfaceMetricSmoothing.h \
       BrainModelSurfaceMetricSmoothingAll.h \
+      BrainModelSurfaceMetricSmoothingOperator.h \
 	   BrainModelSurfaceMorphing.h \
 	   BrainModelSurfaceMultiresolutionMorphing.h \
+	   BrainModelSurfaceMultiresolutionSmoothing.h \
       BrainModelSurfaceNodeColoring.h \
       BrainModelSurfaceOverlay.h \
       BrainModelSurfacePaintAssignRelativeToLine.h \
@@ -211,6 +214,7 @@ SOURCES += BorderFileProjector.cxx \
       BrainModelAlgorithmMultiThreadExecutor.cxx \
 	   BrainModelAlgorithmMultiThreaded.cxx \
       BrainModelAlgorithmRunAsThread.cxx \
+      BrainModelAlgorithmThreadPoolTask.cxx \
 	   BrainModelBorderSet.cxx \
        BrainModelCiftiCorrelationMatrix.cxx \
       BrainModelCiftiDenseConnectomeGradient.cxx \
@@ -274,8 +278,10 @@ SOURCES += BorderFileProjector.cxx \
       BrainModelSurfaceMetricTwoSampleTTest.cxx \
       BrainModelSurfaceMetricSmoothing.cxx \
       BrainModelSurfaceMetricSmoothingAll.cxx \
+      BrainModelSurfaceMetricSmoothingOperator.cxx \
 	   BrainModelSurfaceMorphing.cxx \
 	   BrainModelSurfaceMultiresolutionMorphing.cxx \
+	   BrainModelSurfaceMultiresolutionSmoothing.cxx \
       BrainModelSurfaceNodeColoring.cxx \
       BrainModelSurfaceOverlay.cxx \
       BrainModelSurfacePaintAssignRelativeToLine.cxx \
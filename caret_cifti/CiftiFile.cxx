@@ -37,7 +37,7 @@ using namespace std;
  * 
  * Default Constructor
  * @param CACHE_LEVEL specifies whether the file is loaded into memory, or kept on disk
- * currently only IN_MEMORY is supported 
+ * (ON_DISK memory maps the matrix) 
  */
 CiftiFile::CiftiFile(CACHE_LEVEL clevel) throw (CiftiFileException)
 {
@@ -52,7 +52,7 @@ CiftiFile::CiftiFile(CACHE_LEVEL clevel) throw (CiftiFileException)
  * 
  * @param fileName name and path of the Cifti File
  * @param CACHE_LEVEL specifies whether the file is loaded into memory, or kept on disk
- * currently only IN_MEMORY is supported
+ * (ON_DISK memory maps the matrix)
  */
 CiftiFile::CiftiFile(const QString &fileName,CACHE_LEVEL clevel) throw (CiftiFileException) 
 {
@@ -108,7 +108,7 @@ void CiftiFile::openFile(const QString &fileName) throw (CiftiFileException)
  * 
  * @param fileName name and path of the Cifti File
  * @param CACHE_LEVEL specifies whether the file is loaded into memory, or kept on disk
- * currently only IN_MEMORY is supported 
+ * (ON_DISK memory maps the matrix) 
  */
 void CiftiFile::openFile(const QString &fileName, CACHE_LEVEL clevel) throw (CiftiFileException)
 {
@@ -126,7 +126,23 @@ void CiftiFile::openFile(const QString &fileName, CACHE_LEVEL clevel) throw (Cif
 void CiftiFile::writeFile(const QString &fileName) const throw (CiftiFileException)
 {
    QFile outputFile(fileName);
-   outputFile.open(QIODevice::WriteOnly);
+   if(!outputFile.open(QIODevice::WriteOnly)) throw CiftiFileException("Unable to open " + fileName + " for writing.");
+   writeHeaderAndExtension(outputFile);
+   m_matrix->writeMatrix(outputFile);
+   outputFile.close();
+}
+
+/** 
+ * 
+ * 
+ * write the Nifti2Header and the CiftiXML extension, leaving the file positioned
+ * at the start of the Cifti Matrix, so that the matrix may be written incrementally
+ * 
+ * @param outputFile an open file to write to
+ */
+void CiftiFile::writeHeaderAndExtension(QFile &outputFile) const throw (CiftiFileException)
+{
+   if((m_nifti2Header == NULL) || (m_xml == NULL)) throw CiftiFileException("Cifti File requires a header and XML for writing.");
    //Get XML string and length, which is needed to calculate the vox_offset stored in the Nifti Header
    QByteArray xmlBytes;
    m_xml->writeXML(xmlBytes);
@@ -154,8 +170,6 @@ void CiftiFile::writeFile(const QString &fileName) const throw (CiftiFileExcepti
    char junk[] = "         ";//filler for 8 byte alignment
    char* junk2 = &(junk[0]);
    if (padding) outputFile.write(junk2, padding);
-   m_matrix->writeMatrix(outputFile);
-   outputFile.close();
 }
 
 /**
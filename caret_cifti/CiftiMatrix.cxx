@@ -22,6 +22,8 @@
  *
  */
 /*LICENSE_END*/
+#include <algorithm>
+#include <cstring>
 #include <CiftiMatrix.h>
 #ifdef Q_OS_WIN32
 #include <io.h>
@@ -33,7 +35,8 @@
  * Constructor
  * 
  * Constructor
- * @param file handle to a file that is positioned at the start of the Cifti Matrix
+ * @param file handle to a file that is positioned at the start of the Cifti Matrix,
+ *        when ON_DISK, the matrix is mapped using a new handle to the same file
  * @param dimensions an std::vector containing the number and size of all dimensions i.e. x,y,z,t
  * @param CACHE_LEVEL
  */
@@ -85,6 +88,32 @@ CiftiMatrix::CiftiMatrix() throw (CiftiFileException)
    init();   
 }
 
+/**
+ * Copy Constructor
+ * 
+ * Copy Constructor, an in memory matrix is copied, an on disk
+ * matrix is mapped again from the same file
+ * @param matrix
+ */
+CiftiMatrix::CiftiMatrix(const CiftiMatrix &matrix) throw (CiftiFileException)
+{
+   init();
+   copyMatrix(matrix);
+}
+
+/**
+ * Assignment Operator
+ * 
+ * Assignment Operator, an in memory matrix is copied, an on disk
+ * matrix is mapped again from the same file
+ * @param matrix
+ */
+CiftiMatrix &CiftiMatrix::operator=(const CiftiMatrix &matrix) throw (CiftiFileException)
+{
+   if(this != &matrix) copyMatrix(matrix);
+   return *this;
+}
+
 /**
  * Destructor
  * 
@@ -102,7 +131,15 @@ CiftiMatrix::~CiftiMatrix()
  */
 void CiftiMatrix::swapByteOrder()
 {
-   CiftiByteSwap::swapBytes(m_matrix,m_length);   
+   if(m_matrix)
+   {
+      CiftiByteSwap::swapBytes(m_matrix,m_length);
+   }
+   else if(m_mappedData)
+   {
+      //the mapping is read only, so swapping is done as values are read
+      m_mappedSwapNeeded = !m_mappedSwapNeeded;
+   }
 }
 
 /**
@@ -117,6 +154,19 @@ void CiftiMatrix::swapByteOrder()
 void CiftiMatrix::getMatrixData(float *&matrix, std::vector <int> &dimensions)
 {   
    dimensions = m_dimensions;
+   if((m_matrix == NULL) && (m_mappedData != NULL))
+   {
+      if(m_copyData)
+      {
+         matrix = new float [m_length];
+         getRows(matrix, 0, getNumberOfRows());
+         return;
+      }
+      //the mapping is read only and may need byte swapping, so read the matrix into memory
+      float *temp = new float [m_length];
+      getRows(temp, 0, getNumberOfRows());
+      m_matrix = temp;
+   }
    if(m_copyData)
    {
       matrix = new float [m_length];
@@ -201,6 +251,119 @@ bool CiftiMatrix::getCopyData()
    return m_copyData;
 }
 
+/**
+ * get Cache Level
+ * 
+ * get Cache Level, ON_DISK when the matrix is memory mapped
+ * @return cache level
+ */
+CACHE_LEVEL CiftiMatrix::getCacheLevel() const
+{
+   return m_clevel;
+}
+
+/**
+ * get Number Of Rows
+ * 
+ * get Number Of Rows, the size of the first dimension
+ * @return number of rows
+ */
+long long CiftiMatrix::getNumberOfRows() const
+{
+   if(m_dimensions.empty()) return 0;
+   return m_dimensions[0];
+}
+
+/**
+ * get Number Of Columns
+ * 
+ * get Number Of Columns, the product of the remaining dimensions
+ * @return number of columns
+ */
+long long CiftiMatrix::getNumberOfColumns() const
+{
+   if(m_dimensions.empty()) return 0;
+   long long columns = 1;
+   for(unsigned int i = 1;i<m_dimensions.size();i++)
+   {
+      columns *= m_dimensions[i];
+   }
+   return columns;
+}
+
+/**
+ * get Row
+ * 
+ * copies a row of the matrix, byte swapping if needed
+ * @param rowOut must hold getNumberOfColumns() values
+ * @param row
+ */
+void CiftiMatrix::getRow(float *rowOut, const long long row) const throw (CiftiFileException)
+{
+   getRows(rowOut, row, 1);
+}
+
+/**
+ * get Rows
+ * 
+ * copies consecutive rows of the matrix, byte swapping if needed
+ * @param rowsOut must hold numberOfRows * getNumberOfColumns() values
+ * @param firstRow
+ * @param numberOfRows
+ */
+void CiftiMatrix::getRows(float *rowsOut, const long long firstRow, const long long numberOfRows) const throw (CiftiFileException)
+{
+   if((firstRow < 0) || (numberOfRows < 0) || ((firstRow + numberOfRows) > getNumberOfRows()))
+   {
+      throw CiftiFileException("Invalid row requested from Cifti Matrix.");
+   }
+   const float *matrix = getMatrixPointer();
+   if(matrix == NULL) throw CiftiFileException("Cifti Matrix contains no data.");
+   
+   const long long columns = getNumberOfColumns();
+   const unsigned long long count = numberOfRows * columns;
+   memcpy((char *)rowsOut, (const char *)(matrix + firstRow * columns), count * 4);
+   if((m_matrix == NULL) && m_mappedSwapNeeded) CiftiByteSwap::swapBytes(rowsOut, count);
+}
+
+/**
+ * get Column
+ * 
+ * copies a column of the matrix, byte swapping if needed
+ * @param columnOut must hold getNumberOfRows() values
+ * @param column
+ */
+void CiftiMatrix::getColumn(float *columnOut, const long long column) const throw (CiftiFileException)
+{
+   const long long columns = getNumberOfColumns();
+   if((column < 0) || (column >= columns))
+   {
+      throw CiftiFileException("Invalid column requested from Cifti Matrix.");
+   }
+   const float *matrix = getMatrixPointer();
+   if(matrix == NULL) throw CiftiFileException("Cifti Matrix contains no data.");
+   
+   const long long rows = getNumberOfRows();
+   for(long long i = 0;i<rows;i++)
+   {
+      columnOut[i] = matrix[i * columns + column];
+   }
+   if((m_matrix == NULL) && m_mappedSwapNeeded) CiftiByteSwap::swapBytes(columnOut, rows);
+}
+
+/**
+ * get Matrix Pointer
+ * 
+ * pointer to the in memory matrix, or the mapped matrix
+ * (which may need byte swapping) if the matrix is on disk
+ * @return matrix pointer
+ */
+const float * CiftiMatrix::getMatrixPointer() const
+{
+   if(m_matrix) return m_matrix;
+   return (const float *)m_mappedData;
+}
+
 void CiftiMatrix::init()
 {
    m_clevel = IN_MEMORY;
@@ -213,14 +376,81 @@ void CiftiMatrix::initMatrix()
    m_dimensions.clear();
    m_matrix = NULL;
    m_length = 0;
+   m_mappedFile = NULL;
+   m_mappedData = NULL;
+   m_mappedOffset = 0;
+   m_mappedSwapNeeded = false;
 }
 
 void CiftiMatrix::freeMatrix()
 {
-   if(m_matrix) delete m_matrix;
+   if(m_matrix) delete [] m_matrix;
+   if(m_mappedFile)
+   {
+      if(m_mappedData) m_mappedFile->unmap(m_mappedData);
+      m_mappedFile->close();
+      delete m_mappedFile;
+   }
    initMatrix();
 }
 
+/**
+ * copy Matrix
+ * 
+ * copy the matrix, an in memory matrix is copied, an on disk
+ * matrix is mapped again from the same file
+ * @param matrix
+ */
+void CiftiMatrix::copyMatrix(const CiftiMatrix &matrix) throw (CiftiFileException)
+{
+   freeMatrix();
+   m_clevel = matrix.m_clevel;
+   m_copyData = matrix.m_copyData;
+   if(matrix.m_dimensions.empty()) return;
+   setDimensions(matrix.m_dimensions);
+   
+   if(matrix.m_matrix)
+   {
+      m_matrix = new float [m_length];
+      memcpy((char *)m_matrix,(char *)matrix.m_matrix,m_length*4);
+   }
+   else if(matrix.m_mappedFile)
+   {
+      mapMatrix(matrix.m_mappedFile->fileName(), matrix.m_mappedOffset);
+      m_mappedSwapNeeded = matrix.m_mappedSwapNeeded;
+   }
+}
+
+/**
+ * map Matrix
+ * 
+ * memory map the matrix (dimensions must be set) using a new handle to the file
+ * @param fileName
+ * @param offset the position of the beginning of the CiftiMatrix within the file
+ */
+void CiftiMatrix::mapMatrix(const QString &fileName, unsigned long long offset) throw (CiftiFileException)
+{
+   m_mappedFile = new QFile(fileName);
+   if(!m_mappedFile->open(QIODevice::ReadOnly))
+   {
+      delete m_mappedFile;
+      m_mappedFile = NULL;
+      throw CiftiFileException("Unable to open " + fileName + " for mapping Cifti Matrix.");
+   }
+   if((offset + m_length*4) > (unsigned long long)m_mappedFile->size())
+   {
+      freeMatrix();
+      throw CiftiFileException("Cifti File " + fileName + " is smaller than its matrix dimensions.");
+   }
+   m_mappedOffset = offset;
+   m_mappedData = m_mappedFile->map(offset, m_length*4);
+   if(m_mappedData == NULL)
+   {
+      freeMatrix();
+      throw CiftiFileException("Unable to memory map Cifti Matrix in " + fileName + ".");
+   }
+}
+
 /**
  * readMatrix
  * 
@@ -228,7 +458,7 @@ void CiftiMatrix::freeMatrix()
  * @param fileName
  * @param dimensions
  */
-void CiftiMatrix::readMatrix(const QString &fileName, std::vector<int> &dimensions)
+void CiftiMatrix::readMatrix(const QString &fileName, std::vector<int> &dimensions) throw (CiftiFileException)
 {
    readMatrix(fileName, dimensions, 0);   
 }
@@ -241,22 +471,13 @@ void CiftiMatrix::readMatrix(const QString &fileName, std::vector<int> &dimensio
  * @param dimensions
  * @param offset
  */
-void CiftiMatrix::readMatrix(const QString &fileName, std::vector<int> &dimensions, unsigned long long offset)
+void CiftiMatrix::readMatrix(const QString &fileName, std::vector<int> &dimensions, unsigned long long offset) throw (CiftiFileException)
 {
    QFile ciftiFile;
    ciftiFile.setFileName(fileName);   
-   if(m_clevel == IN_MEMORY)
-   {
-      ciftiFile.open(QIODevice::ReadOnly);
-      if(offset) ciftiFile.seek(offset);
-      readMatrix(ciftiFile,dimensions);
-   }
-   else if(m_clevel == ON_DISK)
-   {
-      CiftiFileException("ON_DISK file IO mode not yet implemented.");
-      ciftiFile.open(QIODevice::ReadOnly);
-      if(offset) ciftiFile.seek(offset);
-   }
+   if(!ciftiFile.open(QIODevice::ReadOnly)) throw CiftiFileException("Unable to open " + fileName + " for reading Cifti Matrix.");
+   if(offset) ciftiFile.seek(offset);
+   readMatrix(ciftiFile,dimensions);
 }
 
 /**
@@ -266,7 +487,7 @@ void CiftiMatrix::readMatrix(const QString &fileName, std::vector<int> &dimensio
  * @param file
  * @param dimensions
  */
-void CiftiMatrix::readMatrix(QFile &file, std::vector<int> &dimensions)
+void CiftiMatrix::readMatrix(QFile &file, std::vector<int> &dimensions) throw (CiftiFileException)
 {
    freeMatrix();
    setDimensions(dimensions);
@@ -274,7 +495,7 @@ void CiftiMatrix::readMatrix(QFile &file, std::vector<int> &dimensions)
    if(m_clevel == IN_MEMORY)
    {
       m_matrix = new float [m_length];
-      if(!m_matrix) CiftiFileException("Error allocating Cifti Matrix.");
+      if(!m_matrix) throw CiftiFileException("Error allocating Cifti Matrix.");
       int fd = file.handle();
       size_t bytes_read = 0;
       size_t bytes_needed = m_length * 4;
@@ -286,11 +507,11 @@ void CiftiMatrix::readMatrix(QFile &file, std::vector<int> &dimensions)
       }
       //unsigned long long bytes_read = file.readData((char *)(m_matrix),m_length);
       //bytes_read = file.read((char *)(m_matrix),1500000000);
-      if(bytes_read != m_length*4) CiftiFileException("Error reading matrix from Cifti File.");
+      if(bytes_read != m_length*4) throw CiftiFileException("Error reading matrix from Cifti File.");
    }
    else if(m_clevel == ON_DISK)
    {
-      CiftiFileException("ON_DISK file IO mode not yet implemented.");
+      mapMatrix(file.fileName(), file.pos());
    }   
 }
 
@@ -302,5 +523,22 @@ void CiftiMatrix::readMatrix(QFile &file, std::vector<int> &dimensions)
  */
 void CiftiMatrix::writeMatrix(QFile &file)
 {   
-   file.write((char *)m_matrix,m_length*4);
+   if(m_matrix || !m_mappedSwapNeeded)
+   {
+      file.write((const char *)getMatrixPointer(),m_length*4);
+      return;
+   }
+   
+   //write a mapped matrix that needs byte swapping in blocks of rows
+   const long long rows = getNumberOfRows();
+   const long long columns = getNumberOfColumns();
+   long long rowsPerBlock = (16 * 1024 * 1024) / (columns > 0 ? columns : 1);
+   if(rowsPerBlock < 1) rowsPerBlock = 1;
+   std::vector<float> block(rowsPerBlock * columns);
+   for(long long i = 0;i<rows;i+=rowsPerBlock)
+   {
+      const long long numRows = std::min(rowsPerBlock, rows - i);
+      getRows(&block[0], i, numRows);
+      file.write((const char *)&block[0], numRows * columns * 4);
+   }
 }
@@ -34,7 +34,8 @@ enum  CACHE_LEVEL {
   ON_DISK
 };
 /// Class for reading and writing Cifti Matrix Data
-//warning!!! when using ON_DISK cache level, don't plan on using the file handle again, consider it gone, once handing it to a CiftiMatrix object.
+//when using ON_DISK cache level, the matrix is memory mapped from its own handle to the file, the file handle
+//passed to the CiftiMatrix is only used to determine the file name and the position of the matrix
 class CiftiMatrix
 { 
 public:
@@ -42,11 +43,13 @@ public:
    CiftiMatrix(const QString &fileName, std::vector<int> &dimensions, unsigned long long int offset, CACHE_LEVEL clevel=IN_MEMORY) throw (CiftiFileException);
    CiftiMatrix(const QString &fileName, std::vector<int> &dimensions, CACHE_LEVEL clevel=IN_MEMORY) throw (CiftiFileException);
    CiftiMatrix() throw (CiftiFileException);
+   CiftiMatrix(const CiftiMatrix &matrix) throw (CiftiFileException);
+   CiftiMatrix &operator=(const CiftiMatrix &matrix) throw (CiftiFileException);
    ~CiftiMatrix();
    void swapByteOrder();
-   void readMatrix(QFile &file, std::vector<int> &dimensions);
-   void readMatrix(const QString &fileName, std::vector<int> &dimensions, unsigned long long offset);
-   void readMatrix(const QString &fileName, std::vector<int> &dimensions);
+   void readMatrix(QFile &file, std::vector<int> &dimensions) throw (CiftiFileException);
+   void readMatrix(const QString &fileName, std::vector<int> &dimensions, unsigned long long offset) throw (CiftiFileException);
+   void readMatrix(const QString &fileName, std::vector<int> &dimensions) throw (CiftiFileException);
    void writeMatrix(QFile &file);
    void getMatrixData(float *&data, std::vector <int> &dimensions);//gets the entire matrix, depending on the copy data preferences,
                            //either copies all of the data
@@ -54,16 +57,29 @@ public:
    void getDimensions(std::vector <int>& dimensions);
    void setCopyData(bool copyData);
    bool getCopyData();
+   CACHE_LEVEL getCacheLevel() const;
+   long long getNumberOfRows() const;
+   long long getNumberOfColumns() const;
+   void getRow(float *rowOut, const long long row) const throw (CiftiFileException);//rowOut must hold getNumberOfColumns() values
+   void getRows(float *rowsOut, const long long firstRow, const long long numberOfRows) const throw (CiftiFileException);
+   void getColumn(float *columnOut, const long long column) const throw (CiftiFileException);//columnOut must hold getNumberOfRows() values
 protected:
    void freeMatrix();
    void initMatrix();
    void init();
    void setDimensions(std::vector <int> dimensions);
+   void mapMatrix(const QString &fileName, unsigned long long offset) throw (CiftiFileException);
+   void copyMatrix(const CiftiMatrix &matrix) throw (CiftiFileException);
+   const float * getMatrixPointer() const;
    float * m_matrix;
    unsigned long long m_length;
    std::vector <int> m_dimensions;
    CACHE_LEVEL m_clevel;
    bool m_copyData;
+   QFile * m_mappedFile;//ON_DISK only, handle used for memory mapping the matrix
+   uchar * m_mappedData;//ON_DISK only, start of the mapped matrix
+   unsigned long long m_mappedOffset;//ON_DISK only, offset of the matrix in the mapped file
+   bool m_mappedSwapNeeded;//ON_DISK only, byte swapping is applied as values are read from the mapped matrix
 };
 
 #endif //__CIFTI_MATRIX
@@ -76,6 +76,9 @@ CommandCiftiCorrelationMatrix::getHelpInformation() const
        + indent9 + "[-output-gifti-external-binary filename]\n"//specified in .gii, .dat is created automatically
        + indent9 + "[-apply-fisher-z-transform]\n"
        + indent9 + "[-parallel]\n"
+       + indent9 + "[-float-accumulation]\n"
+       + indent9 + "[-on-disk]\n"
+       + indent9 + "[-memory-limit <megabytes>]\n"
        + indent9 + "\n"
        + indent9 + "Compute a correlation matrix using the input cifti file.\n"
        + indent9 + "Each row (node) in the cifti file is correlated with all\n"
@@ -106,6 +109,23 @@ CommandCiftiCorrelationMatrix::getHelpInformation() const
        + indent9 + "If the \"-parallel\" option is specified, the algorithm\n"
        + indent9 + "will run its operations with multiple threads to reduce\n"
        + indent9 + "execution time.\n"
+       + indent9 + "\n"
+       + indent9 + "If the \"-float-accumulation\" option is specified, the\n"
+       + indent9 + "correlations are accumulated in single precision which is\n"
+       + indent9 + "faster but less accurate than the default double precision.\n"
+       + indent9 + "\n"
+       + indent9 + "If the \"-on-disk\" option is specified, the input cifti\n"
+       + indent9 + "file's matrix is memory mapped instead of read into memory\n"
+       + indent9 + "and its rows are read as they are needed.\n"
+       + indent9 + "\n"
+       + indent9 + "If the \"-memory-limit\" option is specified, the output\n"
+       + indent9 + "is computed in blocks of rows that are written to the output\n"
+       + indent9 + "cifti file as they are completed.  The memory used by the\n"
+       + indent9 + "input data and a block is limited to approximately the given\n"
+       + indent9 + "number of megabytes.  It is an error if the limit is less\n"
+       + indent9 + "than the input data and a block of 64 rows.\n"
+       + indent9 + "This option may not be used with the\n"
+       + indent9 + "\"-output-gifti-external-binary\" option.\n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -130,6 +150,9 @@ CommandCiftiCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcept
       parameters->getNextParameterAsString("Output Cifti File Name");
    bool applyFisherZTransformFlag = false;
    bool parallelFlag = false;
+   bool floatAccumulationFlag = false;
+   bool onDiskFlag = false;
+   int memoryLimitMegabytes = -1;
    QString outputGiftiFileName;
       
    //
@@ -147,6 +170,18 @@ CommandCiftiCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcept
       else if (paramName == "-parallel") {
          parallelFlag = true;
       }
+      else if (paramName == "-float-accumulation") {
+         floatAccumulationFlag = true;
+      }
+      else if (paramName == "-on-disk") {
+         onDiskFlag = true;
+      }
+      else if (paramName == "-memory-limit") {
+         memoryLimitMegabytes = parameters->getNextParameterAsInt("Memory Limit Megabytes");
+         if (memoryLimitMegabytes <= 0) {
+            throw CommandException("Memory limit must be greater than zero.");
+         }
+      }
       else if (paramName == "-output-gifti-external-binary") {
          outputGiftiFileName = parameters->getNextParameterAsString("Output Gifti File Name");
       }
@@ -154,6 +189,9 @@ CommandCiftiCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcept
          throw CommandException("Unrecognized parameter: " + paramName);
       }
    }      
+   if ((memoryLimitMegabytes > 0) && (outputGiftiFileName.isEmpty() == false)) {
+      throw CommandException("-memory-limit may not be used with -output-gifti-external-binary");
+   }
 
    //
    // Read the cifti file
@@ -162,7 +200,7 @@ CommandCiftiCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcept
  
    QTime readTimer;
    readTimer.start();
-   cf.openFile(inputCiftiFileName);
+   cf.openFile(inputCiftiFileName, (onDiskFlag ? ON_DISK : IN_MEMORY));
    if(DebugControl::getDebugOn()) 
       std::cout << "Time to read file "
                 << (readTimer.elapsed() * 0.001)
@@ -175,10 +213,22 @@ CommandCiftiCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcept
    BrainModelCiftiCorrelationMatrix* alg = NULL;
 
    BrainSet brainSet;
-   alg = new BrainModelCiftiCorrelationMatrix(&brainSet,
-                                                &cf,
-                                                applyFisherZTransformFlag,
-                                                parallelFlag);
+   if (memoryLimitMegabytes > 0) {
+      alg = new BrainModelCiftiCorrelationMatrix(&brainSet,
+                                                   &cf,
+                                                   outputCiftiFileName,
+                                                   memoryLimitMegabytes,
+                                                   applyFisherZTransformFlag,
+                                                   parallelFlag,
+                                                   floatAccumulationFlag);
+   }
+   else {
+      alg = new BrainModelCiftiCorrelationMatrix(&brainSet,
+                                                   &cf,
+                                                   applyFisherZTransformFlag,
+                                                   parallelFlag,
+                                                   floatAccumulationFlag);
+   }
 
    alg->execute();
    if(DebugControl::getDebugOn()) 
@@ -186,6 +236,14 @@ CommandCiftiCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcept
                 << (algTimer.elapsed() * 0.001)
                 << " seconds."
                 << std::endl;
+   
+   //
+   // Output file was written as it was computed
+   //
+   if (memoryLimitMegabytes > 0) {
+      delete alg;
+      return;
+   }
              
    
    //
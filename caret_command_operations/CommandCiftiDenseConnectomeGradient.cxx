@@ -86,6 +86,7 @@ CommandCiftiDenseConnectomeGradient::getHelpInformation() const
        + indent9 + "[-left-roi-override <left-roi>]\n"
        + indent9 + "[-right-roi-override <right-roi>]\n"
        + indent9 + "[-debug-output <debug>]\n"
+       + indent9 + "[-on-disk]\n"
        + indent9 + "\n"
        + indent9 + "Compute the correlation of the input cifti file rows within\n"
        + indent9 + "a structure, then take the gradient of the correlation and\n"
@@ -103,6 +104,9 @@ CommandCiftiDenseConnectomeGradient::getHelpInformation() const
        + indent9 + "files containing the raw correlation, smoothed correlation,\n"
        + indent9 + "and gradient.  Currently there is no such debug output for\n"
        + indent9 + "volumes.\n"
+       + indent9 + "\n"
+       + indent9 + "If \"-on-disk\" is specified, the input cifti file's matrix\n"
+       + indent9 + "is memory mapped instead of read into memory.\n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -137,7 +141,7 @@ CommandCiftiDenseConnectomeGradient::executeCommand() throw (BrainModelAlgorithm
       parameters->getNextParameterAsFloat("Surface Presmoothing Kernel");
    float volumeKernel =
       parameters->getNextParameterAsFloat("Volume Gradient Kernel");
-   bool avgNormals = false, overrideMode = false, debug = false;
+   bool avgNormals = false, overrideMode = false, debug = false, onDisk = false;
    MetricFile* leftROI = NULL, *rightROI = NULL;
    //
    // Process optional parameters
@@ -158,6 +162,8 @@ CommandCiftiDenseConnectomeGradient::executeCommand() throw (BrainModelAlgorithm
          rightROI->readFile(parameters->getNextParameterAsString("Right ROI Override"));
       } else if (identifier == QString("-debug-output")) {
          debug = parameters->getNextParameterAsBoolean("Debug Output");
+      } else if (identifier == QString("-on-disk")) {
+         onDisk = true;
       } else {
          throw CommandException(QString("Unrecognized optional argument: ") + identifier);
       }
@@ -170,7 +176,7 @@ CommandCiftiDenseConnectomeGradient::executeCommand() throw (BrainModelAlgorithm
  
    QTime readTimer;
    readTimer.start();
-   cf.openFile(inputCiftiFileName);
+   cf.openFile(inputCiftiFileName, (onDisk ? ON_DISK : IN_MEMORY));
    BrainSet leftSet(leftTopoName, leftCoordName);
    BrainSet rightSet(rightTopoName, rightCoordName);
    if(DebugControl::getDebugOn()) 
@@ -24,6 +24,7 @@
 /*LICENSE_END*/
 
 #include <iostream>
+#include <vector>
 
 #include <QFileInfo>
 #include <QTime>
@@ -36,6 +37,7 @@
 #include "FileUtilities.h"
 #include "FociProjectionFile.h"
 #include "FreeSurferSurfaceFile.h"
+#include "GiftiDataArray.h"
 #include "GiftiDataArrayFile.h"
 #include "MetricFile.h"
 #include "PreferencesFile.h"
@@ -46,6 +48,11 @@
 #include "TopologyFile.h"
 #include "VtkModelFile.h"
 
+#ifdef HAVE_VTK
+#include "vtkBase64Utilities.h"
+#include "vtkZLibDataCompressor.h"
+#endif // HAVE_VTK
+
 /**
  * constructor.
  */
@@ -55,6 +62,7 @@ CommandFileReadTime::CommandFileReadTime()
 {
    iterations = 3;
    numberOfThreads = 1;
+   decodeBenchmarkFlag = false;
 }
 
 /**
@@ -97,6 +105,7 @@ CommandFileReadTime::getHelpInformation() const
        + indent9 + "<filename>\n"
        + indent9 + "[-iter iterations]\n"
        + indent9 + "[-threads number-of-threads] \n"
+       + indent9 + "[-decode-benchmark] \n"
        + indent9 + "\n"
        + indent9 + "Time the reading of a caret data file.  Not all caret files\n"
        + indent9 + "are supported for this command.\n"
@@ -120,6 +129,12 @@ CommandFileReadTime::getHelpInformation() const
        + indent9 + "The number of threads parameter applied only to the \n"
        + indent9 + "reading of Spec Files.  The default number of threads \n"
        + indent9 + "is " + QString::number(numberOfThreads) + ". \n"
+       + indent9 + "\n"
+       + indent9 + "For GIFTI files (Generic, Metric, Surface Shape), the\n"
+       + indent9 + "\"-decode-benchmark\" option also times decoding of the\n"
+       + indent9 + "file's data after encoding it as Base64 Binary and GZip\n"
+       + indent9 + "Base64 Binary.  The previous (VTK) decoder and the \n"
+       + indent9 + "current decoder are both timed.\n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -147,6 +162,143 @@ CommandFileReadTime::readFileForTiming(AbstractFile* dataFile,
    fileSizeInMBOut = fi.size() / oneMegabyte;
 }
 
+/**
+ * time decoding of the GIFTI file's data as Base64 and GZip Base64.
+ */
+void 
+CommandFileReadTime::benchmarkGiftiDecoding(const GiftiDataArrayFile* gf)
+{
+#ifdef HAVE_VTK
+   //
+   // Concatenate the data of all data arrays
+   //
+   std::vector<unsigned char> data;
+   const int numArrays = gf->getNumberOfDataArrays();
+   for (int i = 0; i < numArrays; i++) {
+      const GiftiDataArray* gda = gf->getDataArray(i);
+      const unsigned char* ptr = NULL;
+      switch (gda->getDataType()) {
+         case GiftiDataArray::DATA_TYPE_FLOAT32:
+            ptr = (const unsigned char*)gda->getDataPointerFloat();
+            break;
+         case GiftiDataArray::DATA_TYPE_INT32:
+            ptr = (const unsigned char*)gda->getDataPointerInt();
+            break;
+         case GiftiDataArray::DATA_TYPE_UINT8:
+            ptr = (const unsigned char*)gda->getDataPointerUByte();
+            break;
+      }
+      if (ptr != NULL) {
+         data.insert(data.end(), ptr, ptr + gda->getDataSizeInBytes());
+      }
+   }
+   if (data.empty()) {
+      return;
+   }
+   const unsigned long dataLength = data.size();
+   
+   //
+   // Encode the data as Base64 and as GZip Base64
+   //
+   std::vector<unsigned char> base64Buffer(dataLength * 2 + 4);
+   const unsigned long base64Length =
+      vtkBase64Utilities::Encode(&data[0], dataLength, &base64Buffer[0]);
+   const QString base64Text = 
+      QString::fromAscii((const char*)&base64Buffer[0], base64Length);
+      
+   vtkZLibDataCompressor* compressor = vtkZLibDataCompressor::New();
+   std::vector<unsigned char> compressedBuffer(
+      compressor->GetMaximumCompressionSpace(dataLength));
+   const unsigned long compressedLength =
+      compressor->Compress(&data[0], dataLength,
+                           &compressedBuffer[0], compressedBuffer.size());
+   std::vector<unsigned char> compressedBase64Buffer(compressedLength * 2 + 4);
+   const unsigned long compressedBase64Length =
+      vtkBase64Utilities::Encode(&compressedBuffer[0], compressedLength, 
+                                 &compressedBase64Buffer[0]);
+   const QString compressedBase64Text = 
+      QString::fromAscii((const char*)&compressedBase64Buffer[0], 
+                         compressedBase64Length);
+
+   //
+   // Time each decoder, the previous decoder converted the text to ASCII first
+   //
+   std::vector<unsigned char> output(dataLength);
+   float vtkBase64Time = 0.0;
+   float base64Time = 0.0;
+   float vtkCompressedTime = 0.0;
+   float compressedTime = 0.0;
+   QTime timer;
+   for (int i = 0; i < iterations; i++) {
+      timer.start();
+      {
+         const QByteArray ba = base64Text.toAscii();
+         vtkBase64Utilities::Decode((const unsigned char*)ba.constData(),
+                                    dataLength,
+                                    &output[0]);
+      }
+      vtkBase64Time += timer.elapsed() / 1000.0;
+      
+      timer.start();
+      if (GiftiDataArray::decodeBase64(base64Text.constData(),
+                                       base64Text.length(),
+                                       &output[0],
+                                       dataLength) != dataLength) {
+         throw CommandException("Base64 decoding failed.");
+      }
+      base64Time += timer.elapsed() / 1000.0;
+      
+      timer.start();
+      {
+         const QByteArray ba = compressedBase64Text.toAscii();
+         std::vector<unsigned char> decoded(compressedLength);
+         vtkBase64Utilities::Decode((const unsigned char*)ba.constData(),
+                                    compressedLength,
+                                    &decoded[0]);
+         compressor->Uncompress(&decoded[0], compressedLength,
+                                &output[0], dataLength);
+      }
+      vtkCompressedTime += timer.elapsed() / 1000.0;
+      
+      timer.start();
+      GiftiDataArray::decodeCompressedBase64(compressedBase64Text.constData(),
+                                             compressedBase64Text.length(),
+                                             &output[0],
+                                             dataLength);
+      compressedTime += timer.elapsed() / 1000.0;
+   }
+   compressor->Delete();
+   
+   const float dataSizeMB = dataLength / 1048576.0;
+   const float numIter = static_cast<float>(iterations);
+   const QString names[4] = { 
+      "Base64 (VTK)", 
+      "Base64", 
+      "GZip Base64 (VTK)",
+      "GZip Base64"
+   };
+   const float times[4] = {
+      vtkBase64Time / numIter,
+      base64Time / numIter,
+      vtkCompressedTime / numIter,
+      compressedTime / numIter
+   };
+   std::cout << "   Decoding of " << dataSizeMB << " MB of data:" << std::endl;
+   for (int i = 0; i < 4; i++) {
+      std::cout << "      " << names[i].toAscii().constData()
+                << ": " << times[i] << " seconds";
+      if (times[i] > 0.0) {
+         std::cout << " (" << (dataSizeMB / times[i]) << " MB/s)";
+      }
+      std::cout << std::endl;
+   }
+#else  // HAVE_VTK
+   std::cout << "   Decode benchmark requires VTK ("
+             << gf->getNumberOfDataArrays() 
+             << " data arrays not timed)." << std::endl;
+#endif // HAVE_VTK
+}
+
 /**
  * execute the command.
  */
@@ -169,6 +321,9 @@ CommandFileReadTime::executeCommand() throw (BrainModelAlgorithmException,
       else if (paramName == "-threads") {
          numberOfThreads = parameters->getNextParameterAsInt("Number of Threads");
       }
+      else if (paramName == "-decode-benchmark") {
+         decodeBenchmarkFlag = true;
+      }
       else {
          throw CommandException("Unrecognized parameter: " + paramName);
       }
@@ -204,14 +359,23 @@ CommandFileReadTime::executeCommand() throw (BrainModelAlgorithmException,
    else if (fileName.endsWith(".func.gii")) {
       MetricFile mf;
       readFileForTiming(&mf, fileName, timeInSeconds, fileSizeInMB);
+      if (decodeBenchmarkFlag) {
+         benchmarkGiftiDecoding(&mf);
+      }
    }
    else if (fileName.endsWith(SpecFile::getGiftiGenericFileExtension())) {
       GiftiDataArrayFile gifti;
       readFileForTiming(&gifti, fileName, timeInSeconds, fileSizeInMB);
+      if (decodeBenchmarkFlag) {
+         benchmarkGiftiDecoding(&gifti);
+      }
    }
    else if (fileName.endsWith(SpecFile::getMetricFileExtension())) {
       MetricFile mf;
       readFileForTiming(&mf, fileName, timeInSeconds, fileSizeInMB);
+      if (decodeBenchmarkFlag) {
+         benchmarkGiftiDecoding(&mf);
+      }
    }
    else if (fileName.endsWith(SpecFile::getSpecFileExtension())) {
       for (int i = 0; i < iterations; i++) {
@@ -239,6 +403,9 @@ CommandFileReadTime::executeCommand() throw (BrainModelAlgorithmException,
    else if (fileName.endsWith(SpecFile::getSurfaceShapeFileExtension())) {
       SurfaceShapeFile ssf;
       readFileForTiming(&ssf, fileName, timeInSeconds, fileSizeInMB);
+      if (decodeBenchmarkFlag) {
+         benchmarkGiftiDecoding(&ssf);
+      }
    }
    else if (fileName.endsWith(SpecFile::getTopoFileExtension())) {
       TopologyFile tf;
@@ -30,6 +30,7 @@
 #include "CommandBase.h"
 
 class AbstractFile;
+class GiftiDataArrayFile;
 
 /// class for
 class CommandFileReadTime : public CommandBase {
@@ -59,12 +60,18 @@ class CommandFileReadTime : public CommandBase {
                              const QString& fileName,
                              float& timeToReadOut,
                              float& fileSizeInMBOut);
+      
+      // time decoding of the GIFTI file's data as Base64 and GZip Base64
+      void benchmarkGiftiDecoding(const GiftiDataArrayFile* gf);
                               
       /// iterations of file reading
       int iterations;
       
       /// number of threads
       int numberOfThreads;
+      
+      /// benchmark GIFTI data decoding
+      bool decodeBenchmarkFlag;
 };
 
 #endif // __COMMAND_FILE_READ_TIME_H__
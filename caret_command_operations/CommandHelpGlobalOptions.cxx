@@ -35,6 +35,7 @@
 #include "MetricFile.h"
 #include "ProgramParameters.h"
 #include "ScriptBuilderParameters.h"
+#include "VolumeFile.h"
 
 /**
  * constructor.
@@ -114,6 +115,13 @@ CommandHelpGlobalOptions::getHelpInformation() const
        + indent9 + "sets the format for writing metric files.  One and only one\n"
        + indent9 + "format must be specified.\n"
        + indent9 + "\n"
+       + indent9 + "Adding the parameter \"-WRITE-NIFTI-GZIP-BLOCKS\" writes\n"
+       + indent9 + "compressed NIFTI volumes (.nii.gz) as a sequence of \n"
+       + indent9 + "independently compressed gzip blocks.  The blocks are \n"
+       + indent9 + "compressed in parallel and, when the file is read by Caret,\n"
+       + indent9 + "decompressed in parallel.  The file remains a valid gzip \n"
+       + indent9 + "file that other software (gunzip, FSL, AFNI) can read.\n"
+       + indent9 + "\n"
        + indent9 + "Available file formats are:\n");
    for (unsigned int i = 0; i < fileFormatNames.size(); i++) {
        helpInfo +=
@@ -149,6 +157,7 @@ CommandHelpGlobalOptions::processGlobalOptions(ProgramParameters& params) throw
    processSetRandomSeedCommand(params);
    processFileWritingFormat(params);
    processMetricFileWritingFormat(params);
+   processNiftiGzipBlockWriting(params);
 }
 
 /**
@@ -402,3 +411,19 @@ CommandHelpGlobalOptions::processMetricFileWritingFormat(ProgramParameters& para
 }
       
 
+/**
+ * process the NIFTI gzip block writing option.
+ */
+void 
+CommandHelpGlobalOptions::processNiftiGzipBlockWriting(ProgramParameters& params) throw (CommandException)
+{
+   const int blocksIndex = params.getIndexOfParameterWithValue("-WRITE-NIFTI-GZIP-BLOCKS");
+   if (blocksIndex >= 0) {
+      VolumeFile::setNiftiGzipBlockWritingEnabled(true);
+      
+      //
+      // Remove the "-WRITE-NIFTI-GZIP-BLOCKS" parameter
+      //
+      params.removeParameterAtIndex(blocksIndex);
+   }
+}
@@ -66,6 +66,9 @@ class CommandHelpGlobalOptions : public CommandBase {
       // process the METRIC file writing format preference
       static void processMetricFileWritingFormat(ProgramParameters& params) throw (CommandException);
       
+      // process the NIFTI gzip block writing option
+      static void processNiftiGzipBlockWriting(ProgramParameters& params) throw (CommandException);
+      
       // execute the command
       void executeCommand() throw (BrainModelAlgorithmException,
                                    CommandException,
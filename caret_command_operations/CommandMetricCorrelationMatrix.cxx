@@ -76,6 +76,7 @@ CommandMetricCorrelationMatrix::getHelpInformation() const
        + indent9 + "<output-metric-file-name>\n"
        + indent9 + "[-apply-fisher-z-transform]\n"
        + indent9 + "[-parallel]\n"
+       + indent9 + "[-float-accumulation]\n"
        + indent9 + "\n"
        + indent9 + "Compute a correlation matrix using the input metric file.\n"
        + indent9 + "Each row (node) in the metric file is correlated with all\n"
@@ -101,6 +102,10 @@ CommandMetricCorrelationMatrix::getHelpInformation() const
        + indent9 + "If the \"-parallel\" option is specified, the algorithm\n"
        + indent9 + "will run its operations with multiple threads to reduce\n"
        + indent9 + "execution time.\n"
+       + indent9 + "\n"
+       + indent9 + "If the \"-float-accumulation\" option is specified, the\n"
+       + indent9 + "correlations are accumulated in single precision which is\n"
+       + indent9 + "faster but less accurate than the default double precision.\n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -125,6 +130,7 @@ CommandMetricCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcep
       parameters->getNextParameterAsString("Output Metric File Name");
    bool applyFisherZTransformFlag = false;
    bool parallelFlag = false;
+   bool floatAccumulationFlag = false;
    bool giftiFlag = true;
    bool incrementalFlag = true;
    
@@ -143,6 +149,9 @@ CommandMetricCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcep
       else if (paramName == "-parallel") {
          parallelFlag = true;
       }
+      else if (paramName == "-float-accumulation") {
+         floatAccumulationFlag = true;
+      }
       else {
          throw CommandException("Unrecognized parameter: " + paramName);
       }
@@ -170,7 +179,8 @@ CommandMetricCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcep
                                                          outputMetricFileName,
                                                          applyFisherZTransformFlag,
                                                          giftiFlag,
-                                                         parallelFlag);
+                                                         parallelFlag,
+                                                         floatAccumulationFlag);
    }
    else {
       BrainSet brainSet;
@@ -178,7 +188,8 @@ CommandMetricCorrelationMatrix::executeCommand() throw (BrainModelAlgorithmExcep
                                                    &mf,
                                                    applyFisherZTransformFlag,
                                                    giftiFlag,
-                                                   parallelFlag);
+                                                   parallelFlag,
+                                                   floatAccumulationFlag);
    }
    alg->execute();
    std::cout << "Time to run algorithm "
@@ -23,6 +23,8 @@
  */
 /*LICENSE_END*/
 
+#include <QDir>
+
 #include "BrainModelSurfaceMetricSmoothing.h"
 #include "BrainModelSurfaceMetricSmoothingAll.h"
 #include "BrainSet.h"
@@ -105,6 +107,8 @@ CommandMetricSmoothing::getHelpInformation() const
        + indent9 + "\n"
        + indent9 + "[-parallel]\n"
        + indent9 + "\n"
+       + indent9 + "[-cache-dir  directory-name]\n"
+       + indent9 + "\n"
        + indent9 + "Smooth metric data.\n"
        + indent9 + "\n"
        + indent9 + "\"smoothing-algorithm\" is one of:\n"
@@ -120,6 +124,13 @@ CommandMetricSmoothing::getHelpInformation() const
        + indent9 + "      iterations.  The intent is to do one iteration of\n"
        + indent9 + "      smoothing, with the sigma specifying how much smoother\n"
        + indent9 + "      the metric is desired to be.\n"
+       + indent9 + "\n"
+       + indent9 + "   \"-cache-dir\" specifies a directory in which the smoothing\n"
+       + indent9 + "      weights (neighborhoods) are saved.  Later smoothing with\n"
+       + indent9 + "      the same surface, algorithm, and parameters reads the\n"
+       + indent9 + "      weights from the directory instead of computing them,\n"
+       + indent9 + "      which is much faster for Geodesic Gaussian.  Not used\n"
+       + indent9 + "      by DILATE and FWHM.\n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -159,6 +170,7 @@ CommandMetricSmoothing::executeCommand() throw (BrainModelAlgorithmException,
    float gaussTangCutoff = 3.0;
    float geoGaussSigma = 2.0;
    bool parallelFlag = false;
+   QString cacheDirectoryName;
    while (parameters->getParametersAvailable()) {
       const QString paramValue = parameters->getNextParameterAsString("Smoothing Parameter");
       if (paramValue == "-fwhm") {
@@ -186,11 +198,22 @@ CommandMetricSmoothing::executeCommand() throw (BrainModelAlgorithmException,
       else if (paramValue == "-parallel") {
          parallelFlag = true;
       }
+      else if (paramValue == "-cache-dir") {
+         cacheDirectoryName = 
+            parameters->getNextParameterAsString("Smoothing Cache Directory");
+      }
       else {
          throw CommandException("Unrecognized parameter: " + paramValue);
       }
    }
    
+   if (cacheDirectoryName.isEmpty() == false) {
+      if (QDir(cacheDirectoryName).exists() == false) {
+         throw CommandException("Smoothing cache directory does not exist: "
+                                + cacheDirectoryName);
+      }
+   }
+   
    //
    // Get algorithm
    //
@@ -280,6 +303,7 @@ CommandMetricSmoothing::executeCommand() throw (BrainModelAlgorithmException,
                    gaussTangCutoff,
                    geoGaussSigma,
                    parallelFlag);
+      smoothing.setOperatorCacheDirectoryName(cacheDirectoryName);
       smoothing.execute();
    }
    else {
@@ -305,6 +329,7 @@ CommandMetricSmoothing::executeCommand() throw (BrainModelAlgorithmException,
                                                       gaussSigmaTang,
                                                       gaussTangCutoff,
                                                       geoGaussSigma);
+         smoothing.setOperatorCacheDirectoryName(cacheDirectoryName);
          smoothing.execute();
       }
    }
@@ -114,6 +114,7 @@ CommandMetricStatisticsTwoSampleTTest::getHelpInformation() const
        + indent9 + "        <b-do-tmap-DOF>   \n"
        + indent9 + "        <b-do-tmap-pvalue>  \n"
        + indent9 + "        <number-of-threads>  \n"
+       + indent9 + "        [-no-shuffled-tmap-file]  \n"
        + indent9 + "         \n"
        + indent9 + "     Perform a two-sample T-Test or perform a Wilcoxon Rank-Sum of the  \n"
        + indent9 + "     data and then perform the T-Test. \n"
@@ -135,6 +136,11 @@ CommandMetricStatisticsTwoSampleTTest::getHelpInformation() const
        + indent9 + "     Users on systems with multiple processors or multi-core systems \n"
        + indent9 + "     should set the number of threads to the number of processors \n"
        + indent9 + "     and/or cores to reduce execution time. \n"
+       + indent9 + "      \n"
+       + indent9 + "     With POOLED and UNPOOLED variance, each shuffled T-Map is \n"
+       + indent9 + "     clustered as it is computed and only its largest cluster and \n"
+       + indent9 + "     maximum T are kept.  Use \"-no-shuffled-tmap-file\" so that the \n"
+       + indent9 + "     shuffled T-Maps are not stored and written to a file. \n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -186,7 +192,17 @@ CommandMetricStatisticsTwoSampleTTest::executeCommand() throw (BrainModelAlgorit
       parameters->getNextParameterAsBoolean("Do T-MAP P-Value");
    const int numberOfThreads = 
       parameters->getNextParameterAsInt("Number of Threads");
-   checkForExcessiveParameters();
+   bool writeShuffledTMapFileFlag = true;
+   while (parameters->getParametersAvailable()) {
+      const QString paramName = 
+         parameters->getNextParameterAsString("Optional T-Test Parameter");
+      if (paramName == "-no-shuffled-tmap-file") {
+         writeShuffledTMapFileFlag = false;
+      }
+      else {
+         throw CommandException("Unrecognized parameter: " + paramName);
+      }
+   }
 
    BrainModelSurfaceMetricTwoSampleTTest::DATA_TRANSFORM_MODE dataTransformMode;
    if (dataTransformModeName == "NO_TRANSFORM") {
@@ -225,7 +241,10 @@ CommandMetricStatisticsTwoSampleTTest::executeCommand() throw (BrainModelAlgorit
                        ? SpecFile::getMetricFileExtension()
                        : SpecFile::getSurfaceShapeFileExtension();
    const QString outputTMapFileName(outputFileNamePrefix + "_TMap" + ext);
-   const QString outputShuffledTMapFileName(outputFileNamePrefix + "_ShuffledTMap" + ext);
+   QString outputShuffledTMapFileName;
+   if (writeShuffledTMapFileFlag) {
+      outputShuffledTMapFileName = outputFileNamePrefix + "_ShuffledTMap" + ext;
+   }
    const QString outputPaintFileName(outputFileNamePrefix + "_TMapClusters" + SpecFile::getPaintFileExtension());
    const QString outputMetricFileName(outputFileNamePrefix + "_TMapClusters" + SpecFile::getMetricFileExtension());
    const QString outputReportFileName(outputFileNamePrefix + "_TMap_Significant_Clusters" + SpecFile::getTextFileExtension());
@@ -471,13 +471,14 @@ void CommandMyelinMapping::doRawMapping(BrainModelSurface* surface,
    thicknessCleanup.discardIslands(surface);//discards outside artifacts
    thicknessCleanup.invertSelectedNodes(surface);//now everything except medial wall, plus artifacts inside
    thicknessCleanup.discardIslands(surface);//discard artifacts inside medial wall
+   GeodesicHelperBase mygeobase(mycoords, mytopo);//distances are computed once, threads only allocate their own scratch arrays
 #ifdef _OPENMP
 #pragma omp parallel
 #endif
    {
       float tempf;
-      GeodesicHelper mygeohelp(mycoords, mytopo);//this should probably be consolidated across the two places it is done, but that will be tough
-      vector<int> nodeslist;//better solution: a GeodesicHelperBase that contains the disntaces, and GeodesicHelper contains the mutex and local arrays only
+      GeodesicHelper mygeohelp(&mygeobase);
+      vector<int> nodeslist;
       vector<float> distancelist;
       float totalweight, weight, weightedsum;
 #ifdef _OPENMP
@@ -659,6 +660,7 @@ void CommandMyelinMapping::doCorrection(BrainModelSurface* surface,
       debug->setValue(i, 1, 0.0f);
    }
    long long zeroNodes = 0, nodesFaked = 0, nodesInCortex = 0, nodesConsidered = 0, nodesRejected = 0, zeroNeighbors = 0;
+   GeodesicHelperBase mygeobase(surface->getCoordinateFile(), surface->getTopologyFile());
 #ifdef _OPENMP
 #pragma omp parallel reduction(+: zeroNodes, nodesFaked, nodesInCortex, nodesConsidered, nodesRejected, zeroNeighbors)
 #endif
@@ -666,7 +668,7 @@ void CommandMyelinMapping::doCorrection(BrainModelSurface* surface,
       vector<int> neighbors;
       vector<float> geodists;
       float tempf, tempf2;
-      GeodesicHelper mygeohelp(surface->getCoordinateFile(), surface->getTopologyFile());
+      GeodesicHelper mygeohelp(&mygeobase);
       TopologyHelper mytopohelp(surface->getTopologyFile(), false, true, false);
 #ifdef _OPENMP
 #pragma omp for
@@ -76,6 +76,7 @@ CommandSurfaceGenerateInflated::getHelpInformation() const
        + indent9 + "<input-closed-topology-file-name> \n"
        + indent9 + "[-compression-factor value] \n"
        + indent9 + "[-iterations-scale  value] \n"
+       + indent9 + "[-multiresolution] \n"
        + indent9 + "[-generate-inflated] \n"
        + indent9 + "[-generate-very-inflated] \n"
        + indent9 + "[-generate-ellipsoid] \n"
@@ -108,6 +109,11 @@ CommandSurfaceGenerateInflated::getHelpInformation() const
        + indent9 + "surfaces produced by FreeSurfer often contain a large\n"
        + indent9 + "number of nodes, 150,000 or more.  In this case, try\n"
        + indent9 + "an \"iterations-scale\" of 2.5.\n"
+       + indent9 + "\n"
+       + indent9 + "Use \"-multiresolution\" to do most of the smoothing on\n"
+       + indent9 + "coarser versions of the surface.  This is much faster\n"
+       + indent9 + "and the surfaces are similar but not identical to the \n"
+       + indent9 + "surfaces produced without the option.\n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -141,6 +147,7 @@ CommandSurfaceGenerateInflated::executeCommand() throw (BrainModelAlgorithmExcep
    bool createCompMedWallFlag = false;
    float iterationsScale = 1.0;  
    float compressionFactor = 0.95;
+   bool multiresolutionFlag = false;
    QString outputSpecFileName;
    QString inflatedCoordinateFileName;
    QString veryInflateCoordinateFileName;
@@ -162,6 +169,9 @@ CommandSurfaceGenerateInflated::executeCommand() throw (BrainModelAlgorithmExcep
       else if (paramName == "-iterations-scale") {
          iterationsScale = parameters->getNextParameterAsFloat("Iterations Scale Value");
       }
+      else if (paramName == "-multiresolution") {
+         multiresolutionFlag = true;
+      }
       else if (paramName == "-generate-inflated") {
          createInflatedFlag = true;
       }
@@ -237,7 +247,8 @@ CommandSurfaceGenerateInflated::executeCommand() throw (BrainModelAlgorithmExcep
                                                            scaleToMatchFiduciaFlag,
                                                            iterationsScale,
                                                            NULL,
-                                                           compressionFactor);
+                                                           compressionFactor,
+                                                           multiresolutionFlag);
    //
    // Write the output files
    //
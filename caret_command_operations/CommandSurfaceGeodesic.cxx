@@ -26,6 +26,8 @@
 #include <iostream>
 #include <fstream>
 
+#include <QFile>
+
 #include "CommandSurfaceGeodesic.h"
 #include "FileFilters.h"
 #include "ProgramParameters.h"
@@ -36,6 +38,7 @@
 #include "MetricFile.h"
 #include "CoordinateFile.h"
 #include "TopologyFile.h"
+#include "GeodesicDistanceFile.h"
 #include "GeodesicHelper.h"
 
 /**
@@ -82,6 +85,9 @@ CommandSurfaceGeodesic::getHelpInformation() const
        + indent9 + "<output-metric>\n"
        + indent9 + "<smoothed>\n"
        + indent9 + "[-node  node-number]\n"
+       + indent9 + "[-geodesic-file]\n"
+       + indent9 + "[-binary-matrix]\n"
+       + indent9 + "[-cutoff  distance]\n"
        + indent9 + "\n"
        + indent9 + "Generate the geodesic distance from all nodes to all other nodes\n"
        + indent9 + "unless a node number is specified in which case the distances are\n"
@@ -101,6 +107,28 @@ CommandSurfaceGeodesic::getHelpInformation() const
        + indent9 + "\n"
        + indent9 + "      smoothed           output smoothed distances by using 2hop neighbors\n"
        + indent9 + "\n"
+       + indent9 + "When all to all distances are computed, roots are processed in\n"
+       + indent9 + "parallel and each row is stored as soon as it is finished.\n"
+       + indent9 + "The following options change what is written to the output file\n"
+       + indent9 + "(instead of a metric file):\n"
+       + indent9 + "\n"
+       + indent9 + "      -geodesic-file     a geodesic distance file (with parents)\n"
+       + indent9 + "\n"
+       + indent9 + "      -binary-matrix     a binary matrix of 32-bit floats, a row of\n"
+       + indent9 + "                         number-of-nodes values for each root node,\n"
+       + indent9 + "                         -1 for unconnected nodes.  The file is\n"
+       + indent9 + "                         memory mapped so the matrix may be larger\n"
+       + indent9 + "                         than memory.\n"
+       + indent9 + "\n"
+       + indent9 + "      -cutoff            only distances up to 'distance' are written,\n"
+       + indent9 + "                         as a binary file containing the 32-bit\n"
+       + indent9 + "                         integer number of nodes, followed by a\n"
+       + indent9 + "                         record for each root node: the integer\n"
+       + indent9 + "                         root node, the integer count of nodes, the\n"
+       + indent9 + "                         count integer node numbers, and the count\n"
+       + indent9 + "                         float distances.  Records are in the order\n"
+       + indent9 + "                         they finish, not root node order.\n"
+       + indent9 + "\n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -125,20 +153,44 @@ CommandSurfaceGeodesic::executeCommand() throw (BrainModelAlgorithmException,
    const bool smooth =
       parameters->getNextParameterAsBoolean("Smoothing");
    int nodeNumber = -1;
+   bool geodesicFileFlag = false;
+   bool binaryMatrixFlag = false;
+   float cutoff = -1.0;
    while (parameters->getParametersAvailable()) {
       QString paramName = parameters->getNextParameterAsString("Geodesic Parameter");
       if (paramName == "-node") {
          nodeNumber = parameters->getNextParameterAsInt("Node Number");
       }
+      else if (paramName == "-geodesic-file") {
+         geodesicFileFlag = true;
+      }
+      else if (paramName == "-binary-matrix") {
+         binaryMatrixFlag = true;
+      }
+      else if (paramName == "-cutoff") {
+         cutoff = parameters->getNextParameterAsFloat("Cutoff Distance");
+         if (cutoff < 0.0) {
+            throw CommandException("Cutoff distance must not be negative.");
+         }
+      }
       else {
          throw CommandException("Invalid Parameter: " + paramName);
       }   
    }
+   if ((static_cast<int>(geodesicFileFlag) 
+        + static_cast<int>(binaryMatrixFlag) 
+        + static_cast<int>(cutoff >= 0.0)) > 1) {
+      throw CommandException("Only one of -geodesic-file, -binary-matrix, and -cutoff may be used.");
+   }
+   if ((nodeNumber >= 0) &&
+       (geodesicFileFlag || binaryMatrixFlag || (cutoff >= 0.0))) {
+      throw CommandException("-node may not be used with -geodesic-file, -binary-matrix, or -cutoff.");
+   }
    BrainSet mybs(topo, coord);//yes, its hideous, but the BrainSet constructor is such an easy way to load them
    BrainModelSurface* mysurf = mybs.getBrainModelSurface(0);
    int numNodes = mysurf->getCoordinateFile()->getNumberOfNodes();
-   GeodesicHelper gh(mysurf->getCoordinateFile(), mysurf->getTopologyFile());
    if (nodeNumber >= 0) {
+      GeodesicHelper gh(mysurf->getCoordinateFile(), mysurf->getTopologyFile());
 #ifdef _USE_STL_FOR_DATA_
       std::vector<int> allNodeIndices;
       allNodeIndices.reserve(numNodes);
@@ -168,23 +220,322 @@ CommandSurfaceGeodesic::executeCommand() throw (BrainModelAlgorithmException,
 #endif
    }
    else {
-      float** result = gh.getGeoAllToAll(smooth);//PASSES BACK ALLOCATED MEMORY, we must delete[] all of it
-      //was more convinient to write the code to catch malloc failures into that function, does not crash if failed, merely deallocates
-      //everything that it succeeded in allocating, then returns NULL
-      if (result != NULL)//happens if memory runs out
-      {
+      //
+      // Surface graph is shared by the threads, rows are stored as they finish
+      //
+      GeodesicHelperBase geodesicBase(mysurf->getCoordinateFile(), mysurf->getTopologyFile());
+      if (geodesicBase.getNumberOfNodes() != numNodes) {
+         throw CommandException("Coordinate and topology files have different numbers of nodes.");
+      }
+      
+      if (cutoff >= 0.0) {
+         SparseRowReceiver receiver(metricName, numNodes);
+         GeodesicHelper::getGeoAllToAllRows(&geodesicBase, &receiver, cutoff, smooth);
+         receiver.close();
+      }
+      else if (binaryMatrixFlag) {
+         BinaryMatrixRowReceiver receiver(metricName, numNodes);
+         GeodesicHelper::getGeoAllToAllRows(&geodesicBase, &receiver, -1.0, smooth);
+      }
+      else if (geodesicFileFlag) {
+         GeodesicDistanceFile geodesicFile;
+         geodesicFile.setNumberOfNodesAndColumns(numNodes, numNodes);
+         GeodesicDistanceFileRowReceiver receiver(&geodesicFile);
+         GeodesicHelper::getGeoAllToAllRows(&geodesicBase, &receiver, -1.0, smooth);
          std::cout << "saving to " << metricName.toLocal8Bit().constData() << "..." << std::endl;
+         geodesicFile.writeFile(metricName);
+      }
+      else {
          MetricFile mymetric;
          mymetric.setNumberOfNodesAndColumns(numNodes, numNodes);
-         for (int i = 0; i < numNodes; ++i)
-         {
-            mymetric.setColumnForAllNodes(i, result[i]);
-            delete[] result[i];
-         }
-         delete[] result;
+         MetricRowReceiver receiver(&mymetric);
+         GeodesicHelper::getGeoAllToAllRows(&geodesicBase, &receiver, -1.0, smooth);
+         std::cout << "saving to " << metricName.toLocal8Bit().constData() << "..." << std::endl;
          mymetric.writeFile(metricName);
-      } else {
-         std::cerr << "getGeoAllToAll() failed." << std::endl;
       }
    }
 }
+
+//***************************************************************************************
+
+/**
+ * constructor.
+ */
+CommandSurfaceGeodesic::ProgressRowReceiver::ProgressRowReceiver(const int numberOfNodesIn)
+{
+   numberOfNodes = numberOfNodesIn;
+   numberOfRowsReceived = 0;
+   numberOfDots = 0;
+   std::cout << "|0%      calculating geodesic distances      100%|" << std::endl;
+}
+
+/**
+ * destructor.
+ */
+CommandSurfaceGeodesic::ProgressRowReceiver::~ProgressRowReceiver()
+{
+}
+
+/**
+ * update the progress after a row is received.
+ */
+void 
+CommandSurfaceGeodesic::ProgressRowReceiver::rowReceived()
+{
+   numberOfRowsReceived++;
+   const int dots = (50 * numberOfRowsReceived) / numberOfNodes;
+   while (numberOfDots < dots) {
+      std::cout << '.';
+      std::cout.flush();
+      numberOfDots++;
+   }
+   if (numberOfRowsReceived == numberOfNodes) {
+      std::cout << std::endl;
+   }
+}
+
+//***************************************************************************************
+
+/**
+ * constructor.
+ */
+CommandSurfaceGeodesic::MetricRowReceiver::MetricRowReceiver(MetricFile* metricFileIn)
+   : ProgressRowReceiver(metricFileIn->getNumberOfNodes())
+{
+   metricFile = metricFileIn;
+}
+
+/**
+ * receive a full row (stored in the root's column).
+ */
+void 
+CommandSurfaceGeodesic::MetricRowReceiver::receiveRow(const int root, 
+                                                      const float* distances, 
+                                                      const int* /*parents*/)
+{
+   metricFile->setColumnForAllNodes(root, distances);
+   metricFile->setColumnName(root, "Node " + QString::number(root));
+   rowReceived();
+}
+
+/**
+ * receive a sparse row (nodes not in the row are -1).
+ */
+void 
+CommandSurfaceGeodesic::MetricRowReceiver::receiveRow(const int root, 
+                                                      const std::vector<int>& nodes, 
+                                                      const std::vector<float>& distances)
+{
+   std::vector<float> values(numberOfNodes, -1.0);
+   for (unsigned int i = 0; i < nodes.size(); i++) {
+      values[nodes[i]] = distances[i];
+   }
+   metricFile->setColumnForAllNodes(root, values);
+   metricFile->setColumnName(root, "Node " + QString::number(root));
+   rowReceived();
+}
+
+//***************************************************************************************
+
+/**
+ * constructor.
+ */
+CommandSurfaceGeodesic::GeodesicDistanceFileRowReceiver::GeodesicDistanceFileRowReceiver(
+                                                   GeodesicDistanceFile* geodesicFileIn)
+   : ProgressRowReceiver(geodesicFileIn->getNumberOfNodes())
+{
+   geodesicFile = geodesicFileIn;
+}
+
+/**
+ * receive a full row (stored in the root's column).
+ */
+void 
+CommandSurfaceGeodesic::GeodesicDistanceFileRowReceiver::receiveRow(const int root, 
+                                                                    const float* distances, 
+                                                                    const int* parents)
+{
+   geodesicFile->setRootNode(root, root);
+   geodesicFile->setColumnName(root, "Node " + QString::number(root));
+   for (int i = 0; i < numberOfNodes; i++) {
+      geodesicFile->setNodeParentDistance(i, root, distances[i]);
+      geodesicFile->setNodeParent(i, root, ((parents != NULL) ? parents[i] : -1));
+   }
+   rowReceived();
+}
+
+/**
+ * receive a sparse row (nodes not in the row have no parent).
+ */
+void 
+CommandSurfaceGeodesic::GeodesicDistanceFileRowReceiver::receiveRow(const int root, 
+                                                                    const std::vector<int>& nodes, 
+                                                                    const std::vector<float>& distances)
+{
+   geodesicFile->setRootNode(root, root);
+   geodesicFile->setColumnName(root, "Node " + QString::number(root));
+   for (int i = 0; i < numberOfNodes; i++) {
+      geodesicFile->setNodeParentDistance(i, root, -1.0);
+      geodesicFile->setNodeParent(i, root, -1);
+   }
+   for (unsigned int i = 0; i < nodes.size(); i++) {
+      geodesicFile->setNodeParentDistance(nodes[i], root, distances[i]);
+   }
+   rowReceived();
+}
+
+//***************************************************************************************
+
+/**
+ * constructor (creates and maps the file).
+ */
+CommandSurfaceGeodesic::BinaryMatrixRowReceiver::BinaryMatrixRowReceiver(const QString& fileName,
+                                                                         const int numberOfNodesIn)
+                                                                       throw (FileException)
+   : ProgressRowReceiver(numberOfNodesIn)
+{
+   matrix = NULL;
+   file = new QFile(fileName);
+   if (file->open(QFile::ReadWrite | QFile::Truncate) == false) {
+      const QString msg = file->errorString();
+      delete file;
+      throw FileException(fileName, msg);
+   }
+   
+   const qint64 numBytes = static_cast<qint64>(numberOfNodes) 
+                         * numberOfNodes * sizeof(float);
+   if (file->resize(numBytes)) {
+      matrix = (float*)file->map(0, numBytes);
+   }
+   if (matrix == NULL) {
+      const QString msg = file->errorString();
+      file->close();
+      delete file;
+      throw FileException(fileName, "Unable to map geodesic matrix: " + msg);
+   }
+}
+
+/**
+ * destructor.
+ */
+CommandSurfaceGeodesic::BinaryMatrixRowReceiver::~BinaryMatrixRowReceiver()
+{
+   file->unmap((uchar*)matrix);
+   file->close();
+   delete file;
+}
+
+/**
+ * receive a full row.
+ */
+void 
+CommandSurfaceGeodesic::BinaryMatrixRowReceiver::receiveRow(const int root, 
+                                                            const float* distances, 
+                                                            const int* /*parents*/)
+{
+   float* row = &matrix[static_cast<qint64>(root) * numberOfNodes];
+   for (int i = 0; i < numberOfNodes; i++) {
+      row[i] = distances[i];
+   }
+   rowReceived();
+}
+
+/**
+ * receive a sparse row (nodes not in the row are -1).
+ */
+void 
+CommandSurfaceGeodesic::BinaryMatrixRowReceiver::receiveRow(const int root, 
+                                                            const std::vector<int>& nodes, 
+                                                            const std::vector<float>& distances)
+{
+   float* row = &matrix[static_cast<qint64>(root) * numberOfNodes];
+   for (int i = 0; i < numberOfNodes; i++) {
+      row[i] = -1.0;
+   }
+   for (unsigned int i = 0; i < nodes.size(); i++) {
+      row[nodes[i]] = distances[i];
+   }
+   rowReceived();
+}
+
+//***************************************************************************************
+
+/**
+ * constructor (creates the file and writes the number of nodes).
+ */
+CommandSurfaceGeodesic::SparseRowReceiver::SparseRowReceiver(const QString& fileName,
+                                                             const int numberOfNodesIn)
+                                                                   throw (FileException)
+   : ProgressRowReceiver(numberOfNodesIn)
+{
+   writeErrorFlag = false;
+   file = new QFile(fileName);
+   if (file->open(QFile::WriteOnly | QFile::Truncate) == false) {
+      const QString msg = file->errorString();
+      delete file;
+      throw FileException(fileName, msg);
+   }
+   
+   writeErrorFlag |= (file->write((const char*)&numberOfNodes, sizeof(int)) != sizeof(int));
+}
+
+/**
+ * destructor.
+ */
+CommandSurfaceGeodesic::SparseRowReceiver::~SparseRowReceiver()
+{
+   if (file->isOpen()) {
+      file->close();
+   }
+   delete file;
+}
+
+/**
+ * receive a full row (all nodes are written).
+ */
+void 
+CommandSurfaceGeodesic::SparseRowReceiver::receiveRow(const int root, 
+                                                      const float* distances, 
+                                                      const int* /*parents*/)
+{
+   std::vector<int> nodes(numberOfNodes);
+   std::vector<float> values(numberOfNodes);
+   for (int i = 0; i < numberOfNodes; i++) {
+      nodes[i] = i;
+      values[i] = distances[i];
+   }
+   receiveRow(root, nodes, values);
+}
+
+/**
+ * receive a sparse row.
+ */
+void 
+CommandSurfaceGeodesic::SparseRowReceiver::receiveRow(const int root, 
+                                                      const std::vector<int>& nodes, 
+                                                      const std::vector<float>& distances)
+{
+   const int count = static_cast<int>(nodes.size());
+   writeErrorFlag |= (file->write((const char*)&root, sizeof(int)) != sizeof(int));
+   writeErrorFlag |= (file->write((const char*)&count, sizeof(int)) != sizeof(int));
+   if (count > 0) {
+      const qint64 nodeBytes = static_cast<qint64>(count) * sizeof(int);
+      writeErrorFlag |= (file->write((const char*)&nodes[0], nodeBytes) != nodeBytes);
+      const qint64 distanceBytes = static_cast<qint64>(count) * sizeof(float);
+      writeErrorFlag |= (file->write((const char*)&distances[0], distanceBytes) != distanceBytes);
+   }
+   rowReceived();
+}
+
+/**
+ * close the file (throws if any write failed).
+ */
+void 
+CommandSurfaceGeodesic::SparseRowReceiver::close() throw (FileException)
+{
+   const QString msg = file->errorString();
+   file->close();
+   if (writeErrorFlag) {
+      throw FileException(file->fileName(), "Error writing sparse geodesic file: " + msg);
+   }
+}
@@ -27,10 +27,16 @@
  */
 /*LICENSE_END*/
 
+#include <vector>
+
 #include "CommandBase.h"
+#include "GeodesicHelper.h"
+
+class GeodesicDistanceFile;
+class MetricFile;
+class QFile;
 
-/// class for
-class CommandSurfaceGeodesic : public CommandBase {
+/// class forCommandSurfaceGeodesic : public CommandBase {
    public:
       // constructor 
       CommandSurfaceGeodesic();
@@ -52,6 +58,116 @@ class CommandSurfaceGeodesic : public CommandBase {
                                    ProgramParametersException,
                                    StatisticException);
 
+      /// receives all to all rows and shows progress
+      class ProgressRowReceiver : public GeodesicHelperRowReceiver {
+         public:
+            // constructor
+            ProgressRowReceiver(const int numberOfNodesIn);
+            
+            // destructor
+            virtual ~ProgressRowReceiver();
+            
+         protected:
+            // update the progress after a row is received
+            void rowReceived();
+            
+            /// number of nodes
+            int numberOfNodes;
+            
+            /// number of rows received
+            int numberOfRowsReceived;
+            
+            /// number of progress dots shown
+            int numberOfDots;
+      };
+      
+      /// places all to all rows into the columns of a metric file
+      class MetricRowReceiver : public ProgressRowReceiver {
+         public:
+            // constructor
+            MetricRowReceiver(MetricFile* metricFileIn);
+            
+            // receive a full row
+            void receiveRow(const int root, const float* distances, const int* parents);
+            
+            // receive a sparse row
+            void receiveRow(const int root, const std::vector<int>& nodes, const std::vector<float>& distances);
+            
+         protected:
+            /// the metric file
+            MetricFile* metricFile;
+      };
+      
+      /// places all to all rows into the columns of a geodesic distance file
+      class GeodesicDistanceFileRowReceiver : public ProgressRowReceiver {
+         public:
+            // constructor
+            GeodesicDistanceFileRowReceiver(GeodesicDistanceFile* geodesicFileIn);
+            
+            /// parents are stored in the geodesic file
+            bool getParentsNeeded() const { return true; }
+            
+            // receive a full row
+            void receiveRow(const int root, const float* distances, const int* parents);
+            
+            // receive a sparse row
+            void receiveRow(const int root, const std::vector<int>& nodes, const std::vector<float>& distances);
+            
+         protected:
+            /// the geodesic distance file
+            GeodesicDistanceFile* geodesicFile;
+      };
+      
+      /// writes all to all rows into a memory mapped binary matrix (float32, row for each root)
+      class BinaryMatrixRowReceiver : public ProgressRowReceiver {
+         public:
+            // constructor (creates and maps the file)
+            BinaryMatrixRowReceiver(const QString& fileName,
+                                    const int numberOfNodesIn) throw (FileException);
+            
+            // destructor
+            ~BinaryMatrixRowReceiver();
+            
+            // receive a full row
+            void receiveRow(const int root, const float* distances, const int* parents);
+            
+            // receive a sparse row
+            void receiveRow(const int root, const std::vector<int>& nodes, const std::vector<float>& distances);
+            
+         protected:
+            /// the file
+            QFile* file;
+            
+            /// the mapped matrix
+            float* matrix;
+      };
+      
+      /// writes sparse all to all rows to a binary file as they are received
+      class SparseRowReceiver : public ProgressRowReceiver {
+         public:
+            // constructor (creates the file)
+            SparseRowReceiver(const QString& fileName,
+                              const int numberOfNodesIn) throw (FileException);
+            
+            // destructor
+            ~SparseRowReceiver();
+            
+            // receive a full row
+            void receiveRow(const int root, const float* distances, const int* parents);
+            
+            // receive a sparse row
+            void receiveRow(const int root, const std::vector<int>& nodes, const std::vector<float>& distances);
+            
+            // close the file (throws if any write failed)
+            void close() throw (FileException);
+            
+         protected:
+            /// the file
+            QFile* file;
+            
+            /// a write failed
+            bool writeErrorFlag;
+      };
 };
 
 #endif // __COMMAND_SURFACE_GEODESIC_H__
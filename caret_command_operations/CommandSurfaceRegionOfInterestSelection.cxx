@@ -95,6 +95,7 @@ CommandSurfaceRegionOfInterestSelection::getHelpInformation() const
        + indent9 + "   SEL-TYPE] \n"
        + indent9 + "[-boundary-only] \n"
        + indent9 + "[-dilate  iterations] \n"
+       + indent9 + "[-dilate-geodesic  distance] \n"
        + indent9 + "[-dilate-paint  paint-file-name column  paint-name  iterations]\n"
        + indent9 + "[-edges   SEL-TYPE] \n"
        + indent9 + "[-erode   iterations] \n"
@@ -162,6 +163,9 @@ CommandSurfaceRegionOfInterestSelection::getHelpInformation() const
        + indent9 + "\n"
        + indent9 + "\"-dilate\" will dilate the ROI for the specified iterations.\n"
        + indent9 + "\n"
+       + indent9 + "\"-dilate-geodesic\" will add all nodes within the specified\n"
+       + indent9 + "   geodesic distance (mm) of any node in the ROI.\n"
+       + indent9 + "\n"
        + indent9 + "\"-dilate-paint\" will dilate the ROI but only nodes that have\n"
        + indent9 + "   the specified paint are added to the ROI.\n"
        + indent9 + "\n"
@@ -429,6 +433,11 @@ CommandSurfaceRegionOfInterestSelection::executeCommand() throw (BrainModelAlgor
             parameters->getNextParameterAsInt("Dilation Iterations");
          roi->dilate(bms, numberOfIterations);
       }
+      else if (parameterName == "-dilate-geodesic") {
+         const float geodesicDistance =
+            parameters->getNextParameterAsFloat("Dilation Geodesic Distance");
+         roi->dilateByGeodesicDistance(bms, geodesicDistance);
+      }
       else if (parameterName == "-dilate-paint") {
          const QString paintFileName = 
             parameters->getNextParameterAsString("Dilate Paint File Name");
@@ -54,6 +54,7 @@ CommandVolumeBlur::getScriptBuilderParameters(ScriptBuilderParameters& paramsOut
    paramsOut.clear();
    paramsOut.addFile("Input Volume File", FileFilters::getVolumeAnatomyFileFilter());
    paramsOut.addFile("Output Volume File", FileFilters::getVolumeAnatomyFileFilter());
+   paramsOut.addVariableListOfParameters("Blur Options");
 }
 
 /**
@@ -67,8 +68,14 @@ CommandVolumeBlur::getHelpInformation() const
        + indent6 + parameters->getProgramNameWithoutPath() + " " + getOperationSwitch() + "  \n"
        + indent9 + "<input-volume-file-name>\n"
        + indent9 + "<output-volume-file-name>\n"
+       + indent9 + "[-fwhm  full-width-half-maximum-millimeters]\n"
        + indent9 + "\n"
        + indent9 + "Blur the volume.\n"
+       + indent9 + "\n"
+       + indent9 + "By default, the volume is blurred with a 5-voxel filter\n"
+       + indent9 + "along each axis.  If \"-fwhm\" is specified, the volume\n"
+       + indent9 + "is instead smoothed with a Gaussian kernel whose full\n"
+       + indent9 + "width at half maximum is in millimeters.\n"
        + indent9 + "\n");
       
    return helpInfo;
@@ -90,12 +97,30 @@ CommandVolumeBlur::executeCommand() throw (BrainModelAlgorithmException,
       parameters->getNextParameterAsString("Output Volume File Name");
    QString outputVolumeFileLabel;
    splitOutputVolumeNameIntoNameAndLabel(outputVolumeFileName, outputVolumeFileLabel);
-   checkForExcessiveParameters();
+   
+   float fullWidthHalfMaximum = -1.0;
+   while (parameters->getParametersAvailable()) {
+      const QString paramName = parameters->getNextParameterAsString("Blur Options");
+      if (paramName == "-fwhm") {
+         fullWidthHalfMaximum = parameters->getNextParameterAsFloat("Full Width Half Maximum");
+         if (fullWidthHalfMaximum <= 0.0) {
+            throw CommandException("Full width half maximum must be greater than zero.");
+         }
+      }
+      else {
+         throw CommandException("Unrecognized parameter: " + paramName);
+      }
+   }
    
    VolumeFile volumeFile;
    volumeFile.readFile(inputVolumeFileName);
    
-   volumeFile.blur();
+   if (fullWidthHalfMaximum > 0.0) {
+      volumeFile.smoothGaussian(fullWidthHalfMaximum);
+   }
+   else {
+      volumeFile.blur();
+   }
                                  
    writeVolumeFile(volumeFile, 
                    outputVolumeFileName,
@@ -0,0 +1,462 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+#include <exception>
+
+#include <QMutexLocker>
+#include <QTime>
+
+#define __CARET_THREAD_POOL_MAIN__
+#include "CaretThreadPool.h"
+#undef __CARET_THREAD_POOL_MAIN__
+
+#include "SystemUtilities.h"
+
+//=============================================================================
+
+/**
+ * destructor.
+ */
+CaretThreadPoolTaskCompletionCallback::~CaretThreadPoolTaskCompletionCallback()
+{
+}
+
+//=============================================================================
+
+/**
+ * constructor.
+ */
+CaretThreadPoolTask::CaretThreadPoolTask()
+{
+   threadPool = NULL;
+   taskGroup = NULL;
+   completionCallback = NULL;
+   finishedFlag = false;
+   autoDeleteFlag = false;
+   exceptionThrownFlag = false;
+   exceptionMessage = "";
+}
+
+/**
+ * destructor.
+ */
+CaretThreadPoolTask::~CaretThreadPoolTask()
+{
+}
+
+/**
+ * see if the task has finished.
+ */
+bool
+CaretThreadPoolTask::isFinished() const
+{
+   if (threadPool == NULL) {
+      return finishedFlag;
+   }
+   QMutexLocker locker(&threadPool->completionMutex);
+   return finishedFlag;
+}
+
+/**
+ * wait until the task has finished.  If called from a pool thread,
+ * other tasks are executed while waiting so that nested waits
+ * cannot exhaust the pool.
+ */
+void
+CaretThreadPoolTask::waitForFinished()
+{
+   if (threadPool != NULL) {
+      threadPool->waitForTask(this);
+   }
+}
+
+//=============================================================================
+
+/**
+ * constructor.
+ */
+CaretThreadPoolTaskGroup::CaretThreadPoolTaskGroup(CaretThreadPool* threadPoolIn)
+{
+   threadPool = threadPoolIn;
+   if (threadPool == NULL) {
+      threadPool = CaretThreadPool::getGlobalThreadPool();
+   }
+   numberOfTasksRemaining = 0;
+}
+
+/**
+ * destructor (waits for any tasks still running).
+ */
+CaretThreadPoolTaskGroup::~CaretThreadPoolTaskGroup()
+{
+   waitForAll();
+}
+
+/**
+ * submit a task to the group's pool.
+ */
+void
+CaretThreadPoolTaskGroup::submit(CaretThreadPoolTask* task)
+{
+   threadPool->submit(task, this);
+}
+
+/**
+ * wait for all tasks in the group, returns false if timed out.
+ */
+bool
+CaretThreadPoolTaskGroup::waitForAll(const unsigned long milliseconds)
+{
+   return threadPool->waitForGroup(this, milliseconds);
+}
+
+/**
+ * get the number of tasks that have not finished.
+ */
+int
+CaretThreadPoolTaskGroup::getNumberOfTasksRemaining() const
+{
+   QMutexLocker locker(&threadPool->completionMutex);
+   return numberOfTasksRemaining;
+}
+
+//=============================================================================
+
+/**
+ * constructor.
+ */
+CaretThreadPool::Worker::Worker(CaretThreadPool* poolIn,
+                                const int workerIndexIn)
+{
+   pool = poolIn;
+   workerIndex = workerIndexIn;
+}
+
+/**
+ * executes tasks until the pool shuts down.
+ */
+void
+CaretThreadPool::Worker::run()
+{
+   while (true) {
+      CaretThreadPoolTask* task = pool->getTask(this);
+      if (task != NULL) {
+         pool->executeTask(task);
+         continue;
+      }
+
+      //
+      // Sleep until a task is queued somewhere in the pool
+      //
+      QMutexLocker locker(&pool->workMutex);
+      if (pool->numberOfQueuedTasks > 0) {
+         continue;
+      }
+      if (pool->shutdownFlag) {
+         break;
+      }
+      pool->workAvailableCondition.wait(&pool->workMutex);
+   }
+}
+
+//=============================================================================
+
+/**
+ * constructor.
+ */
+CaretThreadPool::CaretThreadPool(const int numberOfThreadsIn)
+{
+   nextWorkerForSubmission = 0;
+   numberOfQueuedTasks = 0;
+   shutdownFlag = false;
+
+   const int numThreads = std::max(numberOfThreadsIn, 1);
+   for (int i = 0; i < numThreads; i++) {
+      workers.push_back(new Worker(this, i));
+   }
+   for (int i = 0; i < numThreads; i++) {
+      workers[i]->start();
+   }
+}
+
+/**
+ * destructor (waits for queued tasks).
+ */
+CaretThreadPool::~CaretThreadPool()
+{
+   workMutex.lock();
+   shutdownFlag = true;
+   workAvailableCondition.wakeAll();
+   workMutex.unlock();
+
+   for (unsigned int i = 0; i < workers.size(); i++) {
+      workers[i]->wait();
+      delete workers[i];
+   }
+   workers.clear();
+}
+
+/**
+ * get the global thread pool (created on first use with one
+ * thread per processor).
+ */
+CaretThreadPool*
+CaretThreadPool::getGlobalThreadPool()
+{
+   QMutexLocker locker(&globalThreadPoolMutex);
+   if (globalThreadPool == NULL) {
+      globalThreadPool = new CaretThreadPool(SystemUtilities::getNumberOfProcessors());
+   }
+   return globalThreadPool;
+}
+
+/**
+ * submit a task for execution.  A task submitted from a pool thread
+ * is placed on that thread's queue, otherwise queues are filled
+ * round robin.  Idle threads steal from the other queues.
+ */
+void
+CaretThreadPool::submit(CaretThreadPoolTask* task,
+                        CaretThreadPoolTaskGroup* group)
+{
+   task->threadPool = this;
+   task->taskGroup = group;
+   task->finishedFlag = false;
+   task->exceptionThrownFlag = false;
+   task->exceptionMessage = "";
+
+   if (group != NULL) {
+      QMutexLocker locker(&completionMutex);
+      group->numberOfTasksRemaining++;
+   }
+
+   Worker* worker = getCurrentWorker();
+   if (worker == NULL) {
+      QMutexLocker locker(&workMutex);
+      worker = workers[nextWorkerForSubmission];
+      nextWorkerForSubmission = (nextWorkerForSubmission + 1) % workers.size();
+   }
+
+   worker->taskQueueMutex.lock();
+   worker->taskQueue.push_back(task);
+   worker->taskQueueMutex.unlock();
+
+   QMutexLocker locker(&workMutex);
+   numberOfQueuedTasks++;
+   workAvailableCondition.wakeOne();
+}
+
+/**
+ * is the calling thread one of this pool's threads.
+ */
+bool
+CaretThreadPool::isPoolThread() const
+{
+   return (getCurrentWorker() != NULL);
+}
+
+/**
+ * get the worker for the calling thread (NULL if not a pool thread).
+ */
+CaretThreadPool::Worker*
+CaretThreadPool::getCurrentWorker() const
+{
+   QThread* currentThread = QThread::currentThread();
+   for (unsigned int i = 0; i < workers.size(); i++) {
+      if (workers[i] == currentThread) {
+         return workers[i];
+      }
+   }
+   return NULL;
+}
+
+/**
+ * get a task, first from the worker's own queue (newest task) and
+ * then by stealing from the other queues (oldest task).
+ */
+CaretThreadPoolTask*
+CaretThreadPool::getTask(Worker* worker)
+{
+   CaretThreadPoolTask* task = NULL;
+
+   worker->taskQueueMutex.lock();
+   if (worker->taskQueue.empty() == false) {
+      task = worker->taskQueue.back();
+      worker->taskQueue.pop_back();
+   }
+   worker->taskQueueMutex.unlock();
+
+   const int numWorkers = static_cast<int>(workers.size());
+   for (int i = 1; (i < numWorkers) && (task == NULL); i++) {
+      Worker* victim = workers[(worker->workerIndex + i) % numWorkers];
+      victim->taskQueueMutex.lock();
+      if (victim->taskQueue.empty() == false) {
+         task = victim->taskQueue.front();
+         victim->taskQueue.pop_front();
+      }
+      victim->taskQueueMutex.unlock();
+   }
+
+   if (task != NULL) {
+      QMutexLocker locker(&workMutex);
+      numberOfQueuedTasks--;
+   }
+
+   return task;
+}
+
+/**
+ * execute a task and signal its completion.  The task is not
+ * accessed after it is marked finished unless it is auto delete.
+ */
+void
+CaretThreadPool::executeTask(CaretThreadPoolTask* task)
+{
+   try {
+      task->run();
+   }
+   catch (std::exception& e) {
+      task->exceptionThrownFlag = true;
+      task->exceptionMessage = e.what();
+   }
+   catch (...) {
+      task->exceptionThrownFlag = true;
+      task->exceptionMessage = "Unknown exception thrown by thread pool task.";
+   }
+
+   if (task->completionCallback != NULL) {
+      task->completionCallback->taskCompleted(task);
+   }
+
+   const bool deleteTask = task->autoDeleteFlag;
+
+   completionMutex.lock();
+   task->finishedFlag = true;
+   if (task->taskGroup != NULL) {
+      task->taskGroup->numberOfTasksRemaining--;
+   }
+   completionCondition.wakeAll();
+   completionMutex.unlock();
+
+   if (deleteTask) {
+      delete task;
+   }
+}
+
+/**
+ * wait for a task to finish.
+ */
+void
+CaretThreadPool::waitForTask(CaretThreadPoolTask* task)
+{
+   Worker* worker = getCurrentWorker();
+
+   while (true) {
+      completionMutex.lock();
+      if (task->finishedFlag) {
+         completionMutex.unlock();
+         return;
+      }
+      if (worker == NULL) {
+         completionCondition.wait(&completionMutex);
+         completionMutex.unlock();
+         continue;
+      }
+      completionMutex.unlock();
+
+      //
+      // A pool thread helps with other work while it waits
+      //
+      CaretThreadPoolTask* otherTask = getTask(worker);
+      if (otherTask != NULL) {
+         executeTask(otherTask);
+      }
+      else {
+         completionMutex.lock();
+         if (task->finishedFlag == false) {
+            completionCondition.wait(&completionMutex, 1);
+         }
+         completionMutex.unlock();
+      }
+   }
+}
+
+/**
+ * wait for a group's tasks to finish, returns false if timed out.
+ */
+bool
+CaretThreadPool::waitForGroup(CaretThreadPoolTaskGroup* group,
+                              const unsigned long milliseconds)
+{
+   Worker* worker = getCurrentWorker();
+
+   QTime timer;
+   timer.start();
+
+   while (true) {
+      unsigned long waitTime = ULONG_MAX;
+      if (milliseconds != ULONG_MAX) {
+         const unsigned long elapsed = static_cast<unsigned long>(timer.elapsed());
+         if (elapsed >= milliseconds) {
+            waitTime = 0;
+         }
+         else {
+            waitTime = milliseconds - elapsed;
+         }
+      }
+
+      completionMutex.lock();
+      if (group->numberOfTasksRemaining <= 0) {
+         completionMutex.unlock();
+         return true;
+      }
+      if (waitTime == 0) {
+         completionMutex.unlock();
+         return false;
+      }
+      if (worker == NULL) {
+         completionCondition.wait(&completionMutex, waitTime);
+         completionMutex.unlock();
+         continue;
+      }
+      completionMutex.unlock();
+
+      //
+      // A pool thread helps with other work while it waits
+      //
+      CaretThreadPoolTask* otherTask = getTask(worker);
+      if (otherTask != NULL) {
+         executeTask(otherTask);
+      }
+      else {
+         completionMutex.lock();
+         if (group->numberOfTasksRemaining > 0) {
+            completionCondition.wait(&completionMutex, 1);
+         }
+         completionMutex.unlock();
+      }
+   }
+}
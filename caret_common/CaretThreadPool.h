@@ -0,0 +1,240 @@
+#ifndef __CARET_THREAD_POOL_H__
+#define __CARET_THREAD_POOL_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <climits>
+#include <deque>
+#include <vector>
+
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+
+class CaretThreadPool;
+class CaretThreadPoolTask;
+class CaretThreadPoolTaskGroup;
+
+/// interface for receiving notification when a thread pool task completes
+class CaretThreadPoolTaskCompletionCallback {
+   public:
+      // destructor
+      virtual ~CaretThreadPoolTaskCompletionCallback();
+
+      /// called in the worker thread after the task's run() returns
+      virtual void taskCompleted(CaretThreadPoolTask* task) = 0;
+};
+
+/// a unit of work that is executed by a thread pool (also serves as its future)
+class CaretThreadPoolTask {
+   public:
+      // constructor
+      CaretThreadPoolTask();
+
+      // destructor
+      virtual ~CaretThreadPoolTask();
+
+      /// do the work (called in a pool thread)
+      virtual void run() = 0;
+
+      // see if the task has finished
+      bool isFinished() const;
+
+      // wait until the task has finished (pool threads execute other tasks while waiting)
+      void waitForFinished();
+
+      /// set the callback called when the task completes (not owned by task)
+      void setCompletionCallback(CaretThreadPoolTaskCompletionCallback* cb)
+                                                  { completionCallback = cb; }
+
+      /// delete the task after it runs (an auto delete task cannot be waited upon)
+      void setAutoDelete(const bool flag) { autoDeleteFlag = flag; }
+
+      /// get the auto delete flag
+      bool getAutoDelete() const { return autoDeleteFlag; }
+
+      /// true if run() threw an exception
+      bool getTaskThrewAnException() const { return exceptionThrownFlag; }
+
+      /// message from exception thrown by run()
+      QString getExceptionErrorMessage() const { return exceptionMessage; }
+
+   private:
+      /// pool to which task was submitted
+      CaretThreadPool* threadPool;
+
+      /// group containing the task
+      CaretThreadPoolTaskGroup* taskGroup;
+
+      /// completion callback
+      CaretThreadPoolTaskCompletionCallback* completionCallback;
+
+      /// task finished (protected by pool's completion mutex)
+      bool finishedFlag;
+
+      /// auto delete flag
+      bool autoDeleteFlag;
+
+      /// exception was thrown by run()
+      bool exceptionThrownFlag;
+
+      /// message of exception thrown by run()
+      QString exceptionMessage;
+
+   friend class CaretThreadPool;
+};
+
+/// a group of tasks that can be waited upon together
+class CaretThreadPoolTaskGroup {
+   public:
+      // constructor
+      CaretThreadPoolTaskGroup(CaretThreadPool* threadPoolIn = NULL);
+
+      // destructor (waits for any tasks still running)
+      ~CaretThreadPoolTaskGroup();
+
+      // submit a task to the group's pool
+      void submit(CaretThreadPoolTask* task);
+
+      // wait for all tasks in the group, returns false if timed out
+      bool waitForAll(const unsigned long milliseconds = ULONG_MAX);
+
+      // get the number of tasks that have not finished
+      int getNumberOfTasksRemaining() const;
+
+   private:
+      /// the thread pool
+      CaretThreadPool* threadPool;
+
+      /// number of tasks not finished (protected by pool's completion mutex)
+      int numberOfTasksRemaining;
+
+   friend class CaretThreadPool;
+};
+
+/// process-wide, work-stealing pool of persistent threads
+class CaretThreadPool {
+   public:
+      // constructor
+      CaretThreadPool(const int numberOfThreadsIn);
+
+      // destructor (waits for queued tasks)
+      ~CaretThreadPool();
+
+      // get the global thread pool (created on first use)
+      static CaretThreadPool* getGlobalThreadPool();
+
+      /// get the number of threads in the pool
+      int getNumberOfThreads() const { return static_cast<int>(workers.size()); }
+
+      // submit a task for execution (optionally a member of a group)
+      void submit(CaretThreadPoolTask* task,
+                  CaretThreadPoolTaskGroup* group = NULL);
+
+      // is the calling thread one of this pool's threads
+      bool isPoolThread() const;
+
+   protected:
+      /// a persistent thread with its own queue of tasks
+      class Worker : public QThread {
+         public:
+            // constructor
+            Worker(CaretThreadPool* poolIn, const int workerIndexIn);
+
+            /// the pool
+            CaretThreadPool* pool;
+
+            /// index of this worker
+            int workerIndex;
+
+            /// the worker's task queue (owner pops back, thieves pop front)
+            std::deque<CaretThreadPoolTask*> taskQueue;
+
+            /// protects the task queue
+            QMutex taskQueueMutex;
+
+         protected:
+            // executes tasks until the pool shuts down
+            void run();
+      };
+
+      // get the worker for the calling thread (NULL if not a pool thread)
+      Worker* getCurrentWorker() const;
+
+      // get a task, first from the worker's own queue and then by stealing
+      CaretThreadPoolTask* getTask(Worker* worker);
+
+      // execute a task and signal its completion
+      void executeTask(CaretThreadPoolTask* task);
+
+      // wait for a task to finish
+      void waitForTask(CaretThreadPoolTask* task);
+
+      // wait for a group's tasks to finish
+      bool waitForGroup(CaretThreadPoolTaskGroup* group,
+                        const unsigned long milliseconds);
+
+      /// the worker threads
+      std::vector<Worker*> workers;
+
+      /// next worker queue for tasks submitted from outside the pool
+      int nextWorkerForSubmission;
+
+      /// number of tasks in the queues (protected by workMutex)
+      int numberOfQueuedTasks;
+
+      /// pool is shutting down (protected by workMutex)
+      bool shutdownFlag;
+
+      /// mutex used by idle workers
+      QMutex workMutex;
+
+      /// signalled when a task is queued
+      QWaitCondition workAvailableCondition;
+
+      /// mutex protecting task/group completion
+      QMutex completionMutex;
+
+      /// signalled when any task completes
+      QWaitCondition completionCondition;
+
+      /// the global thread pool
+      static CaretThreadPool* globalThreadPool;
+
+      /// protects creation of the global thread pool
+      static QMutex globalThreadPoolMutex;
+
+   friend class CaretThreadPoolTask;
+   friend class CaretThreadPoolTaskGroup;
+};
+
+#endif // __CARET_THREAD_POOL_H__
+
+#ifdef __CARET_THREAD_POOL_MAIN__
+   CaretThreadPool* CaretThreadPool::globalThreadPool = NULL;
+   QMutex CaretThreadPool::globalThreadPoolMutex;
+#endif // __CARET_THREAD_POOL_MAIN__
@@ -0,0 +1,434 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#include <algorithm>
+#include <cmath>
+
+#include "CorrelationMatrixEngine.h"
+
+/**
+ * multiply a tile of rows with a packed (transposed) tile of rows and
+ * add the result to the accumulator.  The innermost loop is over
+ * contiguous values of the packed tile and the accumulator so that
+ * the compiler is able to vectorize it.
+ */
+template <class T>
+static void
+multiplyTile(const float* rowsI,
+             const long rowStrideI,
+             const long iCount,
+             const float* packedJ,
+             const long jCount,
+             const long kCount,
+             const long tileStride,
+             T* accumulator)
+{
+   for (long ii = 0; ii < iCount; ii++) {
+      const float* a = rowsI + ii * rowStrideI;
+      T* c = accumulator + ii * tileStride;
+      for (long kk = 0; kk < kCount; kk++) {
+         const T av = a[kk];
+         const float* b = packedJ + kk * tileStride;
+         for (long jj = 0; jj < jCount; jj++) {
+            c[jj] += av * b[jj];
+         }
+      }
+   }
+}
+
+//=============================================================================
+
+/**
+ * constructor.
+ */
+CorrelationMatrixEngine::PanelTask::PanelTask(CorrelationMatrixEngine* engineIn,
+                                              const long iStartIn,
+                                              const long iCountIn,
+                                              const long jStartIn,
+                                              const long jEndIn,
+                                              float** outputRowsIn,
+                                              const long outputRowOffsetIn,
+                                              const bool mirrorFlagIn)
+{
+   engine = engineIn;
+   iStart = iStartIn;
+   iCount = iCountIn;
+   jStart = jStartIn;
+   jEnd = jEndIn;
+   outputRows = outputRowsIn;
+   outputRowOffset = outputRowOffsetIn;
+   mirrorFlag = mirrorFlagIn;
+}
+
+/**
+ * compute the tiles.
+ */
+void
+CorrelationMatrixEngine::PanelTask::run()
+{
+   const long tile = CorrelationMatrixEngine::tileSize;
+   std::vector<float> packedTile(CorrelationMatrixEngine::columnTileSize * tile);
+   std::vector<float> floatAccumulator;
+   std::vector<double> doubleAccumulator;
+   if (engine->floatAccumulationFlag) {
+      floatAccumulator.resize(tile * tile);
+   }
+   else {
+      doubleAccumulator.resize(tile * tile);
+   }
+
+   //
+   // Rows that are not in memory are read from the source one tile at a time
+   //
+   const long numberOfColumns = engine->numberOfColumns;
+   std::vector<float> sourceRowsI;
+   std::vector<float> sourceRowsJ;
+   const float* rowsI = NULL;
+   if (engine->rowSource != NULL) {
+      sourceRowsI.resize(iCount * numberOfColumns);
+      sourceRowsJ.resize(tile * numberOfColumns);
+      engine->getNormalizedRows(iStart, iCount, &sourceRowsI[0]);
+      rowsI = &sourceRowsI[0];
+   }
+   else {
+      rowsI = engine->dataValues + iStart * numberOfColumns;
+   }
+
+   for (long j = jStart; j < jEnd; j += tile) {
+      const long jCount = std::min(tile, jEnd - j);
+      const float* rowsJ = NULL;
+      if (engine->rowSource != NULL) {
+         engine->getNormalizedRows(j, jCount, &sourceRowsJ[0]);
+         rowsJ = &sourceRowsJ[0];
+      }
+      else {
+         rowsJ = engine->dataValues + j * numberOfColumns;
+      }
+      engine->computeTile(rowsI,
+                          iStart,
+                          iCount,
+                          rowsJ,
+                          j,
+                          jCount,
+                          &packedTile[0],
+                          (floatAccumulator.empty() ? NULL : &floatAccumulator[0]),
+                          (doubleAccumulator.empty() ? NULL : &doubleAccumulator[0]),
+                          outputRows,
+                          outputRowOffset,
+                          mirrorFlag);
+   }
+}
+
+//=============================================================================
+
+/**
+ * constructor.  The data values are modified (normalized) when
+ * the correlations are computed.
+ */
+CorrelationMatrixEngine::CorrelationMatrixEngine(float* demeanedDataIn,
+                                                 const double* rowSumSquaredIn,
+                                                 const long numberOfRowsIn,
+                                                 const long numberOfColumnsIn,
+                                                 const bool applyFisherZTransformFlagIn,
+                                                 const bool floatAccumulationFlagIn,
+                                                 const bool parallelFlagIn)
+   : dataValues(demeanedDataIn),
+     rowSource(NULL),
+     rowSumSquared(rowSumSquaredIn),
+     numberOfRows(numberOfRowsIn),
+     numberOfColumns(numberOfColumnsIn),
+     applyFisherZTransformFlag(applyFisherZTransformFlagIn),
+     floatAccumulationFlag(floatAccumulationFlagIn),
+     parallelFlag(parallelFlagIn)
+{
+   rowsNormalizedFlag = false;
+}
+
+/**
+ * constructor for rows that are read from a source as they are needed
+ * so that the data is never entirely in memory.
+ */
+CorrelationMatrixEngine::CorrelationMatrixEngine(const RowSource* rowSourceIn,
+                                                 const double* rowSumSquaredIn,
+                                                 const long numberOfRowsIn,
+                                                 const long numberOfColumnsIn,
+                                                 const bool applyFisherZTransformFlagIn,
+                                                 const bool floatAccumulationFlagIn,
+                                                 const bool parallelFlagIn)
+   : dataValues(NULL),
+     rowSource(rowSourceIn),
+     rowSumSquared(rowSumSquaredIn),
+     numberOfRows(numberOfRowsIn),
+     numberOfColumns(numberOfColumnsIn),
+     applyFisherZTransformFlag(applyFisherZTransformFlagIn),
+     floatAccumulationFlag(floatAccumulationFlagIn),
+     parallelFlag(parallelFlagIn)
+{
+   rowsNormalizedFlag = true;
+}
+
+/**
+ * destructor.
+ */
+CorrelationMatrixEngine::~CorrelationMatrixEngine()
+{
+}
+
+/**
+ * compute the symmetric correlation matrix.  Only the tiles on and
+ * above the diagonal are computed, each is also stored transposed.
+ */
+void
+CorrelationMatrixEngine::computeCorrelationMatrix(float** outputRows)
+{
+   normalizeRows();
+
+   //
+   // Tasks with the most tiles are first so that they start first
+   //
+   const long tile = tileSize;
+   std::vector<PanelTask*> tasks;
+   for (long i = 0; i < numberOfRows; i += tile) {
+      tasks.push_back(new PanelTask(this,
+                                    i,
+                                    std::min(tile, numberOfRows - i),
+                                    i,
+                                    numberOfRows,
+                                    outputRows,
+                                    0,
+                                    true));
+   }
+
+   runTasks(tasks);
+}
+
+/**
+ * compute correlations of consecutive rows with all rows.
+ */
+void
+CorrelationMatrixEngine::computeCorrelationsForRows(const long firstRow,
+                                                    const long numberOfRowsToCompute,
+                                                    float* rowsOut)
+{
+   normalizeRows();
+
+   std::vector<float*> outputRows(numberOfRowsToCompute);
+   for (long i = 0; i < numberOfRowsToCompute; i++) {
+      outputRows[i] = rowsOut + i * numberOfRows;
+   }
+
+   //
+   // Split the rows compared with each tile of rows into chunks
+   // so that there is work for all threads
+   //
+   const long tile = tileSize;
+   const long chunkSize = tile * 8;
+   const long lastRow = firstRow + numberOfRowsToCompute;
+   std::vector<PanelTask*> tasks;
+   for (long i = firstRow; i < lastRow; i += tile) {
+      for (long j = 0; j < numberOfRows; j += chunkSize) {
+         tasks.push_back(new PanelTask(this,
+                                       i,
+                                       std::min(tile, lastRow - i),
+                                       j,
+                                       std::min(j + chunkSize, numberOfRows),
+                                       &outputRows[0],
+                                       firstRow,
+                                       false));
+      }
+   }
+
+   runTasks(tasks);
+}
+
+/**
+ * run the panel tasks (and delete them).
+ */
+void
+CorrelationMatrixEngine::runTasks(std::vector<PanelTask*>& tasks)
+{
+   const int numTasks = static_cast<int>(tasks.size());
+   if (parallelFlag && (numTasks > 1)) {
+      CaretThreadPoolTaskGroup group;
+      for (int i = 0; i < numTasks; i++) {
+         group.submit(tasks[i]);
+      }
+      group.waitForAll();
+   }
+   else {
+      for (int i = 0; i < numTasks; i++) {
+         tasks[i]->run();
+      }
+   }
+
+   for (int i = 0; i < numTasks; i++) {
+      delete tasks[i];
+   }
+   tasks.clear();
+}
+
+/**
+ * normalize the rows to unit length so that a dot product of two
+ * rows is their correlation coefficient.
+ */
+void
+CorrelationMatrixEngine::normalizeRows()
+{
+   if (rowsNormalizedFlag) {
+      return;
+   }
+   rowsNormalizedFlag = true;
+
+   for (long i = 0; i < numberOfRows; i++) {
+      //
+      // A row with no variance has a correlation of zero with all rows
+      //
+      float scale = 0.0;
+      if (rowSumSquared[i] != 0.0) {
+         scale = 1.0 / std::sqrt(rowSumSquared[i]);
+      }
+      float* row = dataValues + i * numberOfColumns;
+      for (long k = 0; k < numberOfColumns; k++) {
+         row[k] *= scale;
+      }
+   }
+}
+
+/**
+ * get normalized rows from the row source.
+ */
+void
+CorrelationMatrixEngine::getNormalizedRows(const long firstRow,
+                                           const long numberOfRowsToGet,
+                                           float* rowsOut) const
+{
+   rowSource->getDemeanedRows(firstRow, numberOfRowsToGet, rowsOut);
+
+   for (long i = 0; i < numberOfRowsToGet; i++) {
+      float scale = 0.0;
+      if (rowSumSquared[firstRow + i] != 0.0) {
+         scale = 1.0 / std::sqrt(rowSumSquared[firstRow + i]);
+      }
+      float* row = rowsOut + i * numberOfColumns;
+      for (long k = 0; k < numberOfColumns; k++) {
+         row[k] *= scale;
+      }
+   }
+}
+
+/**
+ * compute one tile and store its correlations.  rowsI and rowsJ
+ * point to the first of the normalized rows iStart and jStart.
+ */
+void
+CorrelationMatrixEngine::computeTile(const float* rowsI,
+                                     const long iStart,
+                                     const long iCount,
+                                     const float* rowsJ,
+                                     const long jStart,
+                                     const long jCount,
+                                     float* packedTile,
+                                     float* floatAccumulator,
+                                     double* doubleAccumulator,
+                                     float** outputRows,
+                                     const long outputRowOffset,
+                                     const bool mirrorFlag) const
+{
+   const long tile = tileSize;
+   if (floatAccumulationFlag) {
+      std::fill(floatAccumulator, floatAccumulator + tile * tile, 0.0f);
+   }
+   else {
+      std::fill(doubleAccumulator, doubleAccumulator + tile * tile, 0.0);
+   }
+
+   for (long k = 0; k < numberOfColumns; k += columnTileSize) {
+      const long kCount = std::min(static_cast<long>(columnTileSize), numberOfColumns - k);
+
+      //
+      // Pack the J rows transposed so that consecutive J values are contiguous
+      //
+      for (long jj = 0; jj < jCount; jj++) {
+         const float* src = rowsJ + jj * numberOfColumns + k;
+         for (long kk = 0; kk < kCount; kk++) {
+            packedTile[kk * tile + jj] = src[kk];
+         }
+      }
+
+      const float* rowsIK = rowsI + k;
+      if (floatAccumulationFlag) {
+         multiplyTile(rowsIK, numberOfColumns, iCount,
+                      packedTile, jCount, kCount, tile, floatAccumulator);
+      }
+      else {
+         multiplyTile(rowsIK, numberOfColumns, iCount,
+                      packedTile, jCount, kCount, tile, doubleAccumulator);
+      }
+   }
+
+   for (long ii = 0; ii < iCount; ii++) {
+      const long iRow = iStart + ii;
+      for (long jj = 0; jj < jCount; jj++) {
+         const long jRow = jStart + jj;
+         const double dot = (floatAccumulationFlag
+                             ? floatAccumulator[ii * tile + jj]
+                             : doubleAccumulator[ii * tile + jj]);
+         const float r = dotProductToOutputValue(dot);
+         outputRows[iRow - outputRowOffset][jRow] = r;
+         if (mirrorFlag) {
+            outputRows[jRow - outputRowOffset][iRow] = r;
+         }
+      }
+   }
+}
+
+/**
+ * convert a dot product of normalized rows to the output value.
+ */
+float
+CorrelationMatrixEngine::dotProductToOutputValue(const double dotProduct) const
+{
+   const double tinyValue = 1.0e-20;
+
+   /*
+    * Rounding in the normalized rows may put the dot product slightly
+    * outside of [-1, 1]
+    */
+   float r = std::max(-1.0, std::min(1.0, dotProduct));
+
+   /*
+    * Apply the Fisher Z-Transform?
+    */
+   if (applyFisherZTransformFlag) {
+      float denom = (1.0 - r);
+      if (denom != 0.0) {
+         r = 0.5 * std::log((1.0 + r) / denom);
+      }
+      else {
+         r = 0.5 * std::log((1.0 + r) / tinyValue);
+      }
+   }
+
+   return r;
+}
@@ -0,0 +1,194 @@
+#ifndef __CORRELATION_MATRIX_ENGINE_H__
+#define __CORRELATION_MATRIX_ENGINE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#include <vector>
+
+#include "CaretThreadPool.h"
+
+/// Computes the correlation coefficient of every pair of rows in a matrix.
+/// The rows are normalized so that the correlation matrix is the product
+/// of the matrix and its transpose, which is computed in cache sized tiles
+/// whose innermost loop runs over contiguous memory so that it vectorizes.
+class CorrelationMatrixEngine {
+   public:
+      /// Supplies rows of a matrix that is not in memory.  Rows are requested
+      /// one tile at a time, possibly from several threads at once.
+      class RowSource {
+         public:
+            /// destructor
+            virtual ~RowSource() { }
+
+            /// copy consecutive rows with each row's mean subtracted
+            virtual void getDemeanedRows(const long firstRow,
+                                         const long numberOfRows,
+                                         float* rowsOut) const = 0;
+      };
+
+      // constructor (data must already have each row's mean subtracted)
+      CorrelationMatrixEngine(float* demeanedDataIn,
+                              const double* rowSumSquaredIn,
+                              const long numberOfRowsIn,
+                              const long numberOfColumnsIn,
+                              const bool applyFisherZTransformFlagIn,
+                              const bool floatAccumulationFlagIn,
+                              const bool parallelFlagIn);
+
+      // constructor for rows that are read from a source as they are needed
+      CorrelationMatrixEngine(const RowSource* rowSourceIn,
+                              const double* rowSumSquaredIn,
+                              const long numberOfRowsIn,
+                              const long numberOfColumnsIn,
+                              const bool applyFisherZTransformFlagIn,
+                              const bool floatAccumulationFlagIn,
+                              const bool parallelFlagIn);
+
+      // destructor
+      ~CorrelationMatrixEngine();
+
+      // compute the symmetric correlation matrix (outputRows[i] points to output row i)
+      void computeCorrelationMatrix(float** outputRows);
+
+      // compute correlations of consecutive rows with all rows
+      // (rowsOut holds numberOfRowsToCompute * getNumberOfRows() values)
+      void computeCorrelationsForRows(const long firstRow,
+                                      const long numberOfRowsToCompute,
+                                      float* rowsOut);
+
+      /// get the number of rows
+      long getNumberOfRows() const { return numberOfRows; }
+
+      /// get the number of rows in a tile (row blocks should be a multiple of this)
+      static long getTileSize() { return tileSize; }
+
+   protected:
+      /// computes the tiles of a panel of rows
+      class PanelTask : public CaretThreadPoolTask {
+         public:
+            // constructor
+            PanelTask(CorrelationMatrixEngine* engineIn,
+                      const long iStartIn,
+                      const long iCountIn,
+                      const long jStartIn,
+                      const long jEndIn,
+                      float** outputRowsIn,
+                      const long outputRowOffsetIn,
+                      const bool mirrorFlagIn);
+
+            // compute the tiles
+            void run();
+
+         protected:
+            /// the engine
+            CorrelationMatrixEngine* engine;
+
+            /// first row of panel
+            long iStart;
+
+            /// number of rows in panel
+            long iCount;
+
+            /// first row compared with panel
+            long jStart;
+
+            /// one past last row compared with panel
+            long jEnd;
+
+            /// the output rows
+            float** outputRows;
+
+            /// row index of outputRows[0]
+            long outputRowOffset;
+
+            /// also store the transpose of each tile
+            bool mirrorFlag;
+      };
+
+      // normalize the rows to unit length
+      void normalizeRows();
+
+      // get normalized rows from the row source
+      void getNormalizedRows(const long firstRow,
+                             const long numberOfRowsToGet,
+                             float* rowsOut) const;
+
+      // run the panel tasks
+      void runTasks(std::vector<PanelTask*>& tasks);
+
+      // compute one tile and store its correlations
+      void computeTile(const float* rowsI,
+                       const long iStart,
+                       const long iCount,
+                       const float* rowsJ,
+                       const long jStart,
+                       const long jCount,
+                       float* packedTile,
+                       float* floatAccumulator,
+                       double* doubleAccumulator,
+                       float** outputRows,
+                       const long outputRowOffset,
+                       const bool mirrorFlag) const;
+
+      // convert a dot product of normalized rows to the output value
+      float dotProductToOutputValue(const double dotProduct) const;
+
+      /// the data (normalized in place, NULL if rows are from a source)
+      float* dataValues;
+
+      /// source of rows when the data is not in memory
+      const RowSource* rowSource;
+
+      /// sum squared of each row's demeaned values
+      const double* rowSumSquared;
+
+      /// number of rows
+      const long numberOfRows;
+
+      /// number of columns
+      const long numberOfColumns;
+
+      /// apply fisher z-transform to correlation coefficients
+      const bool applyFisherZTransformFlag;
+
+      /// accumulate dot products in single precision
+      const bool floatAccumulationFlag;
+
+      /// use the thread pool
+      const bool parallelFlag;
+
+      /// rows have been normalized
+      bool rowsNormalizedFlag;
+
+      /// number of rows in a tile
+      static const long tileSize = 64;
+
+      /// number of columns in a tile
+      static const long columnTileSize = 256;
+
+   friend class PanelTask;
+};
+
+#endif // __CORRELATION_MATRIX_ENGINE_H__
@@ -0,0 +1,361 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#include <algorithm>
+#include <limits>
+
+#include "PointKDTree.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * constructor.
+ */
+PointKDTree::PointKDTree()
+{
+}
+
+/**
+ * destructor.
+ */
+PointKDTree::~PointKDTree()
+{
+}
+
+/**
+ * build the tree from points (three coordinates per point).  If "idsIn" 
+ * is NULL, the id of a point is its index.
+ */
+void 
+PointKDTree::setPoints(const float* xyzIn,
+                       const int* idsIn,
+                       const int numberOfPointsIn)
+{
+   pointXYZ.clear();
+   ids.clear();
+   splitAxis.clear();
+   if (numberOfPointsIn <= 0) {
+      return;
+   }
+   
+   std::vector<int> order(numberOfPointsIn);
+   for (int i = 0; i < numberOfPointsIn; i++) {
+      order[i] = i;
+   }
+   splitAxis.resize(numberOfPointsIn, 0);
+   buildTree(xyzIn, order, 0, numberOfPointsIn);
+   
+   //
+   // Store the points in tree order
+   //
+   pointXYZ.resize(numberOfPointsIn * 3);
+   ids.resize(numberOfPointsIn);
+   for (int i = 0; i < numberOfPointsIn; i++) {
+      const int p = order[i];
+      pointXYZ[i * 3]     = xyzIn[p * 3];
+      pointXYZ[i * 3 + 1] = xyzIn[p * 3 + 1];
+      pointXYZ[i * 3 + 2] = xyzIn[p * 3 + 2];
+      ids[i] = ((idsIn != NULL) ? idsIn[p] : p);
+   }
+}
+
+/**
+ * build the tree for a range of points.  The middle point of the range 
+ * splits it along the axis with the largest extent; points before it in
+ * the range are not greater along the axis and points after it are not less.
+ */
+void 
+PointKDTree::buildTree(const float* xyzIn,
+                       std::vector<int>& order,
+                       const int beginIndex,
+                       const int endIndex)
+{
+   if ((endIndex - beginIndex) <= LEAF_SIZE) {
+      return;
+   }
+   
+   float minXYZ[3], maxXYZ[3];
+   for (int j = 0; j < 3; j++) {
+      minXYZ[j] = std::numeric_limits<float>::max();
+      maxXYZ[j] = -std::numeric_limits<float>::max();
+   }
+   for (int i = beginIndex; i < endIndex; i++) {
+      const float* xyz = &xyzIn[order[i] * 3];
+      for (int j = 0; j < 3; j++) {
+         minXYZ[j] = std::min(minXYZ[j], xyz[j]);
+         maxXYZ[j] = std::max(maxXYZ[j], xyz[j]);
+      }
+   }
+   int axis = 0;
+   for (int j = 1; j < 3; j++) {
+      if ((maxXYZ[j] - minXYZ[j]) > (maxXYZ[axis] - minXYZ[axis])) {
+         axis = j;
+      }
+   }
+   
+   const int middleIndex = (beginIndex + endIndex) / 2;
+   std::nth_element(order.begin() + beginIndex,
+                    order.begin() + middleIndex,
+                    order.begin() + endIndex,
+                    AxisCompare(xyzIn, axis));
+   splitAxis[middleIndex] = static_cast<unsigned char>(axis);
+   
+   buildTree(xyzIn, order, beginIndex, middleIndex);
+   buildTree(xyzIn, order, middleIndex + 1, endIndex);
+}
+
+/**
+ * get the points and their ids (appended to the vectors).
+ */
+void 
+PointKDTree::getPoints(std::vector<float>& xyzOut,
+                       std::vector<int>& idsOut) const
+{
+   xyzOut.insert(xyzOut.end(), pointXYZ.begin(), pointXYZ.end());
+   idsOut.insert(idsOut.end(), ids.begin(), ids.end());
+}
+
+/**
+ * squared distance from location to a point.
+ */
+inline float 
+PointKDTree::distanceSquared(const int pointIndex, const float xyz[3]) const
+{
+   const float* p = &pointXYZ[pointIndex * 3];
+   const float dx = p[0] - xyz[0];
+   const float dy = p[1] - xyz[1];
+   const float dz = p[2] - xyz[2];
+   return (dx*dx + dy*dy + dz*dz);
+}
+
+/**
+ * get the id of the nearest point (-1 if tree is empty).
+ */
+int 
+PointKDTree::getNearestPoint(const float xyz[3],
+                             float* distanceSquaredOut) const
+{
+   int nearestIndex = -1;
+   float nearestDistanceSquared = std::numeric_limits<float>::max();
+   searchNearest(0, getNumberOfPoints(), xyz, nearestIndex, nearestDistanceSquared);
+   
+   if (nearestIndex < 0) {
+      return -1;
+   }
+   if (distanceSquaredOut != NULL) {
+      *distanceSquaredOut = nearestDistanceSquared;
+   }
+   return ids[nearestIndex];
+}
+
+/**
+ * get the ids of the nearest point for many locations (three coordinates
+ * per location).
+ */
+void 
+PointKDTree::getNearestPoints(const float* xyzs,
+                              const int numberOfLocations,
+                              int* idsOut,
+                              const bool runParallelFlag) const
+{
+   if (runParallelFlag) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 256)
+#endif
+      for (int i = 0; i < numberOfLocations; i++) {
+         idsOut[i] = getNearestPoint(&xyzs[i * 3]);
+      }
+   }
+   else {
+      for (int i = 0; i < numberOfLocations; i++) {
+         idsOut[i] = getNearestPoint(&xyzs[i * 3]);
+      }
+   }
+}
+
+/**
+ * get the ids of the "k" nearest points, nearest first.
+ */
+void 
+PointKDTree::getNearestPoints(const float xyz[3],
+                              const int k,
+                              std::vector<int>& idsOut,
+                              std::vector<float>& distancesSquaredOut) const
+{
+   idsOut.clear();
+   distancesSquaredOut.clear();
+   if (k <= 0) {
+      return;
+   }
+   
+   std::vector<std::pair<float, int> > heap;
+   heap.reserve(k + 1);
+   searchKNearest(0, getNumberOfPoints(), xyz, static_cast<unsigned int>(k), heap);
+   
+   std::sort_heap(heap.begin(), heap.end());
+   for (unsigned int i = 0; i < heap.size(); i++) {
+      distancesSquaredOut.push_back(heap[i].first);
+      idsOut.push_back(ids[heap[i].second]);
+   }
+}
+
+/**
+ * get the ids of the points within the radius.
+ */
+void 
+PointKDTree::getPointsWithinRadius(const float xyz[3],
+                                   const float radius,
+                                   std::vector<int>& idsOut) const
+{
+   idsOut.clear();
+   if (radius < 0.0) {
+      return;
+   }
+   searchRadius(0, getNumberOfPoints(), xyz, radius * radius, idsOut);
+}
+
+/**
+ * search a range for the nearest point.  The half of the range containing
+ * the location is searched first so the other half can usually be skipped.
+ */
+void 
+PointKDTree::searchNearest(const int beginIndex,
+                           const int endIndex,
+                           const float xyz[3],
+                           int& nearestIndex,
+                           float& nearestDistanceSquared) const
+{
+   if ((endIndex - beginIndex) <= LEAF_SIZE) {
+      for (int i = beginIndex; i < endIndex; i++) {
+         const float d = distanceSquared(i, xyz);
+         if (d < nearestDistanceSquared) {
+            nearestDistanceSquared = d;
+            nearestIndex = i;
+         }
+      }
+      return;
+   }
+   
+   const int middleIndex = (beginIndex + endIndex) / 2;
+   const float d = distanceSquared(middleIndex, xyz);
+   if (d < nearestDistanceSquared) {
+      nearestDistanceSquared = d;
+      nearestIndex = middleIndex;
+   }
+   
+   const int axis = splitAxis[middleIndex];
+   const float delta = xyz[axis] - pointXYZ[middleIndex * 3 + axis];
+   if (delta < 0.0) {
+      searchNearest(beginIndex, middleIndex, xyz, nearestIndex, nearestDistanceSquared);
+      if ((delta * delta) < nearestDistanceSquared) {
+         searchNearest(middleIndex + 1, endIndex, xyz, nearestIndex, nearestDistanceSquared);
+      }
+   }
+   else {
+      searchNearest(middleIndex + 1, endIndex, xyz, nearestIndex, nearestDistanceSquared);
+      if ((delta * delta) < nearestDistanceSquared) {
+         searchNearest(beginIndex, middleIndex, xyz, nearestIndex, nearestDistanceSquared);
+      }
+   }
+}
+
+/**
+ * search a range for the "k" nearest points.  The heap is a max heap so
+ * its first element is the farthest of the points found so far.
+ */
+void 
+PointKDTree::searchKNearest(const int beginIndex,
+                            const int endIndex,
+                            const float xyz[3],
+                            const unsigned int k,
+                            std::vector<std::pair<float, int> >& heap) const
+{
+   const int middleIndex = (beginIndex + endIndex) / 2;
+   const bool leafFlag = ((endIndex - beginIndex) <= LEAF_SIZE);
+   const int firstIndex = (leafFlag ? beginIndex : middleIndex);
+   const int lastIndex  = (leafFlag ? endIndex : (middleIndex + 1));
+   for (int i = firstIndex; i < lastIndex; i++) {
+      const float d = distanceSquared(i, xyz);
+      if (heap.size() < k) {
+         heap.push_back(std::make_pair(d, i));
+         std::push_heap(heap.begin(), heap.end());
+      }
+      else if (d < heap.front().first) {
+         std::pop_heap(heap.begin(), heap.end());
+         heap.back() = std::make_pair(d, i);
+         std::push_heap(heap.begin(), heap.end());
+      }
+   }
+   if (leafFlag) {
+      return;
+   }
+   
+   const int axis = splitAxis[middleIndex];
+   const float delta = xyz[axis] - pointXYZ[middleIndex * 3 + axis];
+   const int nearBegin = ((delta < 0.0) ? beginIndex : (middleIndex + 1));
+   const int nearEnd   = ((delta < 0.0) ? middleIndex : endIndex);
+   const int farBegin  = ((delta < 0.0) ? (middleIndex + 1) : beginIndex);
+   const int farEnd    = ((delta < 0.0) ? endIndex : middleIndex);
+   searchKNearest(nearBegin, nearEnd, xyz, k, heap);
+   if ((heap.size() < k) ||
+       ((delta * delta) < heap.front().first)) {
+      searchKNearest(farBegin, farEnd, xyz, k, heap);
+   }
+}
+
+/**
+ * search a range for points within the radius.
+ */
+void 
+PointKDTree::searchRadius(const int beginIndex,
+                          const int endIndex,
+                          const float xyz[3],
+                          const float radiusSquared,
+                          std::vector<int>& idsOut) const
+{
+   if ((endIndex - beginIndex) <= LEAF_SIZE) {
+      for (int i = beginIndex; i < endIndex; i++) {
+         if (distanceSquared(i, xyz) <= radiusSquared) {
+            idsOut.push_back(ids[i]);
+         }
+      }
+      return;
+   }
+   
+   const int middleIndex = (beginIndex + endIndex) / 2;
+   if (distanceSquared(middleIndex, xyz) <= radiusSquared) {
+      idsOut.push_back(ids[middleIndex]);
+   }
+   
+   const int axis = splitAxis[middleIndex];
+   const float delta = xyz[axis] - pointXYZ[middleIndex * 3 + axis];
+   if ((delta <= 0.0) || ((delta * delta) <= radiusSquared)) {
+      searchRadius(beginIndex, middleIndex, xyz, radiusSquared, idsOut);
+   }
+   if ((delta >= 0.0) || ((delta * delta) <= radiusSquared)) {
+      searchRadius(middleIndex + 1, endIndex, xyz, radiusSquared, idsOut);
+   }
+}
@@ -0,0 +1,140 @@
+#ifndef __POINT_KD_TREE_H__
+#define __POINT_KD_TREE_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/// A kd-tree for finding the nearest point(s) to a location.  The points are
+/// stored in tree order so a search reads them contiguously.  The tree is
+/// built once from a set of points; queries do not modify the tree so
+/// any number of threads may query it at the same time.
+class PointKDTree {
+   public:
+      // constructor
+      PointKDTree();
+      
+      // destructor
+      ~PointKDTree();
+      
+      // build the tree from points (ids may be NULL to use point indices)
+      void setPoints(const float* xyzIn,
+                     const int* idsIn,
+                     const int numberOfPointsIn);
+      
+      /// get the number of points
+      int getNumberOfPoints() const { return static_cast<int>(ids.size()); }
+      
+      // get the points and their ids (appended to the vectors)
+      void getPoints(std::vector<float>& xyzOut,
+                     std::vector<int>& idsOut) const;
+      
+      // get the id of the nearest point (-1 if tree is empty)
+      int getNearestPoint(const float xyz[3],
+                          float* distanceSquaredOut = NULL) const;
+      
+      // get the ids of the nearest point for many locations
+      void getNearestPoints(const float* xyzs,
+                            const int numberOfLocations,
+                            int* idsOut,
+                            const bool runParallelFlag) const;
+      
+      // get the ids of the "k" nearest points, nearest first
+      void getNearestPoints(const float xyz[3],
+                            const int k,
+                            std::vector<int>& idsOut,
+                            std::vector<float>& distancesSquaredOut) const;
+      
+      // get the ids of the points within the radius
+      void getPointsWithinRadius(const float xyz[3],
+                                 const float radius,
+                                 std::vector<int>& idsOut) const;
+      
+   protected:
+      /// ranges with this many points or fewer are searched linearly
+      enum { LEAF_SIZE = 8 };
+      
+      /// compares points along an axis when building the tree
+      class AxisCompare {
+         public:
+            /// constructor
+            AxisCompare(const float* xyzIn, const int axisIn) 
+               : xyz(xyzIn), axis(axisIn) { }
+            
+            /// compare two points
+            bool operator()(const int p1, const int p2) const 
+               { return (xyz[p1 * 3 + axis] < xyz[p2 * 3 + axis]); }
+            
+         protected:
+            /// coordinates of points
+            const float* xyz;
+            
+            /// axis to compare
+            int axis;
+      };
+      
+      // build the tree for a range of points
+      void buildTree(const float* xyzIn,
+                     std::vector<int>& order,
+                     const int beginIndex,
+                     const int endIndex);
+      
+      // search a range for the nearest point
+      void searchNearest(const int beginIndex,
+                         const int endIndex,
+                         const float xyz[3],
+                         int& nearestIndex,
+                         float& nearestDistanceSquared) const;
+      
+      // search a range for the "k" nearest points (max heap of distance and index)
+      void searchKNearest(const int beginIndex,
+                          const int endIndex,
+                          const float xyz[3],
+                          const unsigned int k,
+                          std::vector<std::pair<float, int> >& heap) const;
+      
+      // search a range for points within the radius
+      void searchRadius(const int beginIndex,
+                        const int endIndex,
+                        const float xyz[3],
+                        const float radiusSquared,
+                        std::vector<int>& idsOut) const;
+      
+      // squared distance from location to a point
+      inline float distanceSquared(const int pointIndex, const float xyz[3]) const;
+      
+      /// coordinates of the points in tree order
+      std::vector<float> pointXYZ;
+      
+      /// ids of the points in tree order
+      std::vector<int> ids;
+      
+      /// axis that splits the range whose middle is the point 
+      std::vector<unsigned char> splitAxis;
+};
+
+#endif // __POINT_KD_TREE_H__
@@ -27,29 +27,18 @@
  */
 /*LICENSE_END*/
 
+#include <cstddef>
 #include <vector>
 
+class PointKDTree;
+
 /// This class is a 3D point locator.  Points may be added at any time.
+/// Added points go into a small buffer that is searched linearly; when the
+/// buffer fills it is merged with the kd-trees of increasing size so that
+/// each point is rebuilt into a tree only a logarithmic number of times.
 class PointLocator {
-   protected:
-      /// Information about a point
-      class Point {
-         public:
-            /// Constructor
-            Point(const float xyzIn[3], const int idIn = -1);
-            
-            /// Destructor
-            ~Point();
-            
-            /// point's coordinate
-            float xyz[3];
-            
-            /// point's ID
-            int idNum;            
-      };
-      
    public:
-      /// Constructor
+      /// Constructor (the number of buckets is no longer used)
       PointLocator(const float boundsIn[6],
                    const int* numBucketsInEachAxis = NULL);
       
@@ -63,68 +52,36 @@ class PointLocator {
       int getNearestPoint(const float xyz[3]) const;
       
    protected:
-      /// Class for storing a bucket
-      class Bucket {
-         public:
-            /// constructor
-            Bucket();
-            
-            /// destructor
-            ~Bucket();
-            
-            /// get nearest point
-            int getNearestPoint(const float xyz[3], float& nearbyDistSQ,
-                                float nearbyXYZ[3]) const;
-            
-            /// the bounds of the bucket
-            float bounds[6];
-            
-            /// the points in the bucket
-            std::vector<Point> points;
-      };
-      
-      /// get bucket for a point (returns false if not in a bucket - out of bounds)
-      bool getBucket(const float xyz[3], int ijk[3]) const;
-      
-      /// get one dimensional bucket index
-      int getBucketIndex(const int ijk[3]) const;
-      
-      /// get one dimensional bucket index
-      int getBucketIndex(const float xyz[3]) const;
+      /// number of points held in the buffer before it is merged into a tree
+      enum { BUFFER_SIZE = 32 };
       
-      /// limit the IJK index to valid buckets
-      void limitIJK(int ijk[3]) const;
+      /// see if a point is within the bounds
+      bool pointInBounds(const float xyz[3]) const;
       
-      /// the buckets
-      Bucket* buckets;
+      /// merge the buffer into the trees
+      void mergeBufferIntoTrees();
       
-      /// size of buckets in X axis
-      float sizeX;
+      /// coordinates of points not yet in a tree
+      std::vector<float> bufferXYZ;
       
-      /// size of buckets in X axis
-      float sizeY;
+      /// ids of points not yet in a tree
+      std::vector<int> bufferIDs;
       
-      /// size of buckets in X axis
-      float sizeZ;
-      
-      /// number of buckets in X axis
-      int numX;
-      
-      /// number of buckets in Y axis
-      int numY;
-      
-      /// number of buckets in Z axis
-      int numZ;
-      
-      /// total number of buckets
-      int totalNumBuckets;
+      /// the trees (tree "i" is empty or holds BUFFER_SIZE * 2^i points)
+      std::vector<PointKDTree*> trees;
       
       /// bounds of the point locator
       float bounds[6];
       
       /// keeps count of points added
       int pointCounter;
+      
+   private:
+      /// copy constructor (not allowed, trees are owned)
+      PointLocator(const PointLocator&);
+      
+      /// assignment operator (not allowed, trees are owned)
+      PointLocator& operator=(const PointLocator&);
 };
 
 #endif // __POINT_LOCATOR_H__
-
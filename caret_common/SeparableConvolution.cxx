@@ -0,0 +1,226 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "SeparableConvolution.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * convolve a row of voxels with a kernel whose center tap is at "radius".
+ * The row's interior is accumulated tap by tap, voxels near its ends use
+ * the clamped edge voxels.  Taps are added in the same order everywhere.
+ */
+static void
+convolveRow(const float* input,
+            float* output,
+            const int numValues,
+            const float* kernel,
+            const int numTaps,
+            const int radius)
+{
+   const int interiorStart = std::min(radius, numValues);
+   const int interiorEnd = std::max(interiorStart, numValues - (numTaps - 1 - radius));
+   
+   for (int i = interiorStart; i < interiorEnd; i++) {
+      output[i] = 0.0;
+   }
+   for (int t = 0; t < numTaps; t++) {
+      const float weight = kernel[t];
+      const int offset = t - radius;
+      for (int i = interiorStart; i < interiorEnd; i++) {
+         output[i] += weight * input[i + offset];
+      }
+   }
+   
+   const int lastIndex = numValues - 1;
+   for (int i = 0; i < numValues; i++) {
+      if (i == interiorStart) {
+         i = interiorEnd;
+         if (i >= numValues) {
+            break;
+         }
+      }
+      float sum = 0.0;
+      for (int t = 0; t < numTaps; t++) {
+         const int indx = std::min(std::max(i + t - radius, 0), lastIndex);
+         sum += kernel[t] * input[indx];
+      }
+      output[i] = sum;
+   }
+}
+
+/**
+ * constructor.
+ */
+SeparableConvolution::SeparableConvolution()
+{
+}
+
+/**
+ * destructor.
+ */
+SeparableConvolution::~SeparableConvolution()
+{
+}
+
+/**
+ * convolve the voxels with the same kernel along each axis.
+ */
+void 
+SeparableConvolution::convolve(float* voxels,
+                               const int dim[3],
+                               const std::vector<float>& kernel)
+{
+   convolve(voxels, dim, kernel, kernel, kernel);
+}
+
+/**
+ * convolve the voxels with a kernel for each axis (an axis with an empty
+ * kernel is not convolved).  Axes are convolved in X, Y, Z order.
+ */
+void 
+SeparableConvolution::convolve(float* voxels,
+                               const int dim[3],
+                               const std::vector<float>& kernelX,
+                               const std::vector<float>& kernelY,
+                               const std::vector<float>& kernelZ)
+{
+   const long numVoxels = static_cast<long>(dim[0]) * dim[1] * dim[2];
+   if (numVoxels <= 0) {
+      return;
+   }
+   if (static_cast<long>(scratchVolume.size()) < numVoxels) {
+      scratchVolume.resize(numVoxels);
+   }
+   
+   //
+   // Each axis reads from one of the voxels or scratch volume and writes 
+   // to the other
+   //
+   const std::vector<float>* kernels[3] = { &kernelX, &kernelY, &kernelZ };
+   float* input = voxels;
+   float* output = &scratchVolume[0];
+   for (int axis = 0; axis < 3; axis++) {
+      if (kernels[axis]->empty() == false) {
+         convolveAxis(input, output, dim, axis, *kernels[axis]);
+         std::swap(input, output);
+      }
+   }
+   
+   if (input != voxels) {
+      std::copy(input, input + numVoxels, voxels);
+   }
+}
+
+/**
+ * convolve the voxels along one axis (0=X, 1=Y, 2=Z).  Along Y and Z the
+ * rows of voxels neighboring an output row are added to it tap by tap.
+ */
+void 
+SeparableConvolution::convolveAxis(const float* input,
+                                   float* output,
+                                   const int dim[3],
+                                   const int axis,
+                                   const std::vector<float>& kernel)
+{
+   const int ncol = dim[0];
+   const int nrow = dim[1];
+   const int nslices = dim[2];
+   const long sliceSize = static_cast<long>(ncol) * nrow;
+   const int numTaps = static_cast<int>(kernel.size());
+   const int radius = numTaps / 2;
+   const float* taps = &kernel[0];
+   
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+   for (int k = 0; k < nslices; k++) {
+      for (int j = 0; j < nrow; j++) {
+         const long rowOffset = k * sliceSize + static_cast<long>(j) * ncol;
+         float* outputRow = output + rowOffset;
+         
+         if (axis == 0) {
+            convolveRow(input + rowOffset, outputRow, ncol, taps, numTaps, radius);
+         }
+         else {
+            for (int i = 0; i < ncol; i++) {
+               outputRow[i] = 0.0;
+            }
+            for (int t = 0; t < numTaps; t++) {
+               const float* inputRow = NULL;
+               if (axis == 1) {
+                  const int jj = std::min(std::max(j + t - radius, 0), nrow - 1);
+                  inputRow = input + k * sliceSize + static_cast<long>(jj) * ncol;
+               }
+               else {
+                  const int kk = std::min(std::max(k + t - radius, 0), nslices - 1);
+                  inputRow = input + kk * sliceSize + static_cast<long>(j) * ncol;
+               }
+               const float weight = taps[t];
+               for (int i = 0; i < ncol; i++) {
+                  outputRow[i] += weight * inputRow[i];
+               }
+            }
+         }
+      }
+   }
+}
+
+/**
+ * create a normalized Gaussian kernel from its full width at half maximum
+ * in voxels.  The kernel extends three standard deviations from its center.
+ */
+void 
+SeparableConvolution::createGaussianKernel(const float fullWidthHalfMaximum,
+                                           std::vector<float>& kernelOut)
+{
+   kernelOut.clear();
+   if (fullWidthHalfMaximum <= 0.0) {
+      kernelOut.push_back(1.0);
+      return;
+   }
+   
+   const double sigma = fullWidthHalfMaximum / (2.0 * std::sqrt(2.0 * std::log(2.0)));
+   const int radius = std::max(1, static_cast<int>(std::ceil(3.0 * sigma)));
+   
+   std::vector<double> weights(radius * 2 + 1);
+   double total = 0.0;
+   for (int i = -radius; i <= radius; i++) {
+      const double w = std::exp(-(i * i) / (2.0 * sigma * sigma));
+      weights[i + radius] = w;
+      total += w;
+   }
+   
+   kernelOut.resize(weights.size());
+   for (unsigned int i = 0; i < weights.size(); i++) {
+      kernelOut[i] = weights[i] / total;
+   }
+}
@@ -0,0 +1,72 @@
+#ifndef __SEPARABLE_CONVOLUTION_H__
+#define __SEPARABLE_CONVOLUTION_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#include <vector>
+
+/// Separable convolution of a volume with a kernel along each of its axes.
+/// Each output row of voxels is accumulated one kernel tap at a time over
+/// the whole row so that the arithmetic is in simple loops the compiler can
+/// vectorize, and voxels beyond the edges of the volume are the edge voxels.
+/// Slices are divided among threads.  The scratch volume is kept between
+/// calls so that an instance used repeatedly does not reallocate it.
+class SeparableConvolution {
+   public:
+      // constructor
+      SeparableConvolution();
+      
+      // destructor
+      ~SeparableConvolution();
+      
+      // convolve the voxels with the same kernel along each axis
+      void convolve(float* voxels,
+                    const int dim[3],
+                    const std::vector<float>& kernel);
+      
+      // convolve the voxels with a kernel for each axis
+      void convolve(float* voxels,
+                    const int dim[3],
+                    const std::vector<float>& kernelX,
+                    const std::vector<float>& kernelY,
+                    const std::vector<float>& kernelZ);
+      
+      // create a normalized Gaussian kernel from its full width at half maximum in voxels
+      static void createGaussianKernel(const float fullWidthHalfMaximum,
+                                       std::vector<float>& kernelOut);
+      
+   protected:
+      // convolve the voxels along one axis
+      void convolveAxis(const float* input,
+                        float* output,
+                        const int dim[3],
+                        const int axis,
+                        const std::vector<float>& kernel);
+      
+      /// scratch volume (only grows)
+      std::vector<float> scratchVolume;
+};
+
+#endif // __SEPARABLE_CONVOLUTION_H__
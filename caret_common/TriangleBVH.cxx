@@ -0,0 +1,393 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#include <algorithm>
+#include <limits>
+
+#include "TriangleBVH.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * constructor.
+ */
+TriangleBVH::TriangleBVH()
+{
+}
+
+/**
+ * destructor.
+ */
+TriangleBVH::~TriangleBVH()
+{
+}
+
+/**
+ * build the hierarchy.  "trianglesIn" contains three point indices for each
+ * triangle and "xyzIn" three coordinates for each point.  Triangles that use
+ * an invalid point index are ignored.
+ */
+void 
+TriangleBVH::setTriangles(const float* xyzIn,
+                          const int numberOfPointsIn,
+                          const int* trianglesIn,
+                          const int numberOfTrianglesIn)
+{
+   boxMinimum.clear();
+   boxMaximum.clear();
+   boxStart.clear();
+   boxCount.clear();
+   triangleXYZ.clear();
+   triangleIndex.clear();
+   
+   std::vector<int> order;
+   std::vector<float> centroids(numberOfTrianglesIn * 3, 0.0);
+   for (int i = 0; i < numberOfTrianglesIn; i++) {
+      const int* t = &trianglesIn[i * 3];
+      if ((t[0] < 0) || (t[0] >= numberOfPointsIn) ||
+          (t[1] < 0) || (t[1] >= numberOfPointsIn) ||
+          (t[2] < 0) || (t[2] >= numberOfPointsIn)) {
+         continue;
+      }
+      for (int j = 0; j < 3; j++) {
+         centroids[i * 3 + j] = (xyzIn[t[0] * 3 + j] 
+                               + xyzIn[t[1] * 3 + j] 
+                               + xyzIn[t[2] * 3 + j]) / 3.0;
+      }
+      order.push_back(i);
+   }
+   const int numTriangles = static_cast<int>(order.size());
+   if (numTriangles <= 0) {
+      return;
+   }
+   
+   //
+   // A binary tree with leaves of at least one triangle has fewer than
+   // twice as many boxes as triangles
+   //
+   const int maxBoxes = 2 * numTriangles;
+   boxMinimum.reserve(maxBoxes * 3);
+   boxMaximum.reserve(maxBoxes * 3);
+   boxStart.reserve(maxBoxes);
+   boxCount.reserve(maxBoxes);
+   boxMinimum.resize(3);
+   boxMaximum.resize(3);
+   boxStart.resize(1);
+   boxCount.resize(1);
+   buildBox(0, xyzIn,trianglesIn, &centroids[0], order, 0, numTriangles);
+   
+   //
+   // Store the triangles in traversal order
+   //
+   triangleXYZ.resize(numTriangles * 9);
+   triangleIndex.resize(numTriangles);
+   for (int i = 0; i < numTriangles; i++) {
+      const int* t = &trianglesIn[order[i] * 3];
+      for (int k = 0; k < 3; k++) {
+         for (int j = 0; j < 3; j++) {
+            triangleXYZ[i * 9 + k * 3 + j] = xyzIn[t[k] * 3 + j];
+         }
+      }
+      triangleIndex[i] = order[i];
+   }
+}
+
+/**
+ * build the box for a range of triangles.  Ranges larger than a leaf are 
+ * split at the median centroid along the axis in which the centroids have
+ * the largest extent.  The two child boxes are stored next to each other.
+ */
+void 
+TriangleBVH::buildBox(const int boxIndex,
+                      const float* xyzIn,
+                      const int* trianglesIn,
+                      const float* centroids,
+                      std::vector<int>& order,
+                      const int beginIndex,
+                      const int endIndex)
+{
+   float minXYZ[3], maxXYZ[3], minCentroid[3], maxCentroid[3];
+   for (int j = 0; j < 3; j++) {
+      minXYZ[j] = std::numeric_limits<float>::max();
+      maxXYZ[j] = -std::numeric_limits<float>::max();
+      minCentroid[j] = std::numeric_limits<float>::max();
+      maxCentroid[j] = -std::numeric_limits<float>::max();
+   }
+   for (int i = beginIndex; i < endIndex; i++) {
+      const int* t = &trianglesIn[order[i] * 3];
+      for (int k = 0; k < 3; k++) {
+         for (int j = 0; j < 3; j++) {
+            minXYZ[j] = std::min(minXYZ[j], xyzIn[t[k] * 3 + j]);
+            maxXYZ[j] = std::max(maxXYZ[j], xyzIn[t[k] * 3 + j]);
+         }
+      }
+      for (int j = 0; j < 3; j++) {
+         minCentroid[j] = std::min(minCentroid[j], centroids[order[i] * 3 + j]);
+         maxCentroid[j] = std::max(maxCentroid[j], centroids[order[i] * 3 + j]);
+      }
+   }
+   for (int j = 0; j < 3; j++) {
+      boxMinimum[boxIndex * 3 + j] = minXYZ[j];
+      boxMaximum[boxIndex * 3 + j] = maxXYZ[j];
+   }
+   
+   if ((endIndex - beginIndex) <= LEAF_SIZE) {
+      boxStart[boxIndex] = beginIndex;
+      boxCount[boxIndex] = endIndex - beginIndex;
+      return;
+   }
+   
+   int axis = 0;
+   for (int j = 1; j < 3; j++) {
+      if ((maxCentroid[j] - minCentroid[j]) > (maxCentroid[axis] - minCentroid[axis])) {
+         axis = j;
+      }
+   }
+   const int middleIndex = (beginIndex + endIndex) / 2;
+   std::nth_element(order.begin() + beginIndex,
+                    order.begin() + middleIndex,
+                    order.begin() + endIndex,
+                    CentroidCompare(centroids, axis));
+   
+   //
+   // Allocate both child boxes before building either so they are adjacent
+   //
+   const int firstChild = static_cast<int>(boxStart.size());
+   boxStart[boxIndex] = firstChild;
+   boxCount[boxIndex] = 0;
+   boxMinimum.resize((firstChild + 2) * 3);
+   boxMaximum.resize((firstChild + 2) * 3);
+   boxStart.resize(firstChild + 2);
+   boxCount.resize(firstChild + 2);
+   
+   buildBox(firstChild, xyzIn, trianglesIn, centroids, order, beginIndex, middleIndex);
+   buildBox(firstChild + 1, xyzIn, trianglesIn, centroids, order, middleIndex, endIndex);
+}
+
+/**
+ * squared distance from a location to a box (zero if inside).
+ */
+inline float 
+TriangleBVH::boxDistanceSquared(const int boxIndex, const float xyz[3]) const
+{
+   const float* minXYZ = &boxMinimum[boxIndex * 3];
+   const float* maxXYZ = &boxMaximum[boxIndex * 3];
+   float distSQ = 0.0;
+   for (int j = 0; j < 3; j++) {
+      const float below = minXYZ[j] - xyz[j];
+      const float above = xyz[j] - maxXYZ[j];
+      const float d = std::max(std::max(below, above), 0.0f);
+      distSQ += d * d;
+   }
+   return distSQ;
+}
+
+/**
+ * get the triangle closest to a location.  Returns the index of the triangle
+ * (as passed to setTriangles) or -1 if there are no triangles.  The barycentric
+ * weights are for the triangle's first, second, and third points and sum to one.
+ */
+int 
+TriangleBVH::getClosestTriangle(const float xyz[3],
+                                float barycentricOut[3],
+                                float closestXYZOut[3],
+                                float& distanceSquaredOut) const
+{
+   int closestTriangle = -1;
+   distanceSquaredOut = std::numeric_limits<float>::max();
+   if (boxStart.empty()) {
+      return -1;
+   }
+   
+   //
+   // Depth of the tree is logarithmic in the number of triangles
+   //
+   int stack[64];
+   int stackSize = 0;
+   stack[stackSize++] = 0;
+   
+   while (stackSize > 0) {
+      const int box = stack[--stackSize];
+      if (boxDistanceSquared(box, xyz) >= distanceSquaredOut) {
+         continue;
+      }
+      
+      if (boxCount[box] > 0) {
+         const int first = boxStart[box];
+         const int last  = first + boxCount[box];
+         for (int i = first; i < last; i++) {
+            const float* t = &triangleXYZ[i * 9];
+            float bary[3], closest[3];
+            closestPointOnTriangle(xyz, &t[0], &t[3], &t[6], bary, closest);
+            const float dx = closest[0] - xyz[0];
+            const float dy = closest[1] - xyz[1];
+            const float dz = closest[2] - xyz[2];
+            const float d = dx*dx + dy*dy + dz*dz;
+            if (d < distanceSquaredOut) {
+               distanceSquaredOut = d;
+               closestTriangle = triangleIndex[i];
+               for (int j = 0; j < 3; j++) {
+                  barycentricOut[j] = bary[j];
+                  closestXYZOut[j]  = closest[j];
+               }
+            }
+         }
+      }
+      else {
+         //
+         // Push the farther child first so the nearer child is searched first
+         //
+         const int child1 = boxStart[box];
+         const int child2 = child1 + 1;
+         const float d1 = boxDistanceSquared(child1, xyz);
+         const float d2 = boxDistanceSquared(child2, xyz);
+         if (d1 <= d2) {
+            if (d2 < distanceSquaredOut) stack[stackSize++] = child2;
+            if (d1 < distanceSquaredOut) stack[stackSize++] = child1;
+         }
+         else {
+            if (d1 < distanceSquaredOut) stack[stackSize++] = child1;
+            if (d2 < distanceSquaredOut) stack[stackSize++] = child2;
+         }
+      }
+   }
+   
+   return closestTriangle;
+}
+
+/**
+ * get the triangles closest to many locations (three coordinates per location).
+ * "barycentricOut" receives three weights per location.  "distanceSquaredOut"
+ * may be NULL.
+ */
+void 
+TriangleBVH::getClosestTriangles(const float* xyzs,
+                                 const int numberOfLocations,
+                                 int* trianglesOut,
+                                 float* barycentricOut,
+                                 float* distanceSquaredOut,
+                                 const bool runParallelFlag) const
+{
+   (void)runParallelFlag;  // unused without OpenMP
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 256) if (runParallelFlag)
+#endif
+   for (int i = 0; i < numberOfLocations; i++) {
+      float closestXYZ[3], distSQ;
+      trianglesOut[i] = getClosestTriangle(&xyzs[i * 3], 
+                                           &barycentricOut[i * 3],
+                                           closestXYZ,
+                                           distSQ);
+      if (distanceSquaredOut != NULL) {
+         distanceSquaredOut[i] = distSQ;
+      }
+   }
+}
+
+/**
+ * get the point on triangle "abc" closest to a location.  The location is 
+ * classified against the Voronoi regions of the triangle's vertices, edges,
+ * and face.
+ */
+void 
+TriangleBVH::closestPointOnTriangle(const float xyz[3],
+                                    const float a[3],
+                                    const float b[3],
+                                    const float c[3],
+                                    float barycentricOut[3],
+                                    float closestXYZOut[3])
+{
+   float ab[3], ac[3], ap[3];
+   for (int j = 0; j < 3; j++) {
+      ab[j] = b[j] - a[j];
+      ac[j] = c[j] - a[j];
+      ap[j] = xyz[j] - a[j];
+   }
+   
+   float u = 1.0, v = 0.0, w = 0.0;   // weights of a, b, c
+   
+   const float d1 = ab[0]*ap[0] + ab[1]*ap[1] + ab[2]*ap[2];
+   const float d2 = ac[0]*ap[0] + ac[1]*ap[1] + ac[2]*ap[2];
+   if ((d1 <= 0.0) && (d2 <= 0.0)) {
+      // vertex a
+   }
+   else {
+      float bp[3];
+      for (int j = 0; j < 3; j++) bp[j] = xyz[j] - b[j];
+      const float d3 = ab[0]*bp[0] + ab[1]*bp[1] + ab[2]*bp[2];
+      const float d4 = ac[0]*bp[0] + ac[1]*bp[1] + ac[2]*bp[2];
+      
+      float cp[3];
+      for (int j = 0; j < 3; j++) cp[j] = xyz[j] - c[j];
+      const float d5 = ab[0]*cp[0] + ab[1]*cp[1] + ab[2]*cp[2];
+      const float d6 = ac[0]*cp[0] + ac[1]*cp[1] + ac[2]*cp[2];
+      
+      const float vc = d1*d4 - d3*d2;
+      const float vb = d5*d2 - d1*d6;
+      const float va = d3*d6 - d5*d4;
+      
+      if ((d3 >= 0.0) && (d4 <= d3)) {
+         // vertex b
+         u = 0.0; v = 1.0;
+      }
+      else if ((d6 >= 0.0) && (d5 <= d6)) {
+         // vertex c
+         u = 0.0; w = 1.0;
+      }
+      else if ((vc <= 0.0) && (d1 >= 0.0) && (d3 <= 0.0)) {
+         // edge ab
+         v = d1 / (d1 - d3);
+         u = 1.0 - v;
+      }
+      else if ((vb <= 0.0) && (d2 >= 0.0) && (d6 <= 0.0)) {
+         // edge ac
+         w = d2 / (d2 - d6);
+         u = 1.0 - w;
+      }
+      else if ((va <= 0.0) && ((d4 - d3) >= 0.0) && ((d5 - d6) >= 0.0)) {
+         // edge bc
+         w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+         u = 0.0;
+         v = 1.0 - w;
+      }
+      else {
+         // face
+         const float sum = va + vb + vc;
+         if (sum != 0.0) {
+            v = vb / sum;
+            w = vc / sum;
+            u = 1.0 - v - w;
+         }
+      }
+   }
+   
+   barycentricOut[0] = u;
+   barycentricOut[1] = v;
+   barycentricOut[2] = w;
+   for (int j = 0; j < 3; j++) {
+      closestXYZOut[j] = u * a[j] + v * b[j] + w * c[j];
+   }
+}
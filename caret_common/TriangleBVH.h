@@ -0,0 +1,129 @@
+#ifndef __TRIANGLE_BVH_H__
+#define __TRIANGLE_BVH_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#include <cstddef>
+#include <vector>
+
+/// A bounding volume hierarchy of axis-aligned boxes over a set of triangles
+/// for finding the triangle closest to a location.  The hierarchy is built
+/// once; queries do not modify it so any number of threads may query it at
+/// the same time.  Boxes and triangle vertices are kept in flat arrays in
+/// traversal order.
+class TriangleBVH {
+   public:
+      // constructor
+      TriangleBVH();
+      
+      // destructor
+      ~TriangleBVH();
+      
+      // build the hierarchy (three point indices per triangle)
+      void setTriangles(const float* xyzIn,
+                        const int numberOfPointsIn,
+                        const int* trianglesIn,
+                        const int numberOfTrianglesIn);
+      
+      /// get the number of triangles in the hierarchy
+      int getNumberOfTriangles() const { return static_cast<int>(triangleIndex.size()); }
+      
+      // get the triangle closest to a location (-1 if there are no triangles)
+      int getClosestTriangle(const float xyz[3],
+                             float barycentricOut[3],
+                             float closestXYZOut[3],
+                             float& distanceSquaredOut) const;
+      
+      // get the triangles closest to many locations
+      void getClosestTriangles(const float* xyzs,
+                               const int numberOfLocations,
+                               int* trianglesOut,
+                               float* barycentricOut,
+                               float* distanceSquaredOut,
+                               const bool runParallelFlag) const;
+      
+      // get the point on a triangle closest to a location
+      static void closestPointOnTriangle(const float xyz[3],
+                                         const float a[3],
+                                         const float b[3],
+                                         const float c[3],
+                                         float barycentricOut[3],
+                                         float closestXYZOut[3]);
+      
+   protected:
+      /// boxes with this many triangles or fewer are leaves
+      enum { LEAF_SIZE = 4 };
+      
+      /// compares triangle centroids along an axis when building
+      class CentroidCompare {
+         public:
+            /// constructor
+            CentroidCompare(const float* centroidsIn, const int axisIn) 
+               : centroids(centroidsIn), axis(axisIn) { }
+            
+            /// compare two triangles
+            bool operator()(const int t1, const int t2) const 
+               { return (centroids[t1 * 3 + axis] < centroids[t2 * 3 + axis]); }
+            
+         protected:
+            /// centroids of triangles
+            const float* centroids;
+            
+            /// axis to compare
+            int axis;
+      };
+      
+      // build the box for a range of triangles
+      void buildBox(const int boxIndex,
+                    const float* xyzIn,
+                    const int* trianglesIn,
+                    const float* centroids,
+                    std::vector<int>& order,
+                    const int beginIndex,
+                    const int endIndex);
+      
+      // squared distance from a location to a box (zero if inside)
+      inline float boxDistanceSquared(const int boxIndex, const float xyz[3]) const;
+      
+      /// minimum corner of each box
+      std::vector<float> boxMinimum;
+      
+      /// maximum corner of each box
+      std::vector<float> boxMaximum;
+      
+      /// leaf: first triangle in box; otherwise: index of first child box (second follows)
+      std::vector<int> boxStart;
+      
+      /// number of triangles in a leaf box (zero if not a leaf)
+      std::vector<int> boxCount;
+      
+      /// vertex coordinates of the triangles in traversal order (nine per triangle)
+      std::vector<float> triangleXYZ;
+      
+      /// index of the triangles (as passed to setTriangles) in traversal order
+      std::vector<int> triangleIndex;
+};
+
+#endif // __TRIANGLE_BVH_H__
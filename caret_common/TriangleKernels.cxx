@@ -0,0 +1,228 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "TriangleKernels.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * compute the unit normal of each triangle ("normalsOut" has three values
+ * per triangle).  The normal is the cross product of (p3 - p2) and (p1 - p2)
+ * computed in double precision as in MathUtilities::computeNormal() so 
+ * that the results are identical.
+ */
+void 
+TriangleKernels::computeTriangleNormals(const float* xyz,
+                                        const int* triangles,
+                                        const int numberOfTriangles,
+                                        float* normalsOut)
+{
+   const int numBlocks = (numberOfTriangles + BLOCK_SIZE - 1) / BLOCK_SIZE;
+   
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+   for (int b = 0; b < numBlocks; b++) {
+      const int first = b * BLOCK_SIZE;
+      const int num = std::min(static_cast<int>(BLOCK_SIZE), numberOfTriangles - first);
+      
+      //
+      // Gather the edge vectors of the block's triangles
+      //
+      double ax[BLOCK_SIZE], ay[BLOCK_SIZE], az[BLOCK_SIZE];
+      double bx[BLOCK_SIZE], by[BLOCK_SIZE], bz[BLOCK_SIZE];
+      for (int i = 0; i < num; i++) {
+         const int* t = &triangles[(first + i) * 3];
+         const float* p1 = &xyz[t[0] * 3];
+         const float* p2 = &xyz[t[1] * 3];
+         const float* p3 = &xyz[t[2] * 3];
+         ax[i] = static_cast<double>(p3[0]) - p2[0];
+         ay[i] = static_cast<double>(p3[1]) - p2[1];
+         az[i] = static_cast<double>(p3[2]) - p2[2];
+         bx[i] = static_cast<double>(p1[0]) - p2[0];
+         by[i] = static_cast<double>(p1[1]) - p2[1];
+         bz[i] = static_cast<double>(p1[2]) - p2[2];
+      }
+      
+      //
+      // Cross product and normalization
+      //
+      double nx[BLOCK_SIZE], ny[BLOCK_SIZE], nz[BLOCK_SIZE];
+      for (int i = 0; i < num; i++) {
+         nx[i] = ay[i] * bz[i] - az[i] * by[i];
+         ny[i] = az[i] * bx[i] - ax[i] * bz[i];
+         nz[i] = ax[i] * by[i] - ay[i] * bx[i];
+         const double length = std::sqrt(nx[i]*nx[i] + ny[i]*ny[i] + nz[i]*nz[i]);
+         const double scale = ((length != 0.0) ? length : 1.0);
+         nx[i] /= scale;
+         ny[i] /= scale;
+         nz[i] /= scale;
+      }
+      
+      float* n = &normalsOut[first * 3];
+      for (int i = 0; i < num; i++) {
+         n[i * 3]     = nx[i];
+         n[i * 3 + 1] = ny[i];
+         n[i * 3 + 2] = nz[i];
+      }
+   }
+}
+
+/**
+ * compute the area of each triangle.  The formula is the one used by
+ * MathUtilities::triangleArea() so that the results are identical.
+ */
+void 
+TriangleKernels::computeTriangleAreas(const float* xyz,
+                                      const int* triangles,
+                                      const int numberOfTriangles,
+                                      float* areasOut)
+{
+   const int numBlocks = (numberOfTriangles + BLOCK_SIZE - 1) / BLOCK_SIZE;
+   
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+   for (int b = 0; b < numBlocks; b++) {
+      const int first = b * BLOCK_SIZE;
+      const int num = std::min(static_cast<int>(BLOCK_SIZE), numberOfTriangles - first);
+      
+      //
+      // Gather the corners of the block's triangles
+      //
+      float x1[BLOCK_SIZE], y1[BLOCK_SIZE], z1[BLOCK_SIZE];
+      float x2[BLOCK_SIZE], y2[BLOCK_SIZE], z2[BLOCK_SIZE];
+      float x3[BLOCK_SIZE], y3[BLOCK_SIZE], z3[BLOCK_SIZE];
+      for (int i = 0; i < num; i++) {
+         const int* t = &triangles[(first + i) * 3];
+         const float* p1 = &xyz[t[0] * 3];
+         const float* p2 = &xyz[t[1] * 3];
+         const float* p3 = &xyz[t[2] * 3];
+         x1[i] = p1[0]; y1[i] = p1[1]; z1[i] = p1[2];
+         x2[i] = p2[0]; y2[i] = p2[1]; z2[i] = p2[2];
+         x3[i] = p3[0]; y3[i] = p3[1]; z3[i] = p3[2];
+      }
+      
+      //
+      // Squared lengths of the sides and area
+      //
+      float* areas = &areasOut[first];
+      for (int i = 0; i < num; i++) {
+         const float dx12 = x1[i] - x2[i];
+         const float dy12 = y1[i] - y2[i];
+         const float dz12 = z1[i] - z2[i];
+         const float dx23 = x2[i] - x3[i];
+         const float dy23 = y2[i] - y3[i];
+         const float dz23 = z2[i] - z3[i];
+         const float dx31 = x3[i] - x1[i];
+         const float dy31 = y3[i] - y1[i];
+         const float dz31 = z3[i] - z1[i];
+         const float a = dx12*dx12 + dy12*dy12 + dz12*dz12;
+         const float b = dx23*dx23 + dy23*dy23 + dz23*dz23;
+         const float c = dx31*dx31 + dy31*dy31 + dz31*dz31;
+         const float d = a - b + c;
+         areas[i] = (0.25 * std::sqrt(std::fabs(4.0*a*c - d*d)));
+      }
+   }
+}
+
+/**
+ * add each triangle's vector (three values per triangle) to the vectors of
+ * its three points.  Points are updated in triangle order so the sums are
+ * the same as adding the triangles one at a time.
+ */
+void 
+TriangleKernels::accumulateTriangleVectorsToPoints(const int* triangles,
+                                                   const int numberOfTriangles,
+                                                   const float* triangleVectors,
+                                                   float* pointVectorsInOut)
+{
+   for (int i = 0; i < numberOfTriangles; i++) {
+      const float* v = &triangleVectors[i * 3];
+      for (int k = 0; k < 3; k++) {
+         float* p = &pointVectorsInOut[triangles[i * 3 + k] * 3];
+         p[0] += v[0];
+         p[1] += v[1];
+         p[2] += v[2];
+      }
+   }
+}
+
+/**
+ * add a fraction of each triangle's value to the values of its three points.
+ * Points are updated in triangle order.
+ */
+void 
+TriangleKernels::accumulateTriangleValuesToPoints(const int* triangles,
+                                                  const int numberOfTriangles,
+                                                  const float* triangleValues,
+                                                  const double fraction,
+                                                  float* pointValuesInOut)
+{
+   for (int i = 0; i < numberOfTriangles; i++) {
+      const float value = triangleValues[i] * fraction;
+      pointValuesInOut[triangles[i * 3]]     += value;
+      pointValuesInOut[triangles[i * 3 + 1]] += value;
+      pointValuesInOut[triangles[i * 3 + 2]] += value;
+   }
+}
+
+/**
+ * sum values.  Values are summed in fixed size blocks (in parallel) and the
+ * block sums are then summed in order, so the result does not depend upon
+ * the number of threads.
+ */
+double 
+TriangleKernels::sumValues(const float* values,
+                           const int numberOfValues)
+{
+   const int sumBlockSize = BLOCK_SIZE * 64;
+   const int numBlocks = (numberOfValues + sumBlockSize - 1) / sumBlockSize;
+   std::vector<double> blockSums(numBlocks, 0.0);
+   
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+   for (int b = 0; b < numBlocks; b++) {
+      const int first = b * sumBlockSize;
+      const int last  = std::min(first + sumBlockSize, numberOfValues);
+      double sum = 0.0;
+      for (int i = first; i < last; i++) {
+         sum += values[i];
+      }
+      blockSums[b] = sum;
+   }
+   
+   double total = 0.0;
+   for (int b = 0; b < numBlocks; b++) {
+      total += blockSums[b];
+   }
+   return total;
+}
@@ -0,0 +1,69 @@
+#ifndef __TRIANGLE_KERNELS_H__
+#define __TRIANGLE_KERNELS_H__
+
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+/// Batch kernels for the normals and areas of a triangle mesh.  Triangles are
+/// processed in fixed size blocks whose corner coordinates are gathered into
+/// separate x, y, and z arrays so the arithmetic on a block is in simple 
+/// loops the compiler can vectorize.  Blocks are divided among threads but 
+/// every result is independent of the number of threads.
+class TriangleKernels {
+   public:
+      // compute the unit normal of each triangle
+      static void computeTriangleNormals(const float* xyz,
+                                         const int* triangles,
+                                         const int numberOfTriangles,
+                                         float* normalsOut);
+      
+      // compute the area of each triangle
+      static void computeTriangleAreas(const float* xyz,
+                                       const int* triangles,
+                                       const int numberOfTriangles,
+                                       float* areasOut);
+      
+      // add each triangle's vector to the vectors of its three points
+      static void accumulateTriangleVectorsToPoints(const int* triangles,
+                                                    const int numberOfTriangles,
+                                                    const float* triangleVectors,
+                                                    float* pointVectorsInOut);
+      
+      // add a fraction of each triangle's value to the values of its three points
+      static void accumulateTriangleValuesToPoints(const int* triangles,
+                                                   const int numberOfTriangles,
+                                                   const float* triangleValues,
+                                                   const double fraction,
+                                                   float* pointValuesInOut);
+      
+      // sum values with an order that does not depend upon the number of threads
+      static double sumValues(const float* values,
+                              const int numberOfValues);
+      
+   protected:
+      /// number of triangles in a block
+      enum { BLOCK_SIZE = 64 };
+};
+
+#endif // __TRIANGLE_KERNELS_H__
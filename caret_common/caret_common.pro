@@ -30,9 +30,11 @@ dll {
 HEADERS += Basename.h \
       CaretException.h \
       CaretLinkedList.h \
+      CaretThreadPool.h \
       CaretTips.h \
       Category.h \
 	   CommandLineUtilities.h \
+	   CorrelationMatrixEngine.h \
        DateAndTime.h \
 	   DebugControl.h \
 	   FileUtilities.h \
@@ -42,9 +44,11 @@ HEADERS += Basename.h \
 	   MathUtilities.h \
 	   MatrixUtilities.h \
       NameIndexSort.h \
+      PointKDTree.h \
       PointLocator.h \
       ProgramParameters.h \
       ProgramParametersException.h \
+      SeparableConvolution.h \
       StatisticsUtilities.h \
       StringTable.h \
       Species.h \
@@ -52,15 +56,19 @@ HEADERS += Basename.h \
 	   StringUtilities.h \
       Structure.h \
 	   SystemUtilities.h \
+	   TriangleBVH.h \
+	   TriangleKernels.h \
       UbuntuMessage.h \
       ValueIndexSort.h \
     CaretVersion.h
 
 SOURCES += Basename.cxx \
       CaretLinkedList.cxx \
+      CaretThreadPool.cxx \
       CaretTips.cxx \
       Category.cxx \
 	   CommandLineUtilities.cxx \
+	   CorrelationMatrixEngine.cxx \
       DateAndTime.cxx \
 	   DebugControl.cxx \
 	   FileUtilities.cxx \
@@ -69,9 +77,11 @@ SOURCES += Basename.cxx \
 	   HttpFileDownload.cxx \
 	   MathUtilities.cxx \
       NameIndexSort.cxx \
+      PointKDTree.cxx \
       PointLocator.cxx \
       ProgramParameters.cxx \
       ProgramParametersException.cxx \
+      SeparableConvolution.cxx \
       StatisticsUtilities.cxx \
       StringTable.cxx \
       Species.cxx \
@@ -79,4 +89,6 @@ SOURCES += Basename.cxx \
 	   StringUtilities.cxx \
       Structure.cxx \
 	   SystemUtilities.cxx \
+	   TriangleBVH.cxx \
+	   TriangleKernels.cxx \
       ValueIndexSort.cxx
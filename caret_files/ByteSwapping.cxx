@@ -7,11 +7,14 @@
 void 
 ByteSwapping::swapBytes(short* n, int numToSwap)
 {
+   //
+   // Swap with shifts on unsigned values so that the loop has no
+   // per-byte stores (the other sizes use the same form)
+   //
+   unsigned short* u = (unsigned short*)n;
    for (int i = 0; i < numToSwap; i++) {
-      char* bytes = (char*)&n[i];
-      char  temp = bytes[0];
-      bytes[0] = bytes[1];
-      bytes[1] = temp;
+      const unsigned short v = u[i];
+      u[i] = static_cast<unsigned short>((v << 8) | (v >> 8));
    }
 }
 
@@ -30,15 +33,13 @@ ByteSwapping::swapBytes(unsigned short* n, int numToSwap)
 void 
 ByteSwapping::swapBytes(int* n, int numToSwap)
 {
+   unsigned int* u = (unsigned int*)n;
    for (int i = 0; i < numToSwap; i++) {
-      char* bytes = (char*)&n[i];
-      char  temp = bytes[0];
-      bytes[0] = bytes[3];
-      bytes[3] = temp;
-
-      temp = bytes[1];
-      bytes[1] = bytes[2];
-      bytes[2] = temp;
+      const unsigned int v = u[i];
+      u[i] = (v << 24)
+           | ((v << 8) & 0x00ff0000U)
+           | ((v >> 8) & 0x0000ff00U)
+           | (v >> 24);
    }
 }
 
@@ -57,23 +58,17 @@ ByteSwapping::swapBytes(unsigned int* n, int numToSwap)
 void 
 ByteSwapping::swapBytes(long long* n, int numToSwap)
 {
+   unsigned long long* u = (unsigned long long*)n;
    for (int i = 0; i < numToSwap; i++) {
-      char* bytes = (char*)&n[i];
-      char  temp = bytes[0];
-      bytes[0] = bytes[7];
-      bytes[7] = temp;
-
-      temp = bytes[1];
-      bytes[1] = bytes[6];
-      bytes[6] = temp;
-
-      temp = bytes[2];
-      bytes[2] = bytes[5];
-      bytes[5] = temp;
-
-      temp = bytes[3];
-      bytes[3] = bytes[4];
-      bytes[4] = temp;
+      const unsigned long long v = u[i];
+      u[i] = (v << 56)
+           | ((v << 40) & 0x00ff000000000000ULL)
+           | ((v << 24) & 0x0000ff0000000000ULL)
+           | ((v <<  8) & 0x000000ff00000000ULL)
+           | ((v >>  8) & 0x00000000ff000000ULL)
+           | ((v >> 24) & 0x0000000000ff0000ULL)
+           | ((v >> 40) & 0x000000000000ff00ULL)
+           | (v >> 56);
    }
 }
 
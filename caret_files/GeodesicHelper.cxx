@@ -30,12 +30,21 @@
 #include <iostream>
 #include <QMutexLocker>
 
-GeodesicHelper::GeodesicHelper(const CoordinateFile* coordsIn, const TopologyFile* topoFileIn)
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+GeodesicHelperBase::GeodesicHelperBase(const CoordinateFile* coordsIn, const TopologyFile* topoFileIn)
 {
-   marked = NULL;
+   numNodes = 0;
+   distances = NULL;
+   distances2 = NULL;
+   nodeNeighbors = NULL;
+   nodeNeighbors2 = NULL;
+   numNeighbors = NULL;
+   numNeighbors2 = NULL;
    if (coordsIn->getNumberOfNodes() != topoFileIn->getNumberOfNodes())
    {
-      numNodes = 0;
       return;
    }//sanity checks passed
    const TopologyHelper* topoHelpIn = topoFileIn->getTopologyHelper(false, true, false);
@@ -43,11 +52,7 @@ GeodesicHelper::GeodesicHelper(const CoordinateFile* coordsIn, const TopologyFil
    numNodes = coordsIn->getNumberOfNodes();
    //allocate
    float* coords = new float[3 * numNodes];
-   output = new float[numNodes];
    numNeighbors = new int[numNodes];
-   marked = new int[numNodes];
-   changed = new int[numNodes];
-   parent = new int[numNodes];
    nodeNeighbors = new int*[numNodes];
    distances = new float*[numNodes];
    coordsIn->getAllCoordinates(coords);//get coords
@@ -64,11 +69,11 @@ GeodesicHelper::GeodesicHelper(const CoordinateFile* coordsIn, const TopologyFil
          coordDiff(coords + coordbase, coords + neighbors[j] * 3, tempvec);
          distances[i][j] = std::sqrt(tempvec[0] * tempvec[0] + tempvec[1] * tempvec[1] + tempvec[2] * tempvec[2]);//precompute for speed in calls
       }//so few floating point operations, this should turn out symmetric
-      marked[i] = 0;//initialize
    }
    std::vector<int> tempneigh2;
    std::vector<float> tempdist2;
-   std::vector<int> maintiles, neightiles;
+   const int* maintiles, *neightiles;
+   int numMainTiles, numNeighTiles;
    nodeNeighbors2 = new int*[numNodes];
    numNeighbors2 = new int[numNodes];
    distances2 = new float*[numNodes];
@@ -77,8 +82,8 @@ GeodesicHelper::GeodesicHelper(const CoordinateFile* coordsIn, const TopologyFil
       tempneigh2.clear();
       tempdist2.clear();
       coordbase = i * 3;//precompute the multiplicative part of the coordinate index, for efficiency
-      topoHelpIn->getNodeTiles(i, maintiles);
-      for (j = 0; j < (int)maintiles.size(); ++j)
+      maintiles = topoHelpIn->getNodeTiles(i, numMainTiles);
+      for (j = 0; j < numMainTiles; ++j)
       {
          const int* tile1 = topoFileIn->getTile(maintiles[j]);
          myneigh = -1;
@@ -98,8 +103,8 @@ GeodesicHelper::GeodesicHelper(const CoordinateFile* coordsIn, const TopologyFil
          if (myneigh2 == -1) continue;//a tile has less than 3 distinct node numbers, move to next tile
          neighbase = myneigh * 3;
          neigh2base = myneigh2 * 3;
-         topoHelpIn->getNodeTiles(myneigh, neightiles);
-         for (k = 0; k < (int)neightiles.size(); ++k)
+         neightiles = topoHelpIn->getNodeTiles(myneigh, numNeighTiles);
+         for (k = 0; k < numNeighTiles; ++k)
          {
             const int* tile2 = topoFileIn->getTile(neightiles[k]);
             farnode = -1;
@@ -186,6 +191,66 @@ GeodesicHelper::GeodesicHelper(const CoordinateFile* coordsIn, const TopologyFil
    delete[] coords;
 }
 
+GeodesicHelperBase::~GeodesicHelperBase()
+{
+   if (numNeighbors)
+   {
+      for (int i = 0; i < numNodes; ++i)
+      {
+         delete[] nodeNeighbors[i];
+         delete[] nodeNeighbors2[i];
+         delete[] distances[i];
+         delete[] distances2[i];
+      }
+      delete[] numNeighbors;
+      delete[] numNeighbors2;
+      delete[] nodeNeighbors;
+      delete[] nodeNeighbors2;
+      delete[] distances;
+      delete[] distances2;
+   }
+}
+
+GeodesicHelper::GeodesicHelper(const CoordinateFile* coordsIn, const TopologyFile* topoFileIn)
+{
+   ownedBase = new GeodesicHelperBase(coordsIn, topoFileIn);
+   initialize(ownedBase);
+}
+
+GeodesicHelper::GeodesicHelper(const GeodesicHelperBase* baseIn)
+{
+   ownedBase = NULL;
+   initialize(baseIn);
+}
+
+void GeodesicHelper::initialize(const GeodesicHelperBase* baseIn)
+{//copy the graph pointers, so the dijkstra code doesn't need an extra indirection
+   numNodes = baseIn->numNodes;
+   distances = baseIn->distances;
+   distances2 = baseIn->distances2;
+   nodeNeighbors = baseIn->nodeNeighbors;
+   nodeNeighbors2 = baseIn->nodeNeighbors2;
+   numNeighbors = baseIn->numNeighbors;
+   numNeighbors2 = baseIn->numNeighbors2;
+   output = new float[numNodes];
+   marked = new int[numNodes];
+   changed = new int[numNodes];
+   parent = new int[numNodes];
+   for (int i = 0; i < numNodes; ++i)
+   {
+      marked[i] = 0;//initialize
+   }
+}
+
+GeodesicHelper::~GeodesicHelper()
+{
+   delete[] output;
+   delete[] marked;
+   delete[] changed;
+   delete[] parent;
+   delete ownedBase;//does nothing if base is shared
+}
+
 void GeodesicHelper::getNodesToGeoDist(const int node, const float maxdist, std::vector<int>& nodesOut, std::vector<float>& distsOut, const bool smoothflag)
 {//public methods sanity check, private methods process
    nodesOut.clear();
@@ -444,6 +509,59 @@ float** GeodesicHelper::getGeoAllToAll(const bool smooth)
    return ret;
 }
 
+void GeodesicHelper::getGeoAllToAllRows(const GeodesicHelperBase* baseIn, GeodesicHelperRowReceiver* receiver, const float maxdist, const bool smooth)
+{//doesn't reuse paths between roots like alltoall, but roots are independent, so it scales with cores and never needs more than a row per thread
+   const int numNodes = baseIn->getNumberOfNodes();
+   const bool sparse = (maxdist >= 0.0f);
+   const bool wantParents = receiver->getParentsNeeded();
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+   {
+      GeodesicHelper myhelper(baseIn);
+      std::vector<float> row, dists;
+      std::vector<int> rowParents, nodes;
+      if (!sparse)
+      {
+         row.resize(numNodes);
+         if (wantParents) rowParents.resize(numNodes);
+      }
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif
+      for (int root = 0; root < numNodes; ++root)
+      {
+         if (sparse)
+         {
+            myhelper.getNodesToGeoDist(root, maxdist, nodes, dists, smooth);
+#ifdef _OPENMP
+#pragma omp critical (GeodesicHelperRowReceiver)
+#endif
+            receiver->receiveRow(root, nodes, dists);
+         } else {
+            for (int i = 0; i < numNodes; ++i)
+            {
+               row[i] = -1.0f;//full surface dijkstra doesn't touch unconnected nodes
+            }
+            if (wantParents)
+            {
+               for (int i = 0; i < numNodes; ++i)
+               {
+                  rowParents[i] = -1;
+               }
+               myhelper.getGeoFromNode(root, &row[0], &rowParents[0], smooth);
+            } else {
+               myhelper.getGeoFromNode(root, &row[0], smooth);
+            }
+#ifdef _OPENMP
+#pragma omp critical (GeodesicHelperRowReceiver)
+#endif
+            receiver->receiveRow(root, &row[0], (wantParents ? &rowParents[0] : NULL));
+         }
+      }
+   }
+}
+
 void GeodesicHelper::alltoall(float** out, int** parents, bool smooth)
 {//propagates info about shortest paths not containing root to other roots, hopefully making the problem tractable
    int root, i, j, whichnode, whichneigh, numNeigh, remain, myparent, myparent2, myparent3, prevdots = 0, dots;
@@ -778,3 +896,118 @@ void GeodesicHelper::getGeoToTheseNodes(const int root, const std::vector<int>&
       distsOut[i] = output[ofInterest[i]];
    }
 }
+
+void GeodesicHelper::getNodesToGeoDist(const std::vector<int>& rootNodes, const std::vector<float>& maxdists, std::vector<int>& nodesOut, std::vector<float>& distsOut, std::vector<int>& rootIndicesOut, const bool smoothflag)
+{
+   nodesOut.clear();
+   distsOut.clear();
+   rootIndicesOut.clear();
+   int i, mysize = rootNodes.size();
+   if (mysize != (int)maxdists.size()) return;
+   for (i = 0; i < mysize; ++i)
+   {
+      if (rootNodes[i] < 0 || rootNodes[i] >= numNodes) return;
+   }
+   QMutexLocker locked(&inUse);
+   dijkstra(rootNodes, maxdists, nodesOut, distsOut, rootIndicesOut, smoothflag);
+}
+
+void GeodesicHelper::getNodesToGeoDist(const std::vector<int>& rootNodes, const float maxdist, std::vector<int>& nodesOut, std::vector<float>& distsOut, const bool smoothflag)
+{
+   std::vector<float> maxdists(rootNodes.size(), maxdist);
+   std::vector<int> rootIndices;
+   getNodesToGeoDist(rootNodes, maxdists, nodesOut, distsOut, rootIndices, smoothflag);
+}
+
+void GeodesicHelper::dijkstra(const std::vector<int>& roots, const std::vector<float>& maxdists, std::vector<int>& nodes, std::vector<float>& dists, std::vector<int>& nearest, bool smooth)
+{//value of a node is its distance minus the cutoff of the root it is reached from, so the heap expands the node with the most cutoff to spare first,
+ //and a node is within the cutoff of some root exactly when its value is not positive
+   int i, j, whichnode, whichneigh, numNeigh, numChanged = 0, numRoots = roots.size();
+   int* neighbors;
+   float tempf;
+   myheap active;
+   for (i = 0; i < numRoots; ++i)
+   {
+      whichnode = roots[i];
+      tempf = -maxdists[i];
+      if (tempf > 0.0f) continue;//negative cutoff, root itself is not included
+      if (!(marked[whichnode] & 4))
+      {
+         marked[whichnode] |= 4;
+         changed[numChanged++] = whichnode;
+      } else if (tempf >= output[whichnode]) {
+         continue;//same node given as a root again, with no more cutoff
+      }
+      output[whichnode] = tempf;
+      parent[whichnode] = i;//parent array holds the index of the root the value comes from
+      active.push(whichnode, tempf);
+   }
+   while (!active.isEmpty())
+   {
+      whichnode = active.pop();
+      if (!(marked[whichnode] & 1))
+      {
+         nodes.push_back(whichnode);
+         dists.push_back(output[whichnode] + maxdists[parent[whichnode]]);
+         nearest.push_back(parent[whichnode]);
+         marked[whichnode] |= 1;
+         neighbors = nodeNeighbors[whichnode];
+         numNeigh = numNeighbors[whichnode];
+         for (j = 0; j < numNeigh; ++j)
+         {
+            whichneigh = neighbors[j];
+            if (!(marked[whichneigh] & 1))
+            {//skip floating point math if marked
+               tempf = output[whichnode] + distances[whichnode][j];
+               if (tempf <= 0.0f)
+               {//keep it off the heap if it is too far from every root
+                  if (!(marked[whichneigh] & 4))
+                  {
+                     marked[whichneigh] |= 4;
+                     changed[numChanged++] = whichneigh;
+                     output[whichneigh] = tempf;
+                     parent[whichneigh] = parent[whichnode];
+                     active.push(whichneigh, tempf);
+                  } else if (tempf < output[whichneigh]) {
+                     output[whichneigh] = tempf;
+                     parent[whichneigh] = parent[whichnode];
+                     active.push(whichneigh, tempf);
+                  }
+               }
+            }
+         }
+         if (smooth)//repeat with numNeighbors2, nodeNeighbors2, distance2
+         {
+            neighbors = nodeNeighbors2[whichnode];
+            numNeigh = numNeighbors2[whichnode];
+            for (j = 0; j < numNeigh; ++j)
+            {
+               whichneigh = neighbors[j];
+               if (!(marked[whichneigh] & 1))
+               {//skip floating point math if marked
+                  tempf = output[whichnode] + distances2[whichnode][j];
+                  if (tempf <= 0.0f)
+                  {//keep it off the heap if it is too far from every root
+                     if (!(marked[whichneigh] & 4))
+                     {
+                        marked[whichneigh] |= 4;
+                        changed[numChanged++] = whichneigh;
+                        output[whichneigh] = tempf;
+                        parent[whichneigh] = parent[whichnode];
+                        active.push(whichneigh, tempf);
+                     } else if (tempf < output[whichneigh]) {
+                        output[whichneigh] = tempf;
+                        parent[whichneigh] = parent[whichnode];
+                        active.push(whichneigh, tempf);
+                     }
+                  }
+               }
+            }
+         }
+      }
+   }
+   for (i = 0; i < numChanged; ++i)
+   {
+      marked[changed[i]] = 0;//minimize reinitialization of arrays
+   }
+}
@@ -36,11 +36,53 @@
 class CoordinateFile;
 class TopologyFile;
 
-//NOTE: this class does NOT stay associated with the coord passed into it, it takes a snapshot of the surface in the constructor
-//This is because it is designed to be fast on repeated calls on a single surface
+//NOTE: these classes do NOT stay associated with the coord passed into them, they take a snapshot of the surface in the constructor
+//This is because they are designed to be fast on repeated calls on a single surface
 //For only a few calls, the constructor may take longer than simply using a well restricted BranModelSurfaceGeodesic
 //This is because it copies neighbors and precomputes all 1 hop and 2 hop shared edge distances in the constructor
 
+/// Immutable graph of a surface (neighbors and precomputed 1 hop and 2 hop distances), may be shared by
+/// any number of GeodesicHelpers in different threads, must outlive the GeodesicHelpers constructed from it
+class GeodesicHelperBase
+{
+   float** distances, **distances2;
+   int** nodeNeighbors, **nodeNeighbors2;
+   int* numNeighbors, *numNeighbors2;
+   int numNodes;
+   GeodesicHelperBase();//Don't allow construction without arguments
+   GeodesicHelperBase(const GeodesicHelperBase&);//or copying, it owns the arrays
+   GeodesicHelperBase& operator=(const GeodesicHelperBase&);
+   static void crossProd(const float in1[3], const float in2[3], float out[3]);//DO NOT PASS AN INPUT AS OUT
+   static float dotProd(const float in1[3], const float in2[3]);
+   static float normalize(float in[3]);
+   static void coordDiff(const float* coord1, const float* coord2, float out[3]);
+   friend class GeodesicHelper;
+public:
+   GeodesicHelperBase(const CoordinateFile* coordsIn, const TopologyFile* topoFileIn);
+   ~GeodesicHelperBase();
+   
+   /// Get the number of nodes in the graph
+   int getNumberOfNodes() const { return numNodes; }
+};
+
+/// Receives the rows of an all to all geodesic computation as they are finished, rows arrive in any order and from any thread, but never concurrently
+class GeodesicHelperRowReceiver
+{
+public:
+   virtual ~GeodesicHelperRowReceiver() { };
+   
+   /// Whether parents should be computed for full rows
+   virtual bool getParentsNeeded() const { return false; };
+   
+   /// Distances from root to all nodes (-1 if not connected), parents are NULL unless requested (root node has itself as parent)
+   virtual void receiveRow(const int root, const float* distances, const int* parents) = 0;
+   
+   /// Only the nodes within the cutoff of root, used when all to all is run with a cutoff
+   virtual void receiveRow(const int root, const std::vector<int>& nodes, const std::vector<float>& distances) = 0;
+};
+
+/// Query context for geodesic distances, holds only the scratch arrays, so one per thread is cheap when constructed from a shared GeodesicHelperBase
+/// (a single instance is also safe to share, calls are serialized with a mutex)
 class GeodesicHelper
 {
    class myheap
@@ -89,43 +131,33 @@ class GeodesicHelper
       };
       inline void clear() { store.clear(); };
    };
-   float* output, **distances, **distances2;//use primitives for speed, and they don't need to change size
-   int** nodeNeighbors, **nodeNeighbors2;//copy neighbors at constructor, because I don't want to mess with inheritance, and I want speed of repeated calls
+   float* output, **distances, **distances2;//use primitives for speed, graph pointers are copied from the base, and are never modified
+   int** nodeNeighbors, **nodeNeighbors2;
    int* numNeighbors, *numNeighbors2, *marked, *changed, *parent;
    int numNodes;
+   GeodesicHelperBase* ownedBase;//NULL when using a shared base
    GeodesicHelper() { marked = NULL; };//Don't allow construction without arguments
+   GeodesicHelper(const GeodesicHelper&);//or copying
+   GeodesicHelper& operator=(const GeodesicHelper&);
+   void initialize(const GeodesicHelperBase* baseIn);//allocate scratch arrays
    void dijkstra(const int root, const float maxdist, std::vector<int>& nodes, std::vector<float>& dists, bool smooth);//geodesic distance restricted
    void dijkstra(const int root, bool smooth);//full surface
    void alltoall(float** out, int** parents, bool smooth);//must be fully allocated
    void dijkstra(const int root, const std::vector<int>& interested, bool smooth);//partial surface
+   void dijkstra(const std::vector<int>& roots, const std::vector<float>& maxdists, std::vector<int>& nodes, std::vector<float>& dists, std::vector<int>& nearest, bool smooth);//multiple roots, each distance restricted
    QMutex inUse;
-   static void crossProd(const float in1[3], const float in2[3], float out[3]);//DO NOT PASS AN INPUT AS OUT
-   static float dotProd(const float in1[3], const float in2[3]);
-   static float normalize(float in[3]);
-   static void coordDiff(const float* coord1, const float* coord2, float out[3]);
 public:
+   /// Builds a private copy of the surface graph
    GeodesicHelper(const CoordinateFile* coordsIn, const TopologyFile* topoFileIn);
-   ~GeodesicHelper() {
-      if (marked) {
-         delete[] output;
-         delete[] numNeighbors;
-         delete[] numNeighbors2;
-         delete[] marked;
-         delete[] changed;
-         delete[] parent;
-         for (int i = 0; i < numNodes; ++i)
-         {
-            delete[] nodeNeighbors[i];
-            delete[] nodeNeighbors2[i];
-            delete[] distances[i];
-            delete[] distances2[i];
-         }
-         delete[] nodeNeighbors;
-         delete[] nodeNeighbors2;
-         delete[] distances;
-         delete[] distances2;
-      }
-   };
+   
+   /// Uses a shared surface graph, only allocates the scratch arrays
+   GeodesicHelper(const GeodesicHelperBase* baseIn);
+   
+   ~GeodesicHelper();
+   
+   /// Get the number of nodes
+   int getNumberOfNodes() const { return numNodes; }
+   
    /// Get distances from root node, up to a geodesic distance cutoff (stops computing when no more nodes are within that distance)
    void getNodesToGeoDist(const int node, const float maxdist, std::vector<int>& neighborsOut, std::vector<float>& distsOut, const bool smoothflag = true);
    
@@ -147,23 +179,34 @@ public:
    /// Get distances from all nodes to all nodes, passes back NULL if cannot allocate, if successful you must eventually delete the memory
    float** getGeoAllToAll(const bool smooth = true);//i really don't think this needs an overloaded function that outputs parents
    
+   /// Get distances from all nodes to all nodes with roots split across threads, each row goes to the receiver as it is finished so memory is only one row per thread,
+   /// a non-negative maxdist passes only the nodes within maxdist of each root (sparse, much faster for small cutoffs)
+   static void getGeoAllToAllRows(const GeodesicHelperBase* baseIn, GeodesicHelperRowReceiver* receiver, const float maxdist = -1.0f, const bool smooth = true);
+   
    /// Get distances to a restricted set of nodes - output vector is in the SAME ORDER and same size as the input vector ofInterest
    void getGeoToTheseNodes(const int root, const std::vector<int>& ofInterest, std::vector<float>& distsOut, bool smoothflag = true);
+   
+   /// Get nodes within the cutoff of any root node, each root has its own cutoff (same size as rootNodes), distance and index into rootNodes
+   /// of the root that reaches each node with the most cutoff to spare (the closest root when the cutoffs are equal), in order of discovery
+   void getNodesToGeoDist(const std::vector<int>& rootNodes, const std::vector<float>& maxdists, std::vector<int>& nodesOut, std::vector<float>& distsOut, std::vector<int>& rootIndicesOut, const bool smoothflag = true);
+   
+   /// Get nodes within a single cutoff of any root node, distance to the closest root
+   void getNodesToGeoDist(const std::vector<int>& rootNodes, const float maxdist, std::vector<int>& nodesOut, std::vector<float>& distsOut, const bool smoothflag = true);
 };
 
-inline void GeodesicHelper::crossProd(const float in1[3], const float in2[3], float out[3])
+inline void GeodesicHelperBase::crossProd(const float in1[3], const float in2[3], float out[3])
 {//avoid loops for speed - NOT SAFE TO PASS AN INPUT AS OUTPUT
    out[0] = in1[1] * in2[2] - in1[2] * in2[1];
    out[1] = in1[2] * in2[0] - in1[0] * in2[2];
    out[2] = in1[0] * in2[1] - in1[1] * in2[0];
 }
 
-inline float GeodesicHelper::dotProd(const float in1[3], const float in2[3])
+inline float GeodesicHelperBase::dotProd(const float in1[3], const float in2[3])
 {
    return in1[0] * in2[0] + in1[1] * in2[1] + in1[2] * in2[2];
 }
 
-inline float GeodesicHelper::normalize(float in[3])
+inline float GeodesicHelperBase::normalize(float in[3])
 {
    float mag = std::sqrt(in[0] * in[0] + in[1] * in[1] + in[2] * in[2]);
    in[0] /= mag;
@@ -172,7 +215,7 @@ inline float GeodesicHelper::normalize(float in[3])
    return mag;
 }
 
-inline void GeodesicHelper::coordDiff(const float* coord1, const float* coord2, float out[3])
+inline void GeodesicHelperBase::coordDiff(const float* coord1, const float* coord2, float out[3])
 {
    out[0] = coord1[0] - coord2[0];
    out[1] = coord1[1] - coord2[1];
@@ -0,0 +1,577 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+#include <algorithm>
+#include <cstring>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "GzipBlockFile.h"
+
+/// uncompressed size of a block
+static const int gzipBlockSize = 1048576;
+
+/// size of a block's gzip header (fixed header, extra length, extra field)
+static const int gzipBlockHeaderSize = 24;
+
+/// size of a block's gzip trailer (CRC-32 and uncompressed size)
+static const int gzipBlockTrailerSize = 8;
+
+/**
+ * Get the number of blocks that are compressed or decompressed at one time.
+ */
+static int
+getNumberOfBlocksPerGroup()
+{
+#ifdef _OPENMP
+   return std::max(omp_get_max_threads(), 1);
+#else
+   return 1;
+#endif
+}
+
+/**
+ * Store a 16-bit little endian value.
+ */
+static void
+putLittleEndian16(unsigned char* bytes, const unsigned int value)
+{
+   bytes[0] = static_cast<unsigned char>(value & 0xff);
+   bytes[1] = static_cast<unsigned char>((value >> 8) & 0xff);
+}
+
+/**
+ * Store a 32-bit little endian value.
+ */
+static void
+putLittleEndian32(unsigned char* bytes, const unsigned int value)
+{
+   putLittleEndian16(bytes, value & 0xffff);
+   putLittleEndian16(&bytes[2], (value >> 16) & 0xffff);
+}
+
+/**
+ * Get a 16-bit little endian value.
+ */
+static unsigned int
+getLittleEndian16(const unsigned char* bytes)
+{
+   return static_cast<unsigned int>(bytes[0]) 
+          | (static_cast<unsigned int>(bytes[1]) << 8);
+}
+
+/**
+ * Get a 32-bit little endian value.
+ */
+static unsigned int
+getLittleEndian32(const unsigned char* bytes)
+{
+   return getLittleEndian16(bytes) | (getLittleEndian16(&bytes[2]) << 16);
+}
+
+/**
+ * Compress data into a gzip block (gzip member).  The output must
+ * be large enough for the largest possible block.  Returns the size
+ * of the block or zero if compression failed.
+ */
+static int
+compressGzipBlock(const char* data,
+                  const int dataSize,
+                  unsigned char* output,
+                  const int outputSize)
+{
+   z_stream stream;
+   std::memset(&stream, 0, sizeof(stream));
+   if (deflateInit2(&stream, 
+                    Z_DEFAULT_COMPRESSION, 
+                    Z_DEFLATED, 
+                    -MAX_WBITS,   // raw deflate, gzip header is added here
+                    8, 
+                    Z_DEFAULT_STRATEGY) != Z_OK) {
+      return 0;
+   }
+   stream.next_in   = (Bytef*)data;
+   stream.avail_in  = dataSize;
+   stream.next_out  = output + gzipBlockHeaderSize;
+   stream.avail_out = outputSize - gzipBlockHeaderSize - gzipBlockTrailerSize;
+   const int result = deflate(&stream, Z_FINISH);
+   const int compressedSize = stream.total_out;
+   deflateEnd(&stream);
+   if (result != Z_STREAM_END) {
+      return 0;
+   }
+   
+   const int blockSize = gzipBlockHeaderSize + compressedSize + gzipBlockTrailerSize;
+   
+   //
+   // gzip header with the FEXTRA flag set, no modification time, unknown OS
+   //
+   output[0] = 0x1f;
+   output[1] = 0x8b;
+   output[2] = Z_DEFLATED;
+   output[3] = 0x04;
+   putLittleEndian32(&output[4], 0);
+   output[8] = 0;
+   output[9] = 255;
+   
+   //
+   // Extra field with one subfield "Ck" containing the block's
+   // compressed and uncompressed sizes
+   //
+   putLittleEndian16(&output[10], 12);
+   output[12] = 'C';
+   output[13] = 'k';
+   putLittleEndian16(&output[14], 8);
+   putLittleEndian32(&output[16], blockSize);
+   putLittleEndian32(&output[20], dataSize);
+   
+   //
+   // trailer
+   //
+   unsigned char* trailer = output + gzipBlockHeaderSize + compressedSize;
+   const uLong crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef*)data, dataSize);
+   putLittleEndian32(trailer, crc);
+   putLittleEndian32(&trailer[4], dataSize);
+   
+   return blockSize;
+}
+
+/**
+ * Check a gzip block header and get the block's sizes.
+ * Returns true if the header is a valid gzip block header.
+ */
+static bool
+parseGzipBlockHeader(const unsigned char* header,
+                     int& blockSizeOut,
+                     int& dataSizeOut)
+{
+   if ((header[0] != 0x1f) ||
+       (header[1] != 0x8b) ||
+       (header[2] != Z_DEFLATED) ||
+       (header[3] != 0x04) ||
+       (getLittleEndian16(&header[10]) != 12) ||
+       (header[12] != 'C') ||
+       (header[13] != 'k') ||
+       (getLittleEndian16(&header[14]) != 8)) {
+      return false;
+   }
+   
+   blockSizeOut = getLittleEndian32(&header[16]);
+   dataSizeOut  = getLittleEndian32(&header[20]);
+   if ((blockSizeOut < (gzipBlockHeaderSize + gzipBlockTrailerSize)) ||
+       (dataSizeOut < 0)) {
+      return false;
+   }
+   
+   return true;
+}
+
+/**
+ * Decompress a gzip block.  Returns true if the block decompressed to
+ * exactly "dataSize" bytes and its CRC is correct.
+ */
+static bool
+decompressGzipBlock(const unsigned char* block,
+                    const int blockSize,
+                    char* data,
+                    const int dataSize)
+{
+   z_stream stream;
+   std::memset(&stream, 0, sizeof(stream));
+   if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+      return false;
+   }
+   stream.next_in   = (Bytef*)(block + gzipBlockHeaderSize);
+   stream.avail_in  = blockSize - gzipBlockHeaderSize - gzipBlockTrailerSize;
+   stream.next_out  = (Bytef*)data;
+   stream.avail_out = dataSize;
+   const int result = inflate(&stream, Z_FINISH);
+   const int numDecompressed = stream.total_out;
+   inflateEnd(&stream);
+   
+   if ((result != Z_STREAM_END) || 
+       (numDecompressed != dataSize)) {
+      return false;
+   }
+   
+   const unsigned char* trailer = block + blockSize - gzipBlockTrailerSize;
+   const uLong crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef*)data, dataSize);
+   if ((getLittleEndian32(trailer) != (crc & 0xffffffffUL)) ||
+       (static_cast<int>(getLittleEndian32(&trailer[4])) != dataSize)) {
+      return false;
+   }
+   
+   return true;
+}
+
+//=============================================================================
+
+/**
+ * Constructor.
+ */
+GzipBlockFileWriter::GzipBlockFileWriter()
+{
+   blockWrittenFlag = false;
+   writeErrorFlag = false;
+}
+
+/**
+ * Destructor.
+ */
+GzipBlockFileWriter::~GzipBlockFileWriter()
+{
+   if (file.isOpen()) {
+      try {
+         close();
+      }
+      catch (FileException&) {
+      }
+   }
+}
+
+/**
+ * open the file for writing.
+ */
+void 
+GzipBlockFileWriter::open(const QString& fileNameIn) throw (FileException)
+{
+   file.setFileName(fileNameIn);
+   if (file.open(QIODevice::WriteOnly) == false) {
+      throw FileException(fileNameIn, "Unable to open for writing");
+   }
+   
+   const int numBlocks = getNumberOfBlocksPerGroup();
+   buffer.resize(numBlocks * gzipBlockSize);
+   compressedBlocks.resize(numBlocks);
+   for (int i = 0; i < numBlocks; i++) {
+      compressedBlocks[i].resize(compressBound(gzipBlockSize)
+                                 + gzipBlockHeaderSize
+                                 + gzipBlockTrailerSize);
+   }
+   
+   blockWrittenFlag = false;
+   writeErrorFlag = false;
+   setp(&buffer[0], &buffer[0] + buffer.size());
+}
+
+/**
+ * compress any remaining data and close the file.
+ */
+void 
+GzipBlockFileWriter::close() throw (FileException)
+{
+   if (file.isOpen() == false) {
+      return;
+   }
+   
+   //
+   // Compress the remaining data, a gzip file must contain at least one member
+   //
+   const int numBytes = static_cast<int>(pptr() - pbase());
+   if ((numBytes > 0) ||
+       (blockWrittenFlag == false)) {
+      if (compressAndWriteBlocks(numBytes) == false) {
+         writeErrorFlag = true;
+      }
+   }
+   setp(NULL, NULL);
+   
+   file.close();
+   buffer.clear();
+   compressedBlocks.clear();
+   
+   if (writeErrorFlag) {
+      throw FileException(file.fileName(), "Error compressing or writing data.");
+   }
+}
+
+/**
+ * called when the buffer is full.
+ */
+GzipBlockFileWriter::int_type 
+GzipBlockFileWriter::overflow(int_type c)
+{
+   if (writeErrorFlag ||
+       (file.isOpen() == false)) {
+      return traits_type::eof();
+   }
+   
+   if (compressAndWriteBlocks(static_cast<int>(pptr() - pbase())) == false) {
+      writeErrorFlag = true;
+      return traits_type::eof();
+   }
+   setp(&buffer[0], &buffer[0] + buffer.size());
+   
+   if (traits_type::eq_int_type(c, traits_type::eof()) == false) {
+      *pptr() = traits_type::to_char_type(c);
+      pbump(1);
+   }
+   
+   return traits_type::not_eof(c);
+}
+
+/**
+ * compress the buffered data and write the blocks to the file.
+ */
+bool 
+GzipBlockFileWriter::compressAndWriteBlocks(const int numBytes)
+{
+   const int numBlocks = std::max((numBytes + gzipBlockSize - 1) / gzipBlockSize, 1);
+   std::vector<int> blockSizes(numBlocks, 0);
+   
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+   for (int i = 0; i < numBlocks; i++) {
+      const int offset = i * gzipBlockSize;
+      const int dataSize = std::min(gzipBlockSize, numBytes - offset);
+      blockSizes[i] = compressGzipBlock(&buffer[offset],
+                                        dataSize,
+                                        &compressedBlocks[i][0],
+                                        static_cast<int>(compressedBlocks[i].size()));
+   }
+   
+   for (int i = 0; i < numBlocks; i++) {
+      if (blockSizes[i] <= 0) {
+         return false;
+      }
+      if (file.write((const char*)&compressedBlocks[i][0], blockSizes[i]) != blockSizes[i]) {
+         return false;
+      }
+   }
+   blockWrittenFlag = true;
+   
+   return true;
+}
+
+//=============================================================================
+
+/**
+ * Constructor for reading from a gzFile (gzFile is not closed by this reader).
+ */
+GzipBlockFileReader::GzipBlockFileReader(gzFile zipFileIn)
+{
+   zipFile = zipFileIn;
+   decompressedDataOffset = 0;
+   decompressedDataSize = 0;
+   position = 0;
+   totalDataSize = 0;
+}
+
+/**
+ * Constructor for reading a gzip block file.
+ */
+GzipBlockFileReader::GzipBlockFileReader(const QString& fileNameIn) throw (FileException)
+{
+   zipFile = NULL;
+   decompressedDataOffset = 0;
+   decompressedDataSize = 0;
+   position = 0;
+   totalDataSize = 0;
+   
+   file.setFileName(fileNameIn);
+   if (file.open(QIODevice::ReadOnly) == false) {
+      throw FileException(fileNameIn, "Unable to open for reading.");
+   }
+   readBlockIndex();
+}
+
+/**
+ * Destructor.
+ */
+GzipBlockFileReader::~GzipBlockFileReader()
+{
+   if (file.isOpen()) {
+      file.close();
+   }
+}
+
+/**
+ * is the file a gzip block file.
+ */
+bool 
+GzipBlockFileReader::isGzipBlockFile(const QString& fileNameIn)
+{
+   QFile f(fileNameIn);
+   if (f.open(QIODevice::ReadOnly) == false) {
+      return false;
+   }
+   
+   unsigned char header[gzipBlockHeaderSize];
+   const bool validFlag = (f.read((char*)header, gzipBlockHeaderSize) == gzipBlockHeaderSize);
+   f.close();
+   
+   int blockSize, dataSize;
+   return (validFlag &&
+           parseGzipBlockHeader(header, blockSize, dataSize));
+}
+
+/**
+ * find the blocks in the file.
+ */
+void 
+GzipBlockFileReader::readBlockIndex() throw (FileException)
+{
+   const qint64 fileSize = file.size();
+   qint64 offset = 0;
+   totalDataSize = 0;
+   while (offset < fileSize) {
+      unsigned char header[gzipBlockHeaderSize];
+      int blockSize = 0;
+      int dataSize = 0;
+      if ((file.seek(offset) == false) ||
+          (file.read((char*)header, gzipBlockHeaderSize) != gzipBlockHeaderSize) ||
+          (parseGzipBlockHeader(header, blockSize, dataSize) == false) ||
+          ((offset + blockSize) > fileSize)) {
+         throw FileException(file.fileName(), 
+                             "Invalid gzip block at offset " 
+                             + QString::number(offset) + ".");
+      }
+      
+      blockFileOffsets.push_back(offset);
+      blockCompressedSizes.push_back(blockSize);
+      blockDataOffsets.push_back(totalDataSize);
+      blockDataSizes.push_back(dataSize);
+      
+      offset += blockSize;
+      totalDataSize += dataSize;
+   }
+}
+
+/**
+ * read data (returns number of bytes read).
+ */
+int 
+GzipBlockFileReader::read(void* data, const unsigned int length)
+{
+   if (zipFile != NULL) {
+      return gzread(zipFile, data, length);
+   }
+   
+   char* output = (char*)data;
+   qint64 numRead = 0;
+   while ((numRead < length) &&
+          (position < totalDataSize)) {
+      //
+      // Decompress the blocks containing the position
+      //
+      if ((position < decompressedDataOffset) ||
+          (position >= (decompressedDataOffset + decompressedDataSize))) {
+         const int block = static_cast<int>(std::upper_bound(blockDataOffsets.begin(),
+                                                             blockDataOffsets.end(),
+                                                             position)
+                                            - blockDataOffsets.begin()) - 1;
+         if (decompressBlocks(block) == false) {
+            break;
+         }
+      }
+      
+      const qint64 num = std::min(static_cast<qint64>(length) - numRead,
+                                  decompressedDataOffset + decompressedDataSize - position);
+      std::memcpy(&output[numRead], 
+                  &decompressedData[position - decompressedDataOffset], 
+                  num);
+      numRead += num;
+      position += num;
+   }
+   
+   return static_cast<int>(numRead);
+}
+
+/**
+ * move to an offset in the uncompressed data (returns true if valid offset).
+ */
+bool 
+GzipBlockFileReader::seek(const qint64 offset)
+{
+   if (zipFile != NULL) {
+      return (gzseek(zipFile, offset, SEEK_SET) >= 0);
+   }
+   
+   if ((offset < 0) ||
+       (offset > totalDataSize)) {
+      return false;
+   }
+   position = offset;
+   return true;
+}
+
+/**
+ * decompress the blocks starting at the specified block.
+ */
+bool 
+GzipBlockFileReader::decompressBlocks(const int firstBlock)
+{
+   decompressedDataOffset = 0;
+   decompressedDataSize = 0;
+   
+   const int numBlocks = std::min(getNumberOfBlocksPerGroup(),
+                                  static_cast<int>(blockFileOffsets.size()) - firstBlock);
+   if ((firstBlock < 0) ||
+       (numBlocks <= 0)) {
+      return false;
+   }
+   const int lastBlock = firstBlock + numBlocks - 1;
+   
+   //
+   // Blocks are contiguous in the file so read them all at once
+   //
+   const qint64 compressedSize = blockFileOffsets[lastBlock] 
+                                 + blockCompressedSizes[lastBlock]
+                                 - blockFileOffsets[firstBlock];
+   compressedData.resize(compressedSize);
+   if ((file.seek(blockFileOffsets[firstBlock]) == false) ||
+       (file.read((char*)&compressedData[0], compressedSize) != compressedSize)) {
+      return false;
+   }
+   
+   const qint64 dataSize = blockDataOffsets[lastBlock]
+                           + blockDataSizes[lastBlock]
+                           - blockDataOffsets[firstBlock];
+   decompressedData.resize(dataSize);
+   
+   int numErrors = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1) reduction(+:numErrors)
+#endif
+   for (int i = firstBlock; i <= lastBlock; i++) {
+      if (decompressGzipBlock(&compressedData[blockFileOffsets[i] - blockFileOffsets[firstBlock]],
+                              blockCompressedSizes[i],
+                              &decompressedData[blockDataOffsets[i] - blockDataOffsets[firstBlock]],
+                              blockDataSizes[i]) == false) {
+         numErrors++;
+      }
+   }
+   if (numErrors > 0) {
+      return false;
+   }
+   
+   decompressedDataOffset = blockDataOffsets[firstBlock];
+   decompressedDataSize = dataSize;
+   
+   return true;
+}
+
@@ -0,0 +1,155 @@
+/*LICENSE_START*/
+/*
+ *  Copyright 1995-2002 Washington University School of Medicine
+ *
+ *  http://brainmap.wustl.edu
+ *
+ *  This file is part of CARET.
+ *
+ *  CARET is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  CARET is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with CARET; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+/*LICENSE_END*/
+
+
+#ifndef __GZIP_BLOCK_FILE_H__
+#define __GZIP_BLOCK_FILE_H__
+
+#include <streambuf>
+#include <vector>
+
+#include <QFile>
+#include <QString>
+
+#include "FileException.h"
+#include "zlib.h"
+
+/// Writes a gzip block file.  A gzip block file is a sequence of 
+/// independently compressed gzip members ("blocks").  The header of each
+/// member contains an extra field with the member's compressed and 
+/// uncompressed sizes so that the blocks can be located without 
+/// decompressing them.  Since concatenated gzip members are a valid gzip
+/// file, gunzip and zlib read the file as a single stream.
+///
+/// Data is written through the std::streambuf interface (use it with a
+/// std::ostream) and is compressed in parallel when a group of blocks
+/// has been filled.
+class GzipBlockFileWriter : public std::streambuf {
+   public:
+      /// Constructor
+      GzipBlockFileWriter();
+      
+      /// Destructor
+      ~GzipBlockFileWriter();
+      
+      /// open the file for writing
+      void open(const QString& fileNameIn) throw (FileException);
+      
+      /// compress any remaining data and close the file
+      void close() throw (FileException);
+      
+   protected:
+      /// called when the buffer is full
+      int_type overflow(int_type c);
+      
+   private:
+      /// compress the buffered data and write the blocks to the file
+      bool compressAndWriteBlocks(const int numBytes);
+      
+      /// the file being written
+      QFile file;
+      
+      /// uncompressed data waiting to be compressed
+      std::vector<char> buffer;
+      
+      /// compressed blocks
+      std::vector<std::vector<unsigned char> > compressedBlocks;
+      
+      /// a block has been written
+      bool blockWrittenFlag;
+      
+      /// an error occurred while writing
+      bool writeErrorFlag;
+};
+
+/// Reads a gzip file.  A gzip block file (see GzipBlockFileWriter) has its
+/// blocks located from their headers and decompressed in parallel.  Any other
+/// file is read through a zlib gzFile.
+class GzipBlockFileReader {
+   public:
+      /// Constructor for reading from a gzFile (gzFile is not closed by this reader)
+      GzipBlockFileReader(gzFile zipFileIn);
+      
+      /// Constructor for reading a gzip block file
+      GzipBlockFileReader(const QString& fileNameIn) throw (FileException);
+      
+      /// Destructor
+      ~GzipBlockFileReader();
+      
+      /// is the file a gzip block file
+      static bool isGzipBlockFile(const QString& fileNameIn);
+      
+      /// read data (returns number of bytes read)
+      int read(void* data, const unsigned int length);
+      
+      /// move to an offset in the uncompressed data (returns true if valid offset)
+      bool seek(const qint64 offset);
+      
+   private:
+      /// find the blocks in the file
+      void readBlockIndex() throw (FileException);
+      
+      /// decompress the blocks starting at the specified block
+      bool decompressBlocks(const int firstBlock);
+      
+      /// gzFile used when not reading a gzip block file
+      gzFile zipFile;
+      
+      /// the gzip block file
+      QFile file;
+      
+      /// offset of each block in the file
+      std::vector<qint64> blockFileOffsets;
+      
+      /// compressed size of each block including the gzip header and trailer
+      std::vector<int> blockCompressedSizes;
+      
+      /// offset of each block in the uncompressed data
+      std::vector<qint64> blockDataOffsets;
+      
+      /// uncompressed size of each block
+      std::vector<int> blockDataSizes;
+      
+      /// compressed data read from the file
+      std::vector<unsigned char> compressedData;
+      
+      /// uncompressed data of the most recently decompressed blocks
+      std::vector<char> decompressedData;
+      
+      /// offset of the decompressed data in the uncompressed data
+      qint64 decompressedDataOffset;
+      
+      /// number of bytes of decompressed data
+      qint64 decompressedDataSize;
+      
+      /// current position in the uncompressed data
+      qint64 position;
+      
+      /// total size of the uncompressed data
+      qint64 totalDataSize;
+};
+
+#endif // __GZIP_BLOCK_FILE_H__
+
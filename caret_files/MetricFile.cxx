@@ -29,6 +29,10 @@
 #include <limits>
 #include <sstream>
 
+#include <QDir>
+#include <QFile>
+#include <QTemporaryFile>
+
 #include "FileUtilities.h"
 #include "MathUtilities.h"
 #define _METRIC_MAIN_
@@ -76,6 +80,8 @@ MetricFile::MetricFile(const QString& descriptiveName,
                        FILE_IO_NONE,
                        FILE_IO_READ_AND_WRITE)
 {
+   nodeMajorDataStore = NULL;
+   nodeMajorDataStoreModified = 0;
    clear();
 }
 
@@ -98,6 +104,8 @@ MetricFile::MetricFile(const int initialNumberOfNodes,
                        FILE_IO_NONE,
                        FILE_IO_READ_AND_WRITE)
 {
+   nodeMajorDataStore = NULL;
+   nodeMajorDataStoreModified = 0;
    setNumberOfNodesAndColumns(initialNumberOfNodes, initialNumberOfColumns);
    for (int j = 0; j < initialNumberOfColumns; j++) {
       setColumnAllNodesToScalar(j, 0.0);
@@ -110,6 +118,8 @@ MetricFile::MetricFile(const int initialNumberOfNodes,
 MetricFile::MetricFile(const MetricFile& mf)
    : GiftiNodeDataFile(mf)
 {
+   nodeMajorDataStore = NULL;
+   nodeMajorDataStoreModified = 0;
    copyHelperMetric(mf);
 }
 
@@ -142,6 +152,7 @@ void
 MetricFile::copyHelperMetric(const MetricFile& mf)
 {
    columnMappingInfo = mf.columnMappingInfo;
+   removeNodeMajorDataStore();
 }
       
 /**
@@ -150,6 +161,7 @@ MetricFile::copyHelperMetric(const MetricFile& mf)
 void
 MetricFile::clear()
 {
+   removeNodeMajorDataStore();
    GiftiNodeDataFile::clear();
    setNumberOfNodesAndColumns(0, 0);
    //readColumnNamesOnly = false;
@@ -161,6 +173,7 @@ MetricFile::clear()
 void 
 MetricFile::addDataArray(GiftiDataArray* nda)
 {
+   removeNodeMajorDataStore();
    GiftiNodeDataFile::addDataArray(nda);
    columnMappingInfo.resize(getNumberOfDataArrays());
 }
@@ -173,6 +186,7 @@ MetricFile::append(const GiftiDataArrayFile& naf) throw (FileException)
 {
    const MetricFile& mf = dynamic_cast<const MetricFile&>(naf);
    int num = getNumberOfDataArrays();
+   removeNodeMajorDataStore();
    GiftiNodeDataFile::append(naf);
    int newNum = getNumberOfDataArrays();
    columnMappingInfo.resize(newNum);
@@ -207,6 +221,7 @@ MetricFile::append(const GiftiDataArrayFile& naf,
        indexDestination.push_back(-1);
    }
 
+   removeNodeMajorDataStore();
    GiftiNodeDataFile::append(naf, indexDestination, fcm);
    columnMappingInfo.resize(getNumberOfDataArrays());
 
@@ -230,6 +245,7 @@ MetricFile::resetDataArray(const int arrayIndex)
 {
    GiftiNodeDataFile::resetDataArray(arrayIndex);
    columnMappingInfo[arrayIndex].reset();
+   updateNodeMajorDataStoreColumn(arrayIndex);
 }
 
 /**
@@ -238,6 +254,7 @@ MetricFile::resetDataArray(const int arrayIndex)
 void 
 MetricFile::removeDataArray(const int arrayIndex)
 {
+   removeNodeMajorDataStore();
    GiftiNodeDataFile::removeDataArray(arrayIndex);
    
    for (int i = arrayIndex; i < (arrayIndex - 1); i++) {
@@ -712,11 +729,16 @@ void
 MetricFile::setValue(const int nodeNumber, const int columnNumber,
                const float metric)
 {
+   const bool storeValid = getNodeMajorDataStoreValid();
    float* data = dataArrays[columnNumber]->getDataPointerFloat();
    data[nodeNumber] = metric;
    dataArrays[columnNumber]->clearMinMaxFloatValuesValid();
    dataArrays[columnNumber]->clearMaxMaxPercentageValuesValid();
    setModified(); 
+   if (storeValid) {
+      nodeMajorDataStore->setValue(nodeNumber, columnNumber, metric);
+      nodeMajorDataStoreModified = getModified();
+   }
 }
 
 /**
@@ -725,6 +747,7 @@ MetricFile::setValue(const int nodeNumber, const int columnNumber,
 void 
 MetricFile::setAllColumnValuesForNode(const int nodeNumber, const float* metrics)
 {
+   const bool storeValid = getNodeMajorDataStoreValid();
    for (int i = 0; i < getNumberOfColumns(); i++) {
       float* data = dataArrays[i]->getDataPointerFloat();
       data[nodeNumber] = metrics[i];
@@ -732,6 +755,111 @@ MetricFile::setAllColumnValuesForNode(const int nodeNumber, const float* metrics
       dataArrays[i]->clearMaxMaxPercentageValuesValid();
    }
    setModified();
+   if (storeValid) {
+      std::copy(metrics, metrics + getNumberOfColumns(),
+                nodeMajorDataStore->getNodeValues(nodeNumber));
+      nodeMajorDataStoreModified = getModified();
+   }
+}
+
+/**
+ * create a memory mapped, node-major copy of the data so that all of a 
+ * node's column values are contiguous.  If the name is empty, a temporary
+ * file is used.  The copy is kept current by the methods that set values.
+ * Any other modification of the file invalidates the copy, and code that 
+ * writes through a data array's pointer without setting the file modified 
+ * must create the copy again.  The store is removed when columns are added
+ * or removed.  The copy is only read through getAllColumnValuesForNodeSpan().
+ */
+void 
+MetricFile::createNodeMajorDataStore(const QString& storeFileName) throw (FileException)
+{
+   removeNodeMajorDataStore();
+   
+   const int numNodes = getNumberOfNodes();
+   const int numCols = getNumberOfColumns();
+   if ((numNodes <= 0) || (numCols <= 0)) {
+      throw FileException(getFileName(), 
+                          "Metric file has no data for a node-major data store.");
+   }
+   
+   nodeMajorDataStore = new MetricNodeMajorDataStore(storeFileName,
+                                                     numNodes,
+                                                     numCols);
+   std::vector<const float*> columnData(numCols);
+   for (int j = 0; j < numCols; j++) {
+      columnData[j] = dataArrays[j]->getDataPointerFloat();
+   }
+   nodeMajorDataStore->setAllColumns(&columnData[0]);
+   nodeMajorDataStoreModified = getModified();
+}
+
+/**
+ * remove the node-major copy of the data.
+ */
+void 
+MetricFile::removeNodeMajorDataStore()
+{
+   if (nodeMajorDataStore != NULL) {
+      delete nodeMajorDataStore;
+      nodeMajorDataStore = NULL;
+   }
+}
+
+/**
+ * see if the node-major copy of the data exists, matches the file's dimensions,
+ * and the file has not been modified except through the value setters.
+ */
+bool 
+MetricFile::getNodeMajorDataStoreValid() const
+{
+   if (nodeMajorDataStore != NULL) {
+      if ((nodeMajorDataStore->getNumberOfNodes() == getNumberOfNodes()) &&
+          (nodeMajorDataStore->getNumberOfColumns() == getNumberOfColumns()) &&
+          (nodeMajorDataStoreModified == getModified())) {
+         return true;
+      }
+   }
+   return false;
+}
+
+/**
+ * get contiguous values of all columns for a node (NULL if there is
+ * no valid node-major store).
+ */
+const float* 
+MetricFile::getAllColumnValuesForNodeSpan(const int nodeNumber) const
+{
+   if (getNodeMajorDataStoreValid()) {
+      return nodeMajorDataStore->getNodeValues(nodeNumber);
+   }
+   return NULL;
+}
+
+/**
+ * get contiguous values of all nodes for a column.
+ */
+const float* 
+MetricFile::getColumnForAllNodesSpan(const int columnNumber) const
+{
+   return dataArrays[columnNumber]->getDataPointerFloat();
+}
+
+/**
+ * update a column in the node-major copy of the data.
+ */
+void 
+MetricFile::updateNodeMajorDataStoreColumn(const int columnNumber)
+{
+   if (nodeMajorDataStore != NULL) {
+      if (getNodeMajorDataStoreValid()) {
+         nodeMajorDataStore->setColumn(columnNumber,
+                                       dataArrays[columnNumber]->getDataPointerFloat());
+      }
+      else {
+         removeNodeMajorDataStore();
+      }
+   }
 }
 
 /**
@@ -2184,6 +2312,7 @@ MetricFile::setColumnAllNodesToScalar(const int columnNumber,
    for (int i = 0; i < numberOfNodes; i++) {
       data[i] = value;
    }
+   updateNodeMajorDataStoreColumn(columnNumber);
    setColumnColorMappingMinMax(columnNumber, value, value);
 }
       
@@ -3063,84 +3192,109 @@ MetricFile::computePermutedTValues(const float constant,
    mf->setColumnName(0, "Permuted T-Values");
    mf->setFileComment("Sign Flipped Permuted T-Values from " + getFileName());
 
-   float* signFlips = new float[numCols];
-   float* values    = new float[numCols];
-   float* oneColumn = new float[numNodes];
-   
    //
    // For the specified number of iterations
    //
+   std::vector<float> tValues;
    for (int iter = 0; iter < iterations; iter++) {
-      //
-      // Generate sign flips by randomly generating an array of plus and minus ones
-      //
-      for (int j = 0; j < numCols; j++) {
-         signFlips[j] = 1.0;
-      }
-      StatisticDataGroup sdg(signFlips, numCols, StatisticDataGroup::DATA_STORAGE_MODE_POINT);
-      StatisticPermutation permuteSigns(StatisticPermutation::PERMUTATION_METHOD_RANDOM_SIGN_FLIP);
-      permuteSigns.addDataGroup(&sdg);
-      try {
-         permuteSigns.execute();
-      }
-      catch (StatisticException& e) {
-         throw FileException(e);
-      }
-      const StatisticDataGroup* flipOutDataGroup = permuteSigns.getOutputData();
-      for (int j = 0; j < numCols; j++) {
-         signFlips[j] = flipOutDataGroup->getData(j);
-      }
+      computePermutedTValuesRepetition(iter,
+                                       constant,
+                                       topologyFile,
+                                       varianceSmoothingIterations,
+                                       varianceSmoothingStrength,
+                                       tValues);
+      mf->setColumnForAllNodes(iter, tValues);
+   }
+   
+   return mf;
+}
+
+/**
+ * compute the T-Values for one iteration of the sign flip permutation.  The
+ * sign flips are determined only by the iteration index so that iterations
+ * may be computed in any order (and in multiple threads) and produce the
+ * same T-Values as computePermutedTValues().
+ */
+void 
+MetricFile::computePermutedTValuesRepetition(const int iterationIndex,
+                                             const float constant,
+                                             const TopologyFile* topologyFile,
+                                             const int varianceSmoothingIterations,
+                                             const float varianceSmoothingStrength,
+                                             std::vector<float>& tValuesOut) const throw (FileException)
+{
+   const int numNodes = getNumberOfNodes();
+   const int numCols = getNumberOfColumns();
+   if ((numNodes <= 0) ||
+       (numCols < 2)) {
+      throw FileException("Metric file contains no nodes or less than two columns.");
+   }
+   
+   std::vector<float> signFlips(numCols);
+   std::vector<float> values(numCols);
+   
+   //
+   // Generate sign flips by randomly generating an array of plus and minus ones
+   //
+   for (int j = 0; j < numCols; j++) {
+      signFlips[j] = 1.0;
+   }
+   StatisticDataGroup sdg(&signFlips, StatisticDataGroup::DATA_STORAGE_MODE_POINT);
+   StatisticPermutation permuteSigns(StatisticPermutation::PERMUTATION_METHOD_RANDOM_SIGN_FLIP);
+   permuteSigns.setPermutationIndex(iterationIndex);
+   permuteSigns.addDataGroup(&sdg);
+   try {
+      permuteSigns.execute();
+   }
+   catch (StatisticException& e) {
+      throw FileException(e);
+   }
+   const StatisticDataGroup* flipOutDataGroup = permuteSigns.getOutputData();
+   for (int j = 0; j < numCols; j++) {
+      signFlips[j] = flipOutDataGroup->getData(j);
+   }
 
 /*      
-      //
-      // generate the permutation sign flips
-      //
-      for (int j = 0; j < numCols; j++) {
-         signFlips[j] = 1.0;
-         if (MathUtilities::randomInteger(-1000, 1000) < 0) {
-            signFlips[j] = -1.0;
-         }
+   //
+   // generate the permutation sign flips
+   //
+   for (int j = 0; j < numCols; j++) {
+      signFlips[j] = 1.0;
+      if (MathUtilities::randomInteger(-1000, 1000) < 0) {
+         signFlips[j] = -1.0;
       }
+   }
 */
-      
-      //
-      // Copy this metric file
-      //
-      MetricFile metricCopy(*this);
-      
-      //
-      // Get the value for all nodes from the copy metric file and apply sign flips
-      //
-      for (int k = 0; k < numNodes; k++) {
-         metricCopy.getAllColumnValuesForNode(k, values);
-         for (int j = 0; j < numCols; j++) {
-            values[j] *= signFlips[j];
-         }
-         metricCopy.setAllColumnValuesForNode(k, values);
+   
+   //
+   // Copy this metric file
+   //
+   MetricFile metricCopy(*this);
+   
+   //
+   // Get the value for all nodes from the copy metric file and apply sign flips
+   //
+   for (int k = 0; k < numNodes; k++) {
+      metricCopy.getAllColumnValuesForNode(k, values);
+      for (int j = 0; j < numCols; j++) {
+         values[j] *= signFlips[j];
       }
-      
-      //
-      // Compute T-Values
-      //
-      MetricFile* tValuesMetric = metricCopy.computeTValues(constant,
-                                                            topologyFile,
-                                                            varianceSmoothingIterations,
-                                                            varianceSmoothingStrength);
-      
-      //
-      // Place the T-Values into the output permuted metric file
-      //
-      tValuesMetric->getColumnForAllNodes(0, oneColumn);
-      mf->setColumnForAllNodes(iter, oneColumn);
-      
-      delete tValuesMetric;
+      metricCopy.setAllColumnValuesForNode(k, &values[0]);
    }
    
-   delete[] signFlips;
-   delete[] values;
-   delete[] oneColumn;
+   //
+   // Compute T-Values
+   //
+   MetricFile* tValuesMetric = metricCopy.computeTValues(constant,
+                                                         topologyFile,
+                                                         varianceSmoothingIterations,
+                                                         varianceSmoothingStrength);
    
-   return mf;
+   //
+   // Place the T-Values into the output
+   //
+   tValuesMetric->getColumnForAllNodes(0, tValuesOut);
+   delete tValuesMetric;
 }
 
 /**
@@ -4087,10 +4241,11 @@ MetricFile::computeShuffledCrossCorrelationsMap(const int numberOfRepetitions) c
       //
       // Randomly select the columns
       //
-      const int col1 = StatisticRandomNumber::randomInteger(0, numberOfColumns - 1);
+      StatisticRandomNumber randomNumber(j);
+      const int col1 = randomNumber.nextInteger(0, numberOfColumns - 1);
       int col2 = col1;
       while (col1 == col2) {
-         col2 = StatisticRandomNumber::randomInteger(0, numberOfColumns - 1);
+         col2 = randomNumber.nextInteger(0, numberOfColumns - 1);
       }
       
       //
@@ -4125,11 +4280,15 @@ MetricFile::computeShuffledCrossCorrelationsMap(const int numberOfRepetitions) c
       
 /**
  * shuffle the values amongst group of input metric files and place
- * into the output files which must already be allocated.
+ * into the output files which must already be allocated.  If the
+ * permutation index is not negative, the shuffle is determined only by
+ * the index (see StatisticPermutation::setPermutationIndex()) so that
+ * shuffles may be performed in any order and in multiple threads.
  */
 void 
 MetricFile::shuffle(const std::vector<MetricFile*>& metricFilesIn,
-                    std::vector<MetricFile*>& metricFilesOut) throw (FileException)
+                    std::vector<MetricFile*>& metricFilesOut,
+                    const int permutationIndex) throw (FileException)
 {
    //
    // Check for input files
@@ -4185,6 +4344,9 @@ MetricFile::shuffle(const std::vector<MetricFile*>& metricFilesIn,
    StatisticDataGroup sdg(&columnsShuffledFloat, 
                           StatisticDataGroup::DATA_STORAGE_MODE_POINT);
    StatisticPermutation perm(StatisticPermutation::PERMUTATION_METHOD_RANDOM_ORDER);
+   if (permutationIndex >= 0) {
+      perm.setPermutationIndex(permutationIndex);
+   }
    perm.addDataGroup(&sdg);
    try {
       perm.execute();
@@ -4252,7 +4414,86 @@ MetricFile::computeStatisticalShuffledTMap(const int numberOfRepetitions,
                                            const TopologyFile* topologyFile,
                                            const int varianceSmoothingIterations,
                                            const float varianceSmoothingStrength,
-                                           const bool poolTheVariance) const throw (FileException)
+                                           const bool poolTheVariance,
+                                           const unsigned int randomStreamNumber) const throw (FileException)
+{
+   const int numberOfNodes = getNumberOfNodes();
+
+   //
+   // Create the output metric file that will contain the tmaps
+   //
+   MetricFile* metricOut = new MetricFile;
+   metricOut->setNumberOfNodesAndColumns(numberOfNodes, numberOfRepetitions);
+   metricOut->appendToFileComment("Shuffled Columns T-Map from ");
+   metricOut->appendToFileComment(FileUtilities::basename(getFileName()));
+   
+   //
+   // Do for the number of repetitions
+   //
+   std::vector<float> tMapValues;
+   for (int nr = 0; nr < numberOfRepetitions; nr++) {
+      //
+      // allow other events to process
+      //
+      AbstractFile::allowEventsToProcess();
+
+      //
+      // Compute the T-Map for this repetition
+      //
+      QString columnName, columnComment;
+      try {
+         computeStatisticalShuffledTMapRepetition(nr,
+                                                  numberInGroup1,
+                                                  topologyFile,
+                                                  varianceSmoothingIterations,
+                                                  varianceSmoothingStrength,
+                                                  poolTheVariance,
+                                                  tMapValues,
+                                                  columnName,
+                                                  columnComment,
+                                                  randomStreamNumber);
+      }
+      catch (FileException& e) {
+         delete metricOut;
+         throw e;
+      }
+      
+      //
+      // Add T-map to output metric file
+      //
+      metricOut->setColumnForAllNodes(nr, tMapValues);
+      metricOut->setColumnName(nr, columnName);
+      metricOut->setColumnComment(nr, columnComment);
+      
+      //
+      // Set column color mapping
+      //
+      metricOut->setColumnColorMappingMinMax(nr, -5.0, 5.0);
+   }
+   
+   return metricOut;
+}
+      
+/**
+ * compute the T-map for one repetition of the shuffled columns split into 
+ * two groups.  The shuffle is keyed by the repetition index so that any 
+ * repetition may be computed independently of the others (and in any thread) 
+ * and produce the same T-map as computeStatisticalShuffledTMap().  Callers
+ * that shuffle more than one file use a different random stream for each.
+ * If the number in group 1 is negative or zero, the columns are split
+ * into two groups of the same size.
+ */
+void 
+MetricFile::computeStatisticalShuffledTMapRepetition(const int repetitionIndex,
+                                                     const int numberInGroup1,
+                                                     const TopologyFile* topologyFile,
+                                                     const int varianceSmoothingIterations,
+                                                     const float varianceSmoothingStrength,
+                                                     const bool poolTheVariance,
+                                                     std::vector<float>& tMapValuesOut,
+                                                     QString& columnNameOut,
+                                                     QString& columnCommentOut,
+                                                     const unsigned int randomStreamNumber) const throw (FileException)
 {
    const int numberOfNodes = getNumberOfNodes();
    const int numberOfColumns = getNumberOfColumns();
@@ -4268,14 +4509,6 @@ MetricFile::computeStatisticalShuffledTMap(const int numberOfRepetitions,
       throw FileException("Size of first group is greater than or equal to the number of colunms.");
    }
 
-   //
-   // Create the output metric file that will contain the tmaps
-   //
-   MetricFile* metricOut = new MetricFile;
-   metricOut->setNumberOfNodesAndColumns(numberOfNodes, numberOfRepetitions);
-   metricOut->appendToFileComment("Shuffled Columns T-Map from ");
-   metricOut->appendToFileComment(FileUtilities::basename(getFileName()));
-   
    //
    // Create metric files for the two groups
    //
@@ -4290,127 +4523,106 @@ MetricFile::computeStatisticalShuffledTMap(const int numberOfRepetitions,
    file2.setNumberOfNodesAndColumns(numberOfNodes, numColumnsFile2);
    
    //
-   // Do for the number of repetitions
+   // Create shuffled columns' indices
    //
-   for (int nr = 0; nr < numberOfRepetitions; nr++) {
-      //
-      // allow other events to process
-      //
-      AbstractFile::allowEventsToProcess();
+   std::vector<float> columnsShuffledFloat(numberOfColumns);
+   for (int i = 0; i < numberOfColumns; i++) {
+      columnsShuffledFloat[i] = i;
+   }
 
-      //
-      // Create shuffled columns' indices
-      //
-      std::vector<float> columnsShuffledFloat(numberOfColumns);
-      for (int i = 0; i < numberOfColumns; i++) {
-         columnsShuffledFloat[i] = i;
-      }
-/*
-      RandomNumberOp randOp;  // used to rand() is called
-      std::random_shuffle(columnsShuffled.begin(), columnsShuffled.end(), randOp);
-*/
-      //
-      // Randomly shuffle the columns
-      //      
-      StatisticDataGroup sdg(&columnsShuffledFloat, 
-                             StatisticDataGroup::DATA_STORAGE_MODE_POINT);
-      StatisticPermutation perm(StatisticPermutation::PERMUTATION_METHOD_RANDOM_ORDER);
-      perm.addDataGroup(&sdg);
-      try {
-         perm.execute();
-      }
-      catch (StatisticException& e) {
-         throw FileException(e);
-      }
-      const StatisticDataGroup* permOut = perm.getOutputData();
-      if (permOut->getNumberOfData() != numberOfColumns) {
-         throw FileException("Program error: StatisticPermutation return wrong number of values.");
-      }
-      std::vector<int> columnsShuffled(numberOfColumns);
-      for (int i = 0; i < numberOfColumns; i++) {
-         columnsShuffled[i] = static_cast<int>(permOut->getData(i));
-      }
+   //
+   // Randomly shuffle the columns
+   //      
+   StatisticDataGroup sdg(&columnsShuffledFloat, 
+                          StatisticDataGroup::DATA_STORAGE_MODE_POINT);
+   StatisticPermutation perm(StatisticPermutation::PERMUTATION_METHOD_RANDOM_ORDER);
+   perm.setPermutationIndex(repetitionIndex, randomStreamNumber);
+   perm.addDataGroup(&sdg);
+   try {
+      perm.execute();
+   }
+   catch (StatisticException& e) {
+      throw FileException(e);
+   }
+   const StatisticDataGroup* permOut = perm.getOutputData();
+   if (permOut->getNumberOfData() != numberOfColumns) {
+      throw FileException("Program error: StatisticPermutation return wrong number of values.");
+   }
+   std::vector<int> columnsShuffled(numberOfColumns);
+   for (int i = 0; i < numberOfColumns; i++) {
+      columnsShuffled[i] = static_cast<int>(permOut->getData(i));
+   }
 
-      //
-      // Set the values for each of the two split metric files
-      //
-      for (int j = 0; j < numColumnsFile1; j++) {
-         const int indx = columnsShuffled[j];
-         for (int i = 0; i < numberOfNodes; i++) {
-            file1.setValue(i, j, getValue(i, indx));
-         }
+   //
+   // Set the values for each of the two split metric files
+   //
+   for (int j = 0; j < numColumnsFile1; j++) {
+      const int indx = columnsShuffled[j];
+      for (int i = 0; i < numberOfNodes; i++) {
+         file1.setValue(i, j, getValue(i, indx));
       }
+   }
 
-      //
-      // Set the values for each of the two split metric files
-      //
-      for (int j = 0; j < numColumnsFile2; j++) {
-         const int indx = columnsShuffled[j + halfIndex];
-         for (int i = 0; i < numberOfNodes; i++) {
-            file2.setValue(i, j, getValue(i, indx));
-         }
-      }
-      
-      //
-      // Compute the T-Map for the two files
-      //
-      MetricFile* tMapMetricFile = computeStatisticalTMap(&file1, &file2, 
-                                                          topologyFile,
-                                                          varianceSmoothingIterations,
-                                                          varianceSmoothingStrength,
-                                                          poolTheVariance,
-                                                          0.05,
-                                                          false,
-                                                          false, 
-                                                          false);
-      const int tMapColumn = tMapMetricFile->getColumnWithName("T-Map");
-      if (tMapColumn < 0) {
-         throw FileException("Unable to find columns named \"T-Map\"");
-      }
-      
-      //
-      // Add T-map to output metric file
-      //
+   //
+   // Set the values for each of the two split metric files
+   //
+   for (int j = 0; j < numColumnsFile2; j++) {
+      const int indx = columnsShuffled[j + halfIndex];
       for (int i = 0; i < numberOfNodes; i++) {
-         metricOut->setValue(i, nr, tMapMetricFile->getValue(i, tMapColumn));
-      }
-      
-      //
-      // Update column name and comment
-      //
-      std::ostringstream str1, str1Com, str2, str2Com;
-      for (int j = 0; j < numberOfColumns; j++) {
-         if (j < halfIndex) {
-            str1 << columnsShuffled[j] << " ";
-            str1Com << getColumnName(columnsShuffled[j]).toAscii().constData() << " ";
-         }
-         else {
-            str2 << columnsShuffled[j] << " ";
-            str2Com << getColumnName(columnsShuffled[j]).toAscii().constData() << " ";
-         }
+         file2.setValue(i, j, getValue(i, indx));
       }
-      std::ostringstream str;
-      str << "T-Test on "
-          << str1.str()
-          << " versus "
-          << str2.str();
-      metricOut->setColumnName(nr, str.str().c_str());
-      std::ostringstream strCom;
-      strCom << "T-Test on "
-             << str1Com.str()
-             << " versus "
-             << str2Com.str();
-      metricOut->setColumnComment(nr, strCom.str().c_str());
-      
-      //
-      // Set column color mapping
-      //
-      metricOut->setColumnColorMappingMinMax(nr, -5.0, 5.0);
-      
+   }
+   
+   //
+   // Compute the T-Map for the two files
+   //
+   MetricFile* tMapMetricFile = computeStatisticalTMap(&file1, &file2, 
+                                                       topologyFile,
+                                                       varianceSmoothingIterations,
+                                                       varianceSmoothingStrength,
+                                                       poolTheVariance,
+                                                       0.05,
+                                                       false,
+                                                       false, 
+                                                       false);
+   const int tMapColumn = tMapMetricFile->getColumnWithName("T-Map");
+   if (tMapColumn < 0) {
       delete tMapMetricFile;
+      throw FileException("Unable to find columns named \"T-Map\"");
    }
    
-   return metricOut;
+   //
+   // Get the T-map values
+   //
+   tMapMetricFile->getColumnForAllNodes(tMapColumn, tMapValuesOut);
+   delete tMapMetricFile;
+   
+   //
+   // Create the column name and comment
+   //
+   std::ostringstream str1, str1Com, str2, str2Com;
+   for (int j = 0; j < numberOfColumns; j++) {
+      if (j < halfIndex) {
+         str1 << columnsShuffled[j] << " ";
+         str1Com << getColumnName(columnsShuffled[j]).toAscii().constData() << " ";
+      }
+      else {
+         str2 << columnsShuffled[j] << " ";
+         str2Com << getColumnName(columnsShuffled[j]).toAscii().constData() << " ";
+      }
+   }
+   std::ostringstream str;
+   str << "T-Test on "
+       << str1.str()
+       << " versus "
+       << str2.str();
+   columnNameOut = str.str().c_str();
+   std::ostringstream strCom;
+   strCom << "T-Test on "
+          << str1Com.str()
+          << " versus "
+          << str2Com.str();
+   columnCommentOut = strCom.str().c_str();
 }
       
 /**
@@ -4504,6 +4716,7 @@ MetricFile::copyColumn(const int inputColumnNumber, const int outputColumnNumber
       for (int i = 0; i < num; i++) {
          dataOut[i] = dataIn[i];
       }
+      updateNodeMajorDataStoreColumn(outputColumnNumber);
    }
 }
       
@@ -5104,3 +5317,105 @@ MetricMappingInfo::getData(QString& surfaceNameOut,
    volumeNumberOut    = volumeNumber;
    subVolumeNumberOut = subVolumeNumber;
 } 
+
+//***************************************************************************************
+
+/**
+ * Constructor.  The file is created (or replaced) and mapped.
+ */
+MetricNodeMajorDataStore::MetricNodeMajorDataStore(const QString& fileNameIn,
+                                                   const int numberOfNodesIn,
+                                                   const int numberOfColumnsIn) throw (FileException)
+{
+   numberOfNodes = numberOfNodesIn;
+   numberOfColumns = numberOfColumnsIn;
+   data = NULL;
+   
+   if (fileNameIn.isEmpty()) {
+      QTemporaryFile* tempFile = new QTemporaryFile(QDir::tempPath() 
+                                                    + QDir::separator() 
+                                                    + "caret_metric_node_major_XXXXXX");
+      if (tempFile->open() == false) {
+         const QString msg = tempFile->errorString();
+         delete tempFile;
+         throw FileException("Unable to create temporary file for node-major data: "
+                             + msg);
+      }
+      file = tempFile;
+   }
+   else {
+      file = new QFile(fileNameIn);
+      if (file->open(QFile::ReadWrite | QFile::Truncate) == false) {
+         const QString msg = file->errorString();
+         delete file;
+         throw FileException(fileNameIn, msg);
+      }
+   }
+   
+   const qint64 numBytes = static_cast<qint64>(numberOfNodes) 
+                         * numberOfColumns * sizeof(float);
+   if (file->resize(numBytes)) {
+      data = (float*)file->map(0, numBytes);
+   }
+   if (data == NULL) {
+      const QString name = file->fileName();
+      const QString msg = file->errorString();
+      file->close();
+      delete file;
+      throw FileException(name, "Unable to map node-major data: " + msg);
+   }
+}
+
+/**
+ * Destructor.
+ */
+MetricNodeMajorDataStore::~MetricNodeMajorDataStore()
+{
+   file->unmap((uchar*)data);
+   file->close();
+   delete file;
+}
+
+/**
+ * get the name of the mapped file.
+ */
+QString 
+MetricNodeMajorDataStore::getFileName() const
+{
+   return file->fileName();
+}
+
+/**
+ * set a column of values for all nodes.
+ */
+void 
+MetricNodeMajorDataStore::setColumn(const int columnNumber, const float* values)
+{
+   float* ptr = &data[columnNumber];
+   for (int i = 0; i < numberOfNodes; i++) {
+      *ptr = values[i];
+      ptr += numberOfColumns;
+   }
+}
+
+/**
+ * set all columns from column-major data.  Nodes are processed in blocks
+ * so that the block of node-major data remains in the cache while it is
+ * filled from the columns.
+ */
+void 
+MetricNodeMajorDataStore::setAllColumns(const float* const* columnData)
+{
+   const int blockSize = 256;
+   for (int iStart = 0; iStart < numberOfNodes; iStart += blockSize) {
+      const int iEnd = std::min(iStart + blockSize, numberOfNodes);
+      for (int j = 0; j < numberOfColumns; j++) {
+         const float* column = columnData[j];
+         float* ptr = &data[static_cast<long>(iStart) * numberOfColumns + j];
+         for (int i = iStart; i < iEnd; i++) {
+            *ptr = column[i];
+            ptr += numberOfColumns;
+         }
+      }
+   }
+}
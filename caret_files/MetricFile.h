@@ -34,6 +34,7 @@
 #include "SpecFile.h"
 
 class DeformationMapFile;
+class QFile;
 class TopologyFile;
 
 /// MetricMappingInfo is a class used when mapping functional volumes to a metric file.
@@ -93,6 +94,67 @@ class MetricMappingInfo {
       int surfaceIndexNumber;
 };
 
+/// MetricNodeMajorDataStore is a memory mapped copy of a metric file's data with
+/// all of a node's column values stored contiguously.  The mapped file contains 
+/// raw floats in the system's byte order, as in a GIFTI external binary file.
+class MetricNodeMajorDataStore {
+   public:
+      // Constructor (temporary file is used if the file name is empty)
+      MetricNodeMajorDataStore(const QString& fileNameIn,
+                               const int numberOfNodesIn,
+                               const int numberOfColumnsIn) throw (FileException);
+      
+      // Destructor
+      ~MetricNodeMajorDataStore();
+      
+      /// get the number of nodes
+      int getNumberOfNodes() const { return numberOfNodes; }
+      
+      /// get the number of columns
+      int getNumberOfColumns() const { return numberOfColumns; }
+      
+      /// get all column values for a node
+      float* getNodeValues(const int nodeNumber) 
+         { return &data[static_cast<long>(nodeNumber) * numberOfColumns]; }
+      
+      /// get all column values for a node (const method)
+      const float* getNodeValues(const int nodeNumber) const
+         { return &data[static_cast<long>(nodeNumber) * numberOfColumns]; }
+      
+      /// set the value for a node's column
+      void setValue(const int nodeNumber, const int columnNumber, const float value)
+         { data[static_cast<long>(nodeNumber) * numberOfColumns + columnNumber] = value; }
+      
+      // set a column of values for all nodes
+      void setColumn(const int columnNumber, const float* values);
+      
+      // set all columns from column-major data (columnData[i] has all nodes of column i)
+      void setAllColumns(const float* const* columnData);
+      
+      /// get the name of the mapped file
+      QString getFileName() const;
+      
+   protected:
+      /// the mapped file
+      QFile* file;
+      
+      /// the mapped data
+      float* data;
+      
+      /// number of nodes
+      int numberOfNodes;
+      
+      /// number of columns
+      int numberOfColumns;
+      
+   private:
+      /// copy constructor not allowed
+      MetricNodeMajorDataStore(const MetricNodeMajorDataStore&);
+      
+      /// assignment operator not allowed
+      MetricNodeMajorDataStore& operator=(const MetricNodeMajorDataStore&);
+};
+
 /// MetricFile - a class that associates one or more floating point values with each surface node
 class MetricFile : public GiftiNodeDataFile {
    public:
@@ -236,6 +298,14 @@ class MetricFile : public GiftiNodeDataFile {
                                          const int varianceSmoothingIterations,
                                          const float varianceSmoothingStrength) const throw (FileException);
                                          
+      // compute the T-Values for one iteration of the sign flip permutation
+      void computePermutedTValuesRepetition(const int iterationIndex,
+                                            const float constant,
+                                            const TopologyFile* topologyFile,
+                                            const int varianceSmoothingIterations,
+                                            const float varianceSmoothingStrength,
+                                            std::vector<float>& tValuesOut) const throw (FileException);
+                                         
       // compute and return a metric file that computes T-Values of "this" metric file
       // T-Value = (mean - constant) / (sample-dev / sqrt(N))
       MetricFile* computeTValues(const float constant,
@@ -278,7 +348,8 @@ class MetricFile : public GiftiNodeDataFile {
                                          
       // shuffle the values amongst group of metric files (input and output files must be same dimensions)
       static void shuffle(const std::vector<MetricFile*>& metricFilesIn,
-                          std::vector<MetricFile*>& metricFilesOut) throw (FileException);
+                          std::vector<MetricFile*>& metricFilesOut,
+                          const int permutationIndex = -1) throw (FileException);
 
       // compute T-map on shuffled columns split into two groups
       MetricFile* computeStatisticalShuffledTMap(const int numberOfRepetitions,
@@ -286,7 +357,20 @@ class MetricFile : public GiftiNodeDataFile {
                                                  const TopologyFile* topologyFile,
                                                  const int varianceSmoothingIterations,
                                                  const float varianceSmoothingStrength,
-                                                 const bool poolTheVariance) const throw (FileException);
+                                                 const bool poolTheVariance,
+                                                 const unsigned int randomStreamNumber = 0) const throw (FileException);
+      
+      // compute the T-map for one repetition of the shuffled columns split into two groups
+      void computeStatisticalShuffledTMapRepetition(const int repetitionIndex,
+                                                    const int numberInGroup1,
+                                                    const TopologyFile* topologyFile,
+                                                    const int varianceSmoothingIterations,
+                                                    const float varianceSmoothingStrength,
+                                                    const bool poolTheVariance,
+                                                    std::vector<float>& tMapValuesOut,
+                                                    QString& columnNameOut,
+                                                    QString& columnCommentOut,
+                                                    const unsigned int randomStreamNumber = 0) const throw (FileException);
       
       // compute shuffled cross correlation maps
       MetricFile* computeShuffledCrossCorrelationsMap(const int numberOfRepetitions) const throw (FileException);
@@ -393,6 +477,21 @@ class MetricFile : public GiftiNodeDataFile {
 
       /// set all columns metrics for a specified node
       void setAllColumnValuesForNode(const int nodeNumber, const float* metrics);
+      
+      // create a memory mapped, node-major copy of the data (temporary file if name is empty)
+      void createNodeMajorDataStore(const QString& storeFileName = "") throw (FileException);
+      
+      // remove the node-major copy of the data
+      void removeNodeMajorDataStore();
+      
+      // see if the node-major copy of the data exists and is current
+      bool getNodeMajorDataStoreValid() const;
+      
+      // get contiguous values of all columns for a node (NULL if no valid node-major store)
+      const float* getAllColumnValuesForNodeSpan(const int nodeNumber) const;
+      
+      // get contiguous values of all nodes for a column
+      const float* getColumnForAllNodesSpan(const int columnNumber) const;
                           
       /// Get a column of values for all nodes
       void getColumnForAllNodes(const int columnNumber,
@@ -488,6 +587,15 @@ class MetricFile : public GiftiNodeDataFile {
       /// column minimum/maximum values valid
       std::vector<int> columnMinimumMaximumValid;
       
+      /// optional node-major copy of the data (not copied with file)
+      MetricNodeMajorDataStore* nodeMajorDataStore;
+      
+      /// file's modification count when the node-major copy was last updated
+      unsigned long nodeMajorDataStoreModified;
+      
+      // update a column in the node-major copy of the data
+      void updateNodeMajorDataStoreColumn(const int columnNumber);
+      
       // copy a column of values to another column
       void copyColumn(const int inputColumnNumber, const int outputColumnNumber);
       
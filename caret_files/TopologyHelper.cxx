@@ -38,6 +38,10 @@
 #include <cmath>
 #include <QMutexLocker>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 /**
  * Comparison operator for EdgeInfo
  */
@@ -65,24 +69,22 @@ TopologyHelper::TopologyHelper(const TopologyFile* tf,
    nodeSortedInfoBuilt = false;
    nodeInfoBuilt       = false;
    edgeInfoBuilt = false;
+   numberOfNodes = 0;
    
    const int numTiles = tf->getNumberOfTiles();
    if (numTiles <= 0) {
       return;
    }
+   const int* tiles = tf->getTile(0);
    
    if (buildNodeInfo) {
       int maxNodeNum = -1;
    
-         //
+      //
       // Get the number of nodes
       //
-      for (int j = 0; j < numTiles; j++) {
-         int n1, n2, n3;
-         tf->getTile(j, n1, n2, n3);
-         if (n1 > maxNodeNum) maxNodeNum = n1;
-         if (n2 > maxNodeNum) maxNodeNum = n2;
-         if (n3 > maxNodeNum) maxNodeNum = n3;
+      for (int j = 0; j < (numTiles * 3); j++) {
+         if (tiles[j] > maxNodeNum) maxNodeNum = tiles[j];
       }
       
       //
@@ -95,60 +97,23 @@ TopologyHelper::TopologyHelper(const TopologyFile* tf,
       //
       maxNodeNum = std::max(maxNodeNum, tf->getNumberOfNodes());
       
-      //
-      // Initialize the node structures
-      //
-      nodes.reserve(maxNodeNum);
-      for (int i = 0; i < maxNodeNum; i++) {
-         nodes.push_back(NodeInfo(i));
-      }
+      buildNodeNeighborsAndTiles(tiles, numTiles, maxNodeNum, sortNodeInfo);
    }
    
    //
-   // Keep track of the tiles
+   // Keep track of the edges
    //
-   for (int j = 0; j < numTiles; j++) {
-      int n1, n2, n3;
-      tf->getTile(j, n1, n2, n3);
-      if (buildNodeInfo) {
-         if (sortNodeInfo) {
-            nodes[n1].addNeighbors(j, n2, n3);
-            nodes[n2].addNeighbors(j, n3, n1);
-            nodes[n3].addNeighbors(j, n1, n2);
-         }
-         else {
-            nodes[n1].addNeighbor(n2);
-            nodes[n1].addNeighbor(n3);
-            nodes[n2].addNeighbor(n1);
-            nodes[n2].addNeighbor(n3);
-            nodes[n3].addNeighbor(n1);
-            nodes[n3].addNeighbor(n2);
-            nodes[n1].addTile(j);
-            nodes[n2].addTile(j);
-            nodes[n3].addTile(j);
-         }
-      }
-      
-      if (buildEdgeInfo) {
+   if (buildEdgeInfo) {
+      for (int j = 0; j < numTiles; j++) {
+         const int n1 = tiles[j * 3];
+         const int n2 = tiles[j * 3 + 1];
+         const int n3 = tiles[j * 3 + 2];
          addEdgeInfo(j, n1, n2);
          addEdgeInfo(j, n2, n3);
          addEdgeInfo(j, n3, n1);
       }
-   }
-
-   if (buildEdgeInfo) {
       edgeInfoBuilt = true;
    }
-   
-   if (buildNodeInfo) {
-      nodeInfoBuilt = true;
-      if (sortNodeInfo) {
-         nodeSortedInfoBuilt = true;
-         for (unsigned int k = 0; k < nodes.size(); k++) {
-            nodes[k].sortNeighbors();
-         }
-      }
-   }
 }
 
 /**
@@ -179,94 +144,45 @@ TopologyHelper::TopologyHelper(vtkPolyData* vtkIn,
    nodeSortedInfoBuilt = false;
    nodeInfoBuilt       = false;
    edgeInfoBuilt = false;
-   
-   //const int numTiles = tf->getNumberOfTiles();
-   //if (numTiles <= 0) {
-   //   return;
-  // }
-   
-   if (buildNodeInfo) {
-      vtkCellArray* polys = vtk->GetPolys();
-      vtkIdType npts;
-      vtkIdType* pts;
-      const int maxNodeNum = vtk->GetNumberOfPoints();  //-1;
-      for (polys->InitTraversal(); polys->GetNextCell(npts,pts); ) {
-         if (npts != 3) {
-            std::cerr << " Polygon is not a triangle in TopologyHelper, ignored"      
-                      << std::endl;
-         }
-         //maxNodeNum = std::max(pts[0], maxNodeNum);
-         //maxNodeNum = std::max(pts[1], maxNodeNum);
-         //maxNodeNum = std::max(pts[2], maxNodeNum);
-      }
-      
-      //
-      // Node indices start at zero so need to increment
-      //
-      //maxNodeNum++; 
-      
-      //
-      // Initialize the node structures
-      //
-      for (int i = 0; i < maxNodeNum; i++) {
-         nodes.push_back(NodeInfo(i));
-      }
-   }
+   numberOfNodes = 0;
    
    //
-   // Keep track of the tiles
+   // Get the tiles
    //
+   std::vector<int> tiles;
    vtkCellArray* polys = vtk->GetPolys();
-   int cellId = 0;
    vtkIdType npts;
    vtkIdType* pts;
-   for (polys->InitTraversal(); polys->GetNextCell(npts,pts); cellId++) {
+   for (polys->InitTraversal(); polys->GetNextCell(npts,pts); ) {
       if (npts != 3) {
-         std::cerr << " Polygon is not a triangle in TopologyHelper"      
+         std::cerr << " Polygon is not a triangle in TopologyHelper, ignored"      
                      << std::endl;
-         return;
+         continue;
       }
-      int n1 = pts[0];
-      int n2 = pts[1];
-      int n3 = pts[2];
-      if (buildNodeInfo) {
-         if (sortNodeInfo) {
-            nodes[n1].addNeighbors(cellId, n2, n3);
-            nodes[n2].addNeighbors(cellId, n3, n1);
-            nodes[n3].addNeighbors(cellId, n1, n2);
-         }
-         else {
-            nodes[n1].addNeighbor(n2);
-            nodes[n1].addNeighbor(n3);
-            nodes[n2].addNeighbor(n1);
-            nodes[n2].addNeighbor(n3);
-            nodes[n3].addNeighbor(n1);
-            nodes[n3].addNeighbor(n2);
-            nodes[n1].addTile(cellId);
-            nodes[n2].addTile(cellId);
-            nodes[n3].addTile(cellId);
-         }
-      }
-      
-      if (buildEdgeInfo) {
-         addEdgeInfo(cellId, n1, n2);
-         addEdgeInfo(cellId, n2, n3);
-         addEdgeInfo(cellId, n3, n1);
-      }
-   }
-
-   if (buildEdgeInfo) {
-      edgeInfoBuilt = true;
+      tiles.push_back(pts[0]);
+      tiles.push_back(pts[1]);
+      tiles.push_back(pts[2]);
    }
+   const int numTiles = static_cast<int>(tiles.size() / 3);
    
    if (buildNodeInfo) {
-      nodeInfoBuilt = true;
-      if (sortNodeInfo) {
-         nodeSortedInfoBuilt = true;
-         for (unsigned int k = 0; k < nodes.size(); k++) {
-            nodes[k].sortNeighbors();
-         }
+      buildNodeNeighborsAndTiles(tiles.empty() ? NULL : &tiles[0], numTiles, 
+                                 vtk->GetNumberOfPoints(), sortNodeInfo);
+   }
+   
+   //
+   // Keep track of the edges
+   //
+   if (buildEdgeInfo) {
+      for (int j = 0; j < numTiles; j++) {
+         const int n1 = tiles[j * 3];
+         const int n2 = tiles[j * 3 + 1];
+         const int n3 = tiles[j * 3 + 2];
+         addEdgeInfo(j, n1, n2);
+         addEdgeInfo(j, n2, n3);
+         addEdgeInfo(j, n3, n1);
       }
+      edgeInfoBuilt = true;
    }
 }
 
@@ -275,7 +191,6 @@ TopologyHelper::TopologyHelper(vtkPolyData* vtkIn,
  */
 TopologyHelper::~TopologyHelper()
 {
-   nodes.clear();
    topologyEdges.clear();
 }
 
@@ -299,104 +214,241 @@ TopologyHelper::addEdgeInfo(const int tileNum, const int node1, const int node2)
 }
 
 /**
- * Sort a nodes neighbors
+ * Build the node neighbors and tiles.  "tiles" contains three nodes for each
+ * tile.  Each node's tiles are found with one counting pass over the tiles so
+ * that the tiles of all nodes are placed in one array.  Each node's neighbors 
+ * are then found from its tiles and also placed in one array.
  */
-void 
-TopologyHelper::NodeInfo::sortNeighbors() 
+void
+TopologyHelper::buildNodeNeighborsAndTiles(const int* tiles,
+                              const int numTiles,
+                              const int numNodes,
+                              const bool sortNodeInfo)
 {
-   if ((edges.size() > 0) && sortMe) {
-      //
-      // Nodes that are on the edge (boundary) of a cut surface must be treated specially when sorting.
-      // In this case the sorting needs to start with the link whose first node is not used
-      // in any other link.  This is true if all tiles are consistently oriented (and they
-      // must be).
-      //
-      int startEdge = -1;
-      for (unsigned int k = 0; k < edges.size(); k++) {
-         const int nodeNum = edges[k].node1;
-         bool foundNode = false;
-         
-         //
-         // See if nodeNum is used in any other edges
-         //
-         for (unsigned int m = 0; m < edges.size(); m++) {
-            if (m != k) {
-               if (edges[m].containsNode(nodeNum) == true) {
-                  foundNode = true;
-                  break;
-               }
-            }
+   numberOfNodes = numNodes;
+   
+   //
+   // Count the tiles used by each node and convert the counts to offsets
+   //
+   tileOffsets.assign(numNodes + 1, 0);
+   for (int j = 0; j < (numTiles * 3); j++) {
+      tileOffsets[tiles[j] + 1]++;
+   }
+   for (int i = 0; i < numNodes; i++) {
+      tileOffsets[i + 1] += tileOffsets[i];
+   }
+   
+   //
+   // Place the tiles used by each node in tile order.  When sorting, also
+   // keep the edge opposite the node in each tile with the same order as the tile.
+   //
+   const int totalNodeTiles = tileOffsets[numNodes];
+   nodeTiles.resize(totalNodeTiles);
+   std::vector<NodeEdgeInfo> nodeEdges;
+   if (sortNodeInfo) {
+      nodeEdges.resize(totalNodeTiles);
+   }
+   std::vector<int> nextTileIndex(tileOffsets.begin(), tileOffsets.end() - 1);
+   for (int j = 0; j < numTiles; j++) {
+      const int n1 = tiles[j * 3];
+      const int n2 = tiles[j * 3 + 1];
+      const int n3 = tiles[j * 3 + 2];
+      const int i1 = nextTileIndex[n1]++;
+      const int i2 = nextTileIndex[n2]++;
+      const int i3 = nextTileIndex[n3]++;
+      nodeTiles[i1] = j;
+      nodeTiles[i2] = j;
+      nodeTiles[i3] = j;
+      if (sortNodeInfo) {
+         nodeEdges[i1] = NodeEdgeInfo(j, n2, n3);
+         nodeEdges[i2] = NodeEdgeInfo(j, n3, n1);
+         nodeEdges[i3] = NodeEdgeInfo(j, n1, n2);
+      }
+   }
+   
+   //
+   // Find each node's neighbors in space large enough for any node 
+   // (sorting produces at most one more neighbor than tiles, otherwise
+   // each tile adds at most two neighbors) and count them
+   //
+   std::vector<int> neighborCapacityOffsets(numNodes + 1, 0);
+   for (int i = 0; i < numNodes; i++) {
+      const int numNodeTiles = tileOffsets[i + 1] - tileOffsets[i];
+      neighborCapacityOffsets[i + 1] = neighborCapacityOffsets[i]
+                                     + (sortNodeInfo ? (numNodeTiles + 1) : (numNodeTiles * 2));
+   }
+   std::vector<int> neighborsFound(neighborCapacityOffsets[numNodes]);
+   std::vector<int> numNeighborsFound(numNodes, 0);
+   std::vector<int> numTilesFound(numNodes, 0);
+   
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1024)
+#endif
+   for (int i = 0; i < numNodes; i++) {
+      const int firstTile = tileOffsets[i];
+      const int numNodeTiles = tileOffsets[i + 1] - firstTile;
+      int* neighbors = &neighborsFound[neighborCapacityOffsets[i]];
+      int numNeighbors = 0;
+      
+      if (sortNodeInfo) {
+         if (numNodeTiles > 0) {
+            //
+            // Sorted tiles replace the node's tiles (there may be fewer of them)
+            //
+            sortNodeNeighbors(&nodeEdges[firstTile], numNodeTiles,
+                              neighbors, numNeighbors,
+                              &nodeTiles[firstTile], numTilesFound[i]);
          }
-         
-         if (foundNode == false) {
-            if (startEdge >= 0) {
-               //std::cerr << "INFO: multiple starting edges for node " << nodeNumber << std::endl;
-            }
-            else {
-               startEdge = k;
+      }
+      else {
+         for (int j = 0; j < numNodeTiles; j++) {
+            const int* tileNodes = &tiles[nodeTiles[firstTile + j] * 3];
+            for (int k = 0; k < 3; k++) {
+               const int n = tileNodes[k];
+               if (n == i) {
+                  continue;
+               }
+               bool found = false;
+               for (int m = 0; m < numNeighbors; m++) {
+                  if (neighbors[m] == n) {
+                     found = true;
+                     break;
+                  }
+               }
+               if (found == false) {
+                  neighbors[numNeighbors++] = n;
+               }
             }
          }
+         numTilesFound[i] = numNodeTiles;
       }
-      
-      bool flag = false;
-      if ((nodeNumber >= 44508) && (nodeNumber <= 44507)) { // modify for debugging
-         std::cerr << "Start Edge for node " << nodeNumber << " is " << startEdge << std::endl;
-         for (unsigned int k = 0; k < edges.size(); k++) {
-            std::cerr << "   " << edges[k].node1 << " " << edges[k].node2 << std::endl;
+      numNeighborsFound[i] = numNeighbors;
+   }
+   
+   //
+   // Pack the neighbors 
+   //
+   neighborOffsets.resize(numNodes + 1);
+   neighborOffsets[0] = 0;
+   for (int i = 0; i < numNodes; i++) {
+      neighborOffsets[i + 1] = neighborOffsets[i] + numNeighborsFound[i];
+   }
+   neighborNodes.resize(neighborOffsets[numNodes]);
+   for (int i = 0; i < numNodes; i++) {
+      std::copy(neighborsFound.begin() + neighborCapacityOffsets[i],
+                neighborsFound.begin() + neighborCapacityOffsets[i] + numNeighborsFound[i],
+                neighborNodes.begin() + neighborOffsets[i]);
+   }
+   
+   //
+   // Sorting may have dropped tiles so pack the tiles
+   //
+   if (sortNodeInfo) {
+      int count = 0;
+      for (int i = 0; i < numNodes; i++) {
+         const int firstTile = tileOffsets[i];
+         tileOffsets[i] = count;
+         for (int j = 0; j < numTilesFound[i]; j++) {
+            nodeTiles[count++] = nodeTiles[firstTile + j];
          }
-         flag = true;
       }
+      tileOffsets[numNodes] = count;
+      nodeTiles.resize(count);
+   }
+   
+   nodeInfoBuilt = true;
+   if (sortNodeInfo) {
+      nodeSortedInfoBuilt = true;
+   }
+}
 
-      // startEdge is less than zero if the node's links are all interior links 
-      if (startEdge < 0) {
-         startEdge = 0;
-      }
-      
-      int currentNode  = edges[startEdge].node1;
-      int nextNeighbor = edges[startEdge].node2;
-      neighbors.push_back(currentNode);
-      tiles.push_back(edges[startEdge].tileNumber);
-      const int firstNode = currentNode;
+/**
+ * Sort a node's neighbors and tiles using the edges opposite the node in
+ * each of its tiles.  "neighborsOut" must have space for one more neighbor
+ * than the number of edges and "tilesOut" space for the number of edges.
+ */
+void 
+TopologyHelper::sortNodeNeighbors(const NodeEdgeInfo* edges,
+                                  const int numEdges,
+                                  int* neighborsOut,
+                                  int& numNeighborsOut,
+                                  int* tilesOut,
+                                  int& numTilesOut) 
+{
+   numNeighborsOut = 0;
+   numTilesOut = 0;
+   if (numEdges <= 0) {
+      return;
+   }
+   
+   //
+   // Nodes that are on the edge (boundary) of a cut surface must be treated specially when sorting.
+   // In this case the sorting needs to start with the link whose first node is not used
+   // in any other link.  This is true if all tiles are consistently oriented (and they
+   // must be).
+   //
+   int startEdge = -1;
+   for (int k = 0; (k < numEdges) && (startEdge < 0); k++) {
+      const int nodeNum = edges[k].node1;
+      bool foundNode = false;
       
-      for (unsigned int i = 1; i < edges.size(); i++) {
-         neighbors.push_back(nextNeighbor);
-         // find edge with node "nextNeighbor" but without node "currentNode"
-         const NodeEdgeInfo* e = findEdgeWithPoint(nextNeighbor, currentNode);
-         if (e != NULL) {
-            tiles.push_back(e->tileNumber);
-            currentNode = nextNeighbor;
-            nextNeighbor = e->getOtherNode(nextNeighbor);
-            if (nextNeighbor < 0) {
-               //std::cerr << "INFO: Unable to find neighbor of"
-               //            <<  nextNeighbor << std::endl;
+      //
+      // See if nodeNum is used in any other edges
+      //
+      for (int m = 0; m < numEdges; m++) {
+         if (m != k) {
+            if (edges[m].containsNode(nodeNum) == true) {
+               foundNode = true;
+               break;
             }
          }
-         else {
-            nextNeighbor = -1;
-            //std::cerr << "INFO: Unable to find edge for for node " 
-            //            << nodeNumber << std::endl;
-            break;
-         }
       }
       
-      if ((nextNeighbor != firstNode) && (nextNeighbor >= 0)) {
-         neighbors.push_back(nextNeighbor);
+      if (foundNode == false) {
+         startEdge = k;
       }
+   }
+   
+   // startEdge is less than zero if the node's links are all interior links 
+   if (startEdge < 0) {
+      startEdge = 0;
+   }
+   
+   int currentNode  = edges[startEdge].node1;
+   int nextNeighbor = edges[startEdge].node2;
+   neighborsOut[numNeighborsOut++] = currentNode;
+   tilesOut[numTilesOut++] = edges[startEdge].tileNumber;
+   const int firstNode = currentNode;
+   
+   for (int i = 1; i < numEdges; i++) {
+      neighborsOut[numNeighborsOut++] = nextNeighbor;
       
-      if (flag) {
-         std::cerr << "Node " << nodeNumber << " neighbors: ";
-         for (unsigned int n = 0; n < neighbors.size(); n++) {
-            std::cerr << "  " << neighbors[n];
-         }
-         std::cerr << std::endl;
-         std::cerr << "Node " << nodeNumber << " tiles: ";
-         for (unsigned int n = 0; n < tiles.size(); n++) {
-            std::cerr << "  " << tiles[n];
+      // find edge with node "nextNeighbor" but without node "currentNode"
+      const NodeEdgeInfo* e = NULL;
+      for (int m = 0; m < numEdges; m++) {
+         if ( ((edges[m].node1 == nextNeighbor) &&
+               (edges[m].node2 != currentNode)) ||
+              ((edges[m].node2 == nextNeighbor) &&
+               (edges[m].node1 != currentNode)) ) {
+            e = &edges[m];
+            break;
          }
-         std::cerr << std::endl;
       }
+      
+      if (e != NULL) {
+         tilesOut[numTilesOut++] = e->tileNumber;
+         currentNode= nextNeighbor;
+         nextNeighbor = e->getOtherNode(nextNeighbor);
+      }
+      else {
+         nextNeighbor = -1;
+         break;
+      }
+   }
+   
+   if ((nextNeighbor!= firstNode) && (nextNeighbor >= 0)) {
+      neighborsOut[numNeighborsOut++] = nextNeighbor;
    }
-   edges.clear();
 }
 
 /**
@@ -405,8 +457,8 @@ TopologyHelper::NodeInfo::sortNeighbors()
 bool
 TopologyHelper::getNodeHasNeighbors(const int nodeNum) const
 {
-   if ((nodeNum >= 0) && (nodeNum < static_cast<int>(nodes.size()))) {
-      return (nodes[nodeNum].neighbors.empty() == false);
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
+      return (neighborOffsets[nodeNum + 1] > neighborOffsets[nodeNum]);
    }
    return false;
 }
@@ -417,8 +469,8 @@ TopologyHelper::getNodeHasNeighbors(const int nodeNum) const
 int 
 TopologyHelper::getNodeNumberOfNeighbors(const int nodeNum) const
 {
-   if ((nodeNum >= 0) && (nodeNum < static_cast<int>(nodes.size()))) {
-      return nodes[nodeNum].neighbors.size();
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
+      return (neighborOffsets[nodeNum + 1] - neighborOffsets[nodeNum]);
    }
    return 0;
 }
@@ -470,10 +522,10 @@ TopologyHelper::getNumberOfBoundaryEdgesForAllNodes(std::vector<int>& numBoundar
 int
 TopologyHelper::getMaximumNumberOfNeighbors() const
 {
-   unsigned int maxNeighbors = 0;
+   int maxNeighbors = 0;
    int numNodes = getNumberOfNodes();
    for (int i = 0; i < numNodes; i++) {
-      const unsigned int num = nodes[i].neighbors.size();
+      const int num = neighborOffsets[i + 1] - neighborOffsets[i];
       if (num > maxNeighbors) {
          maxNeighbors = num;
       }
@@ -488,8 +540,9 @@ void
 TopologyHelper::getNodeNeighbors(const int nodeNum,
                                  std::vector<int>& neighborsOut) const
 {
-   if ((nodeNum >= 0) && (nodeNum < static_cast<int>(nodes.size()))) {
-      neighborsOut = nodes[nodeNum].neighbors;
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
+      neighborsOut.assign(neighborNodes.begin() + neighborOffsets[nodeNum],
+                          neighborNodes.begin() + neighborOffsets[nodeNum + 1]);
    }
    else {
       neighborsOut.clear();
@@ -503,13 +556,14 @@ void
 TopologyHelper::getNodeNeighborsInROI(const int nodeNum,
                                  std::vector<int>& neighborsOut, const float *roiValues) const
 {
-   if ((nodeNum >= 0) && (nodeNum < static_cast<int>(nodes.size()))) {
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
       //Since we are restricting to an roi, we need to make sure that the neighbors are within the ROI, and
       //if not, build a new neighbor list
-      std::vector<int> neighbors = nodes[nodeNum].neighbors;
+      int numNeighbors = 0;
+      const int* neighbors = getNodeNeighbors(nodeNum, numNeighbors);
       //optimization, first, loop through and see any neighbors are outside the roi
       bool neighborOutsideOfRoi = false;
-      for(int i = 0;i<neighbors.size();i++)
+      for(int i = 0;i<numNeighbors;i++)
       {
          if(roiValues[neighbors[i]] == 0.0)
          {
@@ -520,13 +574,13 @@ TopologyHelper::getNodeNeighborsInROI(const int nodeNum,
 
       if(!neighborOutsideOfRoi)
       {
-         neighborsOut = nodes[nodeNum].neighbors;
+         neighborsOut.assign(neighbors, neighbors + numNeighbors);
       }
       else
       {
          neighborsOut.clear();
 
-         for(int i = 0;i<neighbors.size();i++)
+         for(int i = 0;i<numNeighbors;i++)
          {
             if(roiValues[neighbors[i]] == 0.0)//filter out neighbors that are outside of ROI
             {
@@ -590,8 +644,7 @@ TopologyHelper::getNodeNeighborsToDepthIter(const int rootNode,
       newlist = nodelist + newind;
       for (j = 0; j < oldused; ++j)
       {
-         const std::vector<int>& neighbors = nodes[(*oldlist)[j]].neighbors;
-         numNeigh = neighbors.size();
+         const int* neighbors = getNodeNeighbors((*oldlist)[j], numNeigh);
          for (k = 0; k < numNeigh; ++k)
          {
             whichneigh = neighbors[k];
@@ -655,8 +708,8 @@ TopologyHelper::getNodeNeighborsToDepth(const int rootNode,
 
 void TopologyHelper::depthNeighHelper(int node, int depthrem, std::vector<int>& neighborsOut) const
 {
-   const std::vector<int>& neighbors = nodes[node].neighbors;
-   int i, nextdepth = depthrem - 1, numNeigh = neighbors.size(), thisNeigh, mark;
+   int i, nextdepth = depthrem - 1, numNeigh, thisNeigh, mark;
+   const int* neighbors = getNodeNeighbors(node, numNeigh);
    if (nextdepth)
    {//splitting here removes a large number of recursive calls and compares
       for (i = 0; i < numNeigh; ++i)
@@ -714,10 +767,10 @@ TopologyHelper::getNodeNeighborsToDepthOld(const int rootNode,
             //
             // Get all of the nodes neighbors
             //
-            const std::vector<int>& neighbors = nodes[node].neighbors;
-            const unsigned int numNeighs = neighbors.size();
+            int numNeighs = 0;
+            const int* neighbors = getNodeNeighbors(node, numNeighs);
             
-            for (unsigned int j = 0; j < numNeighs; j++) {
+            for (int j = 0; j < numNeighs; j++) {
                const int n = neighbors[j];
                if (nodeVisited[n] == 0) {
                   newNodes.insert(n);
@@ -890,12 +943,12 @@ TopologyHelper::getNodeNeighborsToDepthOld(const int rootNode,
 const int*
 TopologyHelper::getNodeNeighbors(const int nodeNum, int& numNeighborsOut) const
 {
-   if ((nodeNum >= 0) && (nodeNum < static_cast<int>(nodes.size()))) {
-      numNeighborsOut = static_cast<int>(nodes[nodeNum].neighbors.size());
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
+      numNeighborsOut = neighborOffsets[nodeNum + 1] - neighborOffsets[nodeNum];
       if (numNeighborsOut <= 0) {
          return NULL;
       }
-      return &nodes[nodeNum].neighbors[0];
+      return &neighborNodes[neighborOffsets[nodeNum]];
    }
    numNeighborsOut = 0;
    return NULL;
@@ -907,11 +960,30 @@ TopologyHelper::getNodeNeighbors(const int nodeNum, int& numNeighborsOut) const
 void
 TopologyHelper::getNodeTiles(const int nodeNum, std::vector<int>& tilesOut) const
 {
-   if ((nodeNum >= 0) && (nodeNum < static_cast<int>(nodes.size()))) {
-      tilesOut = nodes[nodeNum].tiles;
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
+      tilesOut.assign(nodeTiles.begin() + tileOffsets[nodeNum],
+                      nodeTiles.begin() + tileOffsets[nodeNum + 1]);
    }
    else {
       tilesOut.clear();
    }
 }
 
+/**
+ * Get the tiles that use this node.  Returns a pointer to an array
+ * containing the tiles.
+ */
+const int*
+TopologyHelper::getNodeTiles(const int nodeNum, int& numTilesOut) const
+{
+   if ((nodeNum >= 0) && (nodeNum < numberOfNodes)) {
+      numTilesOut = tileOffsets[nodeNum + 1] - tileOffsets[nodeNum];
+      if (numTilesOut <= 0) {
+         return NULL;
+      }
+      return &nodeTiles[tileOffsets[nodeNum]];
+   }
+   numTilesOut = 0;
+   return NULL;
+}
+
@@ -114,6 +114,8 @@ class TopologyEdgeInfo {
       
       
 /// This class is used to determine the node neighbors and edges for a Topology File.
+/// The neighbors and tiles of all nodes are each kept in one contiguous array
+/// indexed by an array of per-node offsets (compressed sparse row).
 class TopologyHelper {
    public:
       /// Constructor for use with a Caret Topology File
@@ -132,7 +134,7 @@ class TopologyHelper {
       ~TopologyHelper();
       
       /// Get the number of nodes
-      int getNumberOfNodes() const { return nodes.size(); }
+      int getNumberOfNodes() const { return numberOfNodes; }
       
       /// See if a node has neighbors
       bool getNodeHasNeighbors(const int nodeNum) const;
@@ -181,6 +183,10 @@ class TopologyHelper {
       /// Get the tiles used by a node
       void getNodeTiles(const int nodeNum, std::vector<int>& tilesOut) const;
       
+      /// Get the tiles used by a node.  Returns a pointer to an array
+      /// containing the tiles.
+      const int* getNodeTiles(const int nodeNum, int& numTilesOut) const;
+      
       /// get edge info validity
       bool getEdgeInfoValid() const { return edgeInfoBuilt; }
       
@@ -198,8 +204,8 @@ class TopologyHelper {
 
    private:
       
-      /// Stores tiles and vertices of an edge (link) for use when sorting nodes by NodeInfo.
-      /// These edges are those opposite of a NodeInfo node, this is, given a tile with
+      /// Stores tiles and vertices of an edge (link) for use when sorting a node's neighbors.
+      /// These edges are those opposite of a node, this is, given a tile with
       /// nodes A, B, and C, the nodes B and C would be stored in an NodeEdgeInfo for node A. 
       class NodeEdgeInfo {
          public:
@@ -209,6 +215,13 @@ class TopologyHelper {
             /// tile used by this edge
             int tileNumber;
             
+            /// constructor
+            NodeEdgeInfo() {
+               tileNumber = -1;
+               node1 = -1;
+               node2 = -1;
+            }
+            
             /// constructor
             NodeEdgeInfo(const int tileNum, const int node1In, const int node2In) {
                tileNumber = tileNum;
@@ -228,70 +241,35 @@ class TopologyHelper {
             }
       };
       
-      /// Stores information about a node for sorting
-      class NodeInfo {
-         public:
-            /// this node's number
-            int nodeNumber;
-            
-            /// tile's used by this node
-            std::vector<int> tiles;
-            
-            /// the neighboring nodes of this edge
-            std::vector<int> neighbors;
-            
-            /// the edges used to form tiles with this node
-            std::vector<NodeEdgeInfo> edges;
-            
-            /// allow sorting flag
-            bool  sortMe;
-            
-            /// constructor
-            NodeInfo(const int nodeNumberIn) {
-               nodeNumber = nodeNumberIn;
-               sortMe = true;
-            }
-            
-            /// add a neighbor to this node without edge information
-            void addNeighbor(const int newNeighbor1) {
-               for (unsigned int i = 0; i < neighbors.size(); i++) {
-                  if (neighbors[i] == newNeighbor1) {
-                     return;
-                  }
-               }
-               neighbors.push_back(newNeighbor1);
-               sortMe = false;
-            }
-            
-            /// add two neighbors that form a tile using this node
-            void addNeighbors(const int tileNum, const int newNeighbor1, const int newNeighbor2) {
-               edges.push_back(NodeEdgeInfo(tileNum, newNeighbor1, newNeighbor2));
-            }
-
-            /// add a tile to the node
-            void addTile(const int tileNum) { tiles.push_back(tileNum); }
-            
-            /// find an edge that has one endpoint equal to "seekingNode" but
-            /// does not contain the node "notNode".
-            const NodeEdgeInfo* findEdgeWithPoint(const int seekingNode, 
-                                              const int notNode) {
-               for (unsigned int i = 0; i < edges.size(); i++) {
-                  if ( ((edges[i].node1 == seekingNode) &&
-                        (edges[i].node2 != notNode)) ||
-                       ((edges[i].node2 == seekingNode) &&
-                        (edges[i].node1 != notNode)) ) {
-                     return &edges[i];
-                  }
-               }
-               return NULL;
-            }
-
-            /// sort the neighbors for this node
-            void sortNeighbors();
-      };
+      /// first index of each node's neighbors in "neighborNodes" (one extra 
+      /// element at end so that a node's count is the difference of offsets)
+      std::vector<int> neighborOffsets;
+      
+      /// the neighbors of all nodes, contiguous by node
+      std::vector<int> neighborNodes;
+      
+      /// first index of each node's tiles in "nodeTiles" (one extra element at end)
+      std::vector<int> tileOffsets;
+      
+      /// the tiles used by all nodes, contiguous by node
+      std::vector<int> nodeTiles;
+      
+      /// number of nodes
+      int numberOfNodes;
+      
+      /// build the node neighbors and tiles (three nodes per tile)
+      void buildNodeNeighborsAndTiles(const int* tiles,
+                         const int numTiles,
+                         const int numNodes,
+                         const bool sortNodeInfo);
       
-      /// Node storage
-      std::vector<NodeInfo> nodes;
+      /// sort a node's neighbors and tiles using the edges opposite the node
+      static void sortNodeNeighbors(const NodeEdgeInfo* edges,
+                                    const int numEdges,
+                                    int* neighborsOut,
+                                    int& numNeighborsOut,
+                                    int* tilesOut,
+                                    int& numTilesOut);
       
       /// edge storage
       std::set<TopologyEdgeInfo> topologyEdges;
@@ -53,6 +53,10 @@
 #include <sstream>
 #include <stack>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <QProcess>
 
 #define __VOLUME_FILE_MAIN_H__
@@ -63,9 +67,11 @@
 #include "ByteSwapping.h"
 #include "DebugControl.h"
 #include "FileUtilities.h"
+#include "GzipBlockFile.h"
 #include "MathUtilities.h"
 #include "NiftiFileHeader.h"
 #include "ParamsFile.h"
+#include "SeparableConvolution.h"
 #include "SpecFile.h"
 #include "StatisticDataGroup.h"
 #include "StatisticHistogram.h"
@@ -89,12 +95,11 @@
 #include "vtkImageCast.h"
 #include "vtkImageFlip.h"
 #include "vtkImageGaussianSmooth.h"
-#include "vtkImageResample.h"
-#include "vtkImageReslice.h"
 #include "vtkImageSeedConnectivity.h"
 #include "vtkImageShrink3D.h"
 #include "vtkMarchingCubes.h"
 #include "vtkMath.h"
+#include "vtkMatrix4x4.h"
 #include "vtkPointData.h"
 #include "vtkPolyDataNormals.h"
 #include "vtkPolyDataWriter.h"
@@ -126,6 +131,9 @@ VolumeFile::VolumeFile()
    voxels     = NULL;
    voxelColoring  = NULL;
    voxelToSurfaceDistances = NULL;
+   pagedSubVolumeIndex = -1;
+   pagedVoxelsLastAccess = 0;
+   pagedVoxelsPinned = false;
    clear();
 }
 
@@ -144,6 +152,9 @@ VolumeFile::VolumeFile(const VolumeFile& vf)
    voxels     = NULL;
    voxelColoring  = NULL;
    voxelToSurfaceDistances = NULL;
+   pagedSubVolumeIndex = -1;
+   pagedVoxelsLastAccess = 0;
+   pagedVoxelsPinned = false;
    copyVolumeData(vf);
 }
 
@@ -179,6 +190,9 @@ VolumeFile::VolumeFile(const SureFitVectorFile& vf)
    voxels     = NULL;
    voxelColoring  = NULL;
    voxelToSurfaceDistances = NULL;
+   pagedSubVolumeIndex = -1;
+   pagedVoxelsLastAccess = 0;
+   pagedVoxelsPinned = false;
 
    int dim[3];
    vf.getDimensions(dim);
@@ -217,8 +231,12 @@ VolumeFile::VolumeFile(const SureFitVectorFile& vf)
  */
 void 
 VolumeFile::copyVolumeData(const VolumeFile& vf,
-                           const bool copyVoxelData)
+                           const bool copyVoxelData,
+                           const bool allocateVoxelData)
 {
+   if (copyVoxelData) {
+      vf.loadPagedVoxelsForAccess();
+   }
    clear();
    
    //
@@ -262,7 +280,8 @@ VolumeFile::copyVolumeData(const VolumeFile& vf,
    vf.getOrigin(org);
    float space[3];
    vf.getSpacing(space);   
-   initialize(voxelDataType, dim, orient, org, space, false);
+   initialize(voxelDataType, dim, orient, org, space, false,
+              (copyVoxelData || allocateVoxelData));
    
    //
    // Copy the voxels
@@ -308,6 +327,267 @@ VolumeFile::copyVolumeData(const VolumeFile& vf,
    setModified();
 }
       
+/**
+ * read the voxels of a paged sub-volume if they are not in memory.
+ */
+void 
+VolumeFile::loadPagedVoxels() const throw (FileException)
+{
+   if (pagedSubVolumeIndex >= 0) {
+      //
+      // The access counter is only a hint for choosing the least recently
+      // used sub-volume so it is updated without locking and only when
+      // another sub-volume has been accessed since this one
+      //
+      if (pagedVoxelsLastAccess != pagedVoxelsAccessCounter) {
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+         pagedVoxelsAccessCounter++;
+         pagedVoxelsLastAccess = pagedVoxelsAccessCounter;
+      }
+      
+      //
+      // Voxels are only published (never freed) while in parallel so a
+      // non-NULL pointer seen after the flush is safe to use
+      //
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+      if (voxels == NULL) {
+         QString errorMessage;
+#ifdef _OPENMP
+#pragma omp critical (VolumeFilePagedVoxels)
+#endif
+         {
+            if (voxels == NULL) {
+               //
+               // Exceptions may not leave a critical section
+               //
+               try {
+                  readPagedVoxels();
+               }
+               catch (FileException& e) {
+                  errorMessage = e.whatQString();
+               }
+            }
+         }
+         if (errorMessage.isEmpty() == false) {
+            throw FileException(errorMessage);
+         }
+      }
+   }
+}
+
+/**
+ * read the voxels of a paged sub-volume and evict others over the memory budget.
+ * Must be called from within the paged voxels critical section.
+ */
+void 
+VolumeFile::readPagedVoxels() const throw (FileException)
+{
+   VolumeFile* vf = const_cast<VolumeFile*>(this);
+   
+   //
+   // Read just this sub-volume and take its voxels
+   //
+   std::vector<VolumeFile*> volumes;
+   QString errorMessage;
+   try {
+      readFile(pagedVoxelsFileName, pagedSubVolumeIndex, volumes);
+   }
+   catch (FileException& e) {
+      errorMessage = e.whatQString();
+   }
+   
+   const int num = getTotalNumberOfVoxelElements();
+   float* voxelsRead = NULL;
+   if (volumes.empty() == false) {
+      if ((volumes[0]->voxels != NULL) &&
+          (volumes[0]->getTotalNumberOfVoxelElements() == num)) {
+         voxelsRead = volumes[0]->voxels;
+         volumes[0]->voxels = NULL;
+      }
+   }
+   for (unsigned int i = 0; i < volumes.size(); i++) {
+      delete volumes[i];
+   }
+   
+   if (voxelsRead == NULL) {
+      QString msg("Unable to read sub-volume "
+                  + QString::number(pagedSubVolumeIndex)
+                  + " of "
+                  + pagedVoxelsFileName);
+      if (errorMessage.isEmpty() == false) {
+         msg += ": " + errorMessage;
+      }
+      throw FileException(msg);
+   }
+   
+   //
+   // Make sure the voxel values are visible to other threads before the pointer
+   //
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+   vf->voxels = voxelsRead;
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+   vf->allocateVoxelColoring();
+   residentPagedVolumes.push_back(vf);
+   
+   //
+   // Another thread may be using the voxels of other sub-volumes
+   //
+#ifdef _OPENMP
+   if (omp_in_parallel()) {
+      return;
+   }
+#endif
+
+   //
+   // Evict least recently used sub-volumes until within the memory budget.
+   // Modified sub-volumes are never evicted since their voxels cannot be reread
+   // and pinned sub-volumes are never evicted since a pointer to their voxels
+   // has been given out.
+   //
+   const double budgetBytes = static_cast<double>(pagedVoxelsMemoryBudget) * 1024.0 * 1024.0;
+   double residentBytes = 0.0;
+   for (unsigned int i = 0; i < residentPagedVolumes.size(); i++) {
+      residentBytes += static_cast<double>(residentPagedVolumes[i]->getTotalNumberOfVoxelElements())
+                     * sizeof(float);
+   }
+   while (residentBytes > budgetBytes) {
+      int oldestIndex = -1;
+      for (int i = 0; i < static_cast<int>(residentPagedVolumes.size()); i++) {
+         const VolumeFile* rv = residentPagedVolumes[i];
+         if ((rv != this) &&
+             (rv->pagedVoxelsPinned == false) &&
+             (rv->getModified() == 0)) {
+            if ((oldestIndex < 0) ||
+                (rv->pagedVoxelsLastAccess < residentPagedVolumes[oldestIndex]->pagedVoxelsLastAccess)) {
+               oldestIndex = i;
+            }
+         }
+      }
+      if (oldestIndex < 0) {
+         break;
+      }
+      
+      VolumeFile* oldest = residentPagedVolumes[oldestIndex];
+      residentBytes -= static_cast<double>(oldest->getTotalNumberOfVoxelElements())
+                     * sizeof(float);
+      residentPagedVolumes.erase(residentPagedVolumes.begin() + oldestIndex);
+      oldest->evictPagedVoxels();
+   }
+}
+
+/**
+ * read the voxels of a paged sub-volume for a member that cannot throw.
+ * If the voxels cannot be read the error is printed and the voxels are
+ * set to zero.  Algorithms call loadVoxelData() before using a volume
+ * so that a read error is reported to the user instead.
+ */
+void 
+VolumeFile::loadPagedVoxelsForAccess() const
+{
+   try {
+      loadPagedVoxels();
+   }
+   catch (FileException& e) {
+#ifdef _OPENMP
+#pragma omp critical (VolumeFilePagedVoxels)
+#endif
+      {
+         if (voxels == NULL) {
+            std::cout << "ERROR: " << e.whatQString().toAscii().constData() << std::endl;
+            
+            VolumeFile* vf = const_cast<VolumeFile*>(this);
+            const int num = getTotalNumberOfVoxelElements();
+            float* zeroVoxels = new float[num];
+            std::fill(zeroVoxels, zeroVoxels + num, 0.0f);
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+            vf->voxels = zeroVoxels;
+#ifdef _OPENMP
+#pragma omp flush
+#endif
+            vf->allocateVoxelColoring();
+         }
+      }
+   }
+}
+
+/**
+ * get the voxel data of a paged sub-volume and pin it so that it is never evicted.
+ */
+const float* 
+VolumeFile::getPinnedVoxelData() const
+{
+   if (pagedSubVolumeIndex >= 0) {
+      loadPagedVoxelsForAccess();
+      pagedVoxelsPinned = true;
+   }
+   return voxels;
+}
+
+/**
+ * stop paging the sub-volume so that its voxels stay in memory.
+ */
+void 
+VolumeFile::stopPagingVoxels(const bool loadVoxelsFlag)
+{
+   if (pagedSubVolumeIndex >= 0) {
+      if (loadVoxelsFlag) {
+         loadPagedVoxelsForAccess();
+      }
+#ifdef _OPENMP
+#pragma omp critical (VolumeFilePagedVoxels)
+#endif
+      {
+         std::vector<VolumeFile*>::iterator iter = 
+            std::find(residentPagedVolumes.begin(), residentPagedVolumes.end(), this);
+         if (iter != residentPagedVolumes.end()) {
+            residentPagedVolumes.erase(iter);
+         }
+         pagedSubVolumeIndex = -1;
+         pagedVoxelsFileName = "";
+         pagedVoxelsPinned = false;
+      }
+   }
+}
+
+/**
+ * read the voxels of a paged sub-volume and keep them in memory.
+ */
+void 
+VolumeFile::loadVoxelData() throw (FileException)
+{
+   if (pagedSubVolumeIndex >= 0) {
+      loadPagedVoxels();
+      stopPagingVoxels(false);
+   }
+}
+
+/**
+ * free the voxels of a paged sub-volume (reread when next accessed).
+ */
+void 
+VolumeFile::evictPagedVoxels()
+{
+   if (voxels != NULL) {
+      delete[] voxels;
+      voxels = NULL;
+   }
+   if (voxelColoring != NULL) {
+      delete[] voxelColoring;
+      voxelColoring = NULL;
+   }
+   voxelColoringValid = false;
+}
+
 /**
  * set the volume file's type for writing.
  */
@@ -498,6 +778,7 @@ VolumeFile::initialize(const VOXEL_DATA_TYPE vdt, const int dim[3],
       clear();
    }
    
+   stopPagingVoxels(false);
    if (voxels != NULL) {
       delete[] voxels;
       voxels = NULL;
@@ -790,6 +1071,8 @@ VolumeFile::rescaleVoxelValues(const float inputMinimum,
                                const float outputMinimum,
                                const float outputMaximum)
 {
+   stopPagingVoxels(true);
+   
    float inputDiff  = inputMaximum - inputMinimum;
    if (inputDiff == 0.0) {
       inputDiff = 1.0;
@@ -823,6 +1106,8 @@ void
 VolumeFile::scaleVoxelValues(const float scale, const float minimumValueAllowed,
                                 const float maximumValueAllowed)
 {
+   stopPagingVoxels(true);
+   
    const int num = getTotalNumberOfVoxelElements();
    for (int i = 0; i < num; i++) {
       float value = voxels[i];
@@ -842,6 +1127,8 @@ VolumeFile::scaleVoxelValues(const float scale, const float minimumValueAllowed,
 void
 VolumeFile::getMinMaxVoxelValues(float& minVoxelValue, float& maxVoxelValue) 
 {
+   loadPagedVoxelsForAccess();
+   
    if (minMaxVoxelValuesValid == false) {
       const int numVoxelElements = getTotalNumberOfVoxelElements();
       if (numVoxelElements <= 0) {
@@ -958,6 +1245,8 @@ VolumeFile::getHistogram(const int numBuckets,
                          float& minVoxelValue,
                          float& maxVoxelValue) 
 {
+   loadPagedVoxelsForAccess();
+   
    getMinMaxVoxelValues(minVoxelValue, maxVoxelValue);
    
    const int numVoxels = getTotalNumberOfVoxels();
@@ -1050,6 +1339,7 @@ VolumeFile::clear()
 {
    clearAbstractFile();
    
+   stopPagingVoxels(false);
    if (voxels != NULL) {
       delete[] voxels;
       voxels = NULL;
@@ -1221,6 +1511,8 @@ VolumeFile::deleteAllRegionNames()
 void
 VolumeFile::createRegionNamesForVoxelsThatDoNotIndexIntoRegionNames()
 {
+   loadPagedVoxelsForAccess();
+   
    int numVoxels = this->getTotalNumberOfVoxels();
    for (int iv = 0; iv < numVoxels; iv++) {
        int voxel = static_cast<int>(this->voxels[iv]);
@@ -1363,6 +1655,7 @@ VolumeFile::synchronizeRegionNames(std::vector<VolumeFile*>& volumeFiles)
       //
       // Update volume "i" voxels with new region indices
       //
+      vf->stopPagingVoxels(true);
       const int numVoxels = vf->getTotalNumberOfVoxels();
       for (int k = 0; k < numVoxels; k++) {
          vf->voxels[k] = regionIndexUpdater[static_cast<int>(vf->voxels[k])];
@@ -1387,7 +1680,7 @@ float*
 VolumeFile::getVoxelToSurfaceDistances()
 {
    if (voxelToSurfaceDistances == NULL) {
-      if (voxels != NULL) {
+      if (empty() == false) {
          int dim[3];
          getDimensions(dim);
          const int num = dim[0] * dim[1] * dim[2];
@@ -1735,6 +2028,8 @@ VolumeFile::setSlice(const VOLUME_AXIS axis,
 void
 VolumeFile::rotate(const VOLUME_AXIS axis)
 {
+   stopPagingVoxels(true);
+   
    if (DebugControl::getDebugOn()) {
       std::cout << "VolumeFile rotating about axis: " << getAxisLabel(axis).toAscii().constData() << std::endl;
    }
@@ -2069,6 +2364,8 @@ VolumeFile::getVoxelIndexValid(const int i, const int j, const int k) const
 float 
 VolumeFile::getVoxelWithFlatIndex(const int indx, const int component) const
 {
+   loadPagedVoxelsForAccess();
+   
    return voxels[indx*numberOfComponentsPerVoxel + component];
 }
 
@@ -2078,6 +2375,8 @@ VolumeFile::getVoxelWithFlatIndex(const int indx, const int component) const
 void 
 VolumeFile::setVoxelWithFlatIndex(const int indx, const int component, const float value)
 {
+   stopPagingVoxels(true);
+   
    voxels[indx*numberOfComponentsPerVoxel + component] = value;
    setModified();
    minMaxVoxelValuesValid = false;
@@ -2127,6 +2426,8 @@ VolumeFile::getVoxelCoordinate(const VoxelIJK& v,
 float 
 VolumeFile::getVoxel(const int i, const int j, const int k, const int component) const
 {
+   loadPagedVoxelsForAccess();
+   
    const int indx = getVoxelDataIndex(i, j, k, component);
    return voxels[indx];
 }
@@ -2137,6 +2438,8 @@ VolumeFile::getVoxel(const int i, const int j, const int k, const int component)
 float 
 VolumeFile::getVoxel(const int ijk[3], const int component) const
 {
+   loadPagedVoxelsForAccess();
+   
    const int indx = getVoxelDataIndex(ijk, component);
    return voxels[indx];
 }
@@ -2147,6 +2450,8 @@ VolumeFile::getVoxel(const int ijk[3], const int component) const
 float 
 VolumeFile::getVoxel(const VoxelIJK& v, const int component) const
 {
+   loadPagedVoxelsForAccess();
+   
    const int indx = getVoxelDataIndex(v.getIJK(), component);
    return voxels[indx];
 }
@@ -2159,6 +2464,8 @@ VolumeFile::getVoxel(const VoxelIJK& v, const int component) const
 bool
 VolumeFile::getVoxelAllComponents(const int ijk[3], float* voxelValue) const
 {
+   loadPagedVoxelsForAccess();
+   
    if (getVoxelIndexValid(ijk)) {
       if (voxels != NULL) {
          const int indx = getVoxelDataIndex(ijk);
@@ -2218,6 +2525,8 @@ VolumeFile::getVoxelAllComponents(const int i, const int j, const int k, float*
 void
 VolumeFile::setVoxelAllComponents(const int ijk[3], const float* voxelValue) 
 {
+   stopPagingVoxels(true);
+   
    if (getVoxelIndexValid(ijk)) {
       if (voxels != NULL) {
          const int indx = getVoxelDataIndex(ijk);
@@ -2307,6 +2616,8 @@ VolumeFile::setAllVoxelsInSlice(const VOLUME_AXIS axis, const int sliceNumber,
 void
 VolumeFile::setVoxel(const int ijk[3], const int component, const float voxelValue) 
 {
+   stopPagingVoxels(true);
+   
    if (getVoxelIndexValid(ijk)) {
       if (voxels != NULL) {
          const int indx = getVoxelDataIndex(ijk);
@@ -2364,6 +2675,8 @@ VolumeFile::setVoxel(const int i, const int j, const int k, const int component,
 void 
 VolumeFile::setVoxel(const std::vector<int> indicies, const float voxelValue)
 {
+   stopPagingVoxels(true);
+   
    const int num = static_cast<int>(indicies.size());
    
    if (voxels != NULL) {
@@ -2429,6 +2742,8 @@ VolumeFile::setAllVoxelsInRectangle(const int extentIn[6],
 void 
 VolumeFile::setAllVoxels(const float value)
 {
+   stopPagingVoxels(true);
+   
    const int num = getTotalNumberOfVoxelElements();
    for (int i = 0; i < num; i++) {
       voxels[i] = value;
@@ -2447,6 +2762,8 @@ VolumeFile::setAllVoxels(const float value)
 void
 VolumeFile::setVoxelColor(const int ijk[3], const unsigned char rgb[4])
 {
+   loadPagedVoxelsForAccess();
+   
    if (getVoxelIndexValid(ijk)) {
       if (voxelColoring != NULL) {
          const int indx = getVoxelColorIndex(ijk);
@@ -2466,6 +2783,8 @@ VolumeFile::setVoxelColor(const int ijk[3], const unsigned char rgb[4])
 void
 VolumeFile::setVoxelColor(const int i, const int j, const int k, const unsigned char rgb[4])
 {
+   loadPagedVoxelsForAccess();
+   
    if (getVoxelIndexValid(i, j, k)) {
       if (voxelColoring != NULL) {
          const int indx = getVoxelColorIndex(i, j, k);
@@ -2483,6 +2802,8 @@ VolumeFile::setVoxelColor(const int i, const int j, const int k, const unsigned
 void
 VolumeFile::checkForInvalidVoxelColors()
 {
+   loadPagedVoxelsForAccess();
+   
    if (voxelColoringValid == false) {
       if (voxelColoring != NULL) {
          voxelColoringValid = true;
@@ -2501,6 +2822,8 @@ VolumeFile::checkForInvalidVoxelColors()
 bool
 VolumeFile::getVoxelColor(const int ijk[3], unsigned char rgb[4])
 {
+   loadPagedVoxelsForAccess();
+   
    if (getVoxelIndexValid(ijk)) {
       if (voxelColoring != NULL) {
          const int indx = getVoxelColorIndex(ijk);
@@ -2562,6 +2885,8 @@ VolumeFile::getVoxelColor(const int i, const int j, const int k, unsigned char r
 void
 VolumeFile::flip(const VOLUME_AXIS axis, const bool updateOrientation)
 {
+   stopPagingVoxels(true);
+   
    int dim[3];
    getDimensions(dim);
    float spacing[3];
@@ -2705,6 +3030,8 @@ void
 VolumeFile::getNonZeroVoxelExtent(int extentVoxelIndices[6],
                                   float extentCoordinates[6]) const
 {
+   loadPagedVoxelsForAccess();
+   
    bool voxelsFound = false;
    
    if (voxels != NULL) {
@@ -3003,6 +3330,8 @@ void
 VolumeFile::resize(const int cropping[6],
                    ParamsFile* paramsFile)
 {
+   stopPagingVoxels(true);
+   
    if (voxels != NULL) {
       //
       // Get the new dimensions
@@ -3676,6 +4005,8 @@ VolumeFile::getInterpolatedVoxel(const float xyzIn[3], float& voxelValue)
 vtkStructuredPoints* 
 VolumeFile::convertToVtkStructuredPoints(const bool makeUnsignedCharType) const
 {
+   loadPagedVoxelsForAccess();
+   
    vtkStructuredPoints* sp = vtkStructuredPoints::New();
    
    sp->SetDimensions((int*)dimensions);
@@ -3730,6 +4061,8 @@ VolumeFile::convertToVtkStructuredPoints(const bool makeUnsignedCharType) const
 void 
 VolumeFile::convertFromVtkStructuredPoints(vtkStructuredPoints* sp)
 {
+   stopPagingVoxels(false);
+   
    if (voxels != NULL) {
       delete[] voxels;
       voxels = NULL;
@@ -3777,6 +4110,8 @@ VolumeFile::convertFromVtkStructuredPoints(vtkStructuredPoints* sp)
 void 
 VolumeFile::convertFromVtkImageData(vtkImageData* sp)
 {
+   stopPagingVoxels(false);
+   
    if (voxels != NULL) {
       delete[] voxels;
       voxels = NULL;
@@ -3821,6 +4156,8 @@ VolumeFile::convertFromVtkImageData(vtkImageData* sp)
 vtkImageData* 
 VolumeFile::convertToVtkImageData(const bool makeUnsignedCharType) const
 {
+   loadPagedVoxelsForAccess();
+   
    vtkImageData* id = vtkImageData::New();
    
    id->SetDimensions((int*)dimensions);
@@ -3895,102 +4232,352 @@ VolumeFile::applyTransformationMatrix(const TransformationMatrix& tmIn)
 
 
 /**
- * Apply transformation matrix to a volume.
+ * Apply transformation matrix to a volume.  The transform maps coordinates
+ * in the output volume to coordinates in this volume.  The output keeps this
+ * volume's spacing and is sized to contain all of this volume's voxels.
  */
 void
 VolumeFile::applyTransformationMatrix(vtkTransform* transform)
 {
-   vtkStructuredPoints* spInput = convertToVtkStructuredPoints();
+   double matrix[4][4];
+   vtkMatrix4x4* inverse = vtkMatrix4x4::New();
+   vtkMatrix4x4::Invert(transform->GetMatrix(), inverse);
+   for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 4; j++) {
+         matrix[i][j] = transform->GetMatrix()->GetElement(i, j);
+      }
+   }
    
-   vtkImageReslice* reslice = vtkImageReslice::New();   
-   reslice->SetNumberOfThreads(1);
-   reslice->SetInput(spInput);
-   reslice->SetInformationInput(spInput);
-   reslice->SetResliceTransform(transform);
-   reslice->SetAutoCropOutput(1);
- 
+   //
+   // Find the bounds of this volume's corner voxels in the output space
+   //
+   double bounds[6] = {
+       std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(),
+       std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(),
+       std::numeric_limits<double>::max(), -std::numeric_limits<double>::max()
+   };
+   for (int corner = 0; corner < 8; corner++) {
+      double xyz[4] = { origin[0], origin[1], origin[2], 1.0 };
+      for (int axis = 0; axis < 3; axis++) {
+         if (corner & (1 << axis)) {
+            xyz[axis] += (dimensions[axis] - 1) * spacing[axis];
+         }
+      }
+      double outXYZ[4];
+      inverse->MultiplyPoint(xyz, outXYZ);
+      for (int axis = 0; axis < 3; axis++) {
+         bounds[axis*2]   = std::min(bounds[axis*2],   outXYZ[axis]);
+         bounds[axis*2+1] = std::max(bounds[axis*2+1], outXYZ[axis]);
+      }
+   }
+   inverse->Delete();
+   
+   int newDimensions[3];
+   float newOrigin[3];
+   const float newSpacing[3] = { spacing[0], spacing[1], spacing[2] };
+   for (int axis = 0; axis < 3; axis++) {
+      const double extent = (bounds[axis*2+1] - bounds[axis*2]) / std::fabs(spacing[axis]);
+      newDimensions[axis] = static_cast<int>(std::floor(extent + 0.5)) + 1;
+      newOrigin[axis] = (spacing[axis] < 0.0) ? bounds[axis*2+1] : bounds[axis*2];
+   }
+   
+   //
+   // Output voxel index to output coordinate to this volume's coordinate
+   // to this volume's voxel index
+   //
+   double indexTransform[3][4];
+   for (int i = 0; i < 3; i++) {
+      double translate = matrix[i][3] - origin[i];
+      for (int j = 0; j < 3; j++) {
+         indexTransform[i][j] = matrix[i][j] * newSpacing[j] / spacing[i];
+         translate += matrix[i][j] * newOrigin[j];
+      }
+      indexTransform[i][3] = translate / spacing[i];
+   }
+   
+   INTERPOLATION_TYPE interpolationType = INTERPOLATION_TYPE_CUBIC;
    switch (volumeType) {
       case VOLUME_TYPE_ANATOMY:
-         reslice->SetInterpolationModeToCubic();
+         interpolationType = INTERPOLATION_TYPE_CUBIC;
          break;
       case VOLUME_TYPE_FUNCTIONAL:
-         reslice->SetInterpolationModeToCubic();
+         interpolationType = INTERPOLATION_TYPE_CUBIC;
          break;
       case VOLUME_TYPE_PAINT:
-         reslice->SetInterpolationModeToNearestNeighbor();
+         interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
          break;
       case VOLUME_TYPE_PROB_ATLAS:
-         reslice->SetInterpolationModeToNearestNeighbor();
+         interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
          break;
       case VOLUME_TYPE_RGB:
-         reslice->SetInterpolationModeToNearestNeighbor();
+         interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
          break;
       case VOLUME_TYPE_ROI:
-         reslice->SetInterpolationModeToNearestNeighbor();
+         interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
          break;
       case VOLUME_TYPE_SEGMENTATION:
-         reslice->SetInterpolationModeToNearestNeighbor();
+         interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
          break;
       case VOLUME_TYPE_VECTOR:
-         reslice->SetInterpolationModeToNearestNeighbor();
+         interpolationType = INTERPOLATION_TYPE_NEAREST_NEIGHBOR;
          break;
       case VOLUME_TYPE_UNKNOWN:
-         reslice->SetInterpolationModeToCubic();
+         interpolationType = INTERPOLATION_TYPE_CUBIC;
          break;
    }
-   reslice->Update();
-
-   convertFromVtkImageData(reslice->GetOutput());
-
-   reslice->Delete();
-   spInput->Delete();
    
-   allocateVoxelColoring();
-   setModified();
-   minMaxVoxelValuesValid = false;
-   minMaxTwoToNinetyEightPercentVoxelValuesValid = false;
+   resampleVoxels(indexTransform,
+                  newDimensions,
+                  newSpacing,
+                  newOrigin,
+                  interpolationType);
 }
 
 /**
  * resample the image to the specified spacing.
+ * The origin is unchanged and the output covers the same extent.
+ * Throws an exception if a spacing is not positive or if the resampled
+ * volume would have too many voxels.
  */
 void 
 VolumeFile::resampleToSpacing(const float newSpacing[3],
-                              const INTERPOLATION_TYPE interpolationType)
+                              const INTERPOLATION_TYPE interpolationType) throw (FileException)
 {  
-   vtkStructuredPoints* spInput = convertToVtkStructuredPoints();
-
-   vtkImageResample* resample = vtkImageResample::New();   
-   resample->SetNumberOfThreads(1);
-   resample->SetInput(spInput);
-   resample->SetAxisOutputSpacing(0, newSpacing[0]);
-   resample->SetAxisOutputSpacing(1, newSpacing[1]);
-   resample->SetAxisOutputSpacing(2, newSpacing[2]);
-   resample->SetDimensionality(3);
-   resample->SetInterpolationModeToCubic();
+   int newDimensions[3];
+   const float newOrigin[3] = { origin[0], origin[1], origin[2] };
+   double indexTransform[3][4] = {
+      { 0.0, 0.0, 0.0, 0.0 },
+      { 0.0, 0.0, 0.0, 0.0 },
+      { 0.0, 0.0, 0.0, 0.0 }
+   };
+   const double maximumNumberOfElements = std::numeric_limits<int>::max();
+   double numberOfElements = numberOfComponentsPerVoxel;
+   for (int axis = 0; axis < 3; axis++) {
+      if ((spacing[axis] <= 0.0) ||
+          (newSpacing[axis] <= 0.0)) {
+         throw FileException("Voxel sizes must be positive for resampling.");
+      }
+      const double magnification = static_cast<double>(spacing[axis]) / newSpacing[axis];
+      const double dim = std::floor((dimensions[axis] - 1) * magnification + 0.0001) + 1.0;
+      numberOfElements *= dim;
+      if (numberOfElements > maximumNumberOfElements) {
+         throw FileException("Resampled volume would have too many voxels.");
+      }
+      newDimensions[axis] = static_cast<int>(dim);
+      indexTransform[axis][axis] = 1.0 / magnification;
+   }
+   
+   resampleVoxels(indexTransform,
+                  newDimensions,
+                  newSpacing,
+                  newOrigin,
+                  interpolationType);
+}      
+
+/**
+ * Get the voxel indices and weights for interpolating at a continuous
+ * voxel index along one axis.  Voxels beyond the edge of the axis are
+ * replaced with the edge voxel.  Returns false if the index is outside
+ * of the axis.
+ */
+static bool
+getAxisInterpolationWeights(const double x,
+                            const int dim,
+                            const VolumeFile::INTERPOLATION_TYPE interpolationType,
+                            int indices[4],
+                            float weights[4],
+                            int& numWeights)
+{
+   const double tolerance = 0.001;
+   if ((x < -tolerance) || (x > ((dim - 1) + tolerance))) {
+      return false;
+   }
+   
+   int i = static_cast<int>(std::floor(x));
+   i = std::min(std::max(i, 0), dim - 1);
+   const float f = std::min(std::max(x - i, 0.0), 1.0);
+   
    switch (interpolationType) {
-      case INTERPOLATION_TYPE_CUBIC:
-         resample->SetInterpolationModeToCubic();
+      case VolumeFile::INTERPOLATION_TYPE_CUBIC:
+         {
+            //
+            // Catmull-Rom cubic
+            //
+            const float f2 = f * f;
+            const float f3 = f2 * f;
+            weights[0] = -0.5 * f3 + f2 - 0.5 * f;
+            weights[1] =  1.5 * f3 - 2.5 * f2 + 1.0;
+            weights[2] = -1.5 * f3 + 2.0 * f2 + 0.5 * f;
+            weights[3] =  0.5 * f3 - 0.5 * f2;
+            for (int m = 0; m < 4; m++) {
+               indices[m] = std::min(std::max(i - 1 + m, 0), dim - 1);
+            }
+            numWeights = 4;
+         }
          break;
-      case INTERPOLATION_TYPE_LINEAR:
-         resample->SetInterpolationModeToLinear();
+      case VolumeFile::INTERPOLATION_TYPE_LINEAR:
+         indices[0] = i;
+         indices[1] = std::min(i + 1, dim - 1);
+         weights[0] = 1.0 - f;
+         weights[1] = f;
+         numWeights = 2;
          break;
-      case INTERPOLATION_TYPE_NEAREST_NEIGHBOR:
-         resample->SetInterpolationModeToNearestNeighbor();
+      case VolumeFile::INTERPOLATION_TYPE_NEAREST_NEIGHBOR:
+         indices[0] = std::min(static_cast<int>(std::floor(x + 0.5)), dim - 1);
+         indices[0] = std::max(indices[0], 0);
+         weights[0] = 1.0;
+         numWeights = 1;
          break;
    }
-   resample->Update();
    
-   convertFromVtkImageData(resample->GetOutput());
+   return true;
+}
+
+/**
+ * Resample the voxels into a new grid.  "indexTransform" maps the IJK of
+ * a voxel in the new grid to the continuous IJK in the current grid.  New
+ * voxels that map outside of the current grid are set to zero.
+ */
+void
+VolumeFile::resampleVoxels(const double indexTransform[3][4],
+                           const int newDimensions[3],
+                           const float newSpacing[3],
+                           const float newOrigin[3],
+                           const INTERPOLATION_TYPE interpolationType)
+{
+   stopPagingVoxels(true);
+   
+   const int numComp = numberOfComponentsPerVoxel;
+   const int newDimI = newDimensions[0];
+   const int newDimJ = newDimensions[1];
+   const int newDimK = newDimensions[2];
+   float* newVoxels = new float[static_cast<long>(newDimI) * newDimJ * newDimK * numComp];
+   
+   //
+   // If the new grid's axes are parallel to the current grid's axes,
+   // the weights along each axis are the same for every row so compute
+   // them once
+   //
+   const bool axisAlignedFlag = ((indexTransform[0][1] == 0.0) &&
+                                 (indexTransform[0][2] == 0.0) &&
+                                 (indexTransform[1][0] == 0.0) &&
+                                 (indexTransform[1][2] == 0.0) &&
+                                 (indexTransform[2][0] == 0.0) &&
+                                 (indexTransform[2][1] == 0.0));
+   std::vector<int> axisIndices[3];
+   std::vector<float> axisWeights[3];
+   std::vector<int> axisNumWeights[3];
+   if (axisAlignedFlag) {
+      for (int axis = 0; axis < 3; axis++) {
+         const int num = newDimensions[axis];
+         axisIndices[axis].resize(num * 4, 0);
+         axisWeights[axis].resize(num * 4, 0.0);
+         axisNumWeights[axis].resize(num, 0);
+         for (int m = 0; m < num; m++) {
+            const double x = indexTransform[axis][axis] * m + indexTransform[axis][3];
+            if (getAxisInterpolationWeights(x,
+                                            dimensions[axis],
+                                            interpolationType,
+                                            &axisIndices[axis][m * 4],
+                                            &axisWeights[axis][m * 4],
+                                            axisNumWeights[axis][m]) == false) {
+               axisNumWeights[axis][m] = 0;
+            }
+         }
+      }
+   }
+   
+   const int rowSize = dimensions[0];
+   const int sliceSize = dimensions[0] * dimensions[1];
+   const float* inputVoxels = voxels;
+   
+   //
+   // Each thread fills whole slices of the new grid
+   //
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static, 1)
+#endif
+   for (int k = 0; k < newDimK; k++) {
+      int indices[3][4];
+      float weights[3][4];
+      int numWeights[3];
+      const int* axisIndex[3];
+      const float* axisWeight[3];
+      
+      for (int j = 0; j < newDimJ; j++) {
+         float* outputRow = &newVoxels[(j * newDimI + k * newDimI * newDimJ) * numComp];
+         for (int i = 0; i < newDimI; i++) {
+            float* output = &outputRow[i * numComp];
+            for (int m = 0; m < numComp; m++) {
+               output[m] = 0.0;
+            }
+            
+            bool insideFlag = true;
+            if (axisAlignedFlag) {
+               const int ijk[3] = { i, j, k };
+               for (int axis = 0; axis < 3; axis++) {
+                  numWeights[axis] = axisNumWeights[axis][ijk[axis]];
+                  axisIndex[axis]  = &axisIndices[axis][ijk[axis] * 4];
+                  axisWeight[axis] = &axisWeights[axis][ijk[axis] * 4];
+                  if (numWeights[axis] <= 0) {
+                     insideFlag = false;
+                  }
+               }
+            }
+            else {
+               for (int axis = 0; axis < 3; axis++) {
+                  const double x = indexTransform[axis][0] * i
+                                 + indexTransform[axis][1] * j
+                                 + indexTransform[axis][2] * k
+                                 + indexTransform[axis][3];
+                  if (getAxisInterpolationWeights(x,
+                                                  dimensions[axis],
+                                                  interpolationType,
+                                                  indices[axis],
+                                                  weights[axis],
+                                                  numWeights[axis]) == false) {
+                     insideFlag = false;
+                     break;
+                  }
+                  axisIndex[axis]  = indices[axis];
+                  axisWeight[axis] = weights[axis];
+               }
+            }
+            if (insideFlag == false) {
+               continue;
+            }
+            
+            for (int c = 0; c < numWeights[2]; c++) {
+               const int kOffset = axisIndex[2][c] * sliceSize;
+               for (int b = 0; b < numWeights[1]; b++) {
+                  const int jkOffset = kOffset + axisIndex[1][b] * rowSize;
+                  const float jkWeight = axisWeight[2][c] * axisWeight[1][b];
+                  for (int a = 0; a < numWeights[0]; a++) {
+                     const float w = jkWeight * axisWeight[0][a];
+                     const float* input = &inputVoxels[(jkOffset + axisIndex[0][a]) * numComp];
+                     for (int m = 0; m < numComp; m++) {
+                        output[m] += w * input[m];
+                     }
+                  }
+               }
+            }
+         }
+      }
+   }
    
-   resample->Delete();
-   spInput->Delete();
+   delete[] voxels;
+   voxels = newVoxels;
+   for (int i = 0; i < 3; i++) {
+      dimensions[i] = newDimensions[i];
+      spacing[i] = newSpacing[i];
+   }
+   setOrigin(newOrigin);
    
    allocateVoxelColoring();
    setModified();
    minMaxVoxelValuesValid = false;
    minMaxTwoToNinetyEightPercentVoxelValuesValid = false;
-}      
+}
 
 /**
  * make all voxels in a segmentation volume 0 or 255.
@@ -3998,6 +4585,8 @@ VolumeFile::resampleToSpacing(const float newSpacing[3],
 void 
 VolumeFile::makeSegmentationZeroTwoFiftyFive()
 {
+   stopPagingVoxels(true);
+   
    const int num = getTotalNumberOfVoxelElements();
    for (int i = 0; i < num; i++) {
       if (voxels[i] != 0.0) {
@@ -4383,6 +4972,8 @@ VolumeFile::importVtkStructuredPointsVolume(const QString& fileName) throw (File
 void
 VolumeFile::exportVtkStructuredPointsVolume(const QString& fileName) throw (FileException)
 {
+   loadPagedVoxels();
+   
    if (voxels != NULL) {
       vtkStructuredPoints* sp = convertToVtkStructuredPoints();
       vtkStructuredPointsWriter* writer = vtkStructuredPointsWriter::New();
@@ -4416,6 +5007,8 @@ VolumeFile::exportAnalyzeVolume(const QString& fileName) throw (FileException)
 void
 VolumeFile::exportMincVolume(const QString& fileName) throw (FileException)
 {
+   loadPagedVoxels();
+   
 #ifdef HAVE_MINC
    //
    // create an image conversion  variable
@@ -5612,13 +6205,13 @@ VolumeFile::performMathematicalOperation(const VOLUME_MATH_OPERATION operation,
  * Read data of the specified type.
  */
 void 
-VolumeFile::readRgbDataVoxelInterleaved(gzFile dataFile) throw (FileException)
+VolumeFile::readRgbDataVoxelInterleaved(GzipBlockFileReader& dataFile) throw (FileException)
 {
    const int numVoxels = getTotalNumberOfVoxels();
    const int length = numVoxels * sizeof(unsigned char) * 3;
    unsigned char* data = new unsigned char[length];
    
-   const int numRead = gzread(dataFile, (char*)data, (unsigned)length);
+   const int numRead = dataFile.read((char*)data, (unsigned)length);
    if (numRead != length) {
       std::ostringstream str;
       str << "Premature EOF reading zipped file.  Tried to read\n"
@@ -5640,13 +6233,13 @@ VolumeFile::readRgbDataVoxelInterleaved(gzFile dataFile) throw (FileException)
  * Read data of the specified type.
  */
 void 
-VolumeFile::readRgbDataSliceInterleaved(gzFile dataFile) throw (FileException)
+VolumeFile::readRgbDataSliceInterleaved(GzipBlockFileReader& dataFile) throw (FileException)
 {
    const int numVoxels = getTotalNumberOfVoxels();
    const int length = numVoxels * sizeof(unsigned char) * 3;
    unsigned char* data = new unsigned char[length];
    
-   const int numRead = gzread(dataFile, (char*)data, (unsigned)length);
+   const int numRead = dataFile.read((char*)data, (unsigned)length);
    if (numRead != length) {
       std::ostringstream str;
       str << "Premature EOF reading zipped file.  Tried to read\n"
@@ -5675,17 +6268,83 @@ VolumeFile::readRgbDataSliceInterleaved(gzFile dataFile) throw (FileException)
    delete[] data;
 }
 
+/**
+ * Number of voxel values read from a data file at one time.
+ */
+static const int voxelReadChunkSize = 65536;
+
+/**
+ * Byte swap a chunk of voxel data with "valueSize" bytes per value.
+ * The chunk holds values of another type (float, double, ...) so it
+ * is swapped as unsigned integers of the same size.
+ */
+static void
+swapVoxelChunkBytes(char* data, const int valueSize, const int numValues)
+{
+   switch (valueSize) {
+      case 2:
+         ByteSwapping::swapBytes(reinterpret_cast<unsigned short*>(data), numValues);
+         break;
+      case 4:
+         ByteSwapping::swapBytes(reinterpret_cast<unsigned int*>(data), numValues);
+         break;
+      case 8:
+         ByteSwapping::swapBytes(reinterpret_cast<unsigned long long*>(data), numValues);
+         break;
+   }
+}
+
+/**
+ * Read "numValues" values of type T from a data file into float voxels.
+ * The data is read, byte swapped, and converted one fixed-size chunk at
+ * a time so no temporary copy of the entire volume is needed.  Returns
+ * the number of bytes read.
+ */
+template <class T>
+static int
+readVoxelDataInChunks(GzipBlockFileReader& dataFile, 
+                      float* voxelsOut,
+                      const int numValues,
+                      const bool byteSwapData)
+{
+   T* chunk = new T[std::min(numValues, voxelReadChunkSize)];
+   
+   int totalRead = 0;
+   for (int start = 0; start < numValues; start += voxelReadChunkSize) {
+      const int num = std::min(voxelReadChunkSize, numValues - start);
+      const int length = num * sizeof(T);
+      const int numRead = dataFile.read((char*)chunk, (unsigned)length);
+      if (numRead > 0) {
+         totalRead += numRead;
+      }
+      if (numRead != length) {
+         break;
+      }
+      
+      if (byteSwapData) {
+         swapVoxelChunkBytes((char*)chunk, sizeof(T), num);
+      }
+      
+      float* output = &voxelsOut[start];
+      for (int i = 0; i < num; i++) {
+         output[i] = chunk[i];
+      }
+   }
+   
+   delete[] chunk;
+   return totalRead;
+}
+
 /**
  * Read data of the specified type.
  */
 void 
-VolumeFile::readCharData(gzFile dataFile) throw (FileException)
+VolumeFile::readCharData(GzipBlockFileReader& dataFile) throw (FileException)
 {
    const int numVoxels = getTotalNumberOfVoxels();
    const int length = numVoxels * sizeof(char);
-   char* data = new char[length];
    
-   const int numRead = gzread(dataFile, (char*)data, (unsigned)length);
+   const int numRead = readVoxelDataInChunks<char>(dataFile, voxels, numVoxels, false);
    if (numRead != length) {
       std::ostringstream str;
       str << "Premature EOF reading zipped file.  Tried to read\n"
@@ -5693,24 +6352,18 @@ VolumeFile::readCharData(gzFile dataFile) throw (FileException)
       throw FileException(getDataFileNameForReadError(),
                             str.str().c_str());
    }
-   
-   for (int i = 0; i < numVoxels; i++) {
-      voxels[i] = data[i];
-   }
-   delete[] data;
 }
 
 /**
  * Read data of the specified type.
  */
 void 
-VolumeFile::readUnsignedCharData(gzFile dataFile) throw (FileException)
+VolumeFile::readUnsignedCharData(GzipBlockFileReader& dataFile) throw (FileException)
 {
    const int numVoxels = getTotalNumberOfVoxels();
    const int length = numVoxels * sizeof(unsigned char);
-   unsigned char* data = new unsigned char[length];
    
-   const int numRead = gzread(dataFile, (char*)data, (unsigned)length);
+   const int numRead = readVoxelDataInChunks<unsigned char>(dataFile, voxels, numVoxels, false);
    if (numRead != length) {
       std::ostringstream str;
       str << "Premature EOF reading zipped file.  Tried to read\n"
@@ -5718,24 +6371,18 @@ VolumeFile::readUnsignedCharData(gzFile dataFile) throw (FileException)
       throw FileException(getDataFileNameForReadError(),
                             str.str().c_str());
    }
-   
-   for (int i = 0; i < numVoxels; i++) {
-      voxels[i] = data[i];
-   }
-   delete[] data;
 }
 
 /**
  * Read data of the specified type.
  */
 void 
-VolumeFile::readShortData(gzFile dataFile, const bool byteSwapData) throw (FileException)
+VolumeFile::readShortData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException)
 {
    const int numVoxels = getTotalNumberOfVoxels();
    const int length = numVoxels * sizeof(short);
-   short* data = new short[length];
    
-   const int numRead = gzread(dataFile, (char*)data, (unsigned)length);
+   const int numRead = readVoxelDataInChunks<short>(dataFile, voxels, numVoxels, byteSwapData);
    if (numRead != length) {
       std::ostringstream str;
       str << "Premature EOF reading zipped file.  Tried to read\n"
@@ -5743,28 +6390,18 @@ VolumeFile::readShortData(gzFile dataFile, const bool byteSwapData) throw (FileE
       throw FileException(getDataFileNameForReadError(),
                             str.str().c_str());
    }
-   
-   if (byteSwapData) {
-      ByteSwapping::swapBytes(data, numVoxels);
-   }
-   
-   for (int i = 0; i < numVoxels; i++) {
-      voxels[i] = data[i];
-   }
-   delete[] data;
 }
 
 /**
  * Read data of the specified type.
  */
 void 
-VolumeFile::readUnsignedShortData(gzFile dataFile, const bool byteSwapData) throw (FileException)
+VolumeFile::readUnsignedShortData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException)
 {
    const int numVoxels = getTotalNumberOfVoxels();
    const int length = numVoxels * sizeof(unsigned short);
-   unsigned short* data = new unsigned short[length];
    
-   const int numRead = gzread(dataFile, (char*)data, (unsigned)length);
+   const int numRead = readVoxelDataInChunks<unsigned short>(dataFile, voxels, numVoxels, byteSwapData);
    if (numRead != length) {
       std::ostringstream str;
       str << "Premature EOF reading zipped file.  Tried to read\n"
@@ -5772,28 +6409,18 @@ VolumeFile::readUnsignedShortData(gzFile dataFile, const bool byteSwapData) thro
       throw FileException(getDataFileNameForReadError(),
                             str.str().c_str());
    }
-   
-   if (byteSwapData) {
-      ByteSwapping::swapBytes(data, numVoxels);
-   }
-   
-   for (int i = 0; i < numVoxels; i++) {
-      voxels[i] = data[i];
-   }
-   delete[] data;
 }
 
 /**
  * Read data of the specified type.
  */
 void 
-VolumeFile::readIntData(gzFile dataFile, const bool byteSwapData) throw (FileException)
+VolumeFile::readIntData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException)
 {
    const int numVoxels = getTotalNumberOfVoxels();
    const int length = numVoxels * sizeof(int);
-   int* data = new int[length];
    
-   const int numRead = gzread(dataFile, (char*)data, (unsigned)length);
+   const int numRead = readVoxelDataInChunks<int>(dataFile, voxels, numVoxels, byteSwapData);
    if (numRead != length) {
       std::ostringstream str;
       str << "Premature EOF reading zipped file.  Tried to read\n"
@@ -5801,28 +6428,18 @@ VolumeFile::readIntData(gzFile dataFile, const bool byteSwapData) throw (FileExc
       throw FileException(getDataFileNameForReadError(),
                             str.str().c_str());
    }
-   
-   if (byteSwapData) {
-      ByteSwapping::swapBytes(data, numVoxels);
-   }
-   
-   for (int i = 0; i < numVoxels; i++) {
-      voxels[i] = data[i];
-   }
-   delete[] data;
 }
 
 /**
  * Read data of the specified type.
  */
 void 
-VolumeFile::readUnsignedIntData(gzFile dataFile, const bool byteSwapData) throw (FileException)
+VolumeFile::readUnsignedIntData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException)
 {
    const int numVoxels = getTotalNumberOfVoxels();
    const int length = numVoxels * sizeof(unsigned int);
-   unsigned int* data = new unsigned int[length];
    
-   const int numRead = gzread(dataFile, (char*)data, (unsigned)length);
+   const int numRead = readVoxelDataInChunks<unsigned int>(dataFile, voxels, numVoxels, byteSwapData);
    if (numRead != length) {
       std::ostringstream str;
       str << "Premature EOF reading zipped file.  Tried to read\n"
@@ -5830,28 +6447,18 @@ VolumeFile::readUnsignedIntData(gzFile dataFile, const bool byteSwapData) throw
       throw FileException(getDataFileNameForReadError(),
                             str.str().c_str());
    }
-   
-   if (byteSwapData) {
-      ByteSwapping::swapBytes(data, numVoxels);
-   }
-   
-   for (int i = 0; i < numVoxels; i++) {
-      voxels[i] = data[i];
-   }
-   delete[] data;
 }
 
 /**
  * Read data of the specified type.
  */
 void 
-VolumeFile::readLongLongData(gzFile dataFile, const bool byteSwapData) throw (FileException)
+VolumeFile::readLongLongData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException)
 {
    const int numVoxels = getTotalNumberOfVoxels();
    const int length = numVoxels * sizeof(long long);
-   long long* data = new long long[length];
    
-   const int numRead = gzread(dataFile, (char*)data, (unsigned)length);
+   const int numRead = readVoxelDataInChunks<long long>(dataFile, voxels, numVoxels, byteSwapData);
    if (numRead != length) {
       std::ostringstream str;
       str << "Premature EOF reading zipped file.  Tried to read\n"
@@ -5859,28 +6466,18 @@ VolumeFile::readLongLongData(gzFile dataFile, const bool byteSwapData) throw (Fi
       throw FileException(getDataFileNameForReadError(),
                             str.str().c_str());
    }
-   
-   if (byteSwapData) {
-      ByteSwapping::swapBytes(data, numVoxels);
-   }
-   
-   for (int i = 0; i < numVoxels; i++) {
-      voxels[i] = data[i];
-   }
-   delete[] data;
 }
 
 /**
  * Read data of the specified type.
  */
 void 
-VolumeFile::readUnsignedLongLongData(gzFile dataFile, const bool byteSwapData) throw (FileException)
+VolumeFile::readUnsignedLongLongData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException)
 {
    const int numVoxels = getTotalNumberOfVoxels();
    const int length = numVoxels * sizeof(unsigned long long);
-   unsigned long long* data = new unsigned long long[length];
    
-   const int numRead = gzread(dataFile, (char*)data, (unsigned)length);
+   const int numRead = readVoxelDataInChunks<unsigned long long>(dataFile, voxels, numVoxels, byteSwapData);
    if (numRead != length) {
       std::ostringstream str;
       str << "Premature EOF reading zipped file.  Tried to read\n"
@@ -5888,28 +6485,35 @@ VolumeFile::readUnsignedLongLongData(gzFile dataFile, const bool byteSwapData) t
       throw FileException(getDataFileNameForReadError(),
                             str.str().c_str());
    }
-   
-   if (byteSwapData) {
-      ByteSwapping::swapBytes(data, numVoxels);
-   }
-   
-   for (int i = 0; i < numVoxels; i++) {
-      voxels[i] = data[i];
-   }
-   delete[] data;
 }
 
 /**
  * Read data of the specified type.
+ * Float data needs no conversion so it is read directly into the voxels.
  */
 void 
-VolumeFile::readFloatData(gzFile dataFile, const bool byteSwapData) throw (FileException)
+VolumeFile::readFloatData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException)
 {
    const int numVoxels = getTotalNumberOfVoxels();
    const int length = numVoxels * sizeof(float);
-   float* data = new float[length];
    
-   const int numRead = gzread(dataFile, (char*)data, (unsigned)length);
+   int numRead = 0;
+   for (int start = 0; start < numVoxels; start += voxelReadChunkSize) {
+      const int num = std::min(voxelReadChunkSize, numVoxels - start);
+      const int chunkLength = num * sizeof(float);
+      const int chunkRead = dataFile.read((char*)&voxels[start], (unsigned)chunkLength);
+      if (chunkRead > 0) {
+         numRead += chunkRead;
+      }
+      if (chunkRead != chunkLength) {
+         break;
+      }
+      
+      if (byteSwapData) {
+         ByteSwapping::swapBytes(&voxels[start], num);
+      }
+   }
+   
    if (numRead != length) {
       std::ostringstream str;
       str << "Premature EOF reading zipped file.  Tried to read\n"
@@ -5917,28 +6521,18 @@ VolumeFile::readFloatData(gzFile dataFile, const bool byteSwapData) throw (FileE
       throw FileException(getDataFileNameForReadError(),
                             str.str().c_str());
    }
-   
-   if (byteSwapData) {
-      ByteSwapping::swapBytes(data, numVoxels);
-   }
-   
-   for (int i = 0; i < numVoxels; i++) {
-      voxels[i] = data[i];
-   }
-   delete[] data;
 }
 
 /**
  * Read data of the specified type.
  */
 void 
-VolumeFile::readDoubleData(gzFile dataFile, const bool byteSwapData) throw (FileException)
+VolumeFile::readDoubleData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException)
 {
    const int numVoxels = getTotalNumberOfVoxels();
    const int length = numVoxels * sizeof(double);
-   double* data = new double[length];
    
-   const int numRead = gzread(dataFile, (char*)data, (unsigned)length);
+   const int numRead = readVoxelDataInChunks<double>(dataFile, voxels, numVoxels, byteSwapData);
    if (numRead != length) {
       std::ostringstream str;
       str << "Premature EOF reading zipped file.  Tried to read\n"
@@ -5946,15 +6540,6 @@ VolumeFile::readDoubleData(gzFile dataFile, const bool byteSwapData) throw (File
       throw FileException(getDataFileNameForReadError(),
                             str.str().c_str());
    }
-
-   if (byteSwapData) {
-      ByteSwapping::swapBytes(data, numVoxels);
-   }
-   
-   for (int i = 0; i < numVoxels; i++) {
-      voxels[i] = data[i];
-   }
-   delete[] data;
 }
 
 /**
@@ -6087,6 +6672,8 @@ VolumeFile::writeFileData(QTextStream& /*stream*/, QDataStream&,
 void    
 VolumeFile::dualThresholdVolume(const float thresholdLow, const float thresholdHigh)
 {
+   stopPagingVoxels(true);
+   
    int cnt = 0;
    const int num = getTotalNumberOfVoxelElements();
    for (int i = 0; i < num; i++){
@@ -6116,6 +6703,8 @@ VolumeFile::dualThresholdVolume(const float thresholdLow, const float thresholdH
 void    
 VolumeFile::thresholdVolume(const float thresholdValue)
 {
+   stopPagingVoxels(true);
+   
    int cnt = 0;
    const int num = getTotalNumberOfVoxelElements();
    for (int i = 0; i < num; i++){
@@ -6145,6 +6734,8 @@ VolumeFile::thresholdVolume(const float thresholdValue)
 void    
 VolumeFile::inverseThresholdVolume(const float thresholdValue)
 {
+   stopPagingVoxels(true);
+   
    int cnt = 0;
    const int num = getTotalNumberOfVoxelElements();
    for (int i = 0; i < num; i++){
@@ -6425,6 +7016,8 @@ VolumeFile::findBiggestObjectWithinMask(const int iminIn,
                                            const float maxValue,
                                            VoxelIJK& bigSeed) const
 {
+   loadPagedVoxelsForAccess();
+   
    bigSeed.setIJK(-1, -1, -1);
 
    int imin = iminIn;
@@ -6636,6 +7229,8 @@ VolumeFile::findUnsearchedVoxel(const float minValue,
                                    VOXEL_SEARCH_STATUS searchStatus[],
                                    VoxelIJK& seedOut) const
 {
+   loadPagedVoxelsForAccess();
+   
    //
    // Loop through region
    //
@@ -6860,6 +7455,8 @@ VolumeFile::findLimits(const QString& limitFileName, int extent[6])
 void	
 VolumeFile::shiftAxis(const VOLUME_AXIS axis, const int offset)
 {
+   stopPagingVoxels(true);
+   
 	int	i, j, k, idx1, idx2;
 	float	*voltemp;
 
@@ -6961,6 +7558,8 @@ VolumeFile::smearAxis(const VOLUME_AXIS axis,
                          const int sign, 
                          const int core) throw (FileException)
 {
+   stopPagingVoxels(true);
+   
 	const int fliphem = 1; // for 1582
 
    const int numVoxels = getTotalNumberOfVoxels();
@@ -7101,6 +7700,8 @@ VolumeFile::stretchVoxelValuesExcludePercentage(const float bottomPercentToExclu
 void 
 VolumeFile::stretchVoxelValues()
 {
+   stopPagingVoxels(true);
+   
    const int numVoxels = getTotalNumberOfVoxels();
 	float	minVoxel, maxVoxel;
    getMinMaxVoxelValues(minVoxel, maxVoxel);
@@ -7242,6 +7843,8 @@ VolumeFile::maskWithVolumeThreshold(const VolumeFile* maskVolume,
 void 
 VolumeFile::maskVolume(const int limitsIn[6])
 {
+   stopPagingVoxels(true);
+   
    if (DebugControl::getDebugOn()) {
       std::cout << "Extent (maskVolume): " 
                 << limitsIn[0] << " to " << limitsIn[1] << ", "
@@ -7301,6 +7904,9 @@ void
 VolumeFile::sculptVolume(const int option, const VolumeFile* vol2, 
                             const int numsteps, int seed[3], int limits[6])
 {
+   stopPagingVoxels(true);
+   vol2->loadPagedVoxelsForAccess();
+   
    clampVoxelDimension(VOLUME_AXIS_X, limits[0]);
    clampVoxelDimension(VOLUME_AXIS_X, limits[1]);
    clampVoxelDimension(VOLUME_AXIS_Y, limits[2]);
@@ -7405,6 +8011,8 @@ VolumeFile::sculptVolume(const int option, const VolumeFile* vol2,
 void	
 VolumeFile::imposeLimits(const int limits[6])
 {
+   stopPagingVoxels(true);
+   
    const int numVoxels = getTotalNumberOfVoxels();
    float *out = new float[numVoxels];
 	for (int i = 0; i < numVoxels; i++)	{
@@ -7436,6 +8044,8 @@ void
 VolumeFile::makeShellVolume(const int Ndilation, 
                                const int Nerosion)
 {
+   stopPagingVoxels(true);
+   
    const int numVoxels = getTotalNumberOfVoxels();
    VolumeFile vol2(*this);
    VolumeFile vol3(*this);
@@ -7520,6 +8130,8 @@ VolumeFile::stripBorderVoxels(const int neighborOffsets[],
 		                           int numNeighs, 
                                  VolumeFile *vol2)
 {
+   stopPagingVoxels(true);
+   
    const int numVoxels = getTotalNumberOfVoxels();
    int cnt = 0;
    const int slices = dimensions[2] - 1;
@@ -7604,6 +8216,8 @@ VolumeFile::makePlane(const float xslope,
                          const float offset, 
                          const float thickness)
 {
+   stopPagingVoxels(true);
+   
 	if (DebugControl::getDebugOn()) {
       std::cout << "MakePlane " << xslope << "x + " << yslope << "y + " 
                 << zslope << "z - " << offset << " < " << thickness << std::endl;
@@ -7652,6 +8266,8 @@ VolumeFile::doVolMorphOpsWithinMask(const int extent[6], const int nDilation, co
 void 
 VolumeFile::doVolMorphOps(const int nDilation, const int nErosion) 
 {
+   stopPagingVoxels(true);
+   
    if (DebugControl::getDebugOn()) {
    	std::cout << nDilation << " dilation iters, "
                 << nErosion << " erosion iters" << std::endl;
@@ -7718,6 +8334,8 @@ int
 VolumeFile::stripBorderVoxels(const int neighborOffsets[], 
                                  const int numNeighs)
 {
+   stopPagingVoxels(true);
+   
 	/* Mark border voxels */
    if (DebugControl::getDebugOn()) {
    	std::cout << "StripBorderVoxels ..." << std::endl;
@@ -7778,6 +8396,8 @@ VolumeFile::classifyIntensities(const float mean,
                                    const float high, 
                                    const float signum)
 {
+   stopPagingVoxels(true);
+   
 	//%printf ("ClassifyIntensities: mean %f, low %f, high %f, signum %f\n",
 	//%	mean, low, high, signum);
    if (DebugControl::getDebugOn()) {
@@ -7828,6 +8448,8 @@ VolumeFile::classifyIntensities(const float mean,
 int 
 VolumeFile::getNumberOfNonZeroVoxels() const
 {
+   loadPagedVoxelsForAccess();
+   
    int cnt = 0;
    
    const int num = getTotalNumberOfVoxels();
@@ -7851,6 +8473,8 @@ VolumeFile::getNumberOfNonZeroVoxels() const
 void 
 VolumeFile::blur()
 {
+   stopPagingVoxels(true);
+   
 	float	lpf_filter [5];
 
   lpf_filter [0] = 1.0/16.0;
@@ -7866,175 +8490,41 @@ VolumeFile::blur()
 }
 
 /**
- *
+ * smooth the voxels with a Gaussian kernel whose full width at half maximum
+ * is in millimeters (converted to voxels along each axis using the spacing).
  */
-void	
-VolumeFile::seperableConvolve(int ncol, int nrow, int nslices, 
-	                            	float *volume, float *filter)
+void 
+VolumeFile::smoothGaussian(const float fullWidthHalfMaximum)
 {
-	int	isize = ncol*nrow;
-
-	//printf ("\tSeperableConvolve filtersize=%d\n", FSIZE); 
-	float* Result = new float[ncol*nrow*nslices];
-	float* TempSpace = new float[ncol*nrow*nslices];
-
-	float* voxel = volume; 
-	float* tempResult = Result;
-	oneDimConvolve (voxel, tempResult, filter, 0, 1, ncol, nrow, nslices);	
-	//printf ("%d %f %f\n", idx, voxel[idx], tempResult[idx]);
-
-	voxel = Result; 
-	tempResult = TempSpace;
-	oneDimConvolve (voxel, tempResult, filter, 1, ncol, ncol, nrow, nslices);	
-	//printf ("%d %f %f\n", idx, voxel[idx], tempResult[idx]);
-
-	voxel = TempSpace; 
-	tempResult = volume;
-	oneDimConvolve (voxel, tempResult, filter, 2, isize, ncol, nrow, nslices);
-	//printf ("%d %f %f\n", idx, voxel[idx], tempResult[idx]);
-
-	delete[] Result; 
-	delete[] TempSpace; 
-	return;
+   stopPagingVoxels(true);
+   
+   std::vector<float> kernels[3];
+   for (int i = 0; i < 3; i++) {
+      const float voxelSize = std::fabs(spacing[i]);
+      if (voxelSize > 0.0) {
+         SeparableConvolution::createGaussianKernel(fullWidthHalfMaximum / voxelSize,
+                                                    kernels[i]);
+      }
+   }
+   
+   SeparableConvolution convolution;
+   convolution.convolve(voxels, dimensions, kernels[0], kernels[1], kernels[2]);
+   setModified();
+   minMaxVoxelValuesValid = false;
+   minMaxTwoToNinetyEightPercentVoxelValuesValid = false;
 }
 
 /**
  *
  */
 void	
-VolumeFile::oneDimConvolve (float *voxel, float *tempResult, float *filter, 
-                const int dim, const int inc,
-		          const int ncol, const int nrow, const int nslices)
+VolumeFile::seperableConvolve(int ncol, int nrow, int nslices, 
+	                            	float *volume, float *filter)
 {
-   const int FILTSIZE = 5;
-	float	p[FILTSIZE];
-
-	int cnt = 0;
-	for (int k = 0; k < nslices; k++){
-	   for (int j = 0; j < nrow; j++){
-	      for (int i = 0; i < ncol; i++){
-             float* ip = voxel;	 
-             if (dim == 0){
-                if (i == 0){
-                   p[0] = *ip;
-                   p[1] = *ip;
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                        }
-                else if (i == 1) {
-                   p[0] = *(ip-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                }
-                else if (i == ncol-2) {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc);
-                }
-                else if (i == ncol-1) {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *ip;
-                   p[4] = *ip;
-                }
-                else {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                }
-             }
-             else if (dim == 1) {
-                if (j == 0){
-                   p[0] = *ip;
-                   p[1] = *ip;
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                        }
-                else if (j == 1) {
-                   p[0] = *(ip-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                }
-                else if (j == nrow-2) {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc);
-                }
-                else if (j == nrow-1) {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *ip;
-                   p[4] = *ip;
-                }
-	             else {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                }
-             }
-             else if (dim == 2) {
-                if (k == 0){
-                   p[0] = *ip;
-                   p[1] = *ip;
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                        }
-                else if (k == 1) {
-                   p[0] = *(ip-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                }
-                else if (k == nslices-2) {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc);
-                }
-                else if (k == nslices-1) {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *ip;
-                   p[4] = *ip;
-                }
-                else {
-                   p[0] = *(ip-inc-inc);
-                   p[1] = *(ip-inc);
-                   p[2] = *ip;
-                   p[3] = *(ip+inc);
-                   p[4] = *(ip+inc+inc);
-                }
-             }
-             *tempResult = 0;
-             for (int n = 0; n < FILTSIZE; n++){
-               *tempResult += filter[n]*p[n];
-             }
-             tempResult++;
-             voxel++;
-             cnt++;
-	      }
-	   }
-	}
+   const int dim[3] = { ncol, nrow, nslices };
+   const std::vector<float> kernel(filter, filter + 5);
+   SeparableConvolution convolution;
+   convolution.convolve(volume, dim, kernel);
 }
 
 void	
@@ -8153,6 +8643,8 @@ VolumeFile::breadthFirstFloodFill(const VoxelIJK& seed,
 void 
 VolumeFile::fillSegmentationCavities(const VolumeFile* markVolumeIn)
 {
+   stopPagingVoxels(true);
+   
    //
    // Volume to keep track of unset voxels
    //
@@ -8451,6 +8943,8 @@ VolumeFile::getEulerCountsForSegmentationVolume(int& numberOfObjects,
 int 
 VolumeFile::getEulerNumberForSegmentationSubVolume(const int extentIn[6]) const
 {
+   loadPagedVoxelsForAccess();
+   
 /*
    int extent[6] = {
       extentIn[0],
@@ -9300,6 +9794,8 @@ VolumeFile::acPcAlign(const int superiorAcVoxel[3],
 void 
 VolumeFile::convertFromITKImage(VolumeITKImage& itkImageIn) throw (FileException)
 {
+   stopPagingVoxels(true);
+   
 #ifndef HAVE_ITK
       throw FileException("ITK support not compiled into this version of Caret");
 #endif // HAVE_ITK
@@ -9583,6 +10079,13 @@ VolumeFile::readFile(const QString& fileNameIn,
    //
    volumesReadOut.clear();
    
+   //
+   // Only NIFTI sub-volumes are paged, other formats read all sub-volumes
+   //
+   const int nonPagedReadSelection = ((readSelection == VOLUME_READ_SELECTION_ALL_PAGED)
+                                      ? VOLUME_READ_SELECTION_ALL
+                                      : readSelection);
+   
    //
    // hdr/image pair may be NIFTI
    //
@@ -9601,11 +10104,11 @@ VolumeFile::readFile(const QString& fileNameIn,
    //
    if (StringUtilities::endsWith(fileNameIn, SpecFile::getAnalyzeVolumeFileExtension())
        && (niftiFlag == false)) {
-      readFileSpm(fileNameIn, readSelection, volumesReadOut, spmRightIsOnLeft);
+      readFileSpm(fileNameIn, nonPagedReadSelection, volumesReadOut, spmRightIsOnLeft);
       fileTypeToWrite = FILE_READ_WRITE_TYPE_SPM_OR_MEDX;
    }
    else if (StringUtilities::endsWith(fileNameIn, SpecFile::getAfniVolumeFileExtension())) {
-      readFileAfni(fileNameIn, readSelection, volumesReadOut);
+      readFileAfni(fileNameIn, nonPagedReadSelection, volumesReadOut);
       fileTypeToWrite = FILE_READ_WRITE_TYPE_AFNI;
    }
    else if (StringUtilities::endsWith(fileNameIn, SpecFile::getMincVolumeFileExtension())) {
@@ -9628,7 +10131,7 @@ VolumeFile::readFile(const QString& fileNameIn,
       fileTypeToWrite = FILE_READ_WRITE_TYPE_NIFTI;
    }
    else if (StringUtilities::endsWith(fileNameIn, SpecFile::getWustlVolumeFileExtension())) {
-      readFileWuNil(fileNameIn, readSelection, volumesReadOut);
+      readFileWuNil(fileNameIn, nonPagedReadSelection, volumesReadOut);
       fileTypeToWrite = FILE_READ_WRITE_TYPE_WUNIL;
    }
    else if (StringUtilities::endsWith(fileNameIn, ".vtk")) {
@@ -9684,6 +10187,14 @@ VolumeFile::writeFile(const QString& fileNameIn,
       throw FileException(fileNameIn, "No volume data to write.");
    }
    
+   //
+   // Paged sub-volumes must be read before the output file is opened
+   // since the output file may be the file containing their voxels
+   //
+   for (unsigned int i = 0; i < volumesToWrite.size(); i++) {
+      volumesToWrite[i]->loadVoxelData();
+   }
+   
    switch (volumeType) {
       case VOLUME_TYPE_ANATOMY:
          break;
@@ -11208,6 +11719,37 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
       }
    }
    
+   //
+   // Voxel data in a gzip block file is decompressed in parallel,
+   // otherwise it is read from the zlib file
+   //
+   const QString voxelDataFileName = (volumeRead.dataFileName.isEmpty()
+                                      ? volumeRead.filename
+                                      : volumeRead.dataFileName);
+   const bool blockFileFlag = GzipBlockFileReader::isGzipBlockFile(voxelDataFileName);
+   
+   //
+   // Sub-volumes are paged only if one can be read without decompressing
+   // those before it (uncompressed or gzip block file), otherwise all are read
+   //
+   const bool pageSubVolumesFlag = ((readSelection == VOLUME_READ_SELECTION_ALL_PAGED) &&
+                                    (blockFileFlag || (gzdirect(dataFile) != 0)));
+   
+   GzipBlockFileReader* dataReader = NULL;
+   try {
+      if (blockFileFlag) {
+         dataReader = new GzipBlockFileReader(voxelDataFileName);
+         dataReader->seek(gztell(dataFile));
+      }
+      else {
+         dataReader = new GzipBlockFileReader(dataFile);
+      }
+   }
+   catch (FileException& e) {
+      gzclose(dataFile);
+      throw e;
+   }
+   
    try {         
       //
       // loop through and read the volume files
@@ -11219,7 +11761,8 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
          //
          bool readingSingleSubVolume = false;
          bool readIt = false;
-         if (readSelection == VOLUME_READ_SELECTION_ALL) {
+         if ((readSelection == VOLUME_READ_SELECTION_ALL) ||
+             (readSelection == VOLUME_READ_SELECTION_ALL_PAGED)) {
             readIt = true;
          }
          else if (readSelection == i) {
@@ -11233,7 +11776,7 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
             //
             VolumeFile* vf = NULL;
             vf = new VolumeFile;
-            vf->copyVolumeData(volumeRead, false);
+            vf->copyVolumeData(volumeRead, false, (pageSubVolumesFlag == false));
             vf->filename = volumeRead.filename;
             vf->dataFileName = volumeRead.dataFileName;
             
@@ -11243,9 +11786,13 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
             vf->descriptiveLabel = volumeRead.subVolumeNames[i];
             
             //
-            // If only reading a single sub-volume
+            // If paging, voxels are read when first accessed
             //
-            if (readingSingleSubVolume) {
+            if (pageSubVolumesFlag) {
+               vf->pagedVoxelsFileName = volumeRead.filename;
+               vf->pagedSubVolumeIndex = i;
+            }
+            else if (readingSingleSubVolume) {
                //
                // Read just the sub-volume
                //
@@ -11254,7 +11801,7 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
                                                vf->scaleOffset[i],
                                                niftiReadDataOffset,
                                                i,
-                                               dataFile);
+                                               *dataReader);
             }
             else {
                //
@@ -11263,7 +11810,7 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
                vf->readVolumeFileData(byteSwapFlag,
                                       vf->scaleSlope[i],
                                       vf->scaleOffset[i],
-                                      dataFile);
+                                      *dataReader);
             }
             
             if (i < static_cast<int>(studyMetaDataLinkSets.size())) {
@@ -11300,6 +11847,7 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
       }
    }
    catch (FileException& e) {
+      delete dataReader;
       gzclose(dataFile);
       throw e;
    }
@@ -11307,6 +11855,7 @@ VolumeFile::readFileNifti(const QString& fileNameIn,
    //
    // Close the file
    //
+   delete dataReader;
    gzclose(dataFile);
 }                          
 
@@ -13133,6 +13682,12 @@ VolumeFile::writeFileNifti(const QString& fileNameIn,
    //
    const bool zipDataFileFlag = (firstVolume->filename.right(3) == ".gz");
    
+   //
+   // Compressed file may be written as gzip blocks that are compressed in parallel
+   //
+   const bool zipBlocksFlag = (zipDataFileFlag && niftiGzipBlockWritingEnabled);
+   const bool zipStreamFlag = (zipDataFileFlag && (zipBlocksFlag == false));
+   
    //
    // NIFTI stored in one file
    //
@@ -13143,7 +13698,20 @@ VolumeFile::writeFileNifti(const QString& fileNameIn,
    //
    gzFile zipFile = NULL;
    std::ofstream* cppFile = NULL;
-   if (zipDataFileFlag) {
+   GzipBlockFileWriter* blockFile = NULL;
+   std::ostream* dataStream = NULL;
+   if (zipBlocksFlag) {
+      blockFile = new GzipBlockFileWriter;
+      try {
+         blockFile->open(firstVolume->filename);
+      }
+      catch (FileException& e) {
+         delete blockFile;
+         throw e;
+      }
+      dataStream = new std::ostream(blockFile);
+   }
+   else if (zipStreamFlag) {
       zipFile = gzopen(firstVolume->filename.toAscii().constData(), "wb");
       if (zipFile == NULL) {
          throw FileException(firstVolume->filename, "Unable to open for writing");
@@ -13155,6 +13723,7 @@ VolumeFile::writeFileNifti(const QString& fileNameIn,
       if (cppFile == NULL) {
          throw FileException(firstVolume->filename, "Unable to open for writing");
       }
+      dataStream = cppFile;
    }
    firstVolume->dataFileWasZippedFlag = zipDataFileFlag;
 
@@ -13173,7 +13742,7 @@ VolumeFile::writeFileNifti(const QString& fileNameIn,
    // Write the header
    //
    const unsigned long headerSize = sizeof(hdr);
-   if (zipDataFileFlag) {
+   if (zipStreamFlag) {
       //
       // Write the header
       //
@@ -13204,26 +13773,26 @@ VolumeFile::writeFileNifti(const QString& fileNameIn,
       //
       // Write the header
       //
-      cppFile->write((const char*)&hdr, headerSize);
+      dataStream->write((const char*)&hdr, headerSize);
       
       //
       // Write the extender that tells whether or not there are extensions
       //
-      cppFile->write((const char*)&extender, sizeof(extender));     
+      dataStream->write((const char*)&extender, sizeof(extender));     
       
       //
       // write the afni extension
       //
       if (afniExtension.esize > 0) {
-         cppFile->write((const char*)&afniExtension.esize, sizeof(afniExtension.esize));
-         cppFile->write((const char*)&afniExtension.ecode, sizeof(afniExtension.ecode));
-         cppFile->write((const char*)afniExtensionString.toAscii().constData(),
+         dataStream->write((const char*)&afniExtension.esize, sizeof(afniExtension.esize));
+         dataStream->write((const char*)&afniExtension.ecode, sizeof(afniExtension.ecode));
+         dataStream->write((const char*)afniExtensionString.toAscii().constData(),
                         afniExtensionSize);
       }
       if (caretExtension.esize > 0) {
-         cppFile->write((const char*)&caretExtension.esize, sizeof(caretExtension.esize));
-         cppFile->write((const char*)&caretExtension.ecode, sizeof(caretExtension.ecode));
-         cppFile->write((const char*)caretExtensionString.toAscii().constData(),
+         dataStream->write((const char*)&caretExtension.esize, sizeof(caretExtension.esize));
+         dataStream->write((const char*)&caretExtension.ecode, sizeof(caretExtension.ecode));
+         dataStream->write((const char*)caretExtensionString.toAscii().constData(),
                           caretExtensionSize);
       }
    }
@@ -13237,9 +13806,9 @@ VolumeFile::writeFileNifti(const QString& fileNameIn,
       try {
          volumesToWrite[i]->writeVolumeFileData(firstVolume->voxelDataType,
                                                 false,
-                                                zipDataFileFlag,
+                                                zipStreamFlag,
                                                 zipFile,
-                                                cppFile,
+                                                dataStream,
                                                 hdr.scl_slope);
       }
       catch (FileException& e) {
@@ -13251,9 +13820,21 @@ VolumeFile::writeFileNifti(const QString& fileNameIn,
    //
    // Close the data file
    //
-   if (zipDataFileFlag) {
+   if (zipStreamFlag) {
       gzclose(zipFile);
    }
+   else if (zipBlocksFlag) {
+      delete dataStream;
+      try {
+         blockFile->close();
+      }
+      catch (FileException& e) {
+         if (writeErrorMessage.isEmpty()) {
+            writeErrorMessage = e.whatQString();
+         }
+      }
+      delete blockFile;
+   }
    else {
       cppFile->close();
       delete cppFile;
@@ -13767,6 +14348,22 @@ VolumeFile::readVolumeFileData(const bool byteSwapNeeded,
                                const float scaleFact,
                                const float offsetFact,
                                gzFile dataFile) throw (FileException)
+{
+   GzipBlockFileReader dataReader(dataFile);
+   readVolumeFileData(byteSwapNeeded,
+                      scaleFact,
+                      offsetFact,
+                      dataReader);
+}
+
+/**
+ * read the volume data.
+ */
+void 
+VolumeFile::readVolumeFileData(const bool byteSwapNeeded,
+                               const float scaleFact,
+                               const float offsetFact,
+                               GzipBlockFileReader& dataFile) throw (FileException)
 {
    QString errorMessage;
    
@@ -13981,6 +14578,26 @@ VolumeFile::readVolumeFileDataSubVolume(const bool byteSwapNeeded,
                                         const long dataOffset,
                                         const int subVolumeNumber,
                                         gzFile dataFile) throw (FileException)
+{
+   GzipBlockFileReader dataReader(dataFile);
+   readVolumeFileDataSubVolume(byteSwapNeeded,
+                               scaleFact,
+                               offsetFact,
+                               dataOffset,
+                               subVolumeNumber,
+                               dataReader);
+}
+
+/**
+ * read the volume data.
+ */
+void 
+VolumeFile::readVolumeFileDataSubVolume(const bool byteSwapNeeded,
+                                        const float scaleFact,
+                                        const float offsetFact,
+                                        const long dataOffset,
+                                        const int subVolumeNumber,
+                                        GzipBlockFileReader& dataFile) throw (FileException)
 {
    int dataSizeInBytes = 0;
    numberOfComponentsPerVoxel = 1;
@@ -14038,9 +14655,7 @@ VolumeFile::readVolumeFileDataSubVolume(const bool byteSwapNeeded,
    //
    // read the data
    //
-   gzseek(dataFile, 
-          offset, 
-          SEEK_SET);
+   dataFile.seek(offset);
    readVolumeFileData(byteSwapNeeded, 
                       scaleFact,
                       offsetFact,
@@ -14055,9 +14670,11 @@ VolumeFile::writeVolumeFileData(const VOXEL_DATA_TYPE voxelDataTypeForWriting,
                                 const bool byteSwapNeeded,
                                 const bool compressDataWithZlib,
                                 gzFile zipStream,
-                                std::ofstream* cppStream,
+                                std::ostream* cppStream,
                                 const float divideByThisValue) throw (FileException)
 {
+   loadPagedVoxels();
+   
    if (voxelDataType == VOXEL_DATA_TYPE_UNKNOWN) {
       throw FileException("Unknown data type for writing.");
    }
@@ -14528,6 +15145,8 @@ VolumeFile::compareFileForUnitTesting(const AbstractFile* af,
 void	
 VolumeFile::findObjectsWithinSegmentationVolume(std::vector<VoxelGroup>& objectsOut) const
 {
+   loadPagedVoxelsForAccess();
+   
    objectsOut.clear();
    
    VoxelIJK bigSeed(-1, -1, -1);
@@ -51,6 +51,7 @@ class StatisticHistogram;
 class TransformationMatrix;
 class SureFitVectorFile;
 class VolumeModification;
+class GzipBlockFileReader;
 class VolumeITKImage;
 class vtkImageData;
 class vtkStructuredPoints;
@@ -327,7 +328,9 @@ class VolumeFile : public AbstractFile {
          /// read all sub volumes
          VOLUME_READ_SELECTION_ALL = -1,
          /// read header only
-         VOLUME_READ_HEADER_ONLY   = -2
+         VOLUME_READ_HEADER_ONLY   = -2,
+         /// read headers of all sub volumes, voxels are read when first accessed
+         VOLUME_READ_SELECTION_ALL_PAGED = -3
       };
       
       /// data order in slices
@@ -357,6 +360,18 @@ class VolumeFile : public AbstractFile {
       /// set type of volume space used when volume files are read
       static void setVolumeSpace(const VOLUME_SPACE vs) { volumeSpace = vs; }
 
+      /// get compressed NIFTI files are written as gzip blocks (decompressed in parallel when read)
+      static bool getNiftiGzipBlockWritingEnabled() { return niftiGzipBlockWritingEnabled; }
+      
+      /// set compressed NIFTI files are written as gzip blocks (decompressed in parallel when read)
+      static void setNiftiGzipBlockWritingEnabled(const bool b) { niftiGzipBlockWritingEnabled = b; }
+
+      /// get memory (megabytes) used by voxels of paged sub-volumes before the least recently used are evicted
+      static int getPagedVoxelsMemoryBudget() { return pagedVoxelsMemoryBudget; }
+      
+      /// set memory (megabytes) used by voxels of paged sub-volumes before the least recently used are evicted
+      static void setPagedVoxelsMemoryBudget(const int megabytes) { pagedVoxelsMemoryBudget = megabytes; }
+
 /*      
       /// get name, dimensions, origin, and voxel spacing for standard volumes 
       static void getStandardSpaceParameters(const STANDARD_VOLUME_SPACE svs,
@@ -464,7 +479,7 @@ class VolumeFile : public AbstractFile {
       void setVolumeType(const VOLUME_TYPE vt) { volumeType = vt; };
       
       /// returns true if the file is isEmpty
-      bool empty() const { return (voxels == NULL); }
+      bool empty() const { return ((voxels == NULL) && (pagedSubVolumeIndex < 0)); }
       
       /// get the afni header
       AfniHeader* getAfniHeader() { return &afniHeader; }
@@ -473,7 +488,7 @@ class VolumeFile : public AbstractFile {
       WuNilHeader* getWuNilHeader() { return &wunilHeader; }
       
       /// get the volume data (const method)
-      const float* getVoxelData() const { return voxels; }
+      const float* getVoxelData() const { return getPinnedVoxelData(); }
       
       /// get the coordinate at the center of the voxel
       void getVoxelCoordinate(const int ijk[3], 
@@ -488,7 +503,10 @@ class VolumeFile : public AbstractFile {
                               float coord[3]) const;
       
       /// get the volume data
-      float* getVoxelData() { return voxels; }
+      float* getVoxelData() { stopPagingVoxels(true); return voxels; }
+      
+      /// read the voxels of a paged sub-volume and keep them in memory
+      void loadVoxelData() throw (FileException);
       
       /// get a voxel with a flat index
       float getVoxelWithFlatIndex(const int indx, const int component = 0) const;
@@ -892,7 +910,7 @@ class VolumeFile : public AbstractFile {
       
       /// resample the image to the specified spacing
       void resampleToSpacing(const float newSpacing[3],
-                             const INTERPOLATION_TYPE interpolationType);
+                             const INTERPOLATION_TYPE interpolationType) throw (FileException);
       
       /// apply a transformation matrix to a volume
       void applyTransformationMatrix(vtkTransform* transform);
@@ -1162,14 +1180,12 @@ class VolumeFile : public AbstractFile {
       /// blue a volume
       void blur();
       
-      ///
+      /// smooth with a Gaussian kernel (full width at half maximum in millimeters)
+      void smoothGaussian(const float fullWidthHalfMaximum);
+      
+      /// convolve a volume with a 5-tap filter along each axis
       static void seperableConvolve(int ncol, int nrow, int nslices, 
 	                              	float *volume, float *filter);
-                                    
-      ///
-      static void oneDimConvolve(float *voxel, float *tempResult, float *filter, 
-                         const int dim, const int inc,
-                         const int ncol, const int nrow, const int nslices);
       
       /// voxel 6 connected to seed are found in "this" volume
       /// and set to "markValue" in the "mark" volume
@@ -1349,6 +1365,12 @@ class VolumeFile : public AbstractFile {
                               const float offsetFact,
                               gzFile dataFile) throw (FileException);
       
+      /// read the volume data
+      void readVolumeFileData(const bool byteSwapNeeded,
+                              const float scaleFact,
+                              const float offsetFact,
+                              GzipBlockFileReader& dataFile) throw (FileException);
+      
       /// read the volume data
       void readVolumeFileDataSubVolume(const bool byteSwapNeeded,
                                        const float scaleFact,
@@ -1357,18 +1379,52 @@ class VolumeFile : public AbstractFile {
                                        const int subVolumeNumber,
                                        gzFile dataFile) throw (FileException);
       
+      /// read the volume data
+      void readVolumeFileDataSubVolume(const bool byteSwapNeeded,
+                                       const float scaleFact,
+                                       const float offsetFact,
+                                       const long dataOffset,
+                                       const int subVolumeNumber,
+                                       GzipBlockFileReader& dataFile) throw (FileException);
+      
       /// write the volume data
       void writeVolumeFileData(const VOXEL_DATA_TYPE voxelDataTypeForWriting,
                                const bool byteSwapNeeded,
                                const bool compressDataWithZlib,
                                gzFile zipStream,
-                               std::ofstream* cppStream,
+                               std::ostream* cppStream,
                                const float divideByThisValue) throw (FileException);
                                 
       /// copy volume data (used by copy contructor and assignment operator)
       void copyVolumeData(const VolumeFile& vf,
-                          const bool copyVoxelData = true);
+                          const bool copyVoxelData = true,
+                          const bool allocateVoxelData = true);
+
+      /// read the voxels of a paged sub-volume if they are not in memory
+      void loadPagedVoxels() const throw (FileException);
+      
+      /// read the voxels of a paged sub-volume and evict others over the memory budget
+      void readPagedVoxels() const throw (FileException);
+      
+      /// read the voxels of a paged sub-volume for a member that cannot throw
+      void loadPagedVoxelsForAccess() const;
       
+      /// get the voxel data of a paged sub-volume and pin it so that it is never evicted
+      const float* getPinnedVoxelData() const;
+      
+      /// stop paging the sub-volume so that its voxels stay in memory
+      void stopPagingVoxels(const bool loadVoxelsFlag);
+      
+      /// free the voxels of a paged sub-volume (reread when next accessed)
+      void evictPagedVoxels();
+
+      /// resample voxels into a new grid (transform maps new IJK to current IJK)
+      void resampleVoxels(const double indexTransform[3][4],
+                          const int newDimensions[3],
+                          const float newSpacing[3],
+                          const float newOrigin[3],
+                          const INTERPOLATION_TYPE interpolationType);
+
       /// Flood fill starting at a voxel or remove a connected set of voxels.
       void floodFillAndRemoveConnected(const SEGMENTATION_OPERATION operation,
                                        const VOLUME_AXIS axis,
@@ -1399,40 +1455,40 @@ class VolumeFile : public AbstractFile {
                                   QDomElement& /* rootElement */) throw (FileException);
       
       /// Read voxels from the data file
-      void readCharData(gzFile dataFile) throw (FileException);
+      void readCharData(GzipBlockFileReader& dataFile) throw (FileException);
       
       /// Read voxels from the data file
-      void readUnsignedCharData(gzFile dataFile) throw (FileException);
+      void readUnsignedCharData(GzipBlockFileReader& dataFile) throw (FileException);
       
       /// Read voxels from the data file
-      void readShortData(gzFile dataFile, const bool byteSwapData) throw (FileException);
+      void readShortData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException);
       
       /// Read voxels from the data file
-      void readUnsignedShortData(gzFile dataFile, const bool byteSwapData) throw (FileException);
+      void readUnsignedShortData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException);
       
       /// Read voxels from the data file
-      void readIntData(gzFile dataFile, const bool byteSwapData) throw (FileException);
+      void readIntData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException);
       
       /// Read voxels from the data file 
-      void readUnsignedIntData(gzFile dataFile, const bool byteSwapData) throw (FileException);
+      void readUnsignedIntData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException);
       
       /// Read voxels from the data file 
-      void readLongLongData(gzFile dataFile, const bool byteSwapData) throw (FileException);
+      void readLongLongData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException);
       
       /// Read voxels from the data file
-      void readUnsignedLongLongData(gzFile dataFile, const bool byteSwapData) throw (FileException);
+      void readUnsignedLongLongData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException);
       
       /// Read voxels from the data file
-      void readFloatData(gzFile dataFile, const bool byteSwapData) throw (FileException);
+      void readFloatData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException);
       
       /// Read voxels from the data file
-      void readDoubleData(gzFile dataFile, const bool byteSwapData) throw (FileException);
+      void readDoubleData(GzipBlockFileReader& dataFile, const bool byteSwapData) throw (FileException);
       
       /// Read voxels from the data file
-      void readRgbDataVoxelInterleaved(gzFile dataFile) throw (FileException);
+      void readRgbDataVoxelInterleaved(GzipBlockFileReader& dataFile) throw (FileException);
       
       /// Read voxels from the data file
-      void readRgbDataSliceInterleaved(gzFile dataFile) throw (FileException);
+      void readRgbDataSliceInterleaved(GzipBlockFileReader& dataFile) throw (FileException);
       
       /// Get a double attribute from a minc file.
       void get_minc_attribute(int mincid, char *varname, char *attname, 
@@ -1447,6 +1503,18 @@ class VolumeFile : public AbstractFile {
       /// volume space for reading of volumes
       static VOLUME_SPACE volumeSpace;
       
+      /// compressed NIFTI files are written as gzip blocks
+      static bool niftiGzipBlockWritingEnabled;
+      
+      /// memory budget (megabytes) for voxels of paged sub-volumes
+      static int pagedVoxelsMemoryBudget;
+      
+      /// paged sub-volumes whose voxels are in memory
+      static std::vector<VolumeFile*> residentPagedVolumes;
+      
+      /// incremented each time a paged sub-volume is accessed
+      static unsigned long pagedVoxelsAccessCounter;
+      
       /// the type of volume
       VOLUME_TYPE volumeType;
 
@@ -1522,6 +1590,18 @@ class VolumeFile : public AbstractFile {
       /// the voxels
       float* voxels;
       
+      /// name of file containing voxels of paged sub-volume
+      QString pagedVoxelsFileName;
+      
+      /// index of paged sub-volume in its file (negative if not paged)
+      int pagedSubVolumeIndex;
+      
+      /// value of access counter when paged sub-volume last accessed
+      mutable unsigned long pagedVoxelsLastAccess;
+      
+      /// paged sub-volume has given out a pointer to its voxels so it is never evicted
+      mutable bool pagedVoxelsPinned;
+      
       /// minimum voxel value
       float minimumVoxelValue;
       
@@ -1600,6 +1680,10 @@ bool VolumeFile::eulerTableValid = false;
 float VolumeFile::eulerTable[256];
 
 VolumeFile::VOLUME_SPACE VolumeFile::volumeSpace = VolumeFile::VOLUME_SPACE_COORD_LPI;
+bool VolumeFile::niftiGzipBlockWritingEnabled = false;
+int VolumeFile::pagedVoxelsMemoryBudget = 1024;
+std::vector<VolumeFile*> VolumeFile::residentPagedVolumes;
+unsigned long VolumeFile::pagedVoxelsAccessCounter = 0;
 int VolumeFile::localNeighbors[26][3] = {
 	{0, 0, 1},
 	{0, 1, 0},
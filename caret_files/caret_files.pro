@@ -66,6 +66,7 @@ HEADERS += AbstractFile.h \
       GiftiMatrix.h \
       GiftiMetaData.h \
       GiftiNodeDataFile.h \
+      GzipBlockFile.h \
       ImageFile.h \
       LatLonFile.h \
       MDPlotFile.h \
@@ -171,6 +172,7 @@ SOURCES += AbstractFile.cxx \
       GiftiMatrix.cxx \
       GiftiMetaData.cxx \
       GiftiNodeDataFile.cxx \
+      GzipBlockFile.cxx \
       ImageFile.cxx \
       LatLonFile.cxx \
       MDPlotFile.cxx \
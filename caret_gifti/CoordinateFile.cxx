@@ -531,13 +531,16 @@ CoordinateFile::getDistanceBetweenCoordinatesSquared(const int c1,
  * Compute shuffled average coordinate files.  The inputs files are randomly split into 
  * two groups and from these two groups two average coordinate files are created.  
  * numberInGroup1 is the size of the first group but if this value is non-positive, the
- * groups are sized to one-half of the number of input files.
+ * groups are sized to one-half of the number of input files.  If the permutation
+ * index is not negative, the split is determined only by the index so that
+ * shuffles may be performed in any order and in multiple threads.
  */
 void 
 CoordinateFile::createShuffledAverageCoordinatesFiles(const std::vector<CoordinateFile*>& files,
                                                       const int numberInGroup1,
                                                       CoordinateFile& coordFileOut1,
-                                                      CoordinateFile& coordFileOut2)
+                                                      CoordinateFile& coordFileOut2,
+                                                      const int permutationIndex)
                                                                       throw (FileException)
 {
    //
@@ -567,9 +570,16 @@ CoordinateFile::createShuffledAverageCoordinatesFiles(const std::vector<Coordina
    for (int i = 0; i < numFiles; i++) {
       indicesShuffled[i] = i;
    }
-   //RandomNumberOp randOp;  // used to rand() is called
-   StatisticRandomNumberOperator randOp;  // used to rand() is called
-   std::random_shuffle(indicesShuffled.begin(), indicesShuffled.end(), randOp); 
+   if (permutationIndex >= 0) {
+      StatisticRandomNumber generator(permutationIndex);
+      StatisticRandomNumberOperator randOp(&generator);
+      std::random_shuffle(indicesShuffled.begin(), indicesShuffled.end(), randOp); 
+   }
+   else {
+      //RandomNumberOp randOp;  // used to rand() is called
+      StatisticRandomNumberOperator randOp;  // used to rand() is called
+      std::random_shuffle(indicesShuffled.begin(), indicesShuffled.end(), randOp); 
+   }
    
    //
    // set the half files index
@@ -175,7 +175,8 @@ class CoordinateFile : public GiftiNodeDataFile {
       static void createShuffledAverageCoordinatesFiles(const std::vector<CoordinateFile*>& files,
                                                         const int numberInGroup1,
                                                         CoordinateFile& coordFileOut1,
-                                                        CoordinateFile& coordFileOut2)
+                                                        CoordinateFile& coordFileOut2,
+                                                        const int permutationIndex = -1)
                                              throw (FileException);
                                              
       // compute an average coordinate file
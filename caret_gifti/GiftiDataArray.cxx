@@ -38,6 +38,7 @@
 #include "GiftiDataArray.h"
 #include "GiftiDataArrayFile.h"
 #include "StringUtilities.h"
+#include "zlib.h"
 #ifdef HAVE_VTK
 #include "vtkBase64Utilities.h"
 #include "vtkByteSwap.h"
@@ -757,9 +758,14 @@ GiftiDataArray::readFromText(QString& text,
                               externalFileOffsetForReading);
                               
    //
-   // If NOT metadata only
+   // If NOT metadata only (data array without a parent file is being
+   // decoded in a separate thread and always reads its data)
    //
-   if (parentGiftiDataArrayFile->getReadMetaDataOnlyFlag() == false) {
+   bool readMetaDataOnlyFlag = false;
+   if (parentGiftiDataArrayFile != NULL) {
+      readMetaDataOnlyFlag = parentGiftiDataArrayFile->getReadMetaDataOnlyFlag();
+   }
+   if (readMetaDataOnlyFlag == false) {
       //
       // Total number of elements in Data Array
       //
@@ -804,18 +810,15 @@ GiftiDataArray::readFromText(QString& text,
             }
             break;
          case ENCODING_INTERNAL_BASE64_BINARY:
-   #ifdef HAVE_VTK
             {
                //
-               // Decode the Base64 data using VTK's algorithm
+               // Decode the Base64 text directly into the data
                //
-               const QByteArray ba = text.toAscii();
-               const char* textChars = ba.constData();
-               // crashes const char* textChars = text.toAscii().constData();
                const unsigned long numDecoded =
-                     vtkBase64Utilities::Decode((const unsigned char*)textChars,
-                                                data.size(),
-                                                &data[0]);
+                     decodeBase64(text.constData(),
+                                  text.length(),
+                                  &data[0],
+                                  data.size());
                if (numDecoded != data.size()) {
                   std::ostringstream str;
                   str << "Decoding of Base64 Binary data failed.\n"
@@ -831,51 +834,16 @@ GiftiDataArray::readFromText(QString& text,
                   byteSwapData(getSystemEndian());
                }
             }
-   #else  // HAVE_VTK
-            throw FileException("No support for Base64 data since VTK not available at compile time.");
-   #endif // HAVE_VTK
             break;
          case ENCODING_INTERNAL_COMPRESSED_BASE64_BINARY:
-   #ifdef HAVE_VTK
             {
                //
-               // Decode the Base64 data using VTK's algorithm
-               //
-               unsigned char* dataBuffer = new unsigned char[data.size()];
-               const QByteArray ba = text.toAscii();
-               const char* textChars = ba.constData();
-               // crashes const char* textChars = text.toAscii().constData();
-               const unsigned long numDecoded =
-                     vtkBase64Utilities::Decode((const unsigned char*)textChars,
-                                                data.size(),
-                                                dataBuffer);
-               if (numDecoded == 0) {
-                  throw FileException("", "Decoding of GZip Base64 Binary data failed.");
-               }
-               
-               
-               //
-               // Uncompress the data using VTK's algorithm
-               //
-               vtkZLibDataCompressor* compressor = vtkZLibDataCompressor::New();
-               const unsigned long uncompressedDataLength = 
-                                   compressor->Uncompress(dataBuffer,
-                                                          numDecoded,
-                                                          &data[0],
-                                                          data.size());
-               if (uncompressedDataLength != data.size()) {
-                  std::ostringstream str;
-                  str << "Decompression of Binary data failed.\n"
-                      << "Uncompressed " << uncompressedDataLength << " bytes but should be "
-                      << data.size() << " bytes.";
-                  throw FileException("", str.str().c_str());
-               }
-               
-               //
-               // Free memory
+               // Decode the Base64 text and inflate directly into the data
                //
-               delete[] dataBuffer;
-               compressor->Delete();
+               decodeCompressedBase64(text.constData(),
+                                      text.length(),
+                                      &data[0],
+                                      data.size());
                
                //
                // Is byte swapping needed ?
@@ -884,9 +852,6 @@ GiftiDataArray::readFromText(QString& text,
                   byteSwapData(getSystemEndian());
                }
             }
-   #else  // HAVE_VTK
-            throw FileException("No support for Base64 data since VTK not available at compile time.");
-   #endif // HAVE_VTK
             break;
          case ENCODING_EXTERNAL_FILE_BINARY:
             {
@@ -995,6 +960,164 @@ GiftiDataArray::readFromText(QString& text,
    setModified();
 }
 
+/// value of each Base64 character, 0x80 if the character is not in the Base64 alphabet
+static const unsigned char base64DecodeTable[256] = {
+   0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+   0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+   0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3e, 0x80, 0x80, 0x80, 0x3f,
+   0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+   0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+   0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
+   0x80, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+   0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+   0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+   0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+   0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+   0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+   0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+   0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+   0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+   0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
+};
+
+/**
+ * decode Base64 text directly into a buffer.  Groups of four characters 
+ * are decoded at once until whitespace or padding is found, which is
+ * then skipped one character at a time.
+ * Returns the number of bytes decoded.
+ */
+unsigned long 
+GiftiDataArray::decodeBase64(const QChar* text,
+                             const long textLength,
+                             unsigned char* output,
+                             const unsigned long outputLength)
+{
+   unsigned long numOut = 0;
+   unsigned char quad[4];
+   int numInQuad = 0;
+   long i = 0;
+   
+   while ((i < textLength) && (numOut < outputLength)) {
+      if (numInQuad == 0) {
+         while (((i + 4) <= textLength) && ((numOut + 3) <= outputLength)) {
+            const ushort c0 = text[i].unicode();
+            const ushort c1 = text[i + 1].unicode();
+            const ushort c2 = text[i + 2].unicode();
+            const ushort c3 = text[i + 3].unicode();
+            if ((c0 | c1 | c2 | c3) > 0xff) {
+               break;
+            }
+            const unsigned char v0 = base64DecodeTable[c0];
+            const unsigned char v1 = base64DecodeTable[c1];
+            const unsigned char v2 = base64DecodeTable[c2];
+            const unsigned char v3 = base64DecodeTable[c3];
+            if ((v0 | v1 | v2 | v3) & 0x80) {
+               break;
+            }
+            output[numOut]     = (v0 << 2) | (v1 >> 4);
+            output[numOut + 1] = (v1 << 4) | (v2 >> 2);
+            output[numOut + 2] = (v2 << 6) | v3;
+            numOut += 3;
+            i += 4;
+         }
+         if ((i >= textLength) || (numOut >= outputLength)) {
+            break;
+         }
+      }
+      
+      const ushort c = text[i].unicode();
+      i++;
+      if (c == '=') {
+         break;
+      }
+      if (c > 0xff) {
+         continue;
+      }
+      const unsigned char v = base64DecodeTable[c];
+      if (v & 0x80) {
+         continue;  // whitespace
+      }
+      quad[numInQuad] = v;
+      numInQuad++;
+      if (numInQuad == 4) {
+         const unsigned char bytes[3] = {
+            (unsigned char)((quad[0] << 2) | (quad[1] >> 4)),
+            (unsigned char)((quad[1] << 4) | (quad[2] >> 2)),
+            (unsigned char)((quad[2] << 6) | quad[3])
+         };
+         for (int j = 0; (j < 3) && (numOut < outputLength); j++) {
+            output[numOut] = bytes[j];
+            numOut++;
+         }
+         numInQuad = 0;
+      }
+   }
+   
+   //
+   // Characters preceding the padding
+   //
+   if ((numInQuad >= 2) && (numOut < outputLength)) {
+      output[numOut] = (quad[0] << 2) | (quad[1] >> 4);
+      numOut++;
+      if ((numInQuad == 3) && (numOut < outputLength)) {
+         output[numOut] = (quad[1] << 4) | (quad[2] >> 2);
+         numOut++;
+      }
+   }
+   
+   return numOut;
+}
+
+/**
+ * decode Base64 text and inflate it (zlib or gzip format) directly into
+ * a buffer.  Returns the number of bytes after inflation.
+ */
+unsigned long 
+GiftiDataArray::decodeCompressedBase64(const QChar* text,
+                                       const long textLength,
+                                       unsigned char* output,
+                                       const unsigned long outputLength) throw (FileException)
+{
+   //
+   // Decode the compressed data
+   //
+   std::vector<unsigned char> compressedData((textLength / 4) * 3 + 3);
+   const unsigned long numDecoded = decodeBase64(text,
+                                                 textLength,
+                                                 &compressedData[0],
+                                                 compressedData.size());
+   if (numDecoded == 0) {
+      throw FileException("", "Decoding of GZip Base64 Binary data failed.");
+   }
+   
+   //
+   // Inflate into the output (window bits of 15 + 32 detects zlib or gzip header)
+   //
+   z_stream strm;
+   memset(&strm, 0, sizeof(strm));
+   if (inflateInit2(&strm, 15 + 32) != Z_OK) {
+      throw FileException("", "Unable to initialize decompression of Binary data.");
+   }
+   strm.next_in   = (Bytef*)&compressedData[0];
+   strm.avail_in  = numDecoded;
+   strm.next_out  = (Bytef*)output;
+   strm.avail_out = outputLength;
+   const int result = inflate(&strm, Z_FINISH);
+   const unsigned long uncompressedDataLength = strm.total_out;
+   inflateEnd(&strm);
+   
+   if ((result != Z_STREAM_END) ||
+       (uncompressedDataLength != outputLength)) {
+      std::ostringstream str;
+      str << "Decompression of Binary data failed.\n"
+          << "Uncompressed " << uncompressedDataLength << " bytes but should be "
+          << outputLength << " bytes.";
+      throw FileException("", str.str().c_str());
+   }
+   
+   return uncompressedDataLength;
+}
+
 /**
  * convert array indexing order of data.
  */
@@ -165,6 +165,18 @@ class GiftiDataArray {
                         const ENCODING encodingForReading,
                         const QString& externalFileNameForReading,
                         const long externalFileOffsetForReading) throw (FileException);
+      
+      // decode Base64 text directly into a buffer (returns number of bytes decoded)
+      static unsigned long decodeBase64(const QChar* text,
+                                        const long textLength,
+                                        unsigned char* output,
+                                        const unsigned long outputLength);
+      
+      // decode Base64 text and inflate it directly into a buffer (returns number of bytes inflated)
+      static unsigned long decodeCompressedBase64(const QChar* text,
+                                                  const long textLength,
+                                                  unsigned char* output,
+                                                  const unsigned long outputLength) throw (FileException);
                                                
       // write the data as XML
       void writeAsXML(QTextStream& stream, 
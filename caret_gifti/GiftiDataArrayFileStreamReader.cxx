@@ -24,6 +24,7 @@
  */
 /*LICENSE_END*/
 
+#include <algorithm>
 #include <iostream>
 
 #include <QDir>
@@ -42,6 +43,68 @@
 #include "GiftiMetaData.h"
 #include "StringUtilities.h"
 
+/**
+ * constructor.
+ */
+GiftiDataArrayDecodeTask::GiftiDataArrayDecodeTask(GiftiDataArray* dataArrayIn,
+                               const QString& textIn,
+                               const QString& endianNameIn,
+                               const GiftiDataArray::ARRAY_SUBSCRIPTING_ORDER arraySubscriptingOrderIn,
+                               const GiftiDataArray::DATA_TYPE dataTypeIn,
+                               const std::vector<int>& dimensionsIn,
+                               const GiftiDataArray::ENCODING encodingIn,
+                               const QString& externalFileNameIn,
+                               const long externalFileOffsetIn)
+{
+   dataArray = dataArrayIn;
+   errorMessage = "";
+   submittedFlag = false;
+   text = textIn;
+   endianName = endianNameIn;
+   arraySubscriptingOrder = arraySubscriptingOrderIn;
+   dataType = dataTypeIn;
+   dimensions = dimensionsIn;
+   encoding = encodingIn;
+   externalFileName = externalFileNameIn;
+   externalFileOffset = externalFileOffsetIn;
+}
+
+/**
+ * destructor.
+ */
+GiftiDataArrayDecodeTask::~GiftiDataArrayDecodeTask()
+{
+}
+
+/**
+ * decodes the data.  The data array must not have a parent file while
+ * decoding so that the file is not modified from more than one thread.
+ */
+void 
+GiftiDataArrayDecodeTask::run()
+{
+   try {
+      dataArray->readFromText(text,
+                              endianName,
+                              arraySubscriptingOrder,
+                              dataType,
+                              dimensions,
+                              encoding,
+                              externalFileName,
+                              externalFileOffset);
+   }
+   catch (FileException& e) {
+      errorMessage = e.whatQString();
+   }
+   
+   //
+   // Free the encoded data
+   //
+   text = "";
+}
+
+//=============================================================================
+
 /**
  * constructor.
  */
@@ -53,6 +116,8 @@ GiftiDataArrayFileStreamReader::GiftiDataArrayFileStreamReader(QFile* file,
    this->numberOfDataArraysInFile = 0;
    this->dataArrayReadIndex = 0;
    this->giftiDataArrayReadListener = NULL;
+   this->maximumNumberOfPendingDataArrays =
+      std::max(CaretThreadPool::getGlobalThreadPool()->getNumberOfThreads() * 2, 2);
 }
 
 /// For incrementally reading arrays
@@ -88,6 +153,7 @@ GiftiDataArrayFileStreamReader::readFileAndReportDataArraysAsTheyAreRead(
  */
 GiftiDataArrayFileStreamReader::~GiftiDataArrayFileStreamReader()
 {
+   deletePendingDataArrays();
 }
 
 /**
@@ -155,6 +221,14 @@ GiftiDataArrayFileStreamReader::readData() throw (FileException)
       }
    }
    
+   //
+   // Wait for data arrays still being decoded
+   //
+   if (error() == false) {
+      reportDecodedDataArrays(true);
+   }
+   deletePendingDataArrays();
+   
    if (error()) {
       throw FileException(errorString());
    }
@@ -506,6 +580,7 @@ GiftiDataArrayFileStreamReader::readDataArray()
    // Loop through the file
    //
    bool dataWasReadFlag = false;
+   QString text = "";
    while (atEnd() == false) {
       //
       // Read next element
@@ -520,54 +595,29 @@ GiftiDataArrayFileStreamReader::readDataArray()
          // If end of data array, stop reading
          //
          if (name() == GiftiCommon::tagDataArray) {
-            if (dataWasReadFlag == false) {
+            //
+            // If there is no data, the file may have external data
+            // without a set of <Data></Data> tags
+            //
+            if (dataWasReadFlag || externalDataFlag) {
                //
-               // If we get here, the file had external data without
-               // a set of <Data></Data> tags
+               // Decode the data while reading continues
                //
-               if (externalDataFlag) {
-                  try {
-                     //
-                     // Read the data
-                     //
-                     dataWasReadFlag = true;
-                     if (this->giftiFile->getReadMetaDataOnlyFlag() == false) {
-                         QString text = "";
-                         dataArray->readFromText(text,
-                                                 endianName,
-                                                 arraySubscriptingOrderForReadingArrayData,
-                                                 dataTypeForReadingArrayData,
-                                                 dimensionsForReadingArrayData,
-                                                 encodingForReadingArrayData,
-                                                 externalFileName,
-                                                 externalFileOffsetForReadingData);
-                     }
-
-                     //
-                     // Add GIFTI array to GIFTI file
-                     //
-                     if (this->giftiDataArrayReadListener != NULL) {
-                        const QString errorMessage =
-                           this->giftiDataArrayReadListener->dataArrayWasRead(
-                              dataArray, this->dataArrayReadIndex, this->numberOfDataArraysInFile);
-                        if (errorMessage.isEmpty() == false) {
-                           raiseError(errorMessage);
-                        }
-                        this->dataArrayReadIndex++;
-                     }
-                     else {
-                        giftiFile->addDataArray(dataArray);
-                     }
-                  }
-                  catch (FileException& e) {
-                     delete dataArray;
-                     raiseError(e.whatQString());
-                     return;
-                  }
-
-               }
+               addPendingDataArray(
+                  new GiftiDataArrayDecodeTask(dataArray,
+                                               text,
+                                               endianName,
+                                               arraySubscriptingOrderForReadingArrayData,
+                                               dataTypeForReadingArrayData,
+                                               dimensionsForReadingArrayData,
+                                               encodingForReadingArrayData,
+                                               externalFileName,
+                                               externalFileOffsetForReadingData));
             }
-            break;
+            else {
+               delete dataArray;
+            }
+            return;
          }
       }
       
@@ -581,43 +631,9 @@ GiftiDataArrayFileStreamReader::readDataArray()
             readMetaData(dataArray->getMetaData());
          }
          else if (elemName == GiftiCommon::tagData) {
-            try {
-                dataWasReadFlag = true;
-                if (this->giftiFile->getReadMetaDataOnlyFlag() == false) {
-                   //
-                   // Read the data
-                   //
-                   QString text = readElementText();
-                   dataArray->readFromText(text,
-                                           endianName,
-                                           arraySubscriptingOrderForReadingArrayData,
-                                           dataTypeForReadingArrayData,
-                                           dimensionsForReadingArrayData,
-                                           encodingForReadingArrayData,
-                                           externalFileName,
-                                           externalFileOffsetForReadingData);
-                }
-               
-                //
-                // Add GIFTI array to GIFTI file
-                //
-                if (this->giftiDataArrayReadListener != NULL) {
-                   const QString errorMessage =
-                      this->giftiDataArrayReadListener->dataArrayWasRead(
-                         dataArray, this->dataArrayReadIndex, this->numberOfDataArraysInFile);
-                   if (errorMessage.isEmpty() == false) {
-                      raiseError(errorMessage);
-                   }
-                   this->dataArrayReadIndex++;
-                }
-                else {
-                   giftiFile->addDataArray(dataArray);
-                }
-            }
-            catch (FileException& e) {
-               delete dataArray;
-               raiseError(e.whatQString());
-               return;
+            dataWasReadFlag = true;
+            if (this->giftiFile->getReadMetaDataOnlyFlag() == false) {
+               text = readElementText();
             }
          }
          else if (elemName == GiftiCommon::tagMatrix) {
@@ -631,10 +647,107 @@ GiftiDataArrayFileStreamReader::readDataArray()
                        + " in "
                        + GiftiCommon::tagDataArray
                        + ".");
+            delete dataArray;
             return;
          }
       }
    }
+   
+   delete dataArray;
+}
+
+/**
+ * add a data array that is decoded in the thread pool while reading 
+ * continues.  If too many data arrays are pending, wait for the oldest.
+ */
+void 
+GiftiDataArrayFileStreamReader::addPendingDataArray(GiftiDataArrayDecodeTask* task)
+{
+   pendingDataArrays.push_back(task);
+   
+   if (this->giftiFile->getReadMetaDataOnlyFlag() == false) {
+      task->dataArray->setMyParentGiftiDataArrayFile(NULL);
+      task->submittedFlag = true;
+      CaretThreadPool::getGlobalThreadPool()->submit(task);
+   }
+   
+   reportDecodedDataArrays(false);
+   while (pendingDataArrays.size() > maximumNumberOfPendingDataArrays) {
+      pendingDataArrays.front()->waitForFinished();
+      reportDecodedDataArrays(false);
+      if (error()) {
+         break;
+      }
+   }
+}
+
+/**
+ * add decoded data arrays to the file (or report them to the listener)
+ * in the order they appear in the file.  If the wait flag is not set,
+ * reporting stops at the first data array still being decoded.
+ */
+void 
+GiftiDataArrayFileStreamReader::reportDecodedDataArrays(const bool waitForAllFlag)
+{
+   while (pendingDataArrays.empty() == false) {
+      GiftiDataArrayDecodeTask* task = pendingDataArrays.front();
+      if (task->submittedFlag) {
+         if ((waitForAllFlag == false) &&
+             (task->isFinished() == false)) {
+            break;
+         }
+         task->waitForFinished();
+      }
+      pendingDataArrays.pop_front();
+      
+      GiftiDataArray* dataArray = task->dataArray;
+      dataArray->setMyParentGiftiDataArrayFile(giftiFile);
+      QString errorMessage = task->errorMessage;
+      if (task->getTaskThrewAnException()) {
+         errorMessage = task->getExceptionErrorMessage();
+      }
+      delete task;
+      
+      if (errorMessage.isEmpty() == false) {
+         delete dataArray;
+         raiseError(errorMessage);
+         deletePendingDataArrays();
+         return;
+      }
+      
+      //
+      // Add GIFTI array to GIFTI file
+      //
+      if (this->giftiDataArrayReadListener != NULL) {
+         errorMessage =
+            this->giftiDataArrayReadListener->dataArrayWasRead(
+               dataArray, this->dataArrayReadIndex, this->numberOfDataArraysInFile);
+         if (errorMessage.isEmpty() == false) {
+            raiseError(errorMessage);
+            deletePendingDataArrays();
+            return;
+         }
+         this->dataArrayReadIndex++;
+      }
+      else {
+         giftiFile->addDataArray(dataArray);
+      }
+   }
+}
+
+/**
+ * delete data arrays that have not been reported (waits for decoding).
+ */
+void 
+GiftiDataArrayFileStreamReader::deletePendingDataArrays()
+{
+   while (pendingDataArrays.empty() == false) {
+      GiftiDataArrayDecodeTask* task = pendingDataArrays.front();
+      pendingDataArrays.pop_front();
+      task->waitForFinished();
+      delete task->dataArray;
+      delete task;
+   }
 }
 
 /**
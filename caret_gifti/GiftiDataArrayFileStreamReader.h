@@ -27,9 +27,14 @@
  */
 /*LICENSE_END*/
 
+#include <deque>
+#include <vector>
+
 #include <QXmlStreamReader>
 
+#include "CaretThreadPool.h"
 #include "FileException.h"
+#include "GiftiDataArray.h"
 
 class GiftiDataArrayFile;
 class GiftiDataArrayReadListener;
@@ -37,6 +42,61 @@ class GiftiLabelTable;
 class GiftiMetaData;
 class QFile;
 
+/// class that decodes a data array's data in a thread pool
+class GiftiDataArrayDecodeTask : public CaretThreadPoolTask {
+   public:
+      // constructor
+      GiftiDataArrayDecodeTask(GiftiDataArray* dataArrayIn,
+                               const QString& textIn,
+                               const QString& endianNameIn,
+                               const GiftiDataArray::ARRAY_SUBSCRIPTING_ORDER arraySubscriptingOrderIn,
+                               const GiftiDataArray::DATA_TYPE dataTypeIn,
+                               const std::vector<int>& dimensionsIn,
+                               const GiftiDataArray::ENCODING encodingIn,
+                               const QString& externalFileNameIn,
+                               const long externalFileOffsetIn);
+      
+      // destructor
+      ~GiftiDataArrayDecodeTask();
+      
+      // decodes the data
+      void run();
+      
+      /// the data array (not owned by task)
+      GiftiDataArray* dataArray;
+      
+      /// error message if decoding failed
+      QString errorMessage;
+      
+      /// task was submitted to thread pool
+      bool submittedFlag;
+      
+   protected:
+      /// the encoded data
+      QString text;
+      
+      /// endian of data
+      QString endianName;
+      
+      /// subscripting order of data
+      GiftiDataArray::ARRAY_SUBSCRIPTING_ORDER arraySubscriptingOrder;
+      
+      /// type of data
+      GiftiDataArray::DATA_TYPE dataType;
+      
+      /// dimensions of data
+      std::vector<int> dimensions;
+      
+      /// encoding of data
+      GiftiDataArray::ENCODING encoding;
+      
+      /// name of external data file
+      QString externalFileName;
+      
+      /// offset of data in external data file
+      long externalFileOffset;
+};
+
 /// class for reading a GIFTI Data Array file
 class GiftiDataArrayFileStreamReader : QXmlStreamReader {
    public:
@@ -72,6 +132,15 @@ class GiftiDataArrayFileStreamReader : QXmlStreamReader {
       // read the coordinate transform matrix
       void readCoordinateTransformMatrix(GiftiMatrix* matrix);
       
+      // add a data array that is decoded while reading continues
+      void addPendingDataArray(GiftiDataArrayDecodeTask* task);
+      
+      // add decoded data arrays to file or listener in file order
+      void reportDecodedDataArrays(const bool waitForAllFlag);
+      
+      // delete data arrays that have not been reported
+      void deletePendingDataArrays();
+      
       /// GIFTI Data Array File being read
       GiftiDataArrayFile* giftiFile;
 
@@ -83,6 +152,12 @@ class GiftiDataArrayFileStreamReader : QXmlStreamReader {
 
       /// increments as data arrays are read
       int dataArrayReadIndex;
+      
+      /// data arrays being decoded, in file order
+      std::deque<GiftiDataArrayDecodeTask*> pendingDataArrays;
+      
+      /// maximum number of data arrays being decoded
+      unsigned int maximumNumberOfPendingDataArrays;
 };
 
 #endif // __GIFTI_DATA_ARRAY_FILE_STREAM_READER_H__
@@ -710,7 +710,14 @@ GuiVolumeAttributesDialog::resampleVolume()
          static_cast<VolumeFile::INTERPOLATION_TYPE>(
             resamplingMethodComboBox->itemData(methodIndex).toInt());
             
-      vf->resampleToSpacing(spacing, interpolationType);
+      try {
+         vf->resampleToSpacing(spacing, interpolationType);
+      }
+      catch (FileException& e) {
+         QApplication::restoreOverrideCursor();
+         QMessageBox::critical(this, "ERROR", e.whatQString());
+         return;
+      }
       loadVolumeParameters();
       loadVolumeResampling();
    }
@@ -35,6 +35,7 @@
 StatisticAnovaOneWay::StatisticAnovaOneWay()
    : StatisticAlgorithm("ANOVA One-Way")
 {
+   computePValueFlag = true;
 }
 
 /**
@@ -173,10 +174,12 @@ StatisticAnovaOneWay::execute() throw (StatisticException)
    }
    fStatistic = meanSumOfSquaresTreatmentMSTR / meanSumOfSquaresErrorMSE;
    
-   pValue = 
-        StatisticGeneratePValue::getFStatisticPValue(degreesOfFreedomBetweenTreatments,
-                                                     degreesOfFreedomWithinTreatments,
-                                                     fStatistic);
+   if (computePValueFlag) {
+      pValue = 
+           StatisticGeneratePValue::getFStatisticPValue(degreesOfFreedomBetweenTreatments,
+                                                        degreesOfFreedomWithinTreatments,
+                                                        fStatistic);
+   }
 /*
    //
    // Determine P-Value
@@ -71,6 +71,10 @@ class StatisticAnovaOneWay : public StatisticAlgorithm {
       /// P-Value
       double getPValue() const { return pValue; }
       
+      /// set computation of the P-Value (the P-Value uses DCDFLIB which
+      /// is not thread safe, so turn it off when executing in threads)
+      void setComputePValue(const bool b) { computePValueFlag = b; }
+      
    protected:
       /// treatment sum of squares
       double sumOfSquaresTreatmentSSTR;
@@ -101,6 +105,9 @@ class StatisticAnovaOneWay : public StatisticAlgorithm {
       
       /// P-Value
       double pValue;
+      
+      /// compute the P-Value
+      bool computePValueFlag;
 };
 
 #endif // __STATISTIC_ANOVA_ONE_WAY_H__
@@ -41,6 +41,7 @@ StatisticAnovaTwoWay::StatisticAnovaTwoWay()
    meanOfAllY = 0.0;
    numberOfFactorLevelsGroupA = 0;
    numberOfFactorLevelsGroupB = 0;
+   computePValueFlag = true;
 }
 
 /**
@@ -318,18 +319,23 @@ StatisticAnovaTwoWay::execute() throw (StatisticException)
    //
    // Determine P-Values
    //
-   pValueFactorA = 
-        StatisticGeneratePValue::getFStatisticPValue(degreesOfFreedomFactorA,
-                                                     degreesOfFreedomError,
-                                                     fStatisticFactorA);
-   pValueFactorB = 
-        StatisticGeneratePValue::getFStatisticPValue(degreesOfFreedomFactorB,
-                                                     degreesOfFreedomError,
-                                                     fStatisticFactorB);
-   pValueInteraction = 
-        StatisticGeneratePValue::getFStatisticPValue(degreesOfFreedomInteractions,
-                                                     degreesOfFreedomError,
-                                                     fStatisticInteraction);
+   pValueFactorA = 0.0;
+   pValueFactorB = 0.0;
+   pValueInteraction = 0.0;
+   if (computePValueFlag) {
+      pValueFactorA = 
+           StatisticGeneratePValue::getFStatisticPValue(degreesOfFreedomFactorA,
+                                                        degreesOfFreedomError,
+                                                        fStatisticFactorA);
+      pValueFactorB = 
+           StatisticGeneratePValue::getFStatisticPValue(degreesOfFreedomFactorB,
+                                                        degreesOfFreedomError,
+                                                        fStatisticFactorB);
+      pValueInteraction = 
+           StatisticGeneratePValue::getFStatisticPValue(degreesOfFreedomInteractions,
+                                                        degreesOfFreedomError,
+                                                        fStatisticInteraction);
+   }
 /*
    //
    // Determine P-Values
@@ -155,6 +155,10 @@ class StatisticAnovaTwoWay : public StatisticAlgorithm {
       /// P-Value for Interaction
       double getPValueInteraction() const { return pValueInteraction; }
       
+      /// set computation of the P-Values (the P-Values use DCDFLIB which
+      /// is not thread safe, so turn it off when executing in threads)
+      void setComputePValue(const bool b) { computePValueFlag = b; }
+      
    protected:
       // get a data group
       StatisticDataGroup* getDataGroup(const int factorLevelA,
@@ -253,7 +257,9 @@ class StatisticAnovaTwoWay : public StatisticAlgorithm {
       
       /// P-Value for Interaction
       double pValueInteraction;
-
+      
+      /// compute the P-Values
+      bool computePValueFlag;
 };
 
 #endif // __STATISTIC_ANOVA_TWO_WAY_H__
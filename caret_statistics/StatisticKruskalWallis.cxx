@@ -36,6 +36,7 @@
 StatisticKruskalWallis::StatisticKruskalWallis()
    : StatisticAlgorithm("Kruskal-Wallis")
 {
+   computePValueFlag = true;
 }
 
 /**
@@ -162,8 +163,10 @@ StatisticKruskalWallis::execute() throw (StatisticException)
    //
    // Compute P-Value
    //
-   pValue = 
-        StatisticGeneratePValue::getFStatisticPValue(degreesOfFreedomBetweenTreatments,
-                                                     degreesOfFreedomWithinTreatments,
-                                                     fStatistic);
+   if (computePValueFlag) {
+      pValue = 
+           StatisticGeneratePValue::getFStatisticPValue(degreesOfFreedomBetweenTreatments,
+                                                        degreesOfFreedomWithinTreatments,
+                                                        fStatistic);
+   }
 }
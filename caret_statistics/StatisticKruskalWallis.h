@@ -47,6 +47,10 @@ class StatisticKruskalWallis : public StatisticAlgorithm {
       /// P-Value
       double getPValue() const { return pValue; }
       
+      /// set computation of the P-Value (the P-Value uses DCDFLIB which
+      /// is not thread safe, so turn it off when executing in threads)
+      void setComputePValue(const bool b) { computePValueFlag = b; }
+      
       /// get treatment sum of squares
       double getSumOfSquaresTreatmentSSTR() const { return sumOfSquaresTreatmentSSTR; }
       
@@ -95,6 +99,9 @@ class StatisticKruskalWallis : public StatisticAlgorithm {
 
       /// degrees of freedom total
       double degreesOfFreedomTotal;
+      
+      /// compute the P-Value
+      bool computePValueFlag;
 };
 
 #endif // __STATISTIC_KRUSKAL_WALLIS_H__
@@ -40,6 +40,9 @@ StatisticPermutation::StatisticPermutation(const PERMUTATION_METHOD permutationM
 {
    permutationMethod = permutationMethodIn;
    outputDataGroup = NULL;
+   permutationIndex = 0;
+   streamNumber = 0;
+   permutationIndexValid = false;
 }
 
 /**
@@ -53,6 +56,20 @@ StatisticPermutation::~StatisticPermutation()
    }
 }
 
+/**
+ * use a counter-based generator keyed by the random seed and this
+ * permutation index.  Without a permutation index, the global
+ * generator is used.
+ */
+void 
+StatisticPermutation::setPermutationIndex(const unsigned long permutationIndexIn,
+                                          const unsigned int streamNumberIn)
+{
+   permutationIndex = permutationIndexIn;
+   streamNumber = streamNumberIn;
+   permutationIndexValid = true;
+}
+
 /**
  * execute the algorithm.
  */
@@ -79,6 +96,14 @@ StatisticPermutation::execute() throw (StatisticException)
       outputVector->push_back(sdg->getData(i));
    }
    
+   //
+   // Counter-based generator for this permutation
+   //
+   StatisticRandomNumber* generator = NULL;
+   if (permutationIndexValid) {
+      generator = new StatisticRandomNumber(permutationIndex, streamNumber);
+   }
+   
    //
    // Apply the appropriate algorithm to the values
    //
@@ -89,7 +114,12 @@ StatisticPermutation::execute() throw (StatisticException)
             // randomly flip signs of values
             //
             for (int i = 0; i < numValues; i++) {
-               if (StatisticRandomNumber::randomInteger(-1000, 1000) < 0) {
+               if (generator != NULL) {
+                  if (generator->nextInteger(0, 1) == 0) {
+                     (*outputVector)[i] = -(*outputVector)[i];
+                  }
+               }
+               else if (StatisticRandomNumber::randomInteger(-1000, 1000) < 0) {
                   (*outputVector)[i] = -(*outputVector)[i];
                }
             }
@@ -100,7 +130,7 @@ StatisticPermutation::execute() throw (StatisticException)
             //
             // Randomly shuffle the values
             //
-            StatisticRandomNumberOperator randOp;
+            StatisticRandomNumberOperator randOp(generator);
             std::random_shuffle(outputVector->begin(),
                                 outputVector->end(),
                                 randOp);
@@ -108,6 +138,10 @@ StatisticPermutation::execute() throw (StatisticException)
          break;
    }
    
+   if (generator != NULL) {
+      delete generator;
+   }
+   
    //
    // Create the output data group
    //
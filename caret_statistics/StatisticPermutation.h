@@ -54,6 +54,12 @@ class StatisticPermutation : public StatisticAlgorithm {
       /// get the output
       const StatisticDataGroup* getOutputData() const { return outputDataGroup; }
       
+      // use a counter-based generator keyed by the random seed and this
+      // permutation index so that the result does not depend on the thread
+      // or the order in which permutations are executed
+      void setPermutationIndex(const unsigned long permutationIndexIn,
+                               const unsigned int streamNumberIn = 0);
+      
       /// generate a random integer
       static int randomInteger(const int minRandomValue,
                                const int maxRandomValue);
@@ -64,6 +70,15 @@ class StatisticPermutation : public StatisticAlgorithm {
       
       /// the permutation method
       PERMUTATION_METHOD permutationMethod;
+      
+      /// the permutation index
+      unsigned long permutationIndex;
+      
+      /// the stream number
+      unsigned int streamNumber;
+      
+      /// use counter-based generator with permutation index
+      bool permutationIndexValid;
 };
 
 #endif // __STATISTIC_PERMUTATION_H__
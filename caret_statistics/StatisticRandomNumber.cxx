@@ -27,7 +27,135 @@
 #include <algorithm>
 #include <cstdlib>
 
+#define __STATISTIC_RANDOM_NUMBER_MAIN__
 #include "StatisticRandomNumber.h"
+#undef __STATISTIC_RANDOM_NUMBER_MAIN__
+
+/**
+ * constructor for counter-based generator using the seed from setRandomSeed().
+ */
+StatisticRandomNumber::StatisticRandomNumber(const unsigned long permutationIndex,
+                                             const unsigned int streamNumber)
+{
+   initialize(randomSeed, permutationIndex, streamNumber);
+}
+
+/**
+ * constructor for counter-based generator.
+ */
+StatisticRandomNumber::StatisticRandomNumber(const unsigned int seed,
+                                             const unsigned long permutationIndex,
+                                             const unsigned int streamNumber)
+{
+   initialize(seed, permutationIndex, streamNumber);
+}
+
+/**
+ * destructor.
+ */
+StatisticRandomNumber::~StatisticRandomNumber()
+{
+}
+
+/**
+ * initialize the counter-based generator.
+ */
+void 
+StatisticRandomNumber::initialize(const unsigned int seed,
+                                  const unsigned long permutationIndex,
+                                  const unsigned int streamNumber)
+{
+   key[0] = static_cast<uint32_t>(seed);
+   key[1] = static_cast<uint32_t>(streamNumber);
+   
+   const uint64_t index = static_cast<uint64_t>(permutationIndex);
+   counter[0] = 0;
+   counter[1] = 0;
+   counter[2] = static_cast<uint32_t>(index & 0xffffffff);
+   counter[3] = static_cast<uint32_t>(index >> 32);
+   
+   blockIndex = 4;
+}
+
+/**
+ * generate the next block of four random values by applying ten 
+ * Philox rounds to the counter and then incrementing the counter.
+ */
+void 
+StatisticRandomNumber::generateBlock()
+{
+   uint32_t c[4] = { counter[0], counter[1], counter[2], counter[3] };
+   uint32_t k[2] = { key[0], key[1] };
+   
+   for (int round = 0; round < 10; round++) {
+      const uint64_t p0 = static_cast<uint64_t>(0xD2511F53) * c[0];
+      const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57) * c[2];
+      const uint32_t hi0 = static_cast<uint32_t>(p0 >> 32);
+      const uint32_t lo0 = static_cast<uint32_t>(p0);
+      const uint32_t hi1 = static_cast<uint32_t>(p1 >> 32);
+      const uint32_t lo1 = static_cast<uint32_t>(p1);
+      c[0] = hi1 ^ c[1] ^ k[0];
+      c[1] = lo1;
+      c[2] = hi0 ^ c[3] ^ k[1];
+      c[3] = lo0;
+      k[0] += 0x9E3779B9;
+      k[1] += 0xBB67AE85;
+   }
+   
+   for (int i = 0; i < 4; i++) {
+      block[i] = c[i];
+   }
+   blockIndex = 0;
+   
+   counter[0]++;
+   if (counter[0] == 0) {
+      counter[1]++;
+   }
+}
+
+/**
+ * get the next random unsigned 32-bit integer.
+ */
+uint32_t 
+StatisticRandomNumber::nextUnsignedInteger()
+{
+   if (blockIndex >= 4) {
+      generateBlock();
+   }
+   const uint32_t v = block[blockIndex];
+   blockIndex++;
+   return v;
+}
+
+/**
+ * get the next random integer within the specified range (inclusive).
+ */
+int 
+StatisticRandomNumber::nextInteger(const int minRandomValue,
+                                   const int maxRandomValue)
+{
+   if (maxRandomValue <= minRandomValue) {
+      return minRandomValue;
+   }
+   const uint64_t range = static_cast<uint64_t>(
+                             static_cast<int64_t>(maxRandomValue) - minRandomValue) + 1;
+   const uint64_t r = (static_cast<uint64_t>(nextUnsignedInteger()) * range) >> 32;
+   return static_cast<int>(minRandomValue + static_cast<int64_t>(r));
+}
+
+/**
+ * get the next random float within the specified range.
+ */
+float 
+StatisticRandomNumber::nextFloat(const float minRandomValue,
+                                 const float maxRandomValue)
+{
+   const double dm = maxRandomValue - minRandomValue;
+   float v = minRandomValue + (dm * (nextUnsignedInteger() / 4294967296.0));
+   v = std::max(minRandomValue, v);
+   v = std::min(maxRandomValue, v);
+   return v;
+}
 
 /**
  * generate a random integer within the specified range.
@@ -74,4 +202,14 @@ void
 StatisticRandomNumber::setRandomSeed(const int i)
 {
    std::srand(i);
+   randomSeed = static_cast<unsigned int>(i);
+}
+
+/**
+ * get the seed last passed to setRandomSeed().
+ */
+unsigned int 
+StatisticRandomNumber::getRandomSeed()
+{
+   return randomSeed;
 }
@@ -27,9 +27,40 @@
 #ifndef __STATISTIC_RANDOM_NUMBER_H__
 #define __STATISTIC_RANDOM_NUMBER_H__
 
-/// class for random number generation
+#include <stdint.h>
+
+/// class for random number generation.
+///
+/// The static methods use the C library's global generator.  An instance
+/// is a counter-based (Philox4x32-10) generator keyed by the random seed,
+/// a permutation index, and a stream number.  Its sequence depends only
+/// on those values, so permutations may be run on any thread, in any
+/// order, and give the same results as a single-threaded run.
 class StatisticRandomNumber {
    public:
+      // constructor for counter-based generator using seed from setRandomSeed()
+      StatisticRandomNumber(const unsigned long permutationIndex,
+                            const unsigned int streamNumber = 0);
+      
+      // constructor for counter-based generator
+      StatisticRandomNumber(const unsigned int seed,
+                            const unsigned long permutationIndex,
+                            const unsigned int streamNumber);
+      
+      // destructor
+      ~StatisticRandomNumber();
+      
+      // get the next random unsigned 32-bit integer
+      uint32_t nextUnsignedInteger();
+      
+      // get the next random integer within the specified range (inclusive)
+      int nextInteger(const int minRandomValue,
+                      const int maxRandomValue);
+      
+      // get the next random float within the specified range
+      float nextFloat(const float minRandomValue,
+                      const float maxRandomValue);
+      
       // generate a random integer within the specified range
       static float randomFloat(const float minRandomValue,
                                const float maxRandomValue);
@@ -44,7 +75,37 @@ class StatisticRandomNumber {
                                
       // set the seed for the random number generator
       static void setRandomSeed(const int i);      
+      
+      // get the seed last passed to setRandomSeed()
+      static unsigned int getRandomSeed();
+      
+   protected:
+      // initialize the counter-based generator
+      void initialize(const unsigned int seed,
+                      const unsigned long permutationIndex,
+                      const unsigned int streamNumber);
+      
+      // generate the next block of four random values
+      void generateBlock();
+      
+      /// key of the counter-based generator (seed and stream)
+      uint32_t key[2];
+      
+      /// counter of the counter-based generator (block and permutation index)
+      uint32_t counter[4];
+      
+      /// random values from the most recent block
+      uint32_t block[4];
+      
+      /// index of next value in block
+      int blockIndex;
+      
+      /// seed last passed to setRandomSeed()
+      static unsigned int randomSeed;
 };
 
 #endif // __STATISTIC_RANDOM_NUMBER_H__
 
+#ifdef __STATISTIC_RANDOM_NUMBER_MAIN__
+   unsigned int StatisticRandomNumber::randomSeed = 1;
+#endif // __STATISTIC_RANDOM_NUMBER_MAIN__
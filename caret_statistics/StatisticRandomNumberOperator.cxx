@@ -27,11 +27,23 @@
 #include "StatisticRandomNumber.h"
 #include "StatisticRandomNumberOperator.h"
 
+/**
+ * constructor.
+ */
+StatisticRandomNumberOperator::StatisticRandomNumberOperator(StatisticRandomNumber* generatorIn)
+{
+   generator = generatorIn;
+}
+
 /**
  * "()" operator
  */
 ptrdiff_t
 StatisticRandomNumberOperator::operator() (ptrdiff_t maxNum) {
+   if (generator != NULL) {
+      return static_cast<ptrdiff_t>(generator->nextInteger(0, static_cast<int>(maxNum - 1)));
+   }
+   
    const unsigned int minVal = 0;
    const unsigned int maxVal = static_cast<unsigned int>(maxNum - 1);
    const ptrdiff_t p = static_cast<ptrdiff_t>(StatisticRandomNumber::randomInteger(minVal, maxVal));
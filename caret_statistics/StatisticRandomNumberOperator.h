@@ -30,13 +30,22 @@
 #include <cstdlib>
 #include <cstddef>
 
+class StatisticRandomNumber;
+
 /// class for a random number generator object used with standard library algorithms
 class StatisticRandomNumberOperator {
    public:
+      // constructor (global generator is used if "generatorIn" is NULL)
+      StatisticRandomNumberOperator(StatisticRandomNumber* generatorIn = NULL);
+      
       //
       // "()" operator
       //
       ptrdiff_t operator() (ptrdiff_t maxNum);
+      
+   protected:
+      /// counter-based generator (not owned)
+      StatisticRandomNumber* generator;
 };
 
 #endif // __STATISTIC_RANDOM_NUMBER_OPERATOR_H__